@@ -0,0 +1,330 @@
+/*
+Title: Deferred Spot Lighting
+File Name: assetRegistry.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "assetRegistry.h"
+#include "programBinaryCache.h"
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <iterator>
+
+AssetRegistry::AssetRegistry()
+{
+}
+
+AssetRegistry::~AssetRegistry()
+{
+    for (unsigned int i = 0; i < m_assets.size(); i++)
+    {
+        Asset& asset = m_assets[i];
+        switch (asset.m_type)
+        {
+        case ASSET_TEXTURE: asset.m_texture->DecRefCount(); break;
+        case ASSET_CUBE_MAP: asset.m_cubeMap->DecRefCount(); break;
+        case ASSET_MESH: asset.m_mesh->DecRefCount(); break;
+        }
+    }
+}
+
+Texture* AssetRegistry::GetTexture(const std::string& filePath, GLint sampleMode, bool mipmaps)
+{
+    std::vector<char*> filePaths;
+    filePaths.push_back((char*)filePath.c_str());
+    return GetTextures(filePaths, sampleMode, mipmaps)[0];
+}
+
+std::vector<Texture*> AssetRegistry::GetTextures(const std::vector<char*>& filePaths, GLint sampleMode, bool mipmaps)
+{
+    std::string settings = "texture " + std::to_string(sampleMode) + (mipmaps ? " mipmaps" : "");
+
+    std::vector<Texture*> textures(filePaths.size(), nullptr);
+    std::vector<unsigned long long> keys(filePaths.size());
+
+    // Everything that isn't loaded yet goes into one batch. The same file can be in the list twice, so
+    // remember which keys are already in the batch.
+    std::vector<char*> missingPaths;
+    std::vector<unsigned long long> missingKeys;
+    for (unsigned int i = 0; i < filePaths.size(); i++)
+    {
+        keys[i] = GetKey(filePaths[i], settings);
+        int index = Find(keys[i]);
+        if (index >= 0)
+        {
+            textures[i] = m_assets[index].m_texture;
+            m_hits++;
+        }
+        else if (std::find(missingKeys.begin(), missingKeys.end(), keys[i]) == missingKeys.end())
+        {
+            missingPaths.push_back(filePaths[i]);
+            missingKeys.push_back(keys[i]);
+        }
+    }
+
+    if (missingPaths.size() > 0)
+    {
+        std::vector<Texture*> loaded = Texture::Load(missingPaths, sampleMode, mipmaps);
+        for (unsigned int i = 0; i < loaded.size(); i++)
+        {
+            Add(ASSET_TEXTURE, missingPaths[i], missingKeys[i], loaded[i]);
+        }
+    }
+
+    // Fill in the ones that were just loaded (including repeats within this batch).
+    for (unsigned int i = 0; i < filePaths.size(); i++)
+    {
+        if (textures[i] == nullptr)
+        {
+            textures[i] = m_assets[Find(keys[i])].m_texture;
+        }
+    }
+    return textures;
+}
+
+CubeMap* AssetRegistry::GetCubeMap(const std::vector<char*>& filePaths)
+{
+    // A cube map is all six faces, so its key is every face's key combined, in order.
+    unsigned long long key = ProgramBinaryCache::Hash("cube map");
+    std::string name;
+    for (unsigned int i = 0; i < filePaths.size(); i++)
+    {
+        key = ProgramBinaryCache::Hash(std::to_string(GetKey(filePaths[i], "face")), key);
+        name += (i > 0 ? ", " : "") + std::string(filePaths[i]);
+    }
+
+    int index = Find(key);
+    if (index >= 0)
+    {
+        m_hits++;
+        return m_assets[index].m_cubeMap;
+    }
+
+    CubeMap* cubeMap = new CubeMap(filePaths);
+    Add(ASSET_CUBE_MAP, name, key, cubeMap);
+    return cubeMap;
+}
+
+Mesh* AssetRegistry::GetMesh(const std::string& filePath, bool calcTangents)
+{
+    unsigned long long key = GetKey(filePath, calcTangents ? "mesh tangents" : "mesh");
+    int index = Find(key);
+    if (index >= 0)
+    {
+        m_hits++;
+        return m_assets[index].m_mesh;
+    }
+
+    Mesh* mesh = new Mesh(filePath, calcTangents);
+    Add(ASSET_MESH, filePath, key, mesh);
+    return mesh;
+}
+
+unsigned int AssetRegistry::Collect()
+{
+    // With only the registry's reference left, releasing it deletes the asset.
+    std::vector<Asset> kept;
+    unsigned int freed = 0;
+    for (unsigned int i = 0; i < m_assets.size(); i++)
+    {
+        Asset& asset = m_assets[i];
+        unsigned int refCount = 0;
+        switch (asset.m_type)
+        {
+        case ASSET_TEXTURE: refCount = asset.m_texture->GetRefCount(); break;
+        case ASSET_CUBE_MAP: refCount = asset.m_cubeMap->GetRefCount(); break;
+        case ASSET_MESH: refCount = asset.m_mesh->GetRefCount(); break;
+        }
+
+        if (refCount > 1)
+        {
+            kept.push_back(asset);
+            continue;
+        }
+
+        switch (asset.m_type)
+        {
+        case ASSET_TEXTURE: asset.m_texture->DecRefCount(); break;
+        case ASSET_CUBE_MAP: asset.m_cubeMap->DecRefCount(); break;
+        case ASSET_MESH: asset.m_mesh->DecRefCount(); break;
+        }
+        freed++;
+    }
+
+    // The indices changed, so rebuild the lookup.
+    m_assets = kept;
+    m_assetsByKey.clear();
+    for (unsigned int i = 0; i < m_assets.size(); i++)
+    {
+        m_assetsByKey[m_assets[i].m_key] = i;
+    }
+    return freed;
+}
+
+unsigned long long AssetRegistry::GetMemorySize()
+{
+    unsigned long long total = 0;
+    for (unsigned int i = 0; i < m_assets.size(); i++)
+    {
+        Asset& asset = m_assets[i];
+        switch (asset.m_type)
+        {
+        case ASSET_TEXTURE: total += asset.m_texture->GetMemorySize(); break;
+        case ASSET_CUBE_MAP: total += asset.m_cubeMap->GetMemorySize(); break;
+        case ASSET_MESH: total += asset.m_mesh->GetMemorySize(); break;
+        }
+    }
+    return total;
+}
+
+std::string AssetRegistry::GetReport()
+{
+    const char* typeNames[] = { "texture", "cube map", "mesh" };
+
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(2);
+    unsigned long long total = 0;
+    for (unsigned int i = 0; i < m_assets.size(); i++)
+    {
+        Asset& asset = m_assets[i];
+        unsigned long long size = 0;
+        unsigned int refCount = 0;
+        switch (asset.m_type)
+        {
+        case ASSET_TEXTURE: size = asset.m_texture->GetMemorySize(); refCount = asset.m_texture->GetRefCount(); break;
+        case ASSET_CUBE_MAP: size = asset.m_cubeMap->GetMemorySize(); refCount = asset.m_cubeMap->GetRefCount(); break;
+        case ASSET_MESH: size = asset.m_mesh->GetMemorySize(); refCount = asset.m_mesh->GetRefCount(); break;
+        }
+        total += size;
+
+        // The registry's own reference isn't counted as a user.
+        report << std::setw(10) << size / (1024.0 * 1024.0) << " MB  " << typeNames[asset.m_type] << " "
+            << asset.m_name << " (" << refCount - 1 << " users)\n";
+    }
+    report << std::setw(10) << total / (1024.0 * 1024.0) << " MB  total, " << m_assets.size() << " assets, "
+        << m_hits << " loads shared";
+    return report.str();
+}
+
+std::string AssetRegistry::CanonicalizePath(const std::string& filePath)
+{
+    // Split the path into its parts, dropping "." and empty parts, and letting ".." remove the part before it.
+    // A ".." with nothing before it (the start of a relative path) has to stay.
+    std::vector<std::string> parts;
+    std::string part;
+    for (unsigned int i = 0; i <= filePath.size(); i++)
+    {
+        char c = i < filePath.size() ? filePath[i] : '/';
+        if (c != '/' && c != '\\')
+        {
+#ifdef _WIN32
+            // Only Windows file names ignore case. Elsewhere Foo.png and foo.png are different files.
+            c = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+#endif
+            part += c;
+            continue;
+        }
+
+        if (part == "..")
+        {
+            if (parts.size() > 0 && parts.back() != "..")
+            {
+                parts.pop_back();
+            }
+            else
+            {
+                parts.push_back(part);
+            }
+        }
+        else if (part != "." && part != "")
+        {
+            parts.push_back(part);
+        }
+        part = "";
+    }
+
+    // Keep a leading slash for absolute paths.
+    std::string canonical = (filePath.size() > 0 && (filePath[0] == '/' || filePath[0] == '\\')) ? "/" : "";
+    for (unsigned int i = 0; i < parts.size(); i++)
+    {
+        canonical += (i > 0 ? "/" : "") + parts[i];
+    }
+    return canonical;
+}
+
+bool AssetRegistry::HashFile(const std::string& filePath, unsigned long long& hash)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.good())
+    {
+        return false;
+    }
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    hash = ProgramBinaryCache::Hash(contents);
+    return true;
+}
+
+unsigned long long AssetRegistry::GetKey(const std::string& filePath, const std::string& settings)
+{
+    std::string canonical = CanonicalizePath(filePath);
+
+    // Only read the file the first time its path is seen.
+    std::map<std::string, unsigned long long>::iterator found = m_fileHashes.find(canonical);
+    unsigned long long fileHash;
+    if (found != m_fileHashes.end())
+    {
+        fileHash = found->second;
+    }
+    else
+    {
+        if (!HashFile(filePath, fileHash))
+        {
+            fileHash = ProgramBinaryCache::Hash("missing " + canonical);
+        }
+        m_fileHashes[canonical] = fileHash;
+    }
+
+    return ProgramBinaryCache::Hash(settings, fileHash);
+}
+
+int AssetRegistry::Find(unsigned long long key)
+{
+    std::map<unsigned long long, unsigned int>::iterator found = m_assetsByKey.find(key);
+    return found != m_assetsByKey.end() ? (int)found->second : -1;
+}
+
+void AssetRegistry::Add(AssetType type, const std::string& name, unsigned long long key, void* asset)
+{
+    Asset entry;
+    entry.m_type = type;
+    entry.m_name = name;
+    entry.m_key = key;
+    switch (type)
+    {
+    case ASSET_TEXTURE: entry.m_texture = (Texture*)asset; entry.m_texture->IncRefCount(); break;
+    case ASSET_CUBE_MAP: entry.m_cubeMap = (CubeMap*)asset; entry.m_cubeMap->IncRefCount(); break;
+    case ASSET_MESH: entry.m_mesh = (Mesh*)asset; entry.m_mesh->IncRefCount(); break;
+    }
+
+    m_assetsByKey[key] = m_assets.size();
+    m_assets.push_back(entry);
+}
@@ -0,0 +1,116 @@
+/*
+Title: Deferred Spot Lighting
+File Name: assetRegistry.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <iostream>
+#include <fstream>
+
+#include "texture.h"
+#include "cubeMap.h"
+#include "mesh.h"
+
+// Loads textures, cube maps, and meshes only once, no matter how many things use them.
+//
+// Assets are looked up by the hash of the file's contents (plus the settings they're loaded with), so two
+// materials asking for the same file share one GPU copy, even if the path is spelled differently or the file
+// was copied somewhere else. The hash of each canonical path is remembered, so asking for a path again
+// doesn't read the file again.
+//
+// The registry holds a reference to everything it loaded. Anything that keeps an asset should take its own
+// reference (materials already do in SetTexture), and Collect frees whatever only the registry still holds.
+class AssetRegistry
+{
+public:
+    AssetRegistry();
+
+    // Releases the registry's references. Assets still referenced elsewhere stay alive until those are released.
+    ~AssetRegistry();
+
+    Texture* GetTexture(const std::string& filePath, GLint sampleMode, bool mipmaps = true);
+
+    // Looks up a batch of textures. The ones that aren't loaded yet are decoded in parallel (see Texture::Load).
+    std::vector<Texture*> GetTextures(const std::vector<char*>& filePaths, GLint sampleMode, bool mipmaps = true);
+
+    CubeMap* GetCubeMap(const std::vector<char*>& filePaths);
+
+    Mesh* GetMesh(const std::string& filePath, bool calcTangents);
+
+    // Frees every asset that nothing but the registry is using. Returns how many were freed.
+    unsigned int Collect();
+
+    // GPU memory of every asset, and how many references each one has.
+    unsigned long long GetMemorySize();
+    std::string GetReport();
+
+    // Turns a path into one spelling: forward slashes, no "." or "a/.." parts, and on Windows lower case
+    // (its file system is case insensitive).
+    static std::string CanonicalizePath(const std::string& filePath);
+
+    // Hashes the contents of a file. Returns false if it couldn't be read.
+    static bool HashFile(const std::string& filePath, unsigned long long& hash);
+
+private:
+    enum AssetType
+    {
+        ASSET_TEXTURE,
+        ASSET_CUBE_MAP,
+        ASSET_MESH
+    };
+
+    struct Asset
+    {
+        AssetType m_type;
+        // The first path the asset was loaded from (all six for cube maps), for the report.
+        std::string m_name;
+        unsigned long long m_key;
+
+        // Only the one matching m_type is set.
+        Texture* m_texture = nullptr;
+        CubeMap* m_cubeMap = nullptr;
+        Mesh* m_mesh = nullptr;
+    };
+
+    // The key of a file loaded with some settings. Files that can't be read are keyed by their path instead,
+    // so they still only fail to load once.
+    unsigned long long GetKey(const std::string& filePath, const std::string& settings);
+
+    // Returns the index of the asset with a key, or -1.
+    int Find(unsigned long long key);
+
+    void Add(AssetType type, const std::string& name, unsigned long long key, void* asset);
+
+    std::vector<Asset> m_assets;
+    std::map<unsigned long long, unsigned int> m_assetsByKey;
+
+    // Canonical path -> hash of the file's contents.
+    std::map<std::string, unsigned long long> m_fileHashes;
+
+    // How many lookups found an asset that was already loaded.
+    unsigned int m_hits = 0;
+};
@@ -0,0 +1,506 @@
+/*
+Title: Deferred Spot Lighting
+File Name: blockCompressor.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "blockCompressor.h"
+#include "compressedImage.h"
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+// BC7 mode 6 interpolates between its end points with these weights (out of 64).
+static const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+
+// Rounds an 8 bit color to 5:6:5 bits.
+static unsigned short PackColor565(glm::vec3 color)
+{
+    color = glm::clamp(color, glm::vec3(0), glm::vec3(255));
+    unsigned int r = (unsigned int)(color.r * 31 / 255 + .5f);
+    unsigned int g = (unsigned int)(color.g * 63 / 255 + .5f);
+    unsigned int b = (unsigned int)(color.b * 31 / 255 + .5f);
+    return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+// Expands a 5:6:5 color back to 8 bits, the same way the GPU does.
+static glm::vec3 UnpackColor565(unsigned short color)
+{
+    unsigned int r = (color >> 11) & 31;
+    unsigned int g = (color >> 5) & 63;
+    unsigned int b = color & 31;
+    return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+static glm::vec3 GetTexelColor(const unsigned char texels[64], int i)
+{
+    return glm::vec3(texels[i * 4], texels[i * 4 + 1], texels[i * 4 + 2]);
+}
+
+static glm::vec4 GetTexel(const unsigned char texels[64], int i)
+{
+    return glm::vec4(texels[i * 4], texels[i * 4 + 1], texels[i * 4 + 2], texels[i * 4 + 3]);
+}
+
+// Picks the closest of the four BC1 palette colors for every texel, and returns the total squared error.
+// color0 must be greater than color1, which selects the four color mode.
+static float FitIndicesBC1(const unsigned char texels[64], unsigned short color0, unsigned short color1, unsigned int& indices)
+{
+    glm::vec3 palette[4];
+    palette[0] = UnpackColor565(color0);
+    palette[1] = UnpackColor565(color1);
+    palette[2] = (palette[0] * 2.0f + palette[1]) / 3.0f;
+    palette[3] = (palette[0] + palette[1] * 2.0f) / 3.0f;
+
+    float error = 0;
+    indices = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        glm::vec3 texel = GetTexelColor(texels, i);
+        unsigned int best = 0;
+        float bestDistance = FLT_MAX;
+        for (unsigned int j = 0; j < 4; j++)
+        {
+            glm::vec3 difference = texel - palette[j];
+            float distance = glm::dot(difference, difference);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                best = j;
+            }
+        }
+        indices |= best << (i * 2);
+        error += bestDistance;
+    }
+    return error;
+}
+
+// Puts the end points in the order that selects four color mode, fits the indices and returns the error.
+static float FitBC1(const unsigned char texels[64], glm::vec3 end0, glm::vec3 end1, unsigned short& color0, unsigned short& color1, unsigned int& indices)
+{
+    color0 = PackColor565(end0);
+    color1 = PackColor565(end1);
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    // Both ends rounded to the same color. Every texel gets index 0, which is color0 in either mode.
+    if (color0 == color1)
+    {
+        indices = 0;
+        float error = 0;
+        glm::vec3 color = UnpackColor565(color0);
+        for (int i = 0; i < 16; i++)
+        {
+            glm::vec3 difference = GetTexelColor(texels, i) - color;
+            error += glm::dot(difference, difference);
+        }
+        return error;
+    }
+
+    return FitIndicesBC1(texels, color0, color1, indices);
+}
+
+
+
+void BlockCompressor::Compress(const unsigned char* rgba, unsigned int width, unsigned int height, GLenum internalFormat, std::vector<unsigned char>& blocks)
+{
+    unsigned int blockSize = CompressedImage::GetBlockSize(internalFormat);
+    unsigned char texels[64];
+    unsigned char block[16];
+
+    for (unsigned int blockY = 0; blockY < height; blockY += 4)
+    {
+        for (unsigned int blockX = 0; blockX < width; blockX += 4)
+        {
+            // Gather the block's texels, repeating the last row and column for blocks past the edge.
+            for (unsigned int y = 0; y < 4; y++)
+            {
+                for (unsigned int x = 0; x < 4; x++)
+                {
+                    unsigned int sourceX = glm::min(blockX + x, width - 1);
+                    unsigned int sourceY = glm::min(blockY + y, height - 1);
+                    const unsigned char* texel = rgba + (sourceY * width + sourceX) * 4;
+                    for (int c = 0; c < 4; c++)
+                    {
+                        texels[(y * 4 + x) * 4 + c] = texel[c];
+                    }
+                }
+            }
+
+            switch (internalFormat)
+            {
+            case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+                EncodeBC1(texels, block);
+                break;
+            case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+                EncodeBC3(texels, block);
+                break;
+            case GL_COMPRESSED_RG_RGTC2:
+                EncodeBC5(texels, block);
+                break;
+            case GL_COMPRESSED_RGBA_BPTC_UNORM:
+            case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+                EncodeBC7(texels, block);
+                break;
+            }
+            blocks.insert(blocks.end(), block, block + blockSize);
+        }
+    }
+}
+
+void BlockCompressor::Downsample(const std::vector<unsigned char>& source, unsigned int width, unsigned int height,
+    std::vector<unsigned char>& destination, bool normalMap)
+{
+    unsigned int destinationWidth = glm::max(width / 2, 1u);
+    unsigned int destinationHeight = glm::max(height / 2, 1u);
+    destination.resize(destinationWidth * destinationHeight * 4);
+
+    for (unsigned int y = 0; y < destinationHeight; y++)
+    {
+        for (unsigned int x = 0; x < destinationWidth; x++)
+        {
+            // Average the 2x2 texels above this one (a 1 texel wide level repeats its only column or row).
+            glm::vec4 sum(0.0f);
+            for (unsigned int j = 0; j < 2; j++)
+            {
+                for (unsigned int i = 0; i < 2; i++)
+                {
+                    unsigned int sourceX = glm::min(x * 2 + i, width - 1);
+                    unsigned int sourceY = glm::min(y * 2 + j, height - 1);
+                    const unsigned char* texel = &source[(sourceY * width + sourceX) * 4];
+                    sum += glm::vec4(texel[0], texel[1], texel[2], texel[3]);
+                }
+            }
+            glm::vec4 average = sum / 4.0f;
+
+            if (normalMap)
+            {
+                // Averaging directions makes them shorter, so push the result back out to length 1.
+                glm::vec3 normal = glm::vec3(average) / 127.5f - 1.0f;
+                float length = glm::length(normal);
+                if (length > .0001f)
+                {
+                    average = glm::vec4((normal / length + 1.0f) * 127.5f, average.a);
+                }
+            }
+
+            for (int c = 0; c < 4; c++)
+            {
+                destination[(y * destinationWidth + x) * 4 + c] = (unsigned char)glm::clamp(average[c] + .5f, 0.0f, 255.0f);
+            }
+        }
+    }
+}
+
+void BlockCompressor::EncodeBC1(const unsigned char texels[64], unsigned char block[8])
+{
+    // Start with the ends of the texels' spread along their main axis, pulled in a little
+    // since the palette rarely needs to reach the most extreme texel exactly.
+    glm::vec4 mean;
+    glm::vec3 axis = glm::vec3(GetPrincipalAxis(texels, false, mean));
+    float minimum = FLT_MAX;
+    float maximum = -FLT_MAX;
+    for (int i = 0; i < 16; i++)
+    {
+        float t = glm::dot(GetTexelColor(texels, i) - glm::vec3(mean), axis);
+        minimum = glm::min(minimum, t);
+        maximum = glm::max(maximum, t);
+    }
+    float inset = (maximum - minimum) / 16;
+    glm::vec3 end0 = glm::vec3(mean) + axis * (maximum - inset);
+    glm::vec3 end1 = glm::vec3(mean) + axis * (minimum + inset);
+
+    unsigned short color0, color1;
+    unsigned int indices;
+    float error = FitBC1(texels, end0, end1, color0, color1, indices);
+
+    // Now that each texel has a palette entry, solve for the end points that best fit those entries (least squares),
+    // and keep them if they are an improvement.
+    if (color0 != color1)
+    {
+        static const float weights[4] = { 1, 0, 2.0f / 3, 1.0f / 3 };
+        float aa = 0, ab = 0, bb = 0;
+        glm::vec3 ax(0.0f), bx(0.0f);
+        for (int i = 0; i < 16; i++)
+        {
+            float w = weights[(indices >> (i * 2)) & 3];
+            glm::vec3 texel = GetTexelColor(texels, i);
+            aa += w * w;
+            ab += w * (1 - w);
+            bb += (1 - w) * (1 - w);
+            ax += texel * w;
+            bx += texel * (1 - w);
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) > .0001f)
+        {
+            glm::vec3 refined0 = (ax * bb - bx * ab) / determinant;
+            glm::vec3 refined1 = (bx * aa - ax * ab) / determinant;
+
+            unsigned short refinedColor0, refinedColor1;
+            unsigned int refinedIndices;
+            float refinedError = FitBC1(texels, refined0, refined1, refinedColor0, refinedColor1, refinedIndices);
+            if (refinedError < error)
+            {
+                color0 = refinedColor0;
+                color1 = refinedColor1;
+                indices = refinedIndices;
+            }
+        }
+    }
+
+    block[0] = color0 & 0xFF;
+    block[1] = color0 >> 8;
+    block[2] = color1 & 0xFF;
+    block[3] = color1 >> 8;
+    for (int i = 0; i < 4; i++)
+    {
+        block[4 + i] = (indices >> (i * 8)) & 0xFF;
+    }
+}
+
+void BlockCompressor::EncodeBC3(const unsigned char texels[64], unsigned char block[16])
+{
+    // Alpha first, then a BC1 color block.
+    EncodeChannel(texels, 3, block);
+    EncodeBC1(texels, block + 8);
+}
+
+void BlockCompressor::EncodeBC5(const unsigned char texels[64], unsigned char block[16])
+{
+    // Red then green, each with its own end points.
+    EncodeChannel(texels, 0, block);
+    EncodeChannel(texels, 1, block + 8);
+}
+
+void BlockCompressor::EncodeBC7(const unsigned char texels[64], unsigned char block[16])
+{
+    // BC7 has 8 different block layouts (modes). This only uses mode 6: a single line through rgba space,
+    // 7 bit end points that share an extra low bit each, and 4 bit indices.
+    // It's the simplest mode, and still well ahead of BC1 and BC3 for smooth gradients.
+    glm::vec4 mean;
+    glm::vec4 axis = GetPrincipalAxis(texels, true, mean);
+    float minimum = FLT_MAX;
+    float maximum = -FLT_MAX;
+    for (int i = 0; i < 16; i++)
+    {
+        float t = glm::dot(GetTexel(texels, i) - mean, axis);
+        minimum = glm::min(minimum, t);
+        maximum = glm::max(maximum, t);
+    }
+    glm::vec4 ends[2] = { glm::clamp(mean + axis * minimum, glm::vec4(0), glm::vec4(255)), glm::clamp(mean + axis * maximum, glm::vec4(0), glm::vec4(255)) };
+
+    // Each end point is 7 bits per channel plus one low bit (p) shared by all four channels.
+    // Try both values of p and keep whichever lands closer.
+    int quantized[2][4];
+    int pBits[2];
+    glm::vec4 palette[16];
+    for (int e = 0; e < 2; e++)
+    {
+        float bestError = FLT_MAX;
+        for (int p = 0; p < 2; p++)
+        {
+            int candidate[4];
+            float error = 0;
+            for (int c = 0; c < 4; c++)
+            {
+                candidate[c] = glm::clamp((int)std::floor((ends[e][c] - p) / 2 + .5f), 0, 127);
+                float difference = ends[e][c] - ((candidate[c] << 1) | p);
+                error += difference * difference;
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                pBits[e] = p;
+                for (int c = 0; c < 4; c++)
+                {
+                    quantized[e][c] = candidate[c];
+                }
+            }
+        }
+    }
+
+    // The palette, exactly as the GPU will rebuild it.
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            int end0 = (quantized[0][c] << 1) | pBits[0];
+            int end1 = (quantized[1][c] << 1) | pBits[1];
+            palette[i][c] = (float)(((64 - bc7Weights[i]) * end0 + bc7Weights[i] * end1 + 32) >> 6);
+        }
+    }
+
+    int indices[16];
+    for (int i = 0; i < 16; i++)
+    {
+        glm::vec4 texel = GetTexel(texels, i);
+        float bestDistance = FLT_MAX;
+        for (int j = 0; j < 16; j++)
+        {
+            glm::vec4 difference = texel - palette[j];
+            float distance = glm::dot(difference, difference);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                indices[i] = j;
+            }
+        }
+    }
+
+    // The first texel's index only has room for 3 bits, so its top bit must be 0.
+    // If it isn't, swap the end points, which flips every index.
+    if (indices[0] >= 8)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            std::swap(quantized[0][c], quantized[1][c]);
+        }
+        std::swap(pBits[0], pBits[1]);
+        for (int i = 0; i < 16; i++)
+        {
+            indices[i] = 15 - indices[i];
+        }
+    }
+
+    // Write the bits, lowest first: mode (6 zeros and a one), the end points channel by channel, the p bits, then the indices.
+    for (int i = 0; i < 16; i++)
+    {
+        block[i] = 0;
+    }
+    unsigned int position = 0;
+    auto write = [&](unsigned int value, unsigned int bits)
+    {
+        for (unsigned int i = 0; i < bits; i++, position++)
+        {
+            block[position / 8] |= ((value >> i) & 1) << (position % 8);
+        }
+    };
+
+    write(1 << 6, 7);
+    for (int c = 0; c < 4; c++)
+    {
+        write(quantized[0][c], 7);
+        write(quantized[1][c], 7);
+    }
+    write(pBits[0], 1);
+    write(pBits[1], 1);
+    for (int i = 0; i < 16; i++)
+    {
+        write(indices[i], i == 0 ? 3 : 4);
+    }
+}
+
+void BlockCompressor::EncodeChannel(const unsigned char texels[64], int channel, unsigned char block[8])
+{
+    int minimum = 255;
+    int maximum = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        minimum = glm::min(minimum, (int)texels[i * 4 + channel]);
+        maximum = glm::max(maximum, (int)texels[i * 4 + channel]);
+    }
+
+    // With the first end point larger, the block has 8 evenly spaced values from the first to the second.
+    int palette[8];
+    palette[0] = maximum;
+    palette[1] = minimum;
+    for (int i = 2; i < 8; i++)
+    {
+        palette[i] = ((8 - i) * maximum + (i - 1) * minimum + 3) / 7;
+    }
+
+    unsigned long long indices = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int value = texels[i * 4 + channel];
+        unsigned long long best = 0;
+        int bestDistance = 256;
+        for (int j = 0; j < 8; j++)
+        {
+            int distance = std::abs(value - palette[j]);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                best = j;
+            }
+        }
+        indices |= best << (i * 3);
+    }
+
+    block[0] = (unsigned char)maximum;
+    block[1] = (unsigned char)minimum;
+    for (int i = 0; i < 6; i++)
+    {
+        block[2 + i] = (indices >> (i * 8)) & 0xFF;
+    }
+}
+
+glm::vec4 BlockCompressor::GetPrincipalAxis(const unsigned char texels[64], bool useAlpha, glm::vec4& mean)
+{
+    glm::vec4 mask = useAlpha ? glm::vec4(1) : glm::vec4(1, 1, 1, 0);
+
+    mean = glm::vec4(0.0f);
+    for (int i = 0; i < 16; i++)
+    {
+        mean += GetTexel(texels, i) * mask;
+    }
+    mean /= 16.0f;
+
+    // Covariance of the texels around their mean.
+    glm::mat4 covariance(0.0f);
+    for (int i = 0; i < 16; i++)
+    {
+        glm::vec4 offset = GetTexel(texels, i) * mask - mean;
+        covariance += glm::outerProduct(offset, offset);
+    }
+
+    // Repeatedly multiplying by the covariance turns any vector towards its largest eigenvector.
+    // Starting from the diagonal of the bounding box is usually already close.
+    glm::vec4 minimum = glm::vec4(255) * mask;
+    glm::vec4 maximum = glm::vec4(0.0f);
+    for (int i = 0; i < 16; i++)
+    {
+        minimum = glm::min(minimum, GetTexel(texels, i) * mask);
+        maximum = glm::max(maximum, GetTexel(texels, i) * mask);
+    }
+    glm::vec4 axis = maximum - minimum;
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec4 next = covariance * axis;
+        float length = glm::length(next);
+        if (length < .0001f)
+        {
+            break;
+        }
+        axis = next / length;
+    }
+
+    // A flat block has no spread, any direction will do.
+    float length = glm::length(axis);
+    return length > .0001f ? axis / length : glm::normalize(mask);
+}
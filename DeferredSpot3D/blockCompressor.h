@@ -0,0 +1,62 @@
+/*
+Title: Deferred Spot Lighting
+File Name: blockCompressor.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "glm/glm.hpp"
+#include <vector>
+
+// Encodes RGBA8 images into the block compressed formats CompressedImage can load.
+// Every format splits the image into 4x4 blocks, and stores each block as two end point colors
+// and a small index per texel that picks a color on the line between them.
+// This runs offline (see textureCompressor.h), so it favors being simple over being fast.
+class BlockCompressor
+{
+public:
+    // Compresses a whole image, 4 bytes (r, g, b, a) per texel with no padding between rows.
+    // internalFormat is one of the formats listed in compressedImage.h, the blocks are appended to the output.
+    // Blocks that hang off the edge of the image repeat the edge texels.
+    static void Compress(const unsigned char* rgba, unsigned int width, unsigned int height, GLenum internalFormat, std::vector<unsigned char>& blocks);
+
+    // Makes the next mip level with a 2x2 box filter.
+    // For normal maps, rgb is treated as a direction and the average is normalized again, so the shading doesn't go flat.
+    static void Downsample(const std::vector<unsigned char>& source, unsigned int width, unsigned int height,
+        std::vector<unsigned char>& destination, bool normalMap);
+
+    // Each of these encodes one block of 16 texels (64 bytes, rgba, row by row).
+    // BC1 is color only, BC3 adds alpha, BC5 keeps just red and green, and BC7 keeps all four channels at higher precision.
+    static void EncodeBC1(const unsigned char texels[64], unsigned char block[8]);
+    static void EncodeBC3(const unsigned char texels[64], unsigned char block[16]);
+    static void EncodeBC5(const unsigned char texels[64], unsigned char block[16]);
+    static void EncodeBC7(const unsigned char texels[64], unsigned char block[16]);
+
+private:
+    // Encodes one channel (0 to 3) as an 8 byte block with two 8 bit end points and 3 bit indices.
+    // This is the alpha block of BC3, and each half of BC5.
+    static void EncodeChannel(const unsigned char texels[64], int channel, unsigned char block[8]);
+
+    // The direction the texels are most spread out along, found with a few rounds of power iteration.
+    // With useAlpha off, alpha is ignored.
+    static glm::vec4 GetPrincipalAxis(const unsigned char texels[64], bool useAlpha, glm::vec4& mean);
+};
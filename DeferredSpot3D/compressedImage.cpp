@@ -0,0 +1,379 @@
+/*
+Title: Deferred Spot Lighting
+File Name: compressedImage.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "compressedImage.h"
+#include <fstream>
+#include <algorithm>
+
+// DXGI_FORMAT values used by the DX10 DDS header.
+#define DXGI_FORMAT_BC1_UNORM 71
+#define DXGI_FORMAT_BC1_UNORM_SRGB 72
+#define DXGI_FORMAT_BC3_UNORM 77
+#define DXGI_FORMAT_BC3_UNORM_SRGB 78
+#define DXGI_FORMAT_BC5_UNORM 83
+#define DXGI_FORMAT_BC7_UNORM 98
+#define DXGI_FORMAT_BC7_UNORM_SRGB 99
+
+// VkFormat values used by KTX2.
+#define VK_FORMAT_BC1_RGB_UNORM_BLOCK 131
+#define VK_FORMAT_BC1_RGB_SRGB_BLOCK 132
+#define VK_FORMAT_BC1_RGBA_UNORM_BLOCK 133
+#define VK_FORMAT_BC1_RGBA_SRGB_BLOCK 134
+#define VK_FORMAT_BC3_UNORM_BLOCK 137
+#define VK_FORMAT_BC3_SRGB_BLOCK 138
+#define VK_FORMAT_BC5_UNORM_BLOCK 141
+#define VK_FORMAT_BC7_UNORM_BLOCK 145
+#define VK_FORMAT_BC7_SRGB_BLOCK 146
+
+// Four characters packed into a little endian int, the way DDS stores them.
+#define FOURCC(a, b, c, d) ((unsigned int)(a) | ((unsigned int)(b) << 8) | ((unsigned int)(c) << 16) | ((unsigned int)(d) << 24))
+
+// The size of the "DDS " magic plus the DDS_HEADER, and of the optional DDS_HEADER_DX10 after it.
+#define DDS_HEADER_SIZE 128
+#define DDS_DX10_HEADER_SIZE 20
+
+// The size of the KTX2 identifier, header and index, before the level index starts.
+#define KTX2_HEADER_SIZE 80
+
+
+static bool ReadFile(const char* filePath, std::vector<unsigned char>& file)
+{
+    std::ifstream stream(filePath, std::ios::binary);
+    if (!stream)
+    {
+        std::cout << "Could not open " << filePath << std::endl;
+        return false;
+    }
+    file.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static unsigned int ReadU32(const std::vector<unsigned char>& file, size_t offset)
+{
+    return file[offset] | (file[offset + 1] << 8) | (file[offset + 2] << 16) | ((unsigned int)file[offset + 3] << 24);
+}
+
+static unsigned long long ReadU64(const std::vector<unsigned char>& file, size_t offset)
+{
+    return ReadU32(file, offset) | ((unsigned long long)ReadU32(file, offset + 4) << 32);
+}
+
+static void WriteU32(std::vector<unsigned char>& file, unsigned int value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        file.push_back((value >> (i * 8)) & 0xFF);
+    }
+}
+
+
+
+bool CompressedImage::Load(const char* filePath)
+{
+    std::string path = filePath;
+    std::string extension = path.substr(path.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    if (extension == "dds")
+    {
+        return LoadDDS(filePath);
+    }
+    if (extension == "ktx2")
+    {
+        return LoadKTX2(filePath);
+    }
+    std::cout << filePath << " is not a DDS or KTX2 file." << std::endl;
+    return false;
+}
+
+bool CompressedImage::LoadDDS(const char* filePath)
+{
+    std::vector<unsigned char> file;
+    if (!ReadFile(filePath, file))
+    {
+        return false;
+    }
+
+    if (file.size() < DDS_HEADER_SIZE || ReadU32(file, 0) != FOURCC('D', 'D', 'S', ' '))
+    {
+        std::cout << filePath << " is not a DDS file." << std::endl;
+        return false;
+    }
+
+    m_height = ReadU32(file, 12);
+    m_width = ReadU32(file, 16);
+    unsigned int levelCount = std::max(ReadU32(file, 28), 1u);
+    unsigned int fourCC = ReadU32(file, 84);
+    size_t dataOffset = DDS_HEADER_SIZE;
+
+    // Older files name the format with a four character code.
+    // Newer ones put 'DX10' there, and the real format in an extra header.
+    m_internalFormat = 0;
+    if (fourCC == FOURCC('D', 'X', 'T', '1'))
+    {
+        m_internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    }
+    else if (fourCC == FOURCC('D', 'X', 'T', '5'))
+    {
+        m_internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+    else if (fourCC == FOURCC('A', 'T', 'I', '2') || fourCC == FOURCC('B', 'C', '5', 'U'))
+    {
+        m_internalFormat = GL_COMPRESSED_RG_RGTC2;
+    }
+    else if (fourCC == FOURCC('D', 'X', '1', '0') && file.size() >= DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE)
+    {
+        dataOffset += DDS_DX10_HEADER_SIZE;
+        switch (ReadU32(file, DDS_HEADER_SIZE))
+        {
+        case DXGI_FORMAT_BC1_UNORM: m_internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; break;
+        case DXGI_FORMAT_BC1_UNORM_SRGB: m_internalFormat = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT; break;
+        case DXGI_FORMAT_BC3_UNORM: m_internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+        case DXGI_FORMAT_BC3_UNORM_SRGB: m_internalFormat = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT; break;
+        case DXGI_FORMAT_BC5_UNORM: m_internalFormat = GL_COMPRESSED_RG_RGTC2; break;
+        case DXGI_FORMAT_BC7_UNORM: m_internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM; break;
+        case DXGI_FORMAT_BC7_UNORM_SRGB: m_internalFormat = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM; break;
+        }
+
+        // Arrays and cube maps aren't supported, only plain 2D textures.
+        if (ReadU32(file, DDS_HEADER_SIZE + 12) > 1)
+        {
+            std::cout << filePath << " is a texture array, which is not supported." << std::endl;
+            return false;
+        }
+    }
+
+    if (m_internalFormat == 0)
+    {
+        std::cout << filePath << " is not BC1, BC3, BC5 or BC7 compressed." << std::endl;
+        return false;
+    }
+
+    return ReadLevels(file, dataOffset, levelCount, filePath);
+}
+
+bool CompressedImage::LoadKTX2(const char* filePath)
+{
+    std::vector<unsigned char> file;
+    if (!ReadFile(filePath, file))
+    {
+        return false;
+    }
+
+    static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    if (file.size() < KTX2_HEADER_SIZE || !std::equal(identifier, identifier + 12, file.begin()))
+    {
+        std::cout << filePath << " is not a KTX2 file." << std::endl;
+        return false;
+    }
+
+    unsigned int vkFormat = ReadU32(file, 12);
+    m_width = ReadU32(file, 20);
+    m_height = ReadU32(file, 24);
+    unsigned int layerCount = ReadU32(file, 32);
+    unsigned int faceCount = ReadU32(file, 36);
+    unsigned int levelCount = std::max(ReadU32(file, 40), 1u);
+    unsigned int supercompression = ReadU32(file, 44);
+
+    m_internalFormat = 0;
+    switch (vkFormat)
+    {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: m_internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; break;
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: m_internalFormat = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT; break;
+    case VK_FORMAT_BC3_UNORM_BLOCK: m_internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+    case VK_FORMAT_BC3_SRGB_BLOCK: m_internalFormat = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT; break;
+    case VK_FORMAT_BC5_UNORM_BLOCK: m_internalFormat = GL_COMPRESSED_RG_RGTC2; break;
+    case VK_FORMAT_BC7_UNORM_BLOCK: m_internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM; break;
+    case VK_FORMAT_BC7_SRGB_BLOCK: m_internalFormat = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM; break;
+    }
+
+    if (m_internalFormat == 0)
+    {
+        std::cout << filePath << " is not BC1, BC3, BC5 or BC7 compressed." << std::endl;
+        return false;
+    }
+    if (supercompression != 0)
+    {
+        std::cout << filePath << " uses supercompression, which is not supported." << std::endl;
+        return false;
+    }
+    if (layerCount > 1 || faceCount > 1)
+    {
+        std::cout << filePath << " is a texture array or cube map, which is not supported." << std::endl;
+        return false;
+    }
+
+    // Unlike DDS, the levels are stored smallest first, and the level index says where each one is.
+    m_levels.resize(levelCount);
+    for (unsigned int i = 0; i < levelCount; i++)
+    {
+        size_t entry = KTX2_HEADER_SIZE + i * 24;
+        if (entry + 24 > file.size())
+        {
+            std::cout << filePath << " is missing part of its level index." << std::endl;
+            return false;
+        }
+        unsigned long long offset = ReadU64(file, entry);
+        unsigned long long length = ReadU64(file, entry + 8);
+
+        unsigned int levelWidth = std::max(m_width >> i, 1u);
+        unsigned int levelHeight = std::max(m_height >> i, 1u);
+        if (length != GetLevelSize(m_internalFormat, levelWidth, levelHeight) || offset + length > file.size())
+        {
+            std::cout << filePath << " has a level with the wrong size." << std::endl;
+            return false;
+        }
+        m_levels[i].assign(file.begin() + offset, file.begin() + offset + length);
+    }
+    return true;
+}
+
+bool CompressedImage::ReadLevels(const std::vector<unsigned char>& file, size_t offset, unsigned int levelCount, const char* filePath)
+{
+    m_levels.resize(levelCount);
+    for (unsigned int i = 0; i < levelCount; i++)
+    {
+        unsigned int levelWidth = std::max(m_width >> i, 1u);
+        unsigned int levelHeight = std::max(m_height >> i, 1u);
+        unsigned int size = GetLevelSize(m_internalFormat, levelWidth, levelHeight);
+        if (offset + size > file.size())
+        {
+            std::cout << filePath << " ends before all of its mip levels." << std::endl;
+            return false;
+        }
+        m_levels[i].assign(file.begin() + offset, file.begin() + offset + size);
+        offset += size;
+    }
+    return true;
+}
+
+bool CompressedImage::SaveDDS(const char* filePath)
+{
+    unsigned int dxgiFormat = 0;
+    switch (m_internalFormat)
+    {
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: dxgiFormat = DXGI_FORMAT_BC1_UNORM; break;
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT: dxgiFormat = DXGI_FORMAT_BC1_UNORM_SRGB; break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: dxgiFormat = DXGI_FORMAT_BC3_UNORM; break;
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT: dxgiFormat = DXGI_FORMAT_BC3_UNORM_SRGB; break;
+    case GL_COMPRESSED_RG_RGTC2: dxgiFormat = DXGI_FORMAT_BC5_UNORM; break;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM: dxgiFormat = DXGI_FORMAT_BC7_UNORM; break;
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM: dxgiFormat = DXGI_FORMAT_BC7_UNORM_SRGB; break;
+    default:
+        std::cout << "Can't save " << filePath << ", the image has no compressed format." << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> header;
+    WriteU32(header, FOURCC('D', 'D', 'S', ' '));
+
+    // DDS_HEADER: size, flags (caps, height, width, pixel format, mip count, linear size), height, width,
+    // size of level 0, depth, mip count, then 11 reserved ints.
+    WriteU32(header, 124);
+    WriteU32(header, 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000);
+    WriteU32(header, m_height);
+    WriteU32(header, m_width);
+    WriteU32(header, m_levels.size() > 0 ? (unsigned int)m_levels[0].size() : 0);
+    WriteU32(header, 0);
+    WriteU32(header, (unsigned int)m_levels.size());
+    for (int i = 0; i < 11; i++)
+    {
+        WriteU32(header, 0);
+    }
+
+    // DDS_PIXELFORMAT: size, flags (four character code), 'DX10', then 5 unused bit counts and masks.
+    WriteU32(header, 32);
+    WriteU32(header, 0x4);
+    WriteU32(header, FOURCC('D', 'X', '1', '0'));
+    for (int i = 0; i < 5; i++)
+    {
+        WriteU32(header, 0);
+    }
+
+    // Caps (texture, plus complex and mipmap if it has more than one level), then 4 unused ints.
+    WriteU32(header, m_levels.size() > 1 ? (0x1000 | 0x8 | 0x400000) : 0x1000);
+    for (int i = 0; i < 4; i++)
+    {
+        WriteU32(header, 0);
+    }
+
+    // DDS_HEADER_DX10: format, dimension (2D), flags, array size, more flags.
+    WriteU32(header, dxgiFormat);
+    WriteU32(header, 3);
+    WriteU32(header, 0);
+    WriteU32(header, 1);
+    WriteU32(header, 0);
+
+    std::ofstream stream(filePath, std::ios::binary);
+    if (!stream)
+    {
+        std::cout << "Could not write " << filePath << std::endl;
+        return false;
+    }
+    stream.write((const char*)header.data(), header.size());
+    for (unsigned int i = 0; i < m_levels.size(); i++)
+    {
+        stream.write((const char*)m_levels[i].data(), m_levels[i].size());
+    }
+    return stream.good();
+}
+
+bool CompressedImage::IsCompressedFile(const char* filePath)
+{
+    std::string path = filePath;
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos)
+    {
+        return false;
+    }
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == "dds" || extension == "ktx2";
+}
+
+unsigned int CompressedImage::GetBlockSize(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+        return 8;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+        return 16;
+    }
+    return 0;
+}
+
+unsigned int CompressedImage::GetLevelSize(GLenum internalFormat, unsigned int width, unsigned int height)
+{
+    unsigned int blocksX = (width + 3) / 4;
+    unsigned int blocksY = (height + 3) / 4;
+    return blocksX * blocksY * GetBlockSize(internalFormat);
+}
@@ -0,0 +1,73 @@
+/*
+Title: Deferred Spot Lighting
+File Name: compressedImage.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include <vector>
+#include <string>
+#include <iostream>
+
+// A block compressed image and its mip chain, as it's stored in a DDS or KTX2 file.
+// The GPU samples these formats directly, so the blocks go straight into a texture without being decoded.
+//
+// Supported formats (and the GL internal format they load as):
+//     BC1 (DXT1)       GL_COMPRESSED_RGBA_S3TC_DXT1_EXT    4 bits per texel, color with 1 bit alpha
+//     BC3 (DXT5)       GL_COMPRESSED_RGBA_S3TC_DXT5_EXT    8 bits per texel, color with smooth alpha
+//     BC5 (ATI2/RGTC2) GL_COMPRESSED_RG_RGTC2              8 bits per texel, two independent channels (normal map x and y)
+//     BC7 (BPTC)       GL_COMPRESSED_RGBA_BPTC_UNORM       8 bits per texel, high quality color and alpha
+//
+// Rows are expected bottom row first, the order OpenGL (and FreeImage) uses.
+// The texture compressor (textureCompressor.h) writes files that way. Files from other tools are usually
+// top row first, and need to be flipped vertically when they are made.
+class CompressedImage
+{
+public:
+    // Loads a .dds or .ktx2 file, picked by the extension. Returns false (and prints why) if it can't be used.
+    bool Load(const char* filePath);
+    bool LoadDDS(const char* filePath);
+    bool LoadKTX2(const char* filePath);
+
+    // Writes the image as a DDS file with a DX10 header.
+    bool SaveDDS(const char* filePath);
+
+    // True if the path ends in an extension Load understands.
+    static bool IsCompressedFile(const char* filePath);
+
+    // Bytes in one 4x4 block: 8 for BC1, 16 for the others (0 for formats we don't know).
+    static unsigned int GetBlockSize(GLenum internalFormat);
+
+    // Bytes in one mip level of the given size. Partial blocks at the edges still take a full block.
+    static unsigned int GetLevelSize(GLenum internalFormat, unsigned int width, unsigned int height);
+
+    GLenum m_internalFormat = 0;
+    unsigned int m_width = 0;
+    unsigned int m_height = 0;
+
+    // The blocks of each mip level, level 0 first.
+    std::vector<std::vector<unsigned char>> m_levels;
+
+private:
+    // Reads every level from a buffer laid out one level after another, starting with level 0.
+    bool ReadLevels(const std::vector<unsigned char>& file, size_t offset, unsigned int levelCount, const char* filePath);
+};
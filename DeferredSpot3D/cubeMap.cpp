@@ -34,31 +34,71 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 CubeMap::CubeMap(std::vector<char*> filePaths)
 {
+    // Decode all six faces at the same time on worker threads. Only the uploads below need the GL context.
+    std::vector<DecodedImage> faces;
+    ImageDecoder::DecodeAll(filePaths, faces);
+
     // Create an OpenGL texture.
     glGenTextures(1, &m_cubeMap);
 
     // Bind our texture as a cube map.
     glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubeMap);
 
+    // Block compressed faces bring their own mip levels. The cube can only use as many as every face has.
+    unsigned int levels = 0;
+
+    // Every face has to be square, and the same size and format as the first one, or the cube map is incomplete.
+    GLenum format = 0;
+
     // Fill our openGL side texture object.
-    for (GLuint i = 0; i < filePaths.size(); i++)
+    for (GLuint i = 0; i < faces.size(); i++)
     {
-        // Load the face and convet it to 32 bit.
-        FIBITMAP* bitmap = FreeImage_ConvertTo32Bits(FreeImage_Load(FreeImage_GetFileType(filePaths[i]), filePaths[i]));
+        DecodedImage& face = faces[i];
+        if (!face.m_loaded)
+        {
+            continue;
+        }
+
+        GLenum faceFormat = face.IsCompressed() ? face.m_compressed.m_internalFormat : GL_RGBA8;
+        if (face.m_width != face.m_height || (format != 0 && (face.m_width != m_size || faceFormat != format)))
+        {
+            std::cout << "Cube map face " << face.m_filePath << " doesn't match the other faces, it was skipped." << std::endl;
+            continue;
+        }
+        format = faceFormat;
+
+        // DDS and KTX2 faces are uploaded still compressed, one call per mip level.
+        if (face.IsCompressed())
+        {
+            CompressedImage& image = face.m_compressed;
+            for (unsigned int level = 0; level < image.m_levels.size(); level++)
+            {
+                unsigned int levelWidth = image.m_width >> level;
+                unsigned int levelHeight = image.m_height >> level;
+                glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, image.m_internalFormat,
+                    levelWidth > 0 ? levelWidth : 1, levelHeight > 0 ? levelHeight : 1, 0, image.m_levels[level].size(), image.m_levels[level].data());
+            }
+            levels = (levels == 0 || image.m_levels.size() < levels) ? image.m_levels.size() : levels;
+            m_size = image.m_width;
+            continue;
+        }
 
         // Load the image into OpenGL memory.
         // GL_TEXTURE_CUBE_MAP_POSITIVE_X indicates the side of the skybox. Incrementing that value gives us the constant used by each side.
-        glTexImage2D( GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA8, FreeImage_GetWidth(bitmap), FreeImage_GetHeight(bitmap),
-            0, GL_BGRA, GL_UNSIGNED_BYTE, static_cast<void*>(FreeImage_GetBits(bitmap)));
-
-        // We can unload the image now.
-        FreeImage_Unload(bitmap);
+        glTexImage2D( GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA8, face.m_width, face.m_height,
+            0, GL_BGRA, GL_UNSIGNED_BYTE, face.m_pixels.data());
+        levels = 1;
+        m_size = face.m_width;
     }
 
+    m_internalFormat = format != 0 ? format : GL_RGBA8;
+    m_levels = levels > 0 ? levels : 1;
+
     // Set sampler parameters on our cube map.
     // These make sure the texture doesn't look pixelated.
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, levels > 0 ? levels - 1 : 0);
     // These prevent artifacts from appearing near the edges.
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -68,6 +108,41 @@ CubeMap::CubeMap(std::vector<char*> filePaths)
     glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
+CubeMap::CubeMap(glm::vec4 color)
+{
+    unsigned char texel[4];
+    for (int i = 0; i < 4; i++)
+    {
+        texel[i] = (unsigned char)(glm::clamp(color[i], 0.0f, 1.0f) * 255 + .5f);
+    }
+
+    glGenTextures(1, &m_cubeMap);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubeMap);
+    for (GLuint i = 0; i < 6; i++)
+    {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+CubeMap::CubeMap(unsigned int size, unsigned int count, GLenum internalFormat)
+{
+    m_size = size;
+    m_target = GL_TEXTURE_CUBE_MAP_ARRAY;
+
+    glGenTextures(1, &m_cubeMap);
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, m_cubeMap);
+    glTexStorage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 1, internalFormat, size, size, count * 6);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+}
+
 CubeMap::~CubeMap()
 {
     glDeleteTextures(1, &m_cubeMap);
@@ -91,3 +166,57 @@ GLuint CubeMap::GetGLCubeMap()
 {
     return m_cubeMap;
 }
+
+GLenum CubeMap::GetGLTarget()
+{
+    return m_target;
+}
+
+void CubeMap::Allocate(unsigned int size, GLenum internalFormat, unsigned int levels)
+{
+    // Storage from glTexStorage2D can't change size or format, so start over with a new texture.
+    glDeleteTextures(1, &m_cubeMap);
+    glGenTextures(1, &m_cubeMap);
+    m_size = size;
+    m_internalFormat = internalFormat;
+    m_levels = levels;
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubeMap);
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, levels, internalFormat, size, size);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+unsigned int CubeMap::GetSize()
+{
+    return m_size;
+}
+
+GLenum CubeMap::GetInternalFormat()
+{
+    return m_internalFormat;
+}
+
+unsigned int CubeMap::GetLevelCount()
+{
+    return m_levels;
+}
+
+unsigned int CubeMap::GetRefCount()
+{
+    return m_refCount;
+}
+
+unsigned long long CubeMap::GetMemorySize()
+{
+    // Arrays count every face as a layer. Otherwise every face has the same size and format, so measure one and multiply.
+    glBindTexture(m_target, m_cubeMap);
+    unsigned long long size = m_target == GL_TEXTURE_CUBE_MAP_ARRAY ? Texture::GetBoundMemorySize(GL_TEXTURE_CUBE_MAP_ARRAY)
+        : Texture::GetBoundMemorySize(GL_TEXTURE_CUBE_MAP_POSITIVE_X) * 6;
+    glBindTexture(m_target, 0);
+    return size;
+}
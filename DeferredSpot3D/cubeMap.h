@@ -26,20 +26,51 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "GL/glew.h"
 #include "GLFW/glfw3.h"
 #include "FreeImage.h"
+#include "glm/glm.hpp"
 #include <iostream>
 #include <vector>
 
+#include "imageDecoder.h"
+#include "texture.h"
+
 class CubeMap
 {
 private:
     GLuint m_cubeMap;
     unsigned int m_refCount = 0;
 
+    // Width (and height) of each face, 0 for a placeholder.
+    unsigned int m_size = 0;
+    // What Allocate made the storage with.
+    GLenum m_internalFormat = GL_RGBA8;
+    unsigned int m_levels = 1;
+
+    // GL_TEXTURE_CUBE_MAP, or GL_TEXTURE_CUBE_MAP_ARRAY for an array of cube maps.
+    GLenum m_target = GL_TEXTURE_CUBE_MAP;
+
 public:
     CubeMap(std::vector<char*> filePaths);
+    // Creates a cube map with 1x1 faces of a single color, to stand in for one that hasn't loaded yet.
+    CubeMap(glm::vec4 color);
+    // Creates an empty array of cube maps (GL_TEXTURE_CUBE_MAP_ARRAY) to render into, with one mip level.
+    // Layer n of the array is face n % 6 of cube map n / 6.
+    CubeMap(unsigned int size, unsigned int count, GLenum internalFormat);
     ~CubeMap();
     void IncRefCount();
     void DecRefCount();
     GLuint GetGLCubeMap();
+    // What to bind the texture to.
+    GLenum GetGLTarget();
+
+    // Replaces the cube map with new, empty storage (glTexStorage2D) for six square faces to be uploaded into.
+    // The GL texture name changes.
+    void Allocate(unsigned int size, GLenum internalFormat, unsigned int levels);
+    unsigned int GetSize();
+    GLenum GetInternalFormat();
+    unsigned int GetLevelCount();
+
+    // How many references are held, and how much GPU memory all six faces take up.
+    unsigned int GetRefCount();
+    unsigned long long GetMemorySize();
 
 };
\ No newline at end of file
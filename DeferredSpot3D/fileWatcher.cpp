@@ -0,0 +1,165 @@
+/*
+Title: Deferred Spot Lighting
+File Name: fileWatcher.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "fileWatcher.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <chrono>
+#endif
+
+FileWatcher::FileWatcher(std::string directory)
+{
+    m_directory = directory;
+    if (m_directory.size() > 0 && m_directory.back() != '/' && m_directory.back() != '\\')
+    {
+        m_directory += '/';
+    }
+
+#ifdef __linux__
+    // Only report files that were written and closed (or moved in, which is how many editors save),
+    // so we never read a half written file.
+    m_inotify = inotify_init1(IN_NONBLOCK);
+    if (m_inotify == -1 || inotify_add_watch(m_inotify, m_directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1)
+    {
+        std::cout << "Can't watch directory: " << m_directory << std::endl;
+    }
+#endif
+
+    m_running = true;
+    m_thread = std::thread(&FileWatcher::Run, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    // The thread wakes up at least every few hundred milliseconds to check this.
+    m_running = false;
+    m_thread.join();
+
+#ifdef __linux__
+    if (m_inotify != -1)
+    {
+        close(m_inotify);
+    }
+#endif
+}
+
+void FileWatcher::AddFile(std::string filePath)
+{
+#ifndef __linux__
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_modifiedTimes.count(filePath) == 0)
+    {
+        struct stat info;
+        m_modifiedTimes[filePath] = (stat(filePath.c_str(), &info) == 0) ? (long long)info.st_mtime : 0;
+    }
+#else
+    // inotify already watches every file in the directory.
+    (void)filePath;
+#endif
+}
+
+std::vector<std::string> FileWatcher::TakeChangedFiles()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::string> changed;
+    changed.swap(m_changed);
+    return changed;
+}
+
+void FileWatcher::AddChange(std::string filePath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (unsigned int i = 0; i < m_changed.size(); i++)
+    {
+        if (m_changed[i] == filePath)
+        {
+            return;
+        }
+    }
+    m_changed.push_back(filePath);
+}
+
+void FileWatcher::Run()
+{
+    while (m_running)
+    {
+#ifdef __linux__
+        if (m_inotify == -1)
+        {
+            return;
+        }
+
+        // Sleep until there's an event, but wake up now and then to see if we should stop.
+        pollfd descriptor = { m_inotify, POLLIN, 0 };
+        if (poll(&descriptor, 1, 200) <= 0)
+        {
+            continue;
+        }
+
+        // Read every event that's waiting. Each one is followed by the file name.
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* p = buffer; p < buffer + length;)
+            {
+                inotify_event* event = (inotify_event*)p;
+                if (event->len > 0)
+                {
+                    AddChange(m_directory + event->name);
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+        // Copy the list so the main thread can keep adding files while we check them.
+        std::map<std::string, long long> times;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            times = m_modifiedTimes;
+        }
+
+        for (std::map<std::string, long long>::iterator it = times.begin(); it != times.end(); it++)
+        {
+            struct stat info;
+            if (stat(it->first.c_str(), &info) == 0 && (long long)info.st_mtime != it->second)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_modifiedTimes[it->first] = (long long)info.st_mtime;
+                }
+                AddChange(it->first);
+            }
+        }
+#endif
+    }
+}
@@ -0,0 +1,71 @@
+/*
+Title: Deferred Spot Lighting
+File Name: fileWatcher.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+
+// Watches a directory for files being written, on a background thread.
+// The main thread picks up the names of changed files with TakeChangedFiles, whenever it's convenient.
+//
+// On Linux this uses inotify, so the thread just sleeps until the kernel says something changed.
+// Elsewhere it checks the modification time of every file given to AddFile a few times a second.
+class FileWatcher
+{
+public:
+    FileWatcher(std::string directory);
+    ~FileWatcher();
+
+    // A file to check when inotify isn't available. With inotify the whole directory is already watched.
+    void AddFile(std::string filePath);
+
+    // The files that changed since the last call (full paths), each only once.
+    std::vector<std::string> TakeChangedFiles();
+
+private:
+    // The background thread.
+    void Run();
+    void AddChange(std::string filePath);
+
+    std::string m_directory;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+
+    // Everything below is shared with the background thread.
+    std::mutex m_mutex;
+    std::vector<std::string> m_changed;
+
+#ifdef __linux__
+    int m_inotify = -1;
+#else
+    // Last modification time of every file being checked.
+    std::map<std::string, long long> m_modifiedTimes;
+#endif
+};
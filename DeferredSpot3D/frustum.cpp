@@ -0,0 +1,102 @@
+/*
+Title: Deferred Spot Lighting
+File Name: frustum.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "frustum.h"
+
+Frustum::Frustum()
+{
+    for (int i = 0; i < 6; i++)
+    {
+        m_planes[i] = glm::vec4();
+    }
+}
+
+Frustum::Frustum(glm::mat4 viewProjection)
+{
+    // A point is inside the view volume when -w <= x, y, z <= w after projection.
+    // Each of those six inequalities is a plane, made by adding or subtracting a row of the matrix from the last row.
+    // glm matrices are column major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i]).
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+    {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    m_planes[0] = rows[3] + rows[0]; // Left
+    m_planes[1] = rows[3] - rows[0]; // Right
+    m_planes[2] = rows[3] + rows[1]; // Bottom
+    m_planes[3] = rows[3] - rows[1]; // Top
+    m_planes[4] = rows[3] + rows[2]; // Near
+    m_planes[5] = rows[3] - rows[2]; // Far
+
+    // Normalize the planes so that distances are in world units.
+    for (int i = 0; i < 6; i++)
+    {
+        m_planes[i] /= glm::length(glm::vec3(m_planes[i]));
+    }
+}
+
+bool Frustum::IntersectsSphere(glm::vec3 center, float radius)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        // Signed distance from the plane, if it's further outside than the radius the sphere can't be seen.
+        if (glm::dot(glm::vec3(m_planes[i]), center) + m_planes[i].w < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+FrustumTest Frustum::TestBox(glm::vec3 boxMin, glm::vec3 boxMax)
+{
+    FrustumTest result = FRUSTUM_INSIDE;
+    for (int i = 0; i < 6; i++)
+    {
+        // The corner furthest along the plane's normal is the most inside, the opposite corner the most outside.
+        glm::vec3 normal = glm::vec3(m_planes[i]);
+        glm::vec3 inner = glm::mix(boxMin, boxMax, glm::vec3(glm::greaterThan(normal, glm::vec3(0))));
+        glm::vec3 outer = boxMin + boxMax - inner;
+        if (glm::dot(normal, inner) + m_planes[i].w < 0)
+        {
+            return FRUSTUM_OUTSIDE;
+        }
+        if (glm::dot(normal, outer) + m_planes[i].w < 0)
+        {
+            result = FRUSTUM_INTERSECTS;
+        }
+    }
+    return result;
+}
+
+glm::vec4 TransformBoundingSphere(glm::mat4 worldMatrix, glm::vec4 sphere)
+{
+    glm::vec3 center = glm::vec3(worldMatrix * glm::vec4(glm::vec3(sphere), 1));
+
+    // Use the longest basis vector as the scale for the radius.
+    float scale = glm::max(glm::length(glm::vec3(worldMatrix[0])), glm::max(glm::length(glm::vec3(worldMatrix[1])), glm::length(glm::vec3(worldMatrix[2]))));
+
+    return glm::vec4(center, sphere.w * scale);
+}
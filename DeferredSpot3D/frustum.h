@@ -0,0 +1,56 @@
+/*
+Title: Deferred Spot Lighting
+File Name: frustum.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "glm/glm.hpp"
+
+// Where a box is compared to a frustum (Frustum::TestBox).
+enum FrustumTest
+{
+    FRUSTUM_OUTSIDE, // Completely outside one of the planes
+    FRUSTUM_INTERSECTS, // Maybe partly inside
+    FRUSTUM_INSIDE // Inside every plane
+};
+
+// The six planes of a camera's view volume, pulled straight out of a view projection matrix.
+// Each plane is stored as (normal, distance), with the normal pointing into the frustum.
+class Frustum
+{
+public:
+    Frustum();
+    Frustum(glm::mat4 viewProjection);
+
+    // Returns false only if the sphere is completely outside one of the planes.
+    bool IntersectsSphere(glm::vec3 center, float radius);
+
+    // Tests an axis aligned box. Like the sphere, it's only outside if it's completely outside one plane,
+    // so a box near a corner can be called intersecting when it isn't.
+    FrustumTest TestBox(glm::vec3 boxMin, glm::vec3 boxMax);
+
+    glm::vec4 m_planes[6];
+};
+
+// Moves a bounding sphere (xyz = center, w = radius) from model space to world space.
+// The radius is scaled by the largest axis of the matrix, so non uniform scale is still covered.
+glm::vec4 TransformBoundingSphere(glm::mat4 worldMatrix, glm::vec4 sphere);
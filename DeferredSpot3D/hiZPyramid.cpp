@@ -0,0 +1,490 @@
+/*
+Title: Deferred Spot Lighting
+File Name: hiZPyramid.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hiZPyramid.h"
+#include "selfTest.h"
+
+// Must match local_size_x and local_size_y in hiZBuildComp.glsl
+#define HIZ_GROUP_SIZE 8
+
+HiZPyramid::HiZPyramid(unsigned int width, unsigned int height)
+{
+    m_width = width;
+    m_height = height;
+    m_levels = GetLevelCount(width, height);
+
+    // One 32 bit float channel per texel, with every mip level. We only ever use texelFetch, so sample mode doesn't matter much.
+    m_texture = new Texture(width, height, GL_R32F, GL_RED, GL_FLOAT, GL_NEAREST_MIPMAP_NEAREST, m_levels);
+    m_texture->IncRefCount();
+
+    m_buildProgram = new ShaderProgram();
+    m_buildProgram->AttachShader(new Shader("../Assets/hiZBuildComp.glsl", GL_COMPUTE_SHADER));
+    m_buildProgram->IncRefCount();
+
+    // Bind once to link the program so we can look up the uniforms.
+    m_buildProgram->Bind();
+    ResolveUniforms();
+    m_buildProgram->Unbind();
+}
+
+HiZPyramid::~HiZPyramid()
+{
+    m_texture->DecRefCount();
+    m_buildProgram->DecRefCount();
+}
+
+void HiZPyramid::ResolveUniforms()
+{
+    m_sourceLevelUniform = glGetUniformLocation(m_buildProgram->GetGLShaderProgram(), "sourceLevel");
+    m_sourceDepthUniform = glGetUniformLocation(m_buildProgram->GetGLShaderProgram(), "sourceDepth");
+    m_resolvedGeneration = m_buildProgram->GetGeneration();
+}
+
+void HiZPyramid::Resize(unsigned int width, unsigned int height)
+{
+    m_width = width;
+    m_height = height;
+    m_levels = GetLevelCount(width, height);
+    m_texture->Resize(width, height, GL_R32F, GL_RED, GL_FLOAT, m_levels);
+
+    // The old contents don't match the new size, so don't let anyone test against them.
+    m_valid = false;
+}
+
+void HiZPyramid::Build(Texture* depthTexture)
+{
+    m_buildProgram->Bind();
+
+    // The hot reloader may have swapped in a rebuilt program, with its uniforms somewhere else.
+    if (m_buildProgram->GetGeneration() != m_resolvedGeneration)
+    {
+        ResolveUniforms();
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(m_sourceDepthUniform, 0);
+
+    for (unsigned int level = 0; level < m_levels; level++)
+    {
+        if (level == 0)
+        {
+            // The first level is a straight copy of the depth buffer.
+            glBindTexture(GL_TEXTURE_2D, depthTexture->GetGLTexture());
+            glUniform1i(m_sourceLevelUniform, -1);
+        }
+        else
+        {
+            // Every other level reads the level above it.
+            glBindTexture(GL_TEXTURE_2D, m_texture->GetGLTexture());
+            glUniform1i(m_sourceLevelUniform, level - 1);
+        }
+
+        // Write into this level through an image unit.
+        glBindImageTexture(0, m_texture->GetGLTexture(), level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+        unsigned int levelWidth = glm::max(m_width >> level, 1u);
+        unsigned int levelHeight = glm::max(m_height >> level, 1u);
+        glDispatchCompute((levelWidth + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (levelHeight + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+
+        // The next level reads what this one wrote.
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_buildProgram->Unbind();
+
+    m_valid = true;
+}
+
+bool HiZPyramid::IsValid()
+{
+    return m_valid;
+}
+
+Texture* HiZPyramid::GetTexture()
+{
+    return m_texture;
+}
+
+ShaderProgram* HiZPyramid::GetShaderProgram()
+{
+    return m_buildProgram;
+}
+
+void HiZPyramid::ReadLevel(unsigned int level, std::vector<float>& depth)
+{
+    unsigned int levelWidth = glm::max(m_width >> level, 1u);
+    unsigned int levelHeight = glm::max(m_height >> level, 1u);
+    depth.resize(levelWidth * levelHeight);
+
+    glBindTexture(GL_TEXTURE_2D, m_texture->GetGLTexture());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, level, GL_RED, GL_FLOAT, depth.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+unsigned int HiZPyramid::GetLevelCount(unsigned int width, unsigned int height)
+{
+    unsigned int size = glm::max(width, height);
+    unsigned int levels = 1;
+    while (size > 1)
+    {
+        size >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+
+
+void HiZReference::Build(const std::vector<float>& depth, unsigned int width, unsigned int height)
+{
+    unsigned int levels = HiZPyramid::GetLevelCount(width, height);
+    m_levels.resize(levels);
+    m_sizes.resize(levels);
+
+    // Level 0 is a copy.
+    m_levels[0] = depth;
+    m_sizes[0] = glm::ivec2(width, height);
+
+    for (unsigned int level = 1; level < levels; level++)
+    {
+        glm::ivec2 source = m_sizes[level - 1];
+        glm::ivec2 size = glm::max(source / 2, glm::ivec2(1));
+        m_sizes[level] = size;
+        m_levels[level].resize(size.x * size.y);
+
+        for (int y = 0; y < size.y; y++)
+        {
+            for (int x = 0; x < size.x; x++)
+            {
+                // Normally a texel covers 2x2 texels of the level above.
+                // If the level above has an odd size, the last row and column also cover the texel left over at the edge.
+                int countX = (x == size.x - 1 && source.x > 1 && (source.x & 1) == 1) ? 3 : 2;
+                int countY = (y == size.y - 1 && source.y > 1 && (source.y & 1) == 1) ? 3 : 2;
+
+                float farthest = 0;
+                for (int j = 0; j < countY; j++)
+                {
+                    for (int i = 0; i < countX; i++)
+                    {
+                        int sx = glm::min(x * 2 + i, source.x - 1);
+                        int sy = glm::min(y * 2 + j, source.y - 1);
+                        farthest = glm::max(farthest, m_levels[level - 1][sy * source.x + sx]);
+                    }
+                }
+                m_levels[level][y * size.x + x] = farthest;
+            }
+        }
+    }
+}
+
+bool HiZReference::IsSphereOccluded(glm::vec4 sphere, glm::mat4 viewProjection)
+{
+    if (m_levels.size() == 0)
+    {
+        return false;
+    }
+
+    glm::vec2 uvMin, uvMax;
+    float nearestDepth;
+    if (!ProjectSphereToScreen(viewProjection, sphere, uvMin, uvMax, nearestDepth))
+    {
+        return false;
+    }
+
+    // Find the covered pixels on level 0.
+    glm::ivec2 size0 = m_sizes[0];
+    glm::ivec2 pixelMin = glm::min(glm::ivec2(uvMin * glm::vec2(size0)), size0 - 1);
+    glm::ivec2 pixelMax = glm::min(glm::ivec2(uvMax * glm::vec2(size0)), size0 - 1);
+
+    // Pick the first level where the rectangle is at most 2 texels wide and tall.
+    glm::ivec2 extent = pixelMax - pixelMin;
+    int largest = glm::max(extent.x, extent.y);
+    int level = 0;
+    while ((1 << level) < largest && level < (int)m_levels.size() - 1)
+    {
+        level++;
+    }
+
+    // Read the (up to) four texels that cover the rectangle and keep the farthest.
+    glm::ivec2 levelSize = m_sizes[level];
+    glm::ivec2 a = glm::min(glm::ivec2(pixelMin.x >> level, pixelMin.y >> level), levelSize - 1);
+    glm::ivec2 b = glm::min(glm::ivec2(pixelMax.x >> level, pixelMax.y >> level), levelSize - 1);
+    float farthest = glm::max(glm::max(GetDepth(level, a.x, a.y), GetDepth(level, b.x, a.y)),
+        glm::max(GetDepth(level, a.x, b.y), GetDepth(level, b.x, b.y)));
+
+    // Hidden if even the nearest point is behind everything drawn there.
+    return nearestDepth > farthest;
+}
+
+unsigned int HiZReference::GetLevelCount()
+{
+    return m_levels.size();
+}
+
+glm::ivec2 HiZReference::GetLevelSize(unsigned int level)
+{
+    return m_sizes[level];
+}
+
+float HiZReference::GetDepth(unsigned int level, int x, int y)
+{
+    return m_levels[level][y * m_sizes[level].x + x];
+}
+
+int HiZReference::RunTest()
+{
+    SelfTest test("Hi-Z reference");
+
+    // The same random numbers every run.
+    unsigned int seed = 12345;
+    auto random = [&seed]() {
+        seed = seed * 1664525 + 1013904223;
+        return (seed >> 8) / float(1 << 24);
+    };
+
+    // Every level texel is the farthest of exactly the level 0 pixels under it, odd sizes included.
+    // Pixel p is under texel min(p >> level, last texel), which is what IsSphereOccluded reads.
+    glm::ivec2 sizes[] = { glm::ivec2(8, 8), glm::ivec2(7, 5), glm::ivec2(13, 3), glm::ivec2(1, 9), glm::ivec2(33, 17), glm::ivec2(6, 1) };
+    for (glm::ivec2 size : sizes)
+    {
+        std::vector<float> depth(size.x * size.y);
+        for (unsigned int i = 0; i < depth.size(); i++)
+        {
+            depth[i] = random();
+        }
+
+        HiZReference reference;
+        reference.Build(depth, size.x, size.y);
+        bool levelCount = reference.GetLevelCount() == HiZPyramid::GetLevelCount(size.x, size.y) &&
+            reference.GetLevelSize(reference.GetLevelCount() - 1) == glm::ivec2(1);
+        test.Check(levelCount, "The pyramid doesn't end in a single texel");
+
+        bool exact = true;
+        for (unsigned int level = 1; level < reference.GetLevelCount() && levelCount; level++)
+        {
+            glm::ivec2 levelSize = reference.GetLevelSize(level);
+            std::vector<float> farthest(levelSize.x * levelSize.y, -1.f);
+            for (int y = 0; y < size.y; y++)
+            {
+                for (int x = 0; x < size.x; x++)
+                {
+                    glm::ivec2 texel = glm::min(glm::ivec2(x >> level, y >> level), levelSize - 1);
+                    float& value = farthest[texel.y * levelSize.x + texel.x];
+                    value = glm::max(value, depth[y * size.x + x]);
+                }
+            }
+            for (int y = 0; y < levelSize.y; y++)
+            {
+                for (int x = 0; x < levelSize.x; x++)
+                {
+                    exact = exact && reference.GetDepth(level, x, y) == farthest[y * levelSize.x + x];
+                }
+            }
+        }
+        test.Check(exact, "A level isn't the farthest depth of the pixels under it");
+    }
+
+    // A camera at the origin looking down -z, and the depth a point at some distance in front of it ends up with.
+    glm::mat4 viewProjection = glm::perspective(glm::radians(60.f), 4.f / 3.f, .1f, 100.f);
+    auto depthAt = [&](float distance) {
+        glm::vec4 p = viewProjection * glm::vec4(0, 0, -distance, 1);
+        return p.z / p.w * .5f + .5f;
+    };
+
+    // A wall 10 away fills the screen. Spheres behind it are hidden, spheres in front and crossing it aren't.
+    {
+        glm::ivec2 size(61, 47);
+        std::vector<float> depth(size.x * size.y, depthAt(10));
+        HiZReference reference;
+        reference.Build(depth, size.x, size.y);
+
+        test.Check(reference.IsSphereOccluded(glm::vec4(0, 0, -20, 1), viewProjection), "A small sphere behind a wall wasn't rejected");
+        test.Check(reference.IsSphereOccluded(glm::vec4(3, -2, -40, 10), viewProjection), "A large sphere behind a wall wasn't rejected");
+        test.Check(!reference.IsSphereOccluded(glm::vec4(0, 0, -5, 1), viewProjection), "A sphere in front of a wall was rejected");
+        test.Check(!reference.IsSphereOccluded(glm::vec4(1, 1, -10.5f, 1), viewProjection), "A sphere through a wall was rejected");
+        test.Check(!reference.IsSphereOccluded(glm::vec4(0, 0, 0, 1), viewProjection), "A sphere around the camera was rejected");
+
+        // A hole one pixel wide in the last column of the odd sized buffer lets a sphere behind it be seen.
+        for (int y = 0; y < size.y; y++)
+        {
+            depth[y * size.x + size.x - 1] = 1;
+        }
+        reference.Build(depth, size.x, size.y);
+        test.Check(!reference.IsSphereOccluded(glm::vec4(7.5f, 0, -20, 1), viewProjection), "A sphere behind a hole at the odd edge was rejected");
+        test.Check(reference.IsSphereOccluded(glm::vec4(-7.5f, 0, -20, 1), viewProjection), "A sphere away from the hole wasn't rejected");
+    }
+
+    // Random blocks at random depths, and random spheres. A sphere that is in front of any pixel it covers is never
+    // rejected, and enough of the others are.
+    {
+        glm::ivec2 size(101, 67);
+        std::vector<float> depth(size.x * size.y, 1);
+        for (int block = 0; block < 40; block++)
+        {
+            glm::ivec2 a = glm::ivec2(random() * size.x, random() * size.y);
+            glm::ivec2 b = glm::min(a + glm::ivec2(random() * 40, random() * 40), size - 1);
+            float blockDepth = depthAt(2 + random() * 30);
+            for (int y = a.y; y <= b.y; y++)
+            {
+                for (int x = a.x; x <= b.x; x++)
+                {
+                    depth[y * size.x + x] = glm::min(depth[y * size.x + x], blockDepth);
+                }
+            }
+        }
+        HiZReference reference;
+        reference.Build(depth, size.x, size.y);
+
+        int hidden = 0;
+        int rejected = 0;
+        bool visibleKept = true;
+        for (int i = 0; i < 2000; i++)
+        {
+            float distance = 1 + random() * 60;
+            glm::vec4 sphere(glm::vec2(random() - .5f, random() - .5f) * distance, -distance, .1f + random() * 3);
+
+            glm::vec2 uvMin, uvMax;
+            float nearestDepth;
+            bool occluded = reference.IsSphereOccluded(sphere, viewProjection);
+            if (!ProjectSphereToScreen(viewProjection, sphere, uvMin, uvMax, nearestDepth))
+            {
+                visibleKept = visibleKept && !occluded;
+                continue;
+            }
+
+            // Every pixel the sphere's rectangle touches.
+            glm::ivec2 pixelMin = glm::min(glm::ivec2(uvMin * glm::vec2(size)), size - 1);
+            glm::ivec2 pixelMax = glm::min(glm::ivec2(uvMax * glm::vec2(size)), size - 1);
+            bool visible = false;
+            for (int y = pixelMin.y; y <= pixelMax.y; y++)
+            {
+                for (int x = pixelMin.x; x <= pixelMax.x; x++)
+                {
+                    visible = visible || nearestDepth <= depth[y * size.x + x];
+                }
+            }
+
+            visibleKept = visibleKept && !(visible && occluded);
+            hidden += visible ? 0 : 1;
+            rejected += occluded ? 1 : 0;
+        }
+        test.Check(visibleKept, "A sphere that could be seen was rejected");
+        test.Check(hidden > 0 && rejected * 2 > hidden, "Less than half of the hidden spheres were rejected");
+    }
+
+    return test.Finish();
+}
+
+int HiZPyramid::RunTest()
+{
+    SelfTest test("Hi-Z pyramid (GPU)");
+
+    unsigned int seed = 12345;
+    auto random = [&seed]() {
+        seed = seed * 1664525 + 1013904223;
+        return (seed >> 8) / float(1 << 24);
+    };
+
+    glm::uvec2 sizes[] = { glm::uvec2(64, 64), glm::uvec2(61, 47), glm::uvec2(13, 3), glm::uvec2(1, 9), glm::uvec2(1280, 721) };
+    for (glm::uvec2 size : sizes)
+    {
+        std::vector<float> depth(size.x * size.y);
+        for (unsigned int i = 0; i < depth.size(); i++)
+        {
+            depth[i] = random();
+        }
+
+        // A float texture stands in for the depth buffer, the shader only reads its first channel.
+        Texture* depthTexture = new Texture(size.x, size.y, GL_R32F, GL_RED, GL_FLOAT, GL_NEAREST, 1);
+        depthTexture->IncRefCount();
+        glBindTexture(GL_TEXTURE_2D, depthTexture->GetGLTexture());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y, GL_RED, GL_FLOAT, depth.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        HiZPyramid pyramid(size.x, size.y);
+        pyramid.Build(depthTexture);
+        HiZReference reference;
+        reference.Build(depth, size.x, size.y);
+
+        for (unsigned int level = 0; level < reference.GetLevelCount(); level++)
+        {
+            std::vector<float> gpu;
+            pyramid.ReadLevel(level, gpu);
+            glm::ivec2 levelSize = reference.GetLevelSize(level);
+
+            bool same = gpu.size() == (unsigned int)(levelSize.x * levelSize.y);
+            for (int y = 0; y < levelSize.y && same; y++)
+            {
+                for (int x = 0; x < levelSize.x && same; x++)
+                {
+                    same = gpu[y * levelSize.x + x] == reference.GetDepth(level, x, y);
+                }
+            }
+            if (!same)
+            {
+                test.Fail() << size.x << "x" << size.y << " level " << level << " doesn't match the CPU" << std::endl;
+            }
+        }
+
+        depthTexture->DecRefCount();
+    }
+
+    return test.Finish();
+}
+
+
+
+bool ProjectSphereToScreen(glm::mat4 viewProjection, glm::vec4 sphere, glm::vec2& uvMin, glm::vec2& uvMax, float& nearestDepth)
+{
+    uvMin = glm::vec2(1);
+    uvMax = glm::vec2(0);
+    nearestDepth = 1;
+
+    // Project all 8 corners of the sphere's bounding box.
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec3 corner = glm::vec3(sphere) + sphere.w * glm::vec3((i & 1) * 2 - 1, ((i >> 1) & 1) * 2 - 1, ((i >> 2) & 1) * 2 - 1);
+        glm::vec4 p = viewProjection * glm::vec4(corner, 1);
+
+        // A corner behind the camera would flip the rectangle inside out.
+        if (p.w <= .0001f)
+        {
+            return false;
+        }
+
+        glm::vec3 ndc = glm::vec3(p) / p.w;
+        uvMin = glm::min(uvMin, glm::vec2(ndc) * .5f + .5f);
+        uvMax = glm::max(uvMax, glm::vec2(ndc) * .5f + .5f);
+        nearestDepth = glm::min(nearestDepth, ndc.z * .5f + .5f);
+    }
+
+    uvMin = glm::clamp(uvMin, glm::vec2(0), glm::vec2(1));
+    uvMax = glm::clamp(uvMax, glm::vec2(0), glm::vec2(1));
+    return true;
+}
@@ -0,0 +1,115 @@
+/*
+Title: Deferred Spot Lighting
+File Name: hiZPyramid.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <vector>
+#include <iostream>
+
+#include "shaderProgram.h"
+#include "texture.h"
+
+// A hierarchical depth buffer (Hi-Z).
+// Level 0 is a copy of the depth buffer, and every level after that stores the farthest depth
+// of the texels below it. Any object whose nearest point is farther away than the farthest depth
+// in the region it covers must be hidden, and only a handful of texels need to be read to find out,
+// no matter how big the object is on screen.
+class HiZPyramid
+{
+public:
+    HiZPyramid(unsigned int width, unsigned int height);
+    ~HiZPyramid();
+
+    // Must be called when the depth buffer changes size. The pyramid is invalid until the next Build.
+    void Resize(unsigned int width, unsigned int height);
+
+    // Builds every level from the depth texture (which must be the same size as the pyramid).
+    void Build(Texture* depthTexture);
+
+    // False until the pyramid has been built at least once at the current size.
+    bool IsValid();
+
+    Texture* GetTexture();
+
+    // The compute shader that builds the levels, to hand to the ShaderHotReloader.
+    ShaderProgram* GetShaderProgram();
+
+    // Copies a level back from the GPU, row by row starting at the bottom. Slow, only for checking the pyramid.
+    void ReadLevel(unsigned int level, std::vector<float>& depth);
+
+    // Number of levels needed to reduce a width x height image to 1x1.
+    static unsigned int GetLevelCount(unsigned int width, unsigned int height);
+
+    // Builds pyramids of even and odd sizes with hiZBuildComp.glsl, reads every level back and compares it to
+    // HiZReference. Needs an OpenGL context.
+    static int RunTest();
+
+private:
+    // Looks the uniforms up in the program as it is now. Done again whenever the program is rebuilt.
+    void ResolveUniforms();
+
+    Texture* m_texture;
+    ShaderProgram* m_buildProgram;
+
+    unsigned int m_width;
+    unsigned int m_height;
+    unsigned int m_levels;
+    bool m_valid = false;
+
+    GLint m_sourceLevelUniform;
+    GLint m_sourceDepthUniform;
+    unsigned int m_resolvedGeneration = 0;
+};
+
+// The same pyramid built and tested on the CPU.
+// hiZBuildComp.glsl and the isSphereOccluded function in the shaders follow this code exactly.
+class HiZReference
+{
+public:
+    // depth is width * height values, row by row starting at the bottom (the same order glReadPixels uses).
+    void Build(const std::vector<float>& depth, unsigned int width, unsigned int height);
+
+    // Returns true if a world space sphere (xyz = center, w = radius) is completely hidden.
+    bool IsSphereOccluded(glm::vec4 sphere, glm::mat4 viewProjection);
+
+    unsigned int GetLevelCount();
+    glm::ivec2 GetLevelSize(unsigned int level);
+    float GetDepth(unsigned int level, int x, int y);
+
+    // Checks the levels of even and odd sized depth buffers, and that hidden spheres are rejected and visible ones
+    // never are.
+    static int RunTest();
+
+private:
+    std::vector<std::vector<float>> m_levels;
+    std::vector<glm::ivec2> m_sizes;
+};
+
+// Projects the bounding box of a world space sphere to the screen.
+// Outputs the covered rectangle in 0-1 screen coordinates, and the nearest depth (0-1, like the depth buffer).
+// Returns false if any part of the box is behind the camera, in which case nothing can be said about occlusion.
+bool ProjectSphereToScreen(glm::mat4 viewProjection, glm::vec4 sphere, glm::vec2& uvMin, glm::vec2& uvMax, float& nearestDepth);
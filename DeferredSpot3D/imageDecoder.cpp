@@ -0,0 +1,108 @@
+/*
+Title: Deferred Spot Lighting
+File Name: imageDecoder.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "imageDecoder.h"
+
+bool ImageDecoder::Decode(const char* filePath, DecodedImage& image)
+{
+    image.m_filePath = filePath;
+    image.m_loaded = false;
+
+    // Block compressed files are read as they are.
+    if (CompressedImage::IsCompressedFile(filePath))
+    {
+        if (!image.m_compressed.Load(filePath))
+        {
+            return false;
+        }
+        image.m_width = image.m_compressed.m_width;
+        image.m_height = image.m_compressed.m_height;
+        image.m_loaded = true;
+        return true;
+    }
+
+    // Load the file.
+    FREE_IMAGE_FORMAT fileType = FreeImage_GetFileType(filePath);
+    FIBITMAP* bitmap = fileType == FIF_UNKNOWN ? nullptr : FreeImage_Load(fileType, filePath);
+    if (bitmap == nullptr)
+    {
+        std::cout << "Could not load " << filePath << std::endl;
+        return false;
+    }
+
+    // Convert the file to 32 bits so we can use it. The original isn't needed after this.
+    FIBITMAP* bitmap32 = FreeImage_ConvertTo32Bits(bitmap);
+    FreeImage_Unload(bitmap);
+
+    image.m_width = FreeImage_GetWidth(bitmap32);
+    image.m_height = FreeImage_GetHeight(bitmap32);
+
+    // 32 bit rows are already 4 byte aligned, so there is no padding between them.
+    unsigned char* bits = FreeImage_GetBits(bitmap32);
+    image.m_pixels.assign(bits, bits + image.m_width * image.m_height * 4);
+
+    FreeImage_Unload(bitmap32);
+    image.m_loaded = true;
+    return true;
+}
+
+void ImageDecoder::DecodeAll(const std::vector<char*>& filePaths, std::vector<DecodedImage>& images)
+{
+    images.clear();
+    images.resize(filePaths.size());
+
+    // Each worker keeps taking the next file nobody has started yet, until there are none left.
+    // That way one big file doesn't hold up a whole group of small ones.
+    std::atomic<unsigned int> next(0);
+    auto work = [&]()
+    {
+        for (unsigned int i = next++; i < filePaths.size(); i = next++)
+        {
+            Decode(filePaths[i], images[i]);
+        }
+    };
+
+    unsigned int threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+    if (threadCount > filePaths.size())
+    {
+        threadCount = filePaths.size();
+    }
+
+    // The calling thread does its share too.
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < threadCount; i++)
+    {
+        threads.push_back(std::thread(work));
+    }
+    work();
+
+    for (unsigned int i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+}
@@ -0,0 +1,65 @@
+/*
+Title: Deferred Spot Lighting
+File Name: imageDecoder.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "FreeImage.h"
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <iostream>
+
+#include "compressedImage.h"
+
+// An image file loaded into memory, ready to be copied into a texture.
+struct DecodedImage
+{
+    std::string m_filePath;
+    bool m_loaded = false;
+
+    unsigned int m_width = 0;
+    unsigned int m_height = 0;
+
+    // 4 bytes per texel in bgra order, bottom row first (what FreeImage gives us and glTexImage2D wants).
+    std::vector<unsigned char> m_pixels;
+
+    // DDS and KTX2 files stay compressed, and fill this in instead of m_pixels.
+    CompressedImage m_compressed;
+
+    bool IsCompressed() { return m_compressed.m_internalFormat != 0; }
+};
+
+// Reads and decodes image files on the CPU, without touching OpenGL, so it can run on any thread.
+// Decoding a png is mostly inflating and unfiltering it, which is slow and doesn't depend on anything else,
+// so a batch of files is split across worker threads. The textures are then created on the main thread in one go.
+class ImageDecoder
+{
+public:
+    // Decodes a single file. Returns false (and prints why) if it couldn't be loaded.
+    static bool Decode(const char* filePath, DecodedImage& image);
+
+    // Decodes every file, on up to one thread per core. Returns once they are all done.
+    // images[i] is the result for filePaths[i], check m_loaded to see if it worked.
+    static void DecodeAll(const std::vector<char*>& filePaths, std::vector<DecodedImage>& images);
+};
@@ -0,0 +1,375 @@
+/*
+Title: Deferred Spot Lighting
+File Name: instanceCuller.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "instanceCuller.h"
+#include "selfTest.h"
+
+// Must match local_size_x in cullInstancesComp.glsl
+#define CULL_GROUP_SIZE 64
+
+InstanceCuller::InstanceCuller()
+{
+    // The compute shader is the only shader in its program.
+    m_cullProgram = new ShaderProgram();
+    m_cullProgram->AttachShader(new Shader("../Assets/cullInstancesComp.glsl", GL_COMPUTE_SHADER));
+    m_cullProgram->IncRefCount();
+
+    // Bind once to link the program so we can look up the uniforms.
+    m_cullProgram->Bind();
+    ResolveUniforms();
+    m_cullProgram->Unbind();
+
+    glGenBuffers(1, &m_visibleInstanceBuffer);
+    glGenBuffers(1, &m_drawIdBuffer);
+    glGenBuffers(1, &m_boundingSphereBuffer);
+}
+
+InstanceCuller::~InstanceCuller()
+{
+    m_cullProgram->DecRefCount();
+    glDeleteBuffers(1, &m_visibleInstanceBuffer);
+    glDeleteBuffers(1, &m_drawIdBuffer);
+    glDeleteBuffers(1, &m_boundingSphereBuffer);
+}
+
+void InstanceCuller::ResolveUniforms()
+{
+    m_planesUniform = glGetUniformLocation(m_cullProgram->GetGLShaderProgram(), "frustumPlanes");
+    m_instanceCountUniform = glGetUniformLocation(m_cullProgram->GetGLShaderProgram(), "instanceCount");
+    m_useHiZUniform = glGetUniformLocation(m_cullProgram->GetGLShaderProgram(), "useHiZ");
+    m_hiZUniform = glGetUniformLocation(m_cullProgram->GetGLShaderProgram(), "hiZ");
+    m_hiZViewProjectionUniform = glGetUniformLocation(m_cullProgram->GetGLShaderProgram(), "hiZViewProjection");
+    m_resolvedGeneration = m_cullProgram->GetGeneration();
+}
+
+void InstanceCuller::SetViewProjection(glm::mat4 viewProjection)
+{
+    m_frustum = Frustum(viewProjection);
+}
+
+void InstanceCuller::SetOcclusion(HiZPyramid* hiZ, glm::mat4 hiZViewProjection)
+{
+    m_hiZ = hiZ;
+    m_hiZViewProjection = hiZViewProjection;
+}
+
+void InstanceCuller::Cull(DrawCommandList& commandList, GLuint instanceBuffer, GLuint indirectBuffer)
+{
+    std::vector<DrawElementsIndirectCommand>& commands = commandList.GetCommands();
+    std::vector<GLuint>& drawIds = commandList.GetDrawIds();
+    std::vector<glm::vec4>& spheres = commandList.GetBoundingSpheres();
+    unsigned int instanceCount = drawIds.size();
+
+    // Upload the commands with every instance count set to zero.
+    // The compute shader adds one to a command's count for every instance that survives.
+    std::vector<DrawElementsIndirectCommand> emptyCommands = commands;
+    for (unsigned int i = 0; i < emptyCommands.size(); i++)
+    {
+        emptyCommands[i].m_instanceCount = 0;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, indirectBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, emptyCommands.size() * sizeof(DrawElementsIndirectCommand), emptyCommands.data(), GL_STREAM_DRAW);
+
+    // Which command each instance belongs to, and the bounding sphere of each command's mesh.
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawIdBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, drawIds.size() * sizeof(GLuint), drawIds.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_boundingSphereBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, spheres.size() * sizeof(glm::vec4), spheres.data(), GL_STREAM_DRAW);
+
+    // Only grow the output buffer, there's no need to reallocate it every frame.
+    if (instanceCount > m_visibleCapacity)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visibleInstanceBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, instanceCount * sizeof(glm::mat4), NULL, GL_DYNAMIC_COPY);
+        m_visibleCapacity = instanceCount;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // These binding points match the layout(binding = n) declarations in the compute shader.
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_drawIdBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_boundingSphereBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, indirectBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_visibleInstanceBuffer);
+
+    m_cullProgram->Bind();
+
+    // The hot reloader may have swapped in a rebuilt program, with its uniforms somewhere else.
+    if (m_cullProgram->GetGeneration() != m_resolvedGeneration)
+    {
+        ResolveUniforms();
+    }
+    glUniform4fv(m_planesUniform, 6, &(m_frustum.m_planes[0][0]));
+    glUniform1ui(m_instanceCountUniform, instanceCount);
+
+    // Only test occlusion once there's a pyramid that matches the screen.
+    bool useHiZ = m_hiZ != nullptr && m_hiZ->IsValid();
+    glUniform1i(m_useHiZUniform, useHiZ ? 1 : 0);
+    if (useHiZ)
+    {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_hiZ->GetTexture()->GetGLTexture());
+        glUniform1i(m_hiZUniform, 0);
+        glUniformMatrix4fv(m_hiZViewProjectionUniform, 1, GL_FALSE, &(m_hiZViewProjection[0][0]));
+    }
+
+    // One invocation per instance.
+    glDispatchCompute((instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    m_cullProgram->Unbind();
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    for (int i = 0; i < 5; i++)
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+    }
+
+    // The draw reads the counts as indirect commands and the matrices as vertex attributes,
+    // make sure the compute shader's writes are finished and visible to both.
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+GLuint InstanceCuller::GetVisibleInstanceBuffer()
+{
+    return m_visibleInstanceBuffer;
+}
+
+ShaderProgram* InstanceCuller::GetShaderProgram()
+{
+    return m_cullProgram;
+}
+
+void InstanceCuller::CullOnCPU(DrawCommandList& commandList, Frustum& frustum,
+    std::vector<DrawElementsIndirectCommand>& outCommands, std::vector<glm::mat4>& outMatrices,
+    HiZReference* hiZ, glm::mat4 hiZViewProjection)
+{
+    std::vector<glm::mat4>& matrices = commandList.GetInstanceMatrices();
+    std::vector<GLuint>& drawIds = commandList.GetDrawIds();
+    std::vector<glm::vec4>& spheres = commandList.GetBoundingSpheres();
+
+    // Start from the same zeroed commands the GPU starts with.
+    outCommands = commandList.GetCommands();
+    for (unsigned int i = 0; i < outCommands.size(); i++)
+    {
+        outCommands[i].m_instanceCount = 0;
+    }
+    outMatrices.resize(matrices.size());
+
+    // This loop body is the compute shader, one iteration per invocation.
+    for (unsigned int i = 0; i < matrices.size(); i++)
+    {
+        GLuint drawId = drawIds[i];
+        glm::vec4 sphere = TransformBoundingSphere(matrices[i], spheres[drawId]);
+
+        bool occluded = hiZ != nullptr && hiZ->IsSphereOccluded(sphere, hiZViewProjection);
+
+        if (frustum.IntersectsSphere(glm::vec3(sphere), sphere.w) && !occluded)
+        {
+            // The atomicAdd in the shader, the slot is the count before adding.
+            GLuint slot = outCommands[drawId].m_instanceCount++;
+            outMatrices[outCommands[drawId].m_baseInstance + slot] = matrices[i];
+        }
+    }
+}
+
+int InstanceCuller::RunTest()
+{
+    SelfTest test("Instance culling (GPU against CPU)");
+
+    // The same random numbers every run.
+    unsigned int seed = 12345;
+    auto random = [&seed]() {
+        seed = seed * 1664525 + 1013904223;
+        return (seed >> 8) / float(1 << 24);
+    };
+
+    glm::mat4 viewProjection = glm::perspective(glm::radians(60.f), 4.f / 3.f, .1f, 100.f) *
+        glm::lookAt(glm::vec3(0, 0, 30), glm::vec3(0), glm::vec3(0, 1, 0));
+    Frustum frustum(viewProjection);
+
+    // A depth buffer of random blocks, an odd size so the edges of the pyramid are folded.
+    glm::ivec2 size(97, 61);
+    std::vector<float> depth(size.x * size.y, 1);
+    std::vector<float> blockDepths;
+    for (int block = 0; block < 30; block++)
+    {
+        glm::ivec2 a = glm::ivec2(random() * size.x, random() * size.y);
+        glm::ivec2 b = glm::min(a + glm::ivec2(random() * 40, random() * 40), size - 1);
+        glm::vec4 p = viewProjection * glm::vec4(0, 0, 25 - random() * 40, 1);
+        blockDepths.push_back(p.z / p.w * .5f + .5f);
+        for (int y = a.y; y <= b.y; y++)
+        {
+            for (int x = a.x; x <= b.x; x++)
+            {
+                depth[y * size.x + x] = glm::min(depth[y * size.x + x], blockDepths.back());
+            }
+        }
+    }
+    HiZReference reference;
+    reference.Build(depth, size.x, size.y);
+
+    Texture* depthTexture = new Texture(size.x, size.y, GL_R32F, GL_RED, GL_FLOAT, GL_NEAREST, 1);
+    depthTexture->IncRefCount();
+    glBindTexture(GL_TEXTURE_2D, depthTexture->GetGLTexture());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y, GL_RED, GL_FLOAT, depth.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    HiZPyramid* hiZ = new HiZPyramid(size.x, size.y);
+    hiZ->Build(depthTexture);
+
+    // Whether float differences between the GPU and CPU could decide a sphere either way:
+    // right at the edge of a plane, of a pixel, or at the depth of a block.
+    auto ambiguous = [&](glm::vec4 sphere) {
+        for (int i = 0; i < 6; i++)
+        {
+            if (glm::abs(glm::dot(glm::vec3(frustum.m_planes[i]), glm::vec3(sphere)) + frustum.m_planes[i].w + sphere.w) < .001f)
+            {
+                return true;
+            }
+        }
+        glm::vec2 uvMin, uvMax;
+        float nearestDepth;
+        if (!ProjectSphereToScreen(viewProjection, sphere, uvMin, uvMax, nearestDepth))
+        {
+            return false;
+        }
+        glm::vec4 edges(uvMin * glm::vec2(size), uvMax * glm::vec2(size));
+        glm::vec4 fraction = edges - glm::floor(edges);
+        if (glm::any(glm::lessThan(fraction, glm::vec4(.01f))) || glm::any(glm::greaterThan(fraction, glm::vec4(.99f))))
+        {
+            return true;
+        }
+        for (float blockDepth : blockDepths)
+        {
+            if (glm::abs(nearestDepth - blockDepth) < .0001f)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Three meshes with spheres off their origins, and instances scattered in and around the view.
+    DrawCommandList list;
+    for (unsigned int mesh = 0; mesh < 3; mesh++)
+    {
+        MeshPoolEntry entry;
+        entry.m_firstVertex = mesh * 100;
+        entry.m_vertexCount = 100;
+        entry.m_firstIndex = mesh * 300;
+        entry.m_indexCount = 300;
+        entry.m_boundingSphere = glm::vec4(mesh * .5f, 0, 0, 1 + mesh);
+        entry.m_inUse = true;
+
+        std::vector<glm::mat4> matrices;
+        while (matrices.size() < 3000)
+        {
+            glm::vec3 position = glm::vec3(random(), random(), random()) * 80.f - 40.f;
+            glm::mat4 world = glm::translate(glm::mat4(), position);
+            world = glm::rotate(world, random() * 6.28f, glm::normalize(glm::vec3(random(), random(), random()) + .1f));
+            world = glm::scale(world, glm::vec3(.2f + random(), .2f + random(), .2f + random()));
+            if (!ambiguous(TransformBoundingSphere(world, entry.m_boundingSphere)))
+            {
+                matrices.push_back(world);
+            }
+        }
+        list.Add(entry, matrices);
+    }
+
+    GLuint instanceBuffer;
+    GLuint indirectBuffer;
+    glGenBuffers(1, &instanceBuffer);
+    glGenBuffers(1, &indirectBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, list.GetInstanceMatrices().size() * sizeof(glm::mat4), list.GetInstanceMatrices().data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    InstanceCuller* culler = new InstanceCuller();
+    culler->SetViewProjection(viewProjection);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        bool occlusion = pass == 1;
+        culler->SetOcclusion(occlusion ? hiZ : nullptr, viewProjection);
+        culler->Cull(list, instanceBuffer, indirectBuffer);
+
+        std::vector<DrawElementsIndirectCommand> expectedCommands;
+        std::vector<glm::mat4> expectedMatrices;
+        CullOnCPU(list, frustum, expectedCommands, expectedMatrices, occlusion ? &reference : nullptr, viewProjection);
+
+        // Read back what the GPU wrote.
+        std::vector<DrawElementsIndirectCommand> commands(expectedCommands.size(), DrawElementsIndirectCommand(0, 0, 0, 0, 0));
+        std::vector<glm::mat4> matrices(list.GetInstanceMatrices().size());
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, indirectBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culler->GetVisibleInstanceBuffer());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, matrices.size() * sizeof(glm::mat4), matrices.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        const char* name = occlusion ? "with Hi-Z" : "frustum only";
+        unsigned int visible = 0;
+        for (unsigned int c = 0; c < commands.size(); c++)
+        {
+            DrawElementsIndirectCommand& gpu = commands[c];
+            DrawElementsIndirectCommand& cpu = expectedCommands[c];
+            if (gpu.m_count != cpu.m_count || gpu.m_firstIndex != cpu.m_firstIndex || gpu.m_baseVertex != cpu.m_baseVertex ||
+                gpu.m_baseInstance != cpu.m_baseInstance || gpu.m_instanceCount != cpu.m_instanceCount)
+            {
+                test.Fail() << name << ": command " << c << " has " << gpu.m_instanceCount << " instances, "
+                    << cpu.m_instanceCount << " expected" << std::endl;
+                continue;
+            }
+            visible += cpu.m_instanceCount;
+
+            // The GPU's order within a command isn't defined, so compare them sorted.
+            auto byPosition = [](const glm::mat4& a, const glm::mat4& b) {
+                return a[3].x != b[3].x ? a[3].x < b[3].x : a[3].y != b[3].y ? a[3].y < b[3].y : a[3].z < b[3].z;
+            };
+            std::vector<glm::mat4>::iterator first = matrices.begin() + cpu.m_baseInstance;
+            std::vector<glm::mat4>::iterator expectedFirst = expectedMatrices.begin() + cpu.m_baseInstance;
+            std::sort(first, first + cpu.m_instanceCount, byPosition);
+            std::sort(expectedFirst, expectedFirst + cpu.m_instanceCount, byPosition);
+            if (!std::equal(first, first + cpu.m_instanceCount, expectedFirst))
+            {
+                test.Fail() << name << ": command " << c << " kept different instances" << std::endl;
+            }
+        }
+
+        // Make sure the test actually culled something and kept something.
+        if (visible == 0 || visible == list.GetInstanceMatrices().size())
+        {
+            test.Fail() << name << ": " << visible << " of " << list.GetInstanceMatrices().size() << " visible, the scene tests nothing" << std::endl;
+        }
+    }
+
+    delete culler;
+    delete hiZ;
+    depthTexture->DecRefCount();
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteBuffers(1, &indirectBuffer);
+
+    return test.Finish();
+}
@@ -0,0 +1,103 @@
+/*
+Title: Deferred Spot Lighting
+File Name: instanceCuller.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "glm/glm.hpp"
+#include <vector>
+#include <iostream>
+
+#include "shaderProgram.h"
+#include "meshPool.h"
+#include "frustum.h"
+#include "hiZPyramid.h"
+
+// Frustum culls instances on the GPU with a compute shader (cullInstancesComp.glsl).
+// Every instance's bounding sphere is tested against the camera frustum, survivors are appended
+// into a compacted instance buffer, and the instance count of each indirect draw command is
+// written by the GPU, so the CPU never has to look at the instances.
+class InstanceCuller
+{
+public:
+    InstanceCuller();
+    ~InstanceCuller();
+
+    // Set the camera used for culling this frame.
+    void SetViewProjection(glm::mat4 viewProjection);
+
+    // Also cull instances hidden behind the depth in a Hi-Z pyramid.
+    // The view projection must be the one the pyramid's depth was rendered with (normally last frame's).
+    // Pass nullptr to turn occlusion culling off.
+    void SetOcclusion(HiZPyramid* hiZ, glm::mat4 hiZViewProjection);
+
+    // Culls every instance in the command list.
+    // instanceBuffer must already hold the list's instance matrices.
+    // The indirect buffer is overwritten with the list's commands, using the GPU's instance counts.
+    void Cull(DrawCommandList& commandList, GLuint instanceBuffer, GLuint indirectBuffer);
+
+    // The buffer of visible instance matrices written by the last Cull.
+    // Each command's visible instances start at its baseInstance, just like the input.
+    GLuint GetVisibleInstanceBuffer();
+
+    // The culling compute shader, to hand to the ShaderHotReloader.
+    ShaderProgram* GetShaderProgram();
+
+    // Does exactly what the compute shader does, on the CPU.
+    // Survivors are written in instance order (the GPU's order within a command is not defined).
+    // hiZ is optional, and stands in for the pyramid given to SetOcclusion.
+    static void CullOnCPU(DrawCommandList& commandList, Frustum& frustum,
+        std::vector<DrawElementsIndirectCommand>& outCommands, std::vector<glm::mat4>& outMatrices,
+        HiZReference* hiZ = nullptr, glm::mat4 hiZViewProjection = glm::mat4());
+
+    // Culls the same random instances with the compute shader and with CullOnCPU, with and without a Hi-Z pyramid,
+    // reads the GPU's commands and matrices back and compares them. Needs an OpenGL context.
+    static int RunTest();
+
+private:
+    // Looks the uniforms up in the program as it is now. Done again whenever the program is rebuilt.
+    void ResolveUniforms();
+
+    ShaderProgram* m_cullProgram;
+
+    Frustum m_frustum;
+
+    HiZPyramid* m_hiZ = nullptr;
+    glm::mat4 m_hiZViewProjection;
+
+    GLuint m_visibleInstanceBuffer;
+    GLuint m_drawIdBuffer;
+    GLuint m_boundingSphereBuffer;
+
+    // How many matrices the visible instance buffer can hold right now.
+    unsigned int m_visibleCapacity = 0;
+
+    // Uniform locations in the compute shader.
+    GLint m_planesUniform;
+    GLint m_instanceCountUniform;
+    GLint m_useHiZUniform;
+    GLint m_hiZUniform;
+    GLint m_hiZViewProjectionUniform;
+    unsigned int m_resolvedGeneration = 0;
+};
@@ -0,0 +1,373 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightArrays.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "lightArrays.h"
+#include "lightBudget.h"
+
+void LightArrays::Clear()
+{
+    std::vector<float>* arrays[] = {
+        &m_positionX, &m_positionY, &m_positionZ, &m_directionX, &m_directionY, &m_directionZ,
+        &m_colorR, &m_colorG, &m_colorB, &m_colorA, &m_attenuationX, &m_attenuationY, &m_attenuationZ, &m_attenuationW,
+        &m_ranges, &m_angles, &m_cosines, &m_exponents, &m_shadowIndices, &m_sideX, &m_sideY, &m_sideZ, &m_profileLayers };
+    for (unsigned int i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++)
+    {
+        arrays[i]->clear();
+    }
+    m_types.clear();
+    m_directionalLights.clear();
+}
+
+void LightArrays::Add(PointLight& light, float shadowIndex)
+{
+    m_positionX.push_back(light.m_position.x);
+    m_positionY.push_back(light.m_position.y);
+    m_positionZ.push_back(light.m_position.z);
+    m_directionX.push_back(0);
+    m_directionY.push_back(0);
+    m_directionZ.push_back(-1);
+    m_colorR.push_back(light.m_color.r);
+    m_colorG.push_back(light.m_color.g);
+    m_colorB.push_back(light.m_color.b);
+    m_colorA.push_back(light.m_color.a);
+    m_attenuationX.push_back(light.m_attenuation.x);
+    m_attenuationY.push_back(light.m_attenuation.y);
+    m_attenuationZ.push_back(light.m_attenuation.z);
+    m_attenuationW.push_back(light.m_attenuation.w);
+    m_ranges.push_back(light.m_radius);
+
+    // A cone that lets everything through, with no falloff.
+    m_angles.push_back(0);
+    m_cosines.push_back(-2);
+    m_exponents.push_back(0);
+
+    m_shadowIndices.push_back(shadowIndex);
+    m_sideX.push_back(1);
+    m_sideY.push_back(0);
+    m_sideZ.push_back(0);
+    m_profileLayers.push_back(-1);
+    m_types.push_back(LIGHT_TYPE_POINT);
+}
+
+void LightArrays::Add(SpotLight& light, float shadowIndex, float profile)
+{
+    // The cone points down -z of its world matrix, and its profile starts from x. The rest of the matrix isn't needed.
+    glm::vec3 position = glm::vec3(light.m_worldMatrix[3]);
+    glm::vec3 direction = glm::normalize(glm::vec3(light.m_worldMatrix * glm::vec4(0, 0, -1, 0)));
+    glm::vec3 side = glm::normalize(glm::vec3(light.m_worldMatrix[0]));
+
+    m_positionX.push_back(position.x);
+    m_positionY.push_back(position.y);
+    m_positionZ.push_back(position.z);
+    m_directionX.push_back(direction.x);
+    m_directionY.push_back(direction.y);
+    m_directionZ.push_back(direction.z);
+    m_colorR.push_back(light.m_color.r);
+    m_colorG.push_back(light.m_color.g);
+    m_colorB.push_back(light.m_color.b);
+    m_colorA.push_back(light.m_color.a);
+    m_attenuationX.push_back(light.m_attenuation.x);
+    m_attenuationY.push_back(light.m_attenuation.y);
+    m_attenuationZ.push_back(light.m_attenuation.z);
+    m_attenuationW.push_back(light.m_attenuation.w);
+    m_ranges.push_back(light.m_range);
+    m_angles.push_back(light.m_angle);
+    m_cosines.push_back(glm::cos(light.m_angle));
+    m_exponents.push_back(light.m_exponent);
+    m_shadowIndices.push_back(shadowIndex);
+    m_sideX.push_back(side.x);
+    m_sideY.push_back(side.y);
+    m_sideZ.push_back(side.z);
+    m_profileLayers.push_back(profile);
+    m_types.push_back(LIGHT_TYPE_SPOT);
+}
+
+void LightArrays::Add(DirectionalLight& light)
+{
+    // Directional lights are few, and light everything the same way. They're kept as they are.
+    m_directionalLights.push_back(light);
+}
+
+unsigned int LightArrays::GetCount()
+{
+    return m_types.size() + m_directionalLights.size();
+}
+
+void LightArrays::SetProfiles(LightProfiles* profiles)
+{
+    m_profiles = profiles;
+}
+
+void LightArrays::Pack(std::vector<LightRecord>& records)
+{
+    records.resize(GetCount());
+    for (unsigned int i = 0; i < m_types.size(); i++)
+    {
+        LightRecord& record = records[i];
+        record.m_positionType = glm::vec4(m_positionX[i], m_positionY[i], m_positionZ[i], m_types[i]);
+        record.m_directionRange = glm::vec4(m_directionX[i], m_directionY[i], m_directionZ[i], m_ranges[i]);
+        record.m_attenuation = glm::vec4(m_attenuationX[i], m_attenuationY[i], m_attenuationZ[i], m_attenuationW[i]);
+        record.m_color = glm::vec4(m_colorR[i], m_colorG[i], m_colorB[i], m_colorA[i]);
+        record.m_coneShadow = glm::vec4(m_angles[i], m_exponents[i], m_shadowIndices[i], m_cosines[i]);
+        record.m_profile = glm::vec4(m_sideX[i], m_sideY[i], m_sideZ[i], m_profileLayers[i]);
+    }
+    for (unsigned int i = 0; i < m_directionalLights.size(); i++)
+    {
+        LightRecord& record = records[m_types.size() + i];
+        record = LightRecord();
+        record.m_positionType.w = LIGHT_TYPE_DIRECTIONAL;
+        record.m_directionRange = glm::vec4(m_directionalLights[i].m_direction, 0);
+        record.m_color = m_directionalLights[i].m_color;
+    }
+}
+
+glm::vec3 LightArrays::EvaluateLight(unsigned int i, glm::vec3 position, glm::vec3 normal)
+{
+    glm::vec3 surfaceToLight = glm::vec3(m_positionX[i], m_positionY[i], m_positionZ[i]) - position;
+    float distance = glm::length(surfaceToLight);
+    glm::vec3 toLight = surfaceToLight / glm::max(distance, 1e-20f);
+
+    float ndotl = glm::clamp(glm::dot(toLight, normal), 0.f, 1.f);
+    float d = glm::clamp(distance / m_ranges[i], 0.f, 1.f);
+    float attenuation = 1 / (m_attenuationX[i] * d * d + m_attenuationY[i] * d + m_attenuationZ[i]) - m_attenuationW[i];
+
+    // Point lights always pass this, and pow(x, 0) is 1.
+    float spotEffect = glm::clamp(-glm::dot(toLight, glm::vec3(m_directionX[i], m_directionY[i], m_directionZ[i])), 0.f, 1.f);
+    if (spotEffect <= m_cosines[i])
+    {
+        return glm::vec3(0);
+    }
+    attenuation *= GetSpotFalloff(i, -toLight, spotEffect);
+
+    return glm::vec3(m_colorR[i], m_colorG[i], m_colorB[i]) * ndotl * attenuation;
+}
+
+float LightArrays::GetSpotFalloff(unsigned int i, glm::vec3 direction, float spotEffect)
+{
+    // The profile's angles, the same as sampleLightProfile in lightTypes.glsl.
+    if (m_profiles != nullptr && m_profileLayers[i] >= 0)
+    {
+        glm::vec3 axis = glm::vec3(m_directionX[i], m_directionY[i], m_directionZ[i]);
+        glm::vec3 side = glm::vec3(m_sideX[i], m_sideY[i], m_sideZ[i]);
+        glm::vec3 up = glm::cross(axis, side);
+        float angle = std::acos(spotEffect);
+        float around = std::atan2(glm::dot(direction, up), glm::dot(direction, side));
+        return LightProfiles::Sample(m_profiles->GetLayer((int)m_profileLayers[i]), angle, around);
+    }
+    return std::pow(spotEffect, m_exponents[i]);
+}
+
+glm::vec3 LightArrays::EvaluateScalar(glm::vec3 position, glm::vec3 normal)
+{
+    glm::vec3 light = glm::vec3(0);
+    for (unsigned int i = 0; i < m_types.size(); i++)
+    {
+        light += EvaluateLight(i, position, normal);
+    }
+    for (unsigned int i = 0; i < m_directionalLights.size(); i++)
+    {
+        light += glm::vec3(m_directionalLights[i].m_color) * glm::clamp(glm::dot(-m_directionalLights[i].m_direction, normal), 0.f, 1.f);
+    }
+    return light;
+}
+
+glm::vec3 LightArrays::Evaluate(glm::vec3 position, glm::vec3 normal)
+{
+    glm::vec3 light = glm::vec3(0);
+    unsigned int first = 0;
+
+#ifdef LIGHT_EVALUATE_SSE
+    __m128 px = _mm_set1_ps(position.x);
+    __m128 py = _mm_set1_ps(position.y);
+    __m128 pz = _mm_set1_ps(position.z);
+    __m128 nx = _mm_set1_ps(normal.x);
+    __m128 ny = _mm_set1_ps(normal.y);
+    __m128 nz = _mm_set1_ps(normal.z);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1);
+    __m128 tiny = _mm_set1_ps(1e-20f);
+    __m128 red = zero;
+    __m128 green = zero;
+    __m128 blue = zero;
+
+    // Four lights at a time, each line is the same line of EvaluateLight for all four.
+    unsigned int groups = m_types.size() / 4;
+    for (unsigned int g = 0; g < groups; g++)
+    {
+        unsigned int i = g * 4;
+        __m128 lx = _mm_sub_ps(_mm_loadu_ps(&m_positionX[i]), px);
+        __m128 ly = _mm_sub_ps(_mm_loadu_ps(&m_positionY[i]), py);
+        __m128 lz = _mm_sub_ps(_mm_loadu_ps(&m_positionZ[i]), pz);
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz)));
+        __m128 inverseDistance = _mm_div_ps(one, _mm_max_ps(distance, tiny));
+        lx = _mm_mul_ps(lx, inverseDistance);
+        ly = _mm_mul_ps(ly, inverseDistance);
+        lz = _mm_mul_ps(lz, inverseDistance);
+
+        __m128 ndotl = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, nx), _mm_mul_ps(ly, ny)), _mm_mul_ps(lz, nz));
+        ndotl = _mm_min_ps(_mm_max_ps(ndotl, zero), one);
+
+        __m128 d = _mm_min_ps(_mm_max_ps(_mm_div_ps(distance, _mm_loadu_ps(&m_ranges[i])), zero), one);
+        __m128 falloff = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(&m_attenuationX[i]), d), d),
+            _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_attenuationY[i]), d), _mm_loadu_ps(&m_attenuationZ[i])));
+        __m128 attenuation = _mm_sub_ps(_mm_div_ps(one, falloff), _mm_loadu_ps(&m_attenuationW[i]));
+
+        __m128 spotEffect = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, _mm_loadu_ps(&m_directionX[i])), _mm_mul_ps(ly, _mm_loadu_ps(&m_directionY[i]))),
+            _mm_mul_ps(lz, _mm_loadu_ps(&m_directionZ[i])));
+        spotEffect = _mm_min_ps(_mm_max_ps(_mm_sub_ps(zero, spotEffect), zero), one);
+        __m128 inCone = _mm_cmpgt_ps(spotEffect, _mm_loadu_ps(&m_cosines[i]));
+
+        // SSE has no pow or texture to sample, so that one step is done a light at a time.
+        float spot[4], toLightX[4], toLightY[4], toLightZ[4];
+        _mm_storeu_ps(spot, spotEffect);
+        _mm_storeu_ps(toLightX, lx);
+        _mm_storeu_ps(toLightY, ly);
+        _mm_storeu_ps(toLightZ, lz);
+        for (int l = 0; l < 4; l++)
+        {
+            spot[l] = GetSpotFalloff(i + l, -glm::vec3(toLightX[l], toLightY[l], toLightZ[l]), spot[l]);
+        }
+        attenuation = _mm_and_ps(inCone, _mm_mul_ps(attenuation, _mm_loadu_ps(spot)));
+
+        __m128 amount = _mm_mul_ps(ndotl, attenuation);
+        red = _mm_add_ps(red, _mm_mul_ps(_mm_loadu_ps(&m_colorR[i]), amount));
+        green = _mm_add_ps(green, _mm_mul_ps(_mm_loadu_ps(&m_colorG[i]), amount));
+        blue = _mm_add_ps(blue, _mm_mul_ps(_mm_loadu_ps(&m_colorB[i]), amount));
+    }
+
+    // Add up the four lanes.
+    float lanes[3][4];
+    _mm_storeu_ps(lanes[0], red);
+    _mm_storeu_ps(lanes[1], green);
+    _mm_storeu_ps(lanes[2], blue);
+    for (int c = 0; c < 3; c++)
+    {
+        light[c] = lanes[c][0] + lanes[c][1] + lanes[c][2] + lanes[c][3];
+    }
+    first = groups * 4;
+#endif
+
+    // Whatever doesn't make a group of four.
+    for (unsigned int i = first; i < m_types.size(); i++)
+    {
+        light += EvaluateLight(i, position, normal);
+    }
+    for (unsigned int i = 0; i < m_directionalLights.size(); i++)
+    {
+        light += glm::vec3(m_directionalLights[i].m_color) * glm::clamp(glm::dot(-m_directionalLights[i].m_direction, normal), 0.f, 1.f);
+    }
+    return light;
+}
+
+int LightArrays::RunBenchmark(unsigned int lightCount)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0, 1);
+
+    // Half point lights and half spot lights, with ranges of 2 to 10 units, in a 40 unit wide cube.
+    LightArrays lights;
+    for (unsigned int i = 0; i < lightCount / 2; i++)
+    {
+        PointLight light(glm::vec3(unit(random), unit(random), unit(random)) * 40.f - 20.f, 2 + unit(random) * 8,
+            glm::vec4(3, 1, 1, .2f), glm::vec4(unit(random), unit(random), unit(random), 1));
+        lights.Add(light);
+    }
+    for (unsigned int i = lightCount / 2; i < lightCount; i++)
+    {
+        glm::mat4 world = glm::translate(glm::mat4(), glm::vec3(unit(random), unit(random), unit(random)) * 40.f - 20.f);
+        world = glm::rotate(world, unit(random) * 6.28f, glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + .01f));
+        SpotLight light(world, glm::vec4(3, 1, 1, .2f), glm::vec4(unit(random), unit(random), unit(random), 1),
+            2 + unit(random) * 8, .2f + unit(random) * 1.2f, 1 + unit(random) * 32);
+        lights.Add(light);
+    }
+    DirectionalLight sun(glm::vec3(-1, -2, -.5f), glm::vec4(.25f, .22f, .18f, 1));
+    lights.Add(sun);
+
+    // Surfaces to light, like light probes scattered through the scene.
+    const unsigned int surfaceCount = 1000;
+    std::vector<glm::vec3> positions(surfaceCount);
+    std::vector<glm::vec3> normals(surfaceCount);
+    for (unsigned int i = 0; i < surfaceCount; i++)
+    {
+        positions[i] = glm::vec3(unit(random), unit(random), unit(random)) * 40.f - 20.f;
+        normals[i] = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) * 2.f - 1.f);
+    }
+
+    // Run each a few times and keep the fastest, so a single hiccup doesn't count.
+    const int runs = 5;
+    double simdMs = 1e30, scalarMs = 1e30;
+    std::vector<glm::vec3> simd(surfaceCount);
+    std::vector<glm::vec3> scalar(surfaceCount);
+    for (int run = 0; run < runs; run++)
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        for (unsigned int i = 0; i < surfaceCount; i++)
+        {
+            simd[i] = lights.Evaluate(positions[i], normals[i]);
+        }
+        std::chrono::high_resolution_clock::time_point middle = std::chrono::high_resolution_clock::now();
+        for (unsigned int i = 0; i < surfaceCount; i++)
+        {
+            scalar[i] = lights.EvaluateScalar(positions[i], normals[i]);
+        }
+        std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+        simdMs = glm::min(simdMs, std::chrono::duration<double, std::milli>(middle - start).count());
+        scalarMs = glm::min(scalarMs, std::chrono::duration<double, std::milli>(end - middle).count());
+    }
+
+    // The packed records, lit one at a time the way the light budget does (LightBudget::GetLightAt), have to agree too.
+    std::vector<LightRecord> records;
+    lights.Pack(records);
+    float worstSimd = 0;
+    float worstRecords = 0;
+    for (unsigned int i = 0; i < surfaceCount; i++)
+    {
+        glm::vec3 fromRecords = glm::vec3(0);
+        for (unsigned int r = 0; r < records.size(); r++)
+        {
+            glm::vec3 toLight = records[r].m_positionType.w == LIGHT_TYPE_DIRECTIONAL ?
+                -glm::vec3(records[r].m_directionRange) : glm::normalize(glm::vec3(records[r].m_positionType) - positions[i]);
+            glm::vec4 color = records[r].m_positionType.w == LIGHT_TYPE_DIRECTIONAL ? records[r].m_color : LightBudget::GetLightAt(records[r], positions[i]);
+            fromRecords += glm::vec3(color) * glm::clamp(glm::dot(toLight, normals[i]), 0.f, 1.f);
+        }
+
+        // Errors relative to how bright the surface is, sums in a different order don't round the same way.
+        float scale = 1 + glm::length(scalar[i]);
+        worstSimd = glm::max(worstSimd, glm::length(simd[i] - scalar[i]) / scale);
+        worstRecords = glm::max(worstRecords, glm::length(fromRecords - scalar[i]) / scale);
+    }
+    bool same = worstSimd < 1e-4f && worstRecords < 1e-4f;
+
+    std::cout << "Light evaluation, " << lightCount << " lights x " << surfaceCount << " surfaces:" << std::endl;
+#ifdef LIGHT_EVALUATE_SSE
+    std::cout << "  Arrays (SSE):    " << simdMs << " ms, " << (double)lightCount * surfaceCount / (simdMs * 1e3) << " million lights per second" << std::endl;
+#else
+    std::cout << "  Arrays (no SSE): " << simdMs << " ms" << std::endl;
+#endif
+    std::cout << "  Arrays (scalar): " << scalarMs << " ms, " << (double)lightCount * surfaceCount / (scalarMs * 1e3) << " million lights per second" << std::endl;
+    std::cout << "  Largest difference from scalar: " << worstSimd << ", scalar from the records: " << worstRecords << std::endl;
+    std::cout << "  Same light: " << (same ? "yes" : "NO") << std::endl;
+
+    return same ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightArrays.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <vector>
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cmath>
+
+#include "lights.h"
+#include "lightProfiles.h"
+
+// SSE is always there on x64, and on 32 bit x86 when compiling for SSE2 or better.
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define LIGHT_EVALUATE_SSE
+#include <xmmintrin.h>
+#endif
+
+// Every light in the scene, kept as one array per value (positions, directions, colors, ranges, cone cosines...)
+// instead of one struct per light. The CPU mostly wants a few values from many lights at once, so four lights'
+// worth of each value load straight into SSE registers, and nothing it doesn't need is read.
+//
+// The GPU gets a compact LightRecord per light, packed from the arrays on upload (Pack).
+class LightArrays
+{
+public:
+    void Clear();
+
+    // Lights must be added in record order: every point light, then every spot light, then every directional light.
+    // shadowIndex is the light's point shadow cube map, or its entry in the spot shadow buffer (-1 for no shadow).
+    // profile is the spot light's layer in LightProfiles (-1 for none).
+    void Add(PointLight& light, float shadowIndex = -1);
+    void Add(SpotLight& light, float shadowIndex = -1, float profile = -1);
+    void Add(DirectionalLight& light);
+
+    unsigned int GetCount();
+
+    // Where Evaluate reads spot lights' profiles from (lights with a layer), like the light shader does.
+    // Without profiles, spot lights fall off by their exponent.
+    void SetProfiles(LightProfiles* profiles);
+
+    // Fills records with one LightRecord per light, in the order they were added.
+    void Pack(std::vector<LightRecord>& records);
+
+    // The light reaching a surface from every light together, before shadows.
+    // The same formula as shadeLight in lightTypes.glsl, four point or spot lights at a time.
+    // Profiles are read a light at a time, like pow, SSE has nothing to sample them with.
+    glm::vec3 Evaluate(glm::vec3 position, glm::vec3 normal);
+
+    // Exactly the same, one light at a time without SSE. To check and time the SSE version against.
+    glm::vec3 EvaluateScalar(glm::vec3 position, glm::vec3 normal);
+
+    // Times Evaluate and EvaluateScalar on random lights and surfaces, and checks both against the light records
+    // (the values the shaders get) evaluated light by light, and prints the results.
+    // The lights have no profiles, those need an OpenGL context for their texture.
+    // Runs instead of the demo when the first argument is --benchmark-attenuation:
+    //
+    //     DeferredSpot3D --benchmark-attenuation [lights]
+    //
+    // Returns the program's exit code (1 if any of them disagree).
+    static int RunBenchmark(unsigned int lightCount);
+
+private:
+    // One point or spot light's part of Evaluate.
+    glm::vec3 EvaluateLight(unsigned int light, glm::vec3 position, glm::vec3 normal);
+
+    // How much of a spot light inside its cone gets through in a direction (from the light), from its profile or exponent.
+    float GetSpotFalloff(unsigned int light, glm::vec3 direction, float spotEffect);
+
+    // Point and spot lights. Point lights have a cone cosine of -2 and an exponent of 0, so the spot part does nothing.
+    std::vector<float> m_positionX, m_positionY, m_positionZ;
+    std::vector<float> m_directionX, m_directionY, m_directionZ;
+    std::vector<float> m_colorR, m_colorG, m_colorB, m_colorA;
+    std::vector<float> m_attenuationX, m_attenuationY, m_attenuationZ, m_attenuationW;
+    std::vector<float> m_ranges;
+    std::vector<float> m_angles;
+    std::vector<float> m_cosines;
+    std::vector<float> m_exponents;
+    std::vector<float> m_shadowIndices;
+    std::vector<float> m_sideX, m_sideY, m_sideZ;
+    std::vector<float> m_profileLayers;
+    std::vector<unsigned char> m_types;
+
+    std::vector<DirectionalLight> m_directionalLights;
+
+    LightProfiles* m_profiles = nullptr;
+};
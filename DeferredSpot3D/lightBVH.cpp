@@ -0,0 +1,456 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightBVH.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "lightBVH.h"
+
+// Half the surface area of a box, which is all the comparisons need.
+static float HalfArea(glm::vec3 boxMin, glm::vec3 boxMax)
+{
+    glm::vec3 size = glm::max(boxMax - boxMin, glm::vec3(0));
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+LightBVH::LightBVH()
+{
+}
+
+void LightBVH::Build(const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs)
+{
+    m_itemMins = mins;
+    m_itemMaxs = maxs;
+    m_items.resize(mins.size());
+    m_itemLeaves.resize(mins.size());
+    for (unsigned int i = 0; i < m_items.size(); i++)
+    {
+        m_items[i] = i;
+    }
+
+    // A binary tree with n leaves has 2n - 1 nodes, and there are at least a couple of items per leaf.
+    m_nodes.clear();
+    m_parents.clear();
+    m_nodes.reserve(mins.size() + 1);
+    m_parents.reserve(mins.size() + 1);
+    m_surfaceArea = 0;
+    if (m_items.size() > 0)
+    {
+        m_nodes.push_back(LightBVHNode());
+        m_parents.push_back(0);
+        BuildNode(0, 0, m_items.size());
+    }
+    m_builtSurfaceArea = m_surfaceArea;
+}
+
+void LightBVH::BuildNode(unsigned int node, unsigned int first, unsigned int count)
+{
+    if (count <= LIGHT_BVH_LEAF_SIZE)
+    {
+        m_nodes[node].m_first = first;
+        m_nodes[node].m_count = count;
+        for (unsigned int i = first; i < first + count; i++)
+        {
+            m_itemLeaves[m_items[i]] = node;
+        }
+        FitNode(node);
+        return;
+    }
+
+    // Split along the axis the centers are most spread out on, half the items on each side.
+    glm::vec3 centerMin = glm::vec3(FLT_MAX);
+    glm::vec3 centerMax = glm::vec3(-FLT_MAX);
+    for (unsigned int i = first; i < first + count; i++)
+    {
+        glm::vec3 center = m_itemMins[m_items[i]] + m_itemMaxs[m_items[i]];
+        centerMin = glm::min(centerMin, center);
+        centerMax = glm::max(centerMax, center);
+    }
+    glm::vec3 spread = centerMax - centerMin;
+    int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+
+    // Only the middle item has to be in place, everything before it is on one side and everything after on the other.
+    unsigned int half = count / 2;
+    std::nth_element(m_items.begin() + first, m_items.begin() + first + half, m_items.begin() + first + count,
+        [&](unsigned int a, unsigned int b) { return m_itemMins[a][axis] + m_itemMaxs[a][axis] < m_itemMins[b][axis] + m_itemMaxs[b][axis]; });
+
+    // The children go next to each other, so only the left one needs to be stored.
+    unsigned int left = m_nodes.size();
+    m_nodes.push_back(LightBVHNode());
+    m_nodes.push_back(LightBVHNode());
+    m_parents.push_back(node);
+    m_parents.push_back(node);
+    m_nodes[node].m_first = left;
+    m_nodes[node].m_count = 0;
+
+    BuildNode(left, first, half);
+    BuildNode(left + 1, first + half, count - half);
+    FitNode(node);
+}
+
+void LightBVH::FitNode(unsigned int node)
+{
+    LightBVHNode& n = m_nodes[node];
+    m_surfaceArea -= HalfArea(n.m_min, n.m_max);
+
+    if (n.m_count > 0)
+    {
+        n.m_min = glm::vec3(FLT_MAX);
+        n.m_max = glm::vec3(-FLT_MAX);
+        for (unsigned int i = n.m_first; i < n.m_first + n.m_count; i++)
+        {
+            n.m_min = glm::min(n.m_min, m_itemMins[m_items[i]]);
+            n.m_max = glm::max(n.m_max, m_itemMaxs[m_items[i]]);
+        }
+    }
+    else
+    {
+        n.m_min = glm::min(m_nodes[n.m_first].m_min, m_nodes[n.m_first + 1].m_min);
+        n.m_max = glm::max(m_nodes[n.m_first].m_max, m_nodes[n.m_first + 1].m_max);
+    }
+
+    m_surfaceArea += HalfArea(n.m_min, n.m_max);
+}
+
+void LightBVH::SetBounds(unsigned int item, glm::vec3 boxMin, glm::vec3 boxMax)
+{
+    m_itemMins[item] = boxMin;
+    m_itemMaxs[item] = boxMax;
+
+    // Refit from the item's leaf up. Once a node comes out the same as before, nothing above it changes either.
+    unsigned int node = m_itemLeaves[item];
+    while (true)
+    {
+        glm::vec3 oldMin = m_nodes[node].m_min;
+        glm::vec3 oldMax = m_nodes[node].m_max;
+        FitNode(node);
+        if (node == 0 || (m_nodes[node].m_min == oldMin && m_nodes[node].m_max == oldMax))
+        {
+            break;
+        }
+        node = m_parents[node];
+    }
+}
+
+float LightBVH::GetDegradation()
+{
+    return m_builtSurfaceArea > 0 ? (float)(m_surfaceArea / m_builtSurfaceArea) : 1.f;
+}
+
+void LightBVH::AddAll(unsigned int node, std::vector<unsigned int>& items)
+{
+    // Every item under a node is one run in the item order, from its leftmost leaf to its rightmost leaf.
+    unsigned int first = node;
+    while (m_nodes[first].m_count == 0)
+    {
+        first = m_nodes[first].m_first;
+    }
+    unsigned int last = node;
+    while (m_nodes[last].m_count == 0)
+    {
+        last = m_nodes[last].m_first + 1;
+    }
+    items.insert(items.end(), m_items.begin() + m_nodes[first].m_first, m_items.begin() + m_nodes[last].m_first + m_nodes[last].m_count);
+}
+
+void LightBVH::QueryFrustum(Frustum& frustum, std::vector<unsigned int>& items)
+{
+    if (m_nodes.size() == 0)
+    {
+        return;
+    }
+
+    m_stack.clear();
+    m_stack.push_back(0);
+    while (m_stack.size() > 0)
+    {
+        LightBVHNode& node = m_nodes[m_stack.back()];
+        unsigned int index = m_stack.back();
+        m_stack.pop_back();
+
+        FrustumTest test = frustum.TestBox(node.m_min, node.m_max);
+        if (test == FRUSTUM_OUTSIDE)
+        {
+            continue;
+        }
+        // Nothing under a node that's all inside can be outside.
+        if (test == FRUSTUM_INSIDE)
+        {
+            AddAll(index, items);
+        }
+        else if (node.m_count > 0)
+        {
+            for (unsigned int i = node.m_first; i < node.m_first + node.m_count; i++)
+            {
+                if (frustum.TestBox(m_itemMins[m_items[i]], m_itemMaxs[m_items[i]]) != FRUSTUM_OUTSIDE)
+                {
+                    items.push_back(m_items[i]);
+                }
+            }
+        }
+        else
+        {
+            m_stack.push_back(node.m_first);
+            m_stack.push_back(node.m_first + 1);
+        }
+    }
+}
+
+void LightBVH::QueryBox(glm::vec3 boxMin, glm::vec3 boxMax, std::vector<unsigned int>& items)
+{
+    if (m_nodes.size() == 0)
+    {
+        return;
+    }
+
+    m_stack.clear();
+    m_stack.push_back(0);
+    while (m_stack.size() > 0)
+    {
+        LightBVHNode& node = m_nodes[m_stack.back()];
+        m_stack.pop_back();
+
+        if (!BoxesTouch(node.m_min, node.m_max, boxMin, boxMax))
+        {
+            continue;
+        }
+        if (node.m_count > 0)
+        {
+            for (unsigned int i = node.m_first; i < node.m_first + node.m_count; i++)
+            {
+                if (BoxesTouch(m_itemMins[m_items[i]], m_itemMaxs[m_items[i]], boxMin, boxMax))
+                {
+                    items.push_back(m_items[i]);
+                }
+            }
+        }
+        else
+        {
+            m_stack.push_back(node.m_first);
+            m_stack.push_back(node.m_first + 1);
+        }
+    }
+}
+
+void LightBVH::QueryRay(glm::vec3 origin, glm::vec3 direction, float maxDistance, std::vector<unsigned int>& items)
+{
+    if (m_nodes.size() == 0)
+    {
+        return;
+    }
+
+    // Dividing by zero is fine here, it gives infinity and the slab test still works.
+    glm::vec3 inverseDirection = 1.f / direction;
+
+    m_stack.clear();
+    m_stack.push_back(0);
+    while (m_stack.size() > 0)
+    {
+        LightBVHNode& node = m_nodes[m_stack.back()];
+        m_stack.pop_back();
+
+        if (!RayHitsBox(origin, inverseDirection, maxDistance, node.m_min, node.m_max))
+        {
+            continue;
+        }
+        if (node.m_count > 0)
+        {
+            for (unsigned int i = node.m_first; i < node.m_first + node.m_count; i++)
+            {
+                if (RayHitsBox(origin, inverseDirection, maxDistance, m_itemMins[m_items[i]], m_itemMaxs[m_items[i]]))
+                {
+                    items.push_back(m_items[i]);
+                }
+            }
+        }
+        else
+        {
+            m_stack.push_back(node.m_first);
+            m_stack.push_back(node.m_first + 1);
+        }
+    }
+}
+
+unsigned int LightBVH::GetItemCount()
+{
+    return m_items.size();
+}
+
+std::vector<LightBVHNode>& LightBVH::GetNodes()
+{
+    return m_nodes;
+}
+
+bool LightBVH::BoxesTouch(glm::vec3 aMin, glm::vec3 aMax, glm::vec3 bMin, glm::vec3 bMax)
+{
+    return aMin.x <= bMax.x && aMax.x >= bMin.x
+        && aMin.y <= bMax.y && aMax.y >= bMin.y
+        && aMin.z <= bMax.z && aMax.z >= bMin.z;
+}
+
+bool LightBVH::RayHitsBox(glm::vec3 origin, glm::vec3 inverseDirection, float maxDistance, glm::vec3 boxMin, glm::vec3 boxMax)
+{
+    // The ray is inside each pair of planes (slab) for a range of distances, it hits the box if those ranges overlap.
+    glm::vec3 t0 = (boxMin - origin) * inverseDirection;
+    glm::vec3 t1 = (boxMax - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.f));
+    float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxDistance));
+    return enter <= exit;
+}
+
+int LightBVH::RunBenchmark(unsigned int lightCount)
+{
+    std::vector<unsigned int> counts = { 1000, 10000, 100000 };
+    if (lightCount > 0)
+    {
+        counts = { lightCount };
+    }
+
+    bool allSame = true;
+    for (unsigned int c = 0; c < counts.size(); c++)
+    {
+        unsigned int count = counts[c];
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<float> unit(0, 1);
+
+        // Lights of 1 to 5 units in a cube that keeps the same number of lights per unit of volume at every count.
+        float worldSize = 10 * std::cbrt((float)count);
+        std::vector<glm::vec3> mins(count);
+        std::vector<glm::vec3> maxs(count);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            glm::vec3 center = glm::vec3(unit(random), unit(random), unit(random)) * worldSize;
+            float radius = 1 + unit(random) * 4;
+            mins[i] = center - radius;
+            maxs[i] = center + radius;
+        }
+
+        // A camera in the middle, and boxes and rays all over.
+        glm::vec3 middle = glm::vec3(worldSize * .5f);
+        Frustum frustum = Frustum(glm::perspective(.75f, 16 / 9.f, .1f, 100.f) * glm::lookAt(middle, middle + glm::vec3(1, .2f, .5f), glm::vec3(0, 1, 0)));
+        const unsigned int queryCount = 1000;
+        std::vector<glm::vec3> boxMins(queryCount);
+        std::vector<glm::vec3> rayOrigins(queryCount);
+        std::vector<glm::vec3> rayDirections(queryCount);
+        for (unsigned int i = 0; i < queryCount; i++)
+        {
+            boxMins[i] = glm::vec3(unit(random), unit(random), unit(random)) * worldSize;
+            rayOrigins[i] = glm::vec3(unit(random), unit(random), unit(random)) * worldSize;
+            rayDirections[i] = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) * 2.f - 1.f);
+        }
+        glm::vec3 boxSize = glm::vec3(10);
+        float rayLength = 50;
+
+        // Run each part a few times and keep the fastest, so a single hiccup doesn't count.
+        const int runs = 5;
+        double buildMs = 1e30, refitMs = 1e30;
+        double treeMs[3] = { 1e30, 1e30, 1e30 };
+        double linearMs[3] = { 1e30, 1e30, 1e30 };
+        std::vector<unsigned int> treeItems[3];
+        std::vector<unsigned int> linearItems[3];
+        LightBVH tree;
+        float degradation = 1;
+        for (int run = 0; run < runs; run++)
+        {
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            tree.Build(mins, maxs);
+            std::chrono::high_resolution_clock::time_point built = std::chrono::high_resolution_clock::now();
+
+            // A tenth of the lights move a little, like the spinning spot lights do every frame.
+            std::mt19937 moves(run);
+            for (unsigned int i = 0; i < count; i += 10)
+            {
+                glm::vec3 offset = glm::vec3(unit(moves), unit(moves), unit(moves)) - .5f;
+                tree.SetBounds(i, mins[i] + offset, maxs[i] + offset);
+            }
+            std::chrono::high_resolution_clock::time_point refitted = std::chrono::high_resolution_clock::now();
+            degradation = tree.GetDegradation();
+
+            // Query the original positions, so the answers can be compared with the linear scan.
+            tree.Build(mins, maxs);
+
+            buildMs = glm::min(buildMs, std::chrono::duration<double, std::milli>(built - start).count());
+            refitMs = glm::min(refitMs, std::chrono::duration<double, std::milli>(refitted - built).count());
+
+            for (int query = 0; query < 3; query++)
+            {
+                // The tree.
+                treeItems[query].clear();
+                start = std::chrono::high_resolution_clock::now();
+                for (unsigned int q = 0; q < (query == 0 ? 1 : queryCount); q++)
+                {
+                    if (query == 0) tree.QueryFrustum(frustum, treeItems[query]);
+                    if (query == 1) tree.QueryBox(boxMins[q], boxMins[q] + boxSize, treeItems[query]);
+                    if (query == 2) tree.QueryRay(rayOrigins[q], rayDirections[q], rayLength, treeItems[query]);
+                }
+                std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+                treeMs[query] = glm::min(treeMs[query], std::chrono::duration<double, std::milli>(end - start).count());
+
+                // And every light, one at a time.
+                linearItems[query].clear();
+                start = std::chrono::high_resolution_clock::now();
+                for (unsigned int q = 0; q < (query == 0 ? 1 : queryCount); q++)
+                {
+                    glm::vec3 inverseDirection = 1.f / rayDirections[q];
+                    for (unsigned int i = 0; i < count; i++)
+                    {
+                        bool touches = false;
+                        if (query == 0) touches = frustum.TestBox(mins[i], maxs[i]) != FRUSTUM_OUTSIDE;
+                        if (query == 1) touches = BoxesTouch(mins[i], maxs[i], boxMins[q], boxMins[q] + boxSize);
+                        if (query == 2) touches = RayHitsBox(rayOrigins[q], inverseDirection, rayLength, mins[i], maxs[i]);
+                        if (touches)
+                        {
+                            linearItems[query].push_back(i);
+                        }
+                    }
+                }
+                end = std::chrono::high_resolution_clock::now();
+                linearMs[query] = glm::min(linearMs[query], std::chrono::duration<double, std::milli>(end - start).count());
+            }
+        }
+
+        // Both have to find exactly the same lights, though not in the same order.
+        // (The results of all the box and ray queries are lumped together, sorting still compares them exactly.)
+        bool same = true;
+        for (int query = 0; query < 3; query++)
+        {
+            std::sort(treeItems[query].begin(), treeItems[query].end());
+            std::sort(linearItems[query].begin(), linearItems[query].end());
+            same = same && treeItems[query] == linearItems[query];
+        }
+        allSame = allSame && same;
+
+        const char* names[3] = { "Frustum (1 query): ", "Box (1000 queries):", "Ray (1000 queries):" };
+        std::cout << "Light BVH, " << count << " lights (" << tree.GetNodes().size() << " nodes):" << std::endl;
+        std::cout << "  Build:                 " << buildMs << " ms" << std::endl;
+        std::cout << "  Refit 10% of lights:   " << refitMs << " ms, boxes " << degradation << "x the area of a fresh build" << std::endl;
+        for (int query = 0; query < 3; query++)
+        {
+            std::cout << "  " << names[query] << "  tree " << treeMs[query] << " ms, linear " << linearMs[query] << " ms ("
+                << linearMs[query] / treeMs[query] << "x), " << treeItems[query].size() << " found" << std::endl;
+        }
+        std::cout << "  Same lights found: " << (same ? "yes" : "NO") << std::endl;
+    }
+
+    return allSame ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightBVH.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cfloat>
+
+#include "frustum.h"
+
+// Lights per leaf. Testing a few boxes in a row is cheaper than another level of nodes.
+#define LIGHT_BVH_LEAF_SIZE 4
+
+// One node of a LightBVH. Leaves hold a run of items, other nodes have two children next to each other.
+struct LightBVHNode
+{
+    glm::vec3 m_min;
+    unsigned int m_first; // Leaves: the first of their items in LightBVH's item order. Others: the left child (right is m_first + 1)
+    glm::vec3 m_max;
+    unsigned int m_count; // Leaves: how many items, 0 for every other node
+};
+
+// A bounding volume hierarchy over light bounds, to answer "which lights touch this" without looking at every light.
+// Items are boxes, numbered in the order they were given to Build. For lights that's the light buffer's record index,
+// so a query hands back records that can be used directly.
+//
+// Lights that move don't need a rebuild. SetBounds refits the boxes from a light's leaf up to the root, which keeps
+// every query correct, though boxes get looser the further lights move from where they were at the last Build.
+// GetDegradation says how much looser, to decide when rebuilding is worth it.
+class LightBVH
+{
+public:
+    LightBVH();
+
+    // Builds the tree from scratch, splitting each node in half along its longest axis.
+    void Build(const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs);
+
+    // Moves one item, and refits the boxes above it.
+    void SetBounds(unsigned int item, glm::vec3 boxMin, glm::vec3 boxMax);
+
+    // How much bigger the boxes are now than after the last Build: the total surface area of every node, over what it
+    // was then. 1 straight after a build.
+    float GetDegradation();
+
+    // Every item whose box touches the query, appended to items. Boxes are only tested against boxes, so callers that
+    // need an exact answer still have to check each item, but only the items that came back.
+    void QueryFrustum(Frustum& frustum, std::vector<unsigned int>& items);
+    void QueryBox(glm::vec3 boxMin, glm::vec3 boxMax, std::vector<unsigned int>& items);
+    void QueryRay(glm::vec3 origin, glm::vec3 direction, float maxDistance, std::vector<unsigned int>& items);
+
+    unsigned int GetItemCount();
+    std::vector<LightBVHNode>& GetNodes();
+
+    // The same tests as the queries make, for a single box.
+    static bool BoxesTouch(glm::vec3 aMin, glm::vec3 aMax, glm::vec3 bMin, glm::vec3 bMax);
+    static bool RayHitsBox(glm::vec3 origin, glm::vec3 inverseDirection, float maxDistance, glm::vec3 boxMin, glm::vec3 boxMax);
+
+    // Times building, refitting and each query against testing every light, at 1000, 10000 and 100000 lights
+    // (or just lightCount, if it isn't 0), and prints the results.
+    // Runs instead of the demo when the first argument is --benchmark-lights:
+    //
+    //     DeferredSpot3D --benchmark-lights [lights]
+    //
+    // Returns the program's exit code (1 if the tree and the linear scan disagree).
+    static int RunBenchmark(unsigned int lightCount);
+
+private:
+    // Makes node cover items [first, first + count) of m_items, splitting it if there are too many.
+    void BuildNode(unsigned int node, unsigned int first, unsigned int count);
+
+    // Sets a node's box from its items or children.
+    void FitNode(unsigned int node);
+
+    // Adds every item under a node, without testing anything (the whole node is inside the query).
+    void AddAll(unsigned int node, std::vector<unsigned int>& items);
+
+    std::vector<LightBVHNode> m_nodes;
+    std::vector<unsigned int> m_parents;
+
+    // Item numbers, in leaf order, and where each item is.
+    std::vector<unsigned int> m_items;
+    std::vector<unsigned int> m_itemLeaves;
+    std::vector<glm::vec3> m_itemMins;
+    std::vector<glm::vec3> m_itemMaxs;
+
+    // Kept up to date by FitNode.
+    double m_surfaceArea = 0;
+    double m_builtSurfaceArea = 0;
+
+    // Nodes still to visit during a query, kept to save allocating it every time.
+    std::vector<unsigned int> m_stack;
+};
@@ -0,0 +1,295 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightBudget.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "lightBudget.h"
+
+LightBudget::LightBudget(unsigned int budget, glm::vec3 gridMin, glm::vec3 gridMax, glm::uvec3 gridSize)
+{
+    m_budget = budget;
+
+    // Need at least two points along each axis to blend between.
+    m_gridSize = glm::max(gridSize, glm::uvec3(2));
+    m_gridMin = gridMin;
+    m_gridSpacing = (gridMax - gridMin) / glm::vec3(m_gridSize - glm::uvec3(1));
+    m_gridPoints.resize(m_gridSize.x * m_gridSize.y * m_gridSize.z);
+
+    // The grid is the same size every frame, so the buffer is only made once.
+    glGenBuffers(1, &m_gridBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_gridBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, m_gridPoints.size() * sizeof(LightGridPoint), m_gridPoints.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+LightBudget::~LightBudget()
+{
+    glDeleteBuffers(1, &m_gridBuffer);
+}
+
+void LightBudget::SetBudget(unsigned int budget)
+{
+    m_budget = budget;
+}
+
+unsigned int LightBudget::GetBudget()
+{
+    return m_budget;
+}
+
+void LightBudget::SetFadeRange(float fadeRange)
+{
+    m_fadeRange = fadeRange;
+}
+
+float LightBudget::GetFadeRange()
+{
+    return m_fadeRange;
+}
+
+void LightBudget::Update(std::vector<LightRecord>& records, unsigned int volumeCount, std::vector<bool>& onScreen,
+    std::vector<float>& screenAreas, std::vector<float>& weights)
+{
+    weights.assign(records.size(), 0);
+    m_drawnCount = 0;
+    m_gridCount = 0;
+
+    m_ranked.clear();
+    for (unsigned int i = 0; i < volumeCount; i++)
+    {
+        if (onScreen[i])
+        {
+            m_ranked.push_back(std::make_pair(GetImportance(records[i], screenAreas[i]), i));
+        }
+    }
+
+    // Move the most important lights to the front. They don't need to be in order, only ahead of the rest,
+    // and the one right after them is the best light that didn't make it.
+    float cutoff = 0;
+    unsigned int drawn = m_ranked.size();
+    if (m_ranked.size() > m_budget)
+    {
+        std::nth_element(m_ranked.begin(), m_ranked.begin() + m_budget, m_ranked.end(), std::greater<std::pair<float, unsigned int>>());
+        cutoff = m_ranked[m_budget].first;
+        drawn = m_budget;
+    }
+
+    // A light exactly as important as the cutoff isn't drawn at all, and one fadeRange above it is drawn fully.
+    for (unsigned int i = 0; i < drawn; i++)
+    {
+        float weight = 1;
+        if (cutoff > 0 && m_fadeRange > 0)
+        {
+            weight = glm::clamp((m_ranked[i].first / cutoff - 1) / m_fadeRange, 0.f, 1.f);
+        }
+        weights[m_ranked[i].second] = weight;
+    }
+
+    // Whatever isn't drawn goes in the grid.
+    std::fill(m_gridPoints.begin(), m_gridPoints.end(), LightGridPoint());
+    for (unsigned int i = 0; i < m_ranked.size(); i++)
+    {
+        unsigned int light = m_ranked[i].second;
+        if (weights[light] > 0)
+        {
+            m_drawnCount++;
+        }
+        if (weights[light] < 1)
+        {
+            AddLight(records[light], 1 - weights[light]);
+            m_gridCount++;
+        }
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_gridBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_gridPoints.size() * sizeof(LightGridPoint), m_gridPoints.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void LightBudget::Bind()
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_GRID_BINDING, m_gridBuffer);
+}
+
+void LightBudget::Unbind()
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_GRID_BINDING, 0);
+}
+
+void LightBudget::SetProfiles(LightProfiles* profiles)
+{
+    m_profiles = profiles;
+}
+
+glm::vec3 LightBudget::GetGridMin()
+{
+    return m_gridMin;
+}
+
+glm::vec3 LightBudget::GetGridSpacing()
+{
+    return m_gridSpacing;
+}
+
+glm::uvec3 LightBudget::GetGridSize()
+{
+    return m_gridSize;
+}
+
+std::vector<LightGridPoint>& LightBudget::GetGridPoints()
+{
+    return m_gridPoints;
+}
+
+unsigned int LightBudget::GetDrawnCount()
+{
+    return m_drawnCount;
+}
+
+unsigned int LightBudget::GetGridCount()
+{
+    return m_gridCount;
+}
+
+float LightBudget::GetImportance(LightRecord& light, float screenArea)
+{
+    // Brightness is the color's luminance, attenuated to halfway through the light's range.
+    // Range and distance already show up in how much of the screen the light covers.
+    glm::vec4& a = light.m_attenuation;
+    float attenuation = 1 / (a.x * .25f + a.y * .5f + a.z) - a.w;
+    float luminance = glm::dot(glm::vec3(light.m_color), glm::vec3(.2126f, .7152f, .0722f));
+    return luminance * glm::max(attenuation, 0.f) * screenArea;
+}
+
+glm::vec4 LightBudget::GetLightAt(LightRecord& light, glm::vec3 position, float minDistance, LightProfiles* profiles)
+{
+    glm::vec3 surfaceToLight = glm::vec3(light.m_positionType) - position;
+    float distance = glm::length(surfaceToLight);
+
+    glm::vec4& a = light.m_attenuation;
+    float d = glm::clamp(glm::max(distance, minDistance) / light.m_directionRange.w, 0.f, 1.f);
+    float attenuation = 1 / (a.x * d * d + a.y * d + a.z) - a.w;
+    if (attenuation <= 0)
+    {
+        return glm::vec4(0);
+    }
+
+    if (light.m_positionType.w == LIGHT_TYPE_SPOT && distance > 0)
+    {
+        float spotEffect = glm::dot(-surfaceToLight / distance, glm::vec3(light.m_directionRange));
+        if (spotEffect <= light.m_coneShadow.w)
+        {
+            return glm::vec4(0);
+        }
+
+        // The profile's angles, the same as sampleLightProfile in lightTypes.glsl.
+        if (profiles != nullptr && light.m_profile.w >= 0)
+        {
+            glm::vec3 direction = -surfaceToLight / distance;
+            glm::vec3 axis = glm::vec3(light.m_directionRange);
+            glm::vec3 side = glm::vec3(light.m_profile);
+            glm::vec3 up = glm::cross(axis, side);
+            float angle = std::acos(glm::clamp(spotEffect, -1.f, 1.f));
+            float around = std::atan2(glm::dot(direction, up), glm::dot(direction, side));
+            attenuation *= LightProfiles::Sample(profiles->GetLayer((int)light.m_profile.w), angle, around);
+        }
+        else
+        {
+            attenuation *= glm::pow(spotEffect, light.m_coneShadow.y);
+        }
+    }
+
+    return light.m_color * attenuation;
+}
+
+void LightBudget::AddLight(LightRecord& light, float amount)
+{
+    // Only the points inside the light's bounding sphere can get any of it.
+    glm::vec4 sphere = light.GetBoundingSphere();
+    glm::vec3 first = glm::ceil((glm::vec3(sphere) - sphere.w - m_gridMin) / m_gridSpacing);
+    glm::vec3 last = glm::floor((glm::vec3(sphere) + sphere.w - m_gridMin) / m_gridSpacing);
+    glm::ivec3 begin = glm::ivec3(glm::max(first, glm::vec3(0)));
+    glm::ivec3 end = glm::ivec3(glm::min(last, glm::vec3(m_gridSize) - 1.f));
+
+    // A light right next to a point would be far too bright for the points around it, so nothing is closer than half a step.
+    float minDistance = glm::length(m_gridSpacing) * .5f;
+
+    for (int z = begin.z; z <= end.z; z++)
+    {
+        for (int y = begin.y; y <= end.y; y++)
+        {
+            for (int x = begin.x; x <= end.x; x++)
+            {
+                glm::vec3 position = m_gridMin + glm::vec3(x, y, z) * m_gridSpacing;
+                glm::vec4 color = GetLightAt(light, position, minDistance, m_profiles) * amount;
+                if (color == glm::vec4(0))
+                {
+                    continue;
+                }
+
+                // Light from one direction, as first order spherical harmonics with the cosine lobe already applied:
+                // a quarter of it in every direction, plus half of it times the cosine to the light.
+                // A normal facing the light gets 3/4 of it, one facing away gets -1/4 (which is clamped to 0).
+                glm::vec3 toLight = glm::vec3(light.m_positionType) - position;
+                glm::vec3 direction = glm::length(toLight) > 0 ? glm::normalize(toLight) : glm::vec3(0);
+                LightGridPoint& point = m_gridPoints[GetPointIndex(glm::uvec3(x, y, z))];
+                point.m_red += glm::vec4(.25f, direction * .5f) * color.r;
+                point.m_green += glm::vec4(.25f, direction * .5f) * color.g;
+                point.m_blue += glm::vec4(.25f, direction * .5f) * color.b;
+            }
+        }
+    }
+}
+
+glm::vec3 LightBudget::Sample(glm::vec3 position, glm::vec3 normal)
+{
+    // Where the position is in the grid, in steps. Outside the grid there's no light from it.
+    glm::vec3 cell = (position - m_gridMin) / m_gridSpacing;
+    if (glm::any(glm::lessThan(cell, glm::vec3(0))) || glm::any(glm::greaterThan(cell, glm::vec3(m_gridSize - glm::uvec3(1)))))
+    {
+        return glm::vec3(0);
+    }
+
+    glm::uvec3 low = glm::min(glm::uvec3(cell), m_gridSize - glm::uvec3(2));
+    glm::vec3 t = cell - glm::vec3(low);
+
+    // Blend the eight points around the position, then apply the normal.
+    LightGridPoint blended;
+    for (int i = 0; i < 8; i++)
+    {
+        glm::uvec3 corner = low + glm::uvec3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+        glm::vec3 w3 = glm::mix(glm::vec3(1) - t, t, glm::vec3(corner - low));
+        float w = w3.x * w3.y * w3.z;
+        LightGridPoint& point = m_gridPoints[GetPointIndex(corner)];
+        blended.m_red += point.m_red * w;
+        blended.m_green += point.m_green * w;
+        blended.m_blue += point.m_blue * w;
+    }
+
+    glm::vec4 n = glm::vec4(1, normal);
+    return glm::max(glm::vec3(glm::dot(blended.m_red, n), glm::dot(blended.m_green, n), glm::dot(blended.m_blue, n)), glm::vec3(0));
+}
+
+unsigned int LightBudget::GetPointIndex(glm::uvec3 point)
+{
+    return (point.z * m_gridSize.y + point.y) * m_gridSize.x + point.x;
+}
@@ -0,0 +1,128 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightBudget.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "glm/glm.hpp"
+#include <vector>
+#include <algorithm>
+
+#include "lights.h"
+#include "lightProfiles.h"
+
+// Must match the binding of the LightGrid block in lightGrid.glsl.
+#define LIGHT_GRID_BINDING 3
+
+// Same layout as lightGridPoint in lightGrid.glsl.
+// Light arriving at a point as first order spherical harmonics, one vec4 per color channel:
+// x = the part every direction gets, yzw = the part that depends on the direction (times the normal).
+struct LightGridPoint
+{
+    glm::vec4 m_red;
+    glm::vec4 m_green;
+    glm::vec4 m_blue;
+};
+
+// Keeps the number of lights shaded per pixel under a budget, however many lights there are.
+//
+// Every light on screen is given an importance: how bright it is (color and attenuation) times how much of the
+// screen it covers (which takes care of range and distance). Only the most important lights are drawn as volumes.
+// The rest are added into a coarse grid of points over the scene, each holding the light that reaches it as
+// spherical harmonics, which the ambient light pass blends between and applies to every pixel (lightGrid.glsl).
+//
+// Lights near the cutoff fade from one to the other, by how close their importance is to the best light that didn't
+// make it, so a light crossing the cutoff never pops.
+class LightBudget
+{
+public:
+    // The grid is gridSize points spread from gridMin to gridMax (corners included), nothing outside it gets light from it.
+    LightBudget(unsigned int budget, glm::vec3 gridMin, glm::vec3 gridMax, glm::uvec3 gridSize);
+    ~LightBudget();
+
+    // The most lights drawn as volumes.
+    void SetBudget(unsigned int budget);
+    unsigned int GetBudget();
+
+    // How far above the cutoff a light's importance has to be to be fully drawn, as a fraction of the cutoff.
+    // Lights in between are partly drawn and partly in the grid.
+    void SetFadeRange(float fadeRange);
+    float GetFadeRange();
+
+    // Where the grid reads spot lights' profiles from (lights with a layer), like the light shader does.
+    void SetProfiles(LightProfiles* profiles);
+
+    // Picks the lights to draw and rebuilds the grid from the others. Only the first volumeCount records (point and spot
+    // lights) are looked at, and only the ones that are on screen, with their screen area (0 to 1) in screenAreas.
+    // weights gets how much of each light to draw: 1 for all of it, 0 for none (it's all in the grid).
+    void Update(std::vector<LightRecord>& records, unsigned int volumeCount, std::vector<bool>& onScreen,
+        std::vector<float>& screenAreas, std::vector<float>& weights);
+
+    // Makes the grid visible to shaders at LIGHT_GRID_BINDING.
+    void Bind();
+    void Unbind();
+
+    // For the ambient light pass's uniforms (lightGrid.glsl).
+    glm::vec3 GetGridMin();
+    glm::vec3 GetGridSpacing();
+    glm::uvec3 GetGridSize();
+    std::vector<LightGridPoint>& GetGridPoints();
+
+    // How many lights were drawn (even partly) and how many went in the grid (even partly) by the last Update.
+    unsigned int GetDrawnCount();
+    unsigned int GetGridCount();
+
+    // How much a light matters this frame, from how bright it is and how much of the screen it covers.
+    static float GetImportance(LightRecord& light, float screenArea);
+
+    // How much of a light (its color, times attenuation and the spot cone) reaches a point, like shadeLight in lightTypes.glsl.
+    // Distances under minDistance are treated as minDistance, the grid can't show anything closer anyway.
+    // Spot lights with a profile layer read it from profiles, without profiles they use their exponent.
+    static glm::vec4 GetLightAt(LightRecord& light, glm::vec3 position, float minDistance = 0, LightProfiles* profiles = nullptr);
+
+    // Adds amount (0 to 1) of a light to every grid point in its range.
+    void AddLight(LightRecord& light, float amount);
+
+    // The light the grid gives a surface, blending between the nearest points. Same as sampleLightGrid in lightGrid.glsl.
+    glm::vec3 Sample(glm::vec3 position, glm::vec3 normal);
+
+private:
+    unsigned int GetPointIndex(glm::uvec3 point);
+
+    unsigned int m_budget;
+    float m_fadeRange = .25f;
+    LightProfiles* m_profiles = nullptr;
+
+    glm::vec3 m_gridMin;
+    glm::vec3 m_gridSpacing;
+    glm::uvec3 m_gridSize;
+    std::vector<LightGridPoint> m_gridPoints;
+    GLuint m_gridBuffer;
+
+    unsigned int m_drawnCount = 0;
+    unsigned int m_gridCount = 0;
+
+    // Scratch space for sorting lights by importance.
+    std::vector<std::pair<float, unsigned int>> m_ranked;
+};
@@ -0,0 +1,231 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightBuffer.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "lightBuffer.h"
+
+LightBuffer::LightBuffer()
+{
+    glGenBuffers(1, &m_buffer);
+    glGenBuffers(1, &m_shadowBuffer);
+}
+
+LightBuffer::~LightBuffer()
+{
+    glDeleteBuffers(1, &m_buffer);
+    glDeleteBuffers(1, &m_shadowBuffer);
+}
+
+void LightBuffer::Update(std::vector<PointLight>& pointLights, std::vector<SpotLight>& spotLights, std::vector<DirectionalLight>& directionalLights,
+    const std::vector<float>& pointShadowIndices, const std::vector<SpotShadow>& spotShadows)
+{
+    m_lights.Clear();
+    m_spotShadows.clear();
+    m_pointCount = pointLights.size();
+    m_spotCount = spotLights.size();
+    m_directionalCount = directionalLights.size();
+
+    for (unsigned int i = 0; i < pointLights.size(); i++)
+    {
+        m_lights.Add(pointLights[i], i < pointShadowIndices.size() ? pointShadowIndices[i] : -1);
+    }
+    for (unsigned int i = 0; i < spotLights.size(); i++)
+    {
+        // Only spot lights that got a tile in the atlas take up room in the shadow buffer.
+        float shadowIndex = -1;
+        if (i < spotShadows.size() && spotShadows[i].m_bounds.x >= 0)
+        {
+            shadowIndex = (float)m_spotShadows.size();
+            m_spotShadows.push_back(spotShadows[i]);
+        }
+        int profile = spotLights[i].m_profile;
+        if (profile < 0 && m_profiles != nullptr)
+        {
+            profile = m_profiles->AddExponent(spotLights[i].m_exponent);
+        }
+        m_lights.Add(spotLights[i], shadowIndex, (float)profile);
+    }
+    for (unsigned int i = 0; i < directionalLights.size(); i++)
+    {
+        m_lights.Add(directionalLights[i]);
+    }
+    m_lights.Pack(m_records);
+
+    UpdateBVH();
+
+    if (m_spotShadows.size() > 0)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_shadowBuffer);
+        if (m_spotShadows.size() > m_shadowCapacity)
+        {
+            glBufferData(GL_SHADER_STORAGE_BUFFER, m_spotShadows.size() * sizeof(SpotShadow), m_spotShadows.data(), GL_DYNAMIC_DRAW);
+            m_shadowCapacity = m_spotShadows.size();
+        }
+        else
+        {
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_spotShadows.size() * sizeof(SpotShadow), m_spotShadows.data());
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    if (m_records.size() == 0)
+    {
+        return;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+    if (m_records.size() > m_capacity)
+    {
+        glBufferData(GL_SHADER_STORAGE_BUFFER, m_records.size() * sizeof(LightRecord), m_records.data(), GL_DYNAMIC_DRAW);
+        m_capacity = m_records.size();
+    }
+    else
+    {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_records.size() * sizeof(LightRecord), m_records.data());
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void LightBuffer::SetProfiles(LightProfiles* profiles)
+{
+    m_profiles = profiles;
+    m_lights.SetProfiles(profiles);
+}
+
+void LightBuffer::Bind()
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_BUFFER_BINDING, m_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_SHADOW_BINDING, m_shadowBuffer);
+}
+
+void LightBuffer::Unbind()
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_BUFFER_BINDING, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_SHADOW_BINDING, 0);
+}
+
+unsigned int LightBuffer::GetFirstPoint()
+{
+    return 0;
+}
+
+unsigned int LightBuffer::GetPointCount()
+{
+    return m_pointCount;
+}
+
+unsigned int LightBuffer::GetFirstSpot()
+{
+    return m_pointCount;
+}
+
+unsigned int LightBuffer::GetSpotCount()
+{
+    return m_spotCount;
+}
+
+unsigned int LightBuffer::GetFirstDirectional()
+{
+    return m_pointCount + m_spotCount;
+}
+
+unsigned int LightBuffer::GetDirectionalCount()
+{
+    return m_directionalCount;
+}
+
+std::vector<LightRecord>& LightBuffer::GetRecords()
+{
+    return m_records;
+}
+
+LightArrays& LightBuffer::GetLights()
+{
+    return m_lights;
+}
+
+void LightBuffer::UpdateBVH()
+{
+    unsigned int volumeCount = m_pointCount + m_spotCount;
+    m_refitCount = 0;
+
+    // A different set of lights needs a new tree.
+    m_rebuilt = volumeCount != m_bvh.GetItemCount();
+    if (m_rebuilt)
+    {
+        m_bvhSpheres.resize(volumeCount);
+        for (unsigned int i = 0; i < volumeCount; i++)
+        {
+            m_bvhSpheres[i] = m_records[i].GetBoundingSphere();
+        }
+    }
+    else
+    {
+        // Otherwise only the lights that moved (or changed size) are refitted.
+        for (unsigned int i = 0; i < volumeCount; i++)
+        {
+            glm::vec4 sphere = m_records[i].GetBoundingSphere();
+            if (sphere != m_bvhSpheres[i])
+            {
+                m_bvhSpheres[i] = sphere;
+                m_bvh.SetBounds(i, glm::vec3(sphere) - sphere.w, glm::vec3(sphere) + sphere.w);
+                m_refitCount++;
+            }
+        }
+
+        // Lights that wandered far from where they were built leave big, overlapping boxes behind. Start over.
+        m_rebuilt = m_bvh.GetDegradation() > m_rebuildThreshold;
+    }
+
+    if (m_rebuilt)
+    {
+        std::vector<glm::vec3> mins(volumeCount);
+        std::vector<glm::vec3> maxs(volumeCount);
+        for (unsigned int i = 0; i < volumeCount; i++)
+        {
+            mins[i] = glm::vec3(m_bvhSpheres[i]) - m_bvhSpheres[i].w;
+            maxs[i] = glm::vec3(m_bvhSpheres[i]) + m_bvhSpheres[i].w;
+        }
+        m_bvh.Build(mins, maxs);
+    }
+}
+
+LightBVH& LightBuffer::GetBVH()
+{
+    return m_bvh;
+}
+
+unsigned int LightBuffer::GetRefitCount()
+{
+    return m_refitCount;
+}
+
+bool LightBuffer::GetRebuilt()
+{
+    return m_rebuilt;
+}
+
+void LightBuffer::SetRebuildThreshold(float degradation)
+{
+    m_rebuildThreshold = degradation;
+}
@@ -0,0 +1,116 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightBuffer.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "glm/glm.hpp"
+#include <vector>
+
+#include "lights.h"
+#include "lightBVH.h"
+#include "lightArrays.h"
+#include "lightProfiles.h"
+
+// Must match the binding of the Lights block in lightTypes.glsl.
+#define LIGHT_BUFFER_BINDING 0
+// Must match the binding of the SpotShadows block in lightFrag.glsl.
+#define LIGHT_SHADOW_BINDING 4
+
+// Every light in the scene as one array of tagged records (LightRecord in lights.h), in one storage buffer.
+// The light volume pass and the ambient light pass both read it, each shader works out what a light is from its type.
+// Records are sorted by type: point lights first, then spot lights (both drawn as volumes), then directional lights.
+// On the CPU the lights are kept as arrays of values (LightArrays), the records are packed from them on upload.
+// Spot lights' shadows go in a second, smaller buffer, only shadowed spot lights have an entry.
+//
+// The buffer also keeps a bounding volume hierarchy over the point and spot lights (by record index), for finding
+// the lights that touch something without looking at all of them. Lights that moved are refitted in place, and the
+// tree is only rebuilt when the number of lights changes or refitting has made it too loose.
+class LightBuffer
+{
+public:
+    LightBuffer();
+    ~LightBuffer();
+
+    // Rebuilds the records and uploads them. Shadows are optional, and line up with their lights
+    // (PointShadowRenderer::GetShadowIndices and SpotShadowRenderer::GetShadows), lights past the end have none.
+    void Update(std::vector<PointLight>& pointLights, std::vector<SpotLight>& spotLights, std::vector<DirectionalLight>& directionalLights,
+        const std::vector<float>& pointShadowIndices = std::vector<float>(), const std::vector<SpotShadow>& spotShadows = std::vector<SpotShadow>());
+
+    // Spot lights without a profile of their own get one made from their exponent (LightProfiles::AddExponent).
+    // Without profiles, the shader works the exponent out itself. GetLights().Evaluate reads the same profiles.
+    void SetProfiles(LightProfiles* profiles);
+
+    // Makes the buffers visible to shaders at LIGHT_BUFFER_BINDING and LIGHT_SHADOW_BINDING.
+    void Bind();
+    void Unbind();
+
+    // Where each type starts in the buffer, and how many there are.
+    unsigned int GetFirstPoint();
+    unsigned int GetPointCount();
+    unsigned int GetFirstSpot();
+    unsigned int GetSpotCount();
+    unsigned int GetFirstDirectional();
+    unsigned int GetDirectionalCount();
+
+    std::vector<LightRecord>& GetRecords();
+
+    // The same lights, as arrays.
+    LightArrays& GetLights();
+
+    // The tree over every point and spot light's bounding sphere, up to date with the last Update.
+    LightBVH& GetBVH();
+
+    // How many lights were refitted into the tree by the last Update, and whether it had to be rebuilt instead.
+    unsigned int GetRefitCount();
+    bool GetRebuilt();
+
+    // Rebuild once the tree's boxes add up to this many times the area they had after the last build.
+    void SetRebuildThreshold(float degradation);
+
+private:
+    GLuint m_buffer;
+    GLuint m_shadowBuffer;
+
+    // Only grow the buffers, there's no need to reallocate them every frame.
+    unsigned int m_capacity = 0;
+    unsigned int m_shadowCapacity = 0;
+
+    LightArrays m_lights;
+    LightProfiles* m_profiles = nullptr;
+    std::vector<LightRecord> m_records;
+    std::vector<SpotShadow> m_spotShadows;
+    unsigned int m_pointCount = 0;
+    unsigned int m_spotCount = 0;
+    unsigned int m_directionalCount = 0;
+
+    // Rebuilds or refits the tree from the records.
+    void UpdateBVH();
+
+    LightBVH m_bvh;
+    std::vector<glm::vec4> m_bvhSpheres;
+    unsigned int m_refitCount = 0;
+    bool m_rebuilt = false;
+    float m_rebuildThreshold = 1.5f;
+};
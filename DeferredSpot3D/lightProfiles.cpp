@@ -0,0 +1,515 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightProfiles.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "lightProfiles.h"
+#include "selfTest.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <random>
+#include <cstring>
+
+bool IESProfile::Parse(const std::string& text, IESProfile& profile)
+{
+    // Everything before the TILT line is keywords ([TEST], [MANUFAC]...), which don't change the light.
+    size_t tilt = text.find("TILT=");
+    if (tilt == std::string::npos)
+    {
+        std::cout << "IES profile has no TILT= line, it isn't an IES file" << std::endl;
+        return false;
+    }
+    size_t tiltEnd = text.find_first_of("\r\n", tilt);
+    if (tiltEnd == std::string::npos)
+    {
+        std::cout << "IES profile ends after its TILT= line" << std::endl;
+        return false;
+    }
+    std::string tiltValue = text.substr(tilt + 5, tiltEnd - tilt - 5);
+    tiltValue.erase(tiltValue.find_last_not_of(" \t") + 1);
+
+    // The rest is numbers, separated by spaces, commas or line breaks.
+    std::string rest = text.substr(tiltEnd);
+    std::replace(rest.begin(), rest.end(), ',', ' ');
+    std::istringstream stream(rest);
+    std::vector<float> numbers;
+    float number;
+    while (stream >> number)
+    {
+        numbers.push_back(number);
+    }
+    if (!stream.eof())
+    {
+        std::cout << "IES profile has something that isn't a number after its TILT= line" << std::endl;
+        return false;
+    }
+
+    // A tilt table says how the lamp's output changes as the whole light is tilted.
+    // Lights here don't tilt away from how they were measured, so it's skipped over.
+    unsigned int next = 0;
+    if (tiltValue == "INCLUDE")
+    {
+        if (numbers.size() < 2)
+        {
+            std::cout << "IES profile's tilt table is cut off" << std::endl;
+            return false;
+        }
+        next = 2 + 2 * (unsigned int)numbers[1];
+    }
+    else if (tiltValue != "NONE")
+    {
+        std::cout << "IES profile's tilt file (" << tiltValue << ") is ignored" << std::endl;
+    }
+
+    // Lamps, lumens per lamp, multiplier, vertical and horizontal angle counts, photometric type, units, width,
+    // length, height, then ballast factor, a value for future use, and input watts.
+    if (numbers.size() < next + 13)
+    {
+        std::cout << "IES profile is cut off before the end of its header" << std::endl;
+        return false;
+    }
+    float multiplier = numbers[next + 2] * numbers[next + 10];
+    unsigned int verticalCount = (unsigned int)numbers[next + 3];
+    unsigned int horizontalCount = (unsigned int)numbers[next + 4];
+    int photometricType = (int)numbers[next + 5];
+    next += 13;
+
+    if (photometricType != 1)
+    {
+        std::cout << "IES profile uses type " << (photometricType == 2 ? "B" : "A") << " photometry, only type C is supported" << std::endl;
+        return false;
+    }
+    if (verticalCount == 0 || horizontalCount == 0)
+    {
+        std::cout << "IES profile has no angles" << std::endl;
+        return false;
+    }
+    if (numbers.size() < next + verticalCount + horizontalCount + verticalCount * horizontalCount)
+    {
+        std::cout << "IES profile is cut off, it has " << numbers.size() - next << " of "
+            << verticalCount + horizontalCount + verticalCount * horizontalCount << " angles and values" << std::endl;
+        return false;
+    }
+
+    profile.m_verticalAngles.assign(numbers.begin() + next, numbers.begin() + next + verticalCount);
+    next += verticalCount;
+    profile.m_horizontalAngles.assign(numbers.begin() + next, numbers.begin() + next + horizontalCount);
+    next += horizontalCount;
+    profile.m_candela.assign(numbers.begin() + next, numbers.begin() + next + verticalCount * horizontalCount);
+    for (unsigned int i = 0; i < profile.m_candela.size(); i++)
+    {
+        profile.m_candela[i] *= multiplier;
+    }
+
+    // Interpolation needs the angles in order.
+    if (!std::is_sorted(profile.m_verticalAngles.begin(), profile.m_verticalAngles.end()) ||
+        !std::is_sorted(profile.m_horizontalAngles.begin(), profile.m_horizontalAngles.end()))
+    {
+        std::cout << "IES profile's angles aren't in order" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool IESProfile::Load(const char* filePath, IESProfile& profile)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "Error opening IES profile: " << filePath << std::endl;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    if (!Parse(text.str(), profile))
+    {
+        std::cout << "Error reading IES profile: " << filePath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+float IESProfile::GetCandela(float verticalAngle, float horizontalAngle)
+{
+    if (m_candela.empty() || verticalAngle < m_verticalAngles.front() || verticalAngle > m_verticalAngles.back())
+    {
+        return 0;
+    }
+
+    // Fold the horizontal angle into the part the file has.
+    unsigned int horizontalCount = m_horizontalAngles.size();
+    float last = m_horizontalAngles.back();
+    float h = std::fmod(horizontalAngle, 360.f);
+    if (h < 0)
+    {
+        h += 360;
+    }
+    if (last == 90)
+    {
+        h = h > 180 ? 360 - h : h;
+        h = h > 90 ? 180 - h : h;
+    }
+    else if (last == 180)
+    {
+        h = h > 180 ? 360 - h : h;
+    }
+
+    // The planes on either side. A file that doesn't reach 360 wraps from its last plane back around to its first.
+    unsigned int h0 = 0, h1 = 0;
+    float ht = 0;
+    if (horizontalCount > 1 && h >= last)
+    {
+        h0 = horizontalCount - 1;
+        float span = m_horizontalAngles.front() + 360 - last;
+        ht = span > 0 ? (h - last) / span : 0;
+    }
+    else if (horizontalCount > 1 && h > m_horizontalAngles.front())
+    {
+        h1 = std::upper_bound(m_horizontalAngles.begin(), m_horizontalAngles.end(), h) - m_horizontalAngles.begin();
+        h0 = h1 - 1;
+        ht = (h - m_horizontalAngles[h0]) / (m_horizontalAngles[h1] - m_horizontalAngles[h0]);
+    }
+
+    // The vertical angles on either side.
+    unsigned int verticalCount = m_verticalAngles.size();
+    unsigned int v1 = std::upper_bound(m_verticalAngles.begin(), m_verticalAngles.end(), verticalAngle) - m_verticalAngles.begin();
+    v1 = glm::min(v1, verticalCount - 1);
+    unsigned int v0 = v1 > 0 ? v1 - 1 : 0;
+    float vt = v1 > v0 ? glm::clamp((verticalAngle - m_verticalAngles[v0]) / (m_verticalAngles[v1] - m_verticalAngles[v0]), 0.f, 1.f) : 0;
+
+    float* plane0 = &m_candela[h0 * verticalCount];
+    float* plane1 = &m_candela[h1 * verticalCount];
+    return glm::mix(glm::mix(plane0[v0], plane0[v1], vt), glm::mix(plane1[v0], plane1[v1], vt), ht);
+}
+
+float IESProfile::GetMaxCandela()
+{
+    return m_candela.empty() ? 0 : *std::max_element(m_candela.begin(), m_candela.end());
+}
+
+LightProfiles::LightProfiles()
+{
+    // Half floats keep the dim edges of steep falloffs that 8 bits would round away.
+    m_texture = new Texture(glm::uvec3(LIGHT_PROFILE_WIDTH, LIGHT_PROFILE_HEIGHT, LIGHT_PROFILE_LAYERS), GL_R16F, GL_LINEAR);
+    m_texture->IncRefCount();
+
+    // Going around the axis comes back to the start.
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture->GetGLTexture());
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+LightProfiles::~LightProfiles()
+{
+    m_texture->DecRefCount();
+}
+
+int LightProfiles::Add(std::vector<float>& texels)
+{
+    if (m_layers.size() >= LIGHT_PROFILE_LAYERS)
+    {
+        std::cout << "Light profile array is full (" << LIGHT_PROFILE_LAYERS << " layers)" << std::endl;
+        return -1;
+    }
+
+    int layer = m_layers.size();
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture->GetGLTexture());
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, LIGHT_PROFILE_WIDTH, LIGHT_PROFILE_HEIGHT, 1, GL_RED, GL_FLOAT, texels.data());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    m_layers.push_back(texels);
+    return layer;
+}
+
+int LightProfiles::AddExponent(float exponent)
+{
+    std::map<float, int>::iterator found = m_exponentLayers.find(exponent);
+    if (found != m_exponentLayers.end())
+    {
+        return found->second;
+    }
+
+    std::vector<float> texels;
+    ResampleExponent(exponent, texels);
+    int layer = Add(texels);
+    m_exponentLayers[exponent] = layer;
+    return layer;
+}
+
+int LightProfiles::AddIES(IESProfile& profile)
+{
+    if (profile.GetMaxCandela() <= 0)
+    {
+        std::cout << "IES profile gives off no light" << std::endl;
+        return -1;
+    }
+    std::vector<float> texels;
+    ResampleIES(profile, texels);
+    return Add(texels);
+}
+
+int LightProfiles::AddIES(const char* filePath)
+{
+    IESProfile profile;
+    if (!IESProfile::Load(filePath, profile))
+    {
+        return -1;
+    }
+    return AddIES(profile);
+}
+
+int LightProfiles::AddCookie(const char* filePath, float fieldAngle)
+{
+    DecodedImage image;
+    if (!ImageDecoder::Decode(filePath, image))
+    {
+        return -1;
+    }
+    if (image.IsCompressed())
+    {
+        std::cout << "Cookies can't be block compressed: " << filePath << std::endl;
+        return -1;
+    }
+
+    // Only the brightness of the image is used (the light's color is in its record).
+    std::vector<float> luminance(image.m_width * image.m_height);
+    for (unsigned int i = 0; i < luminance.size(); i++)
+    {
+        unsigned char* bgra = &image.m_pixels[i * 4];
+        luminance[i] = (.0722f * bgra[0] + .7152f * bgra[1] + .2126f * bgra[2]) / 255.f;
+    }
+    return AddCookie(luminance, image.m_width, image.m_height, fieldAngle);
+}
+
+int LightProfiles::AddCookie(const std::vector<float>& luminance, unsigned int width, unsigned int height, float fieldAngle)
+{
+    std::vector<float> texels;
+    if (!ResampleCookie(luminance, width, height, fieldAngle, texels))
+    {
+        return -1;
+    }
+    return Add(texels);
+}
+
+unsigned int LightProfiles::GetCount()
+{
+    return m_layers.size();
+}
+
+Texture* LightProfiles::GetTexture()
+{
+    return m_texture;
+}
+
+std::vector<float>& LightProfiles::GetLayer(int layer)
+{
+    return m_layers[layer];
+}
+
+float LightProfiles::GetColumnAngle(unsigned int column)
+{
+    return 2 * std::asin((column + .5f) / LIGHT_PROFILE_WIDTH);
+}
+
+float LightProfiles::GetRowAngle(unsigned int row)
+{
+    return (row + .5f) / LIGHT_PROFILE_HEIGHT * glm::two_pi<float>();
+}
+
+void LightProfiles::ResampleExponent(float exponent, std::vector<float>& texels)
+{
+    // The same all the way around, and nothing behind the light.
+    texels.resize(LIGHT_PROFILE_WIDTH * LIGHT_PROFILE_HEIGHT);
+    for (unsigned int column = 0; column < LIGHT_PROFILE_WIDTH; column++)
+    {
+        float value = std::pow(glm::max(std::cos(GetColumnAngle(column)), 0.f), exponent);
+        for (unsigned int row = 0; row < LIGHT_PROFILE_HEIGHT; row++)
+        {
+            texels[row * LIGHT_PROFILE_WIDTH + column] = value;
+        }
+    }
+}
+
+void LightProfiles::ResampleIES(IESProfile& profile, std::vector<float>& texels)
+{
+    float scale = 1 / profile.GetMaxCandela();
+    texels.resize(LIGHT_PROFILE_WIDTH * LIGHT_PROFILE_HEIGHT);
+    for (unsigned int row = 0; row < LIGHT_PROFILE_HEIGHT; row++)
+    {
+        float horizontal = glm::degrees(GetRowAngle(row));
+        for (unsigned int column = 0; column < LIGHT_PROFILE_WIDTH; column++)
+        {
+            texels[row * LIGHT_PROFILE_WIDTH + column] = profile.GetCandela(glm::degrees(GetColumnAngle(column)), horizontal) * scale;
+        }
+    }
+}
+
+bool LightProfiles::ResampleCookie(const std::vector<float>& luminance, unsigned int width, unsigned int height, float fieldAngle,
+    std::vector<float>& texels)
+{
+    if (width == 0 || height == 0 || luminance.size() < width * height)
+    {
+        std::cout << "Cookie image is empty" << std::endl;
+        return false;
+    }
+    if (fieldAngle <= 0 || fieldAngle >= glm::half_pi<float>())
+    {
+        std::cout << "Cookie field angle has to be between 0 and 90 degrees" << std::endl;
+        return false;
+    }
+
+    float fieldTangent = std::tan(fieldAngle);
+    texels.resize(LIGHT_PROFILE_WIDTH * LIGHT_PROFILE_HEIGHT);
+    for (unsigned int row = 0; row < LIGHT_PROFILE_HEIGHT; row++)
+    {
+        float around = GetRowAngle(row);
+        for (unsigned int column = 0; column < LIGHT_PROFILE_WIDTH; column++)
+        {
+            // How far out in the image this direction lands, 1 at the edge of the field.
+            float angle = GetColumnAngle(column);
+            float distance = angle < glm::half_pi<float>() ? std::tan(angle) / fieldTangent : 2;
+            if (distance > 1)
+            {
+                texels[row * LIGHT_PROFILE_WIDTH + column] = 0;
+                continue;
+            }
+
+            // Bilinear sample of the image, side axis to the right.
+            float x = glm::clamp((.5f + .5f * distance * std::cos(around)) * width - .5f, 0.f, width - 1.f);
+            float y = glm::clamp((.5f + .5f * distance * std::sin(around)) * height - .5f, 0.f, height - 1.f);
+            unsigned int x0 = (unsigned int)x, y0 = (unsigned int)y;
+            unsigned int x1 = glm::min(x0 + 1, width - 1), y1 = glm::min(y0 + 1, height - 1);
+            float tx = x - x0, ty = y - y0;
+            float bottom = glm::mix(luminance[y0 * width + x0], luminance[y0 * width + x1], tx);
+            float top = glm::mix(luminance[y1 * width + x0], luminance[y1 * width + x1], tx);
+            texels[row * LIGHT_PROFILE_WIDTH + column] = glm::mix(bottom, top, ty);
+        }
+    }
+    return true;
+}
+
+float LightProfiles::Sample(const std::vector<float>& texels, float angle, float around)
+{
+    // Texel centers are half a texel in, like the GPU.
+    float x = glm::clamp(std::sin(glm::clamp(angle, 0.f, glm::pi<float>()) * .5f) * LIGHT_PROFILE_WIDTH - .5f, 0.f, LIGHT_PROFILE_WIDTH - 1.f);
+    float y = around / glm::two_pi<float>() * LIGHT_PROFILE_HEIGHT - .5f;
+
+    unsigned int x0 = (unsigned int)x;
+    unsigned int x1 = glm::min(x0 + 1, (unsigned int)LIGHT_PROFILE_WIDTH - 1);
+    float tx = x - x0;
+
+    // Rows repeat.
+    float rowFloor = std::floor(y);
+    float ty = y - rowFloor;
+    int wrapped = (int)rowFloor % LIGHT_PROFILE_HEIGHT;
+    unsigned int y0 = wrapped < 0 ? wrapped + LIGHT_PROFILE_HEIGHT : wrapped;
+    unsigned int y1 = (y0 + 1) % LIGHT_PROFILE_HEIGHT;
+
+    float bottom = glm::mix(texels[y0 * LIGHT_PROFILE_WIDTH + x0], texels[y0 * LIGHT_PROFILE_WIDTH + x1], tx);
+    float top = glm::mix(texels[y1 * LIGHT_PROFILE_WIDTH + x0], texels[y1 * LIGHT_PROFILE_WIDTH + x1], tx);
+    return glm::mix(bottom, top, ty);
+}
+
+int LightProfiles::RunTest()
+{
+    SelfTest test("Light profiles");
+
+    // A small file with a tilt table, commas, a multiplier of 2, and planes from 0 to 180 (mirrored across 0-180).
+    const char* text =
+        "IESNA:LM-63-2002\r\n"
+        "[TEST] Light profile test\r\n"
+        "[LUMINAIRE] Test light\r\n"
+        "TILT=INCLUDE\r\n"
+        "1\r\n3\r\n0, 45, 90\r\n1, .9, .8\r\n"
+        "1 1000 2 5 3 1 2 .1 .1 .1\r\n"
+        "1 1 20\r\n"
+        "0 22.5 45 67.5 90\r\n"
+        "0 90 180\r\n"
+        "50 45 40 20 0\r\n"
+        "100 75 50 25 0\r\n"
+        "150 100 50 25 5\r\n";
+
+    IESProfile profile;
+    if (!IESProfile::Parse(text, profile) || profile.m_verticalAngles.size() != 5 || profile.m_horizontalAngles.size() != 3)
+    {
+        test.Fail() << "IES file not read" << std::endl;
+        return test.Finish();
+    }
+
+    // Candela at and between the angles in the file, with the multiplier applied.
+    struct { float vertical, horizontal, candela; } expected[] = {
+        { 0, 0, 100 }, { 22.5f, 90, 150 }, { 45, 180, 100 }, { 11.25f, 0, 95 }, { 0, 45, 150 },
+        { 22.5f, 270, 150 }, { 22.5f, 225, 175 }, { 90, 180, 10 }, { 100, 0, 0 } };
+    for (unsigned int i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+    {
+        float candela = profile.GetCandela(expected[i].vertical, expected[i].horizontal);
+        if (glm::abs(candela - expected[i].candela) > 1e-3f)
+        {
+            test.Fail() << "Candela at " << expected[i].vertical << ", " << expected[i].horizontal << " is " << candela
+                << ", should be " << expected[i].candela << std::endl;
+        }
+    }
+
+    // Files that aren't IES, or stop early, are refused.
+    std::cout << "  (Two errors expected:)" << std::endl;
+    IESProfile broken;
+    test.Check(!IESProfile::Parse("not a light", broken) && !IESProfile::Parse(std::string(text).substr(0, std::strlen(text) - 30), broken),
+        "A broken IES file was read");
+
+    // Each kind of layer, read back at random directions, against the falloff it came from.
+    std::mt19937 random(77);
+    std::uniform_real_distribution<float> unit(0, 1);
+    std::vector<float> iesTexels, exponentTexels, cookieTexels;
+    ResampleIES(profile, iesTexels);
+    ResampleExponent(16, exponentTexels);
+
+    // A cookie that gets brighter from left to right, over a 45 degree field.
+    const unsigned int cookieSize = 64;
+    std::vector<float> cookie(cookieSize * cookieSize);
+    for (unsigned int i = 0; i < cookie.size(); i++)
+    {
+        cookie[i] = (i % cookieSize) / (cookieSize - 1.f);
+    }
+    float field = glm::quarter_pi<float>();
+    test.Check(ResampleCookie(cookie, cookieSize, cookieSize, field, cookieTexels), "The cookie wasn't resampled");
+
+    float worstIES = 0, worstExponent = 0, worstCookie = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        float angle = unit(random) * glm::radians(90.f);
+        float around = unit(random) * glm::two_pi<float>();
+        float ies = profile.GetCandela(glm::degrees(angle), glm::degrees(around)) / profile.GetMaxCandela();
+        worstIES = glm::max(worstIES, glm::abs(Sample(iesTexels, angle, around) - ies));
+        worstExponent = glm::max(worstExponent, glm::abs(Sample(exponentTexels, angle, around) - std::pow(std::cos(angle), 16.f)));
+
+        // The gradient is linear, so away from the edge of the field it's exactly where the direction lands.
+        float cookieAngle = std::atan(unit(random) * .9f * std::tan(field));
+        float distance = std::tan(cookieAngle) / std::tan(field);
+        float value = .5f + .5f * distance * std::cos(around);
+        worstCookie = glm::max(worstCookie, glm::abs(Sample(cookieTexels, cookieAngle, around) - value));
+    }
+    std::cout << "  Largest difference from the falloff: IES " << worstIES << ", exponent " << worstExponent << ", cookie " << worstCookie << std::endl;
+    test.Check(worstIES <= .02f && worstExponent <= .01f && worstCookie <= .02f, "A layer is too far from its falloff");
+
+    return test.Finish();
+}
@@ -0,0 +1,119 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightProfiles.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/constants.hpp"
+#include <vector>
+#include <map>
+#include <string>
+#include <iostream>
+
+#include "texture.h"
+#include "imageDecoder.h"
+
+// The size of every profile, and how many profiles fit in the array.
+#define LIGHT_PROFILE_WIDTH 128
+#define LIGHT_PROFILE_HEIGHT 64
+#define LIGHT_PROFILE_LAYERS 32
+
+// A photometric file in the IESNA LM-63 format, the candela a real luminaire gives off in each direction.
+// Only type C photometry (the usual one for interior lights) is read. Angles are in degrees, vertical angle 0 is
+// straight down the light's axis, and horizontal angles go around it.
+struct IESProfile
+{
+    std::vector<float> m_verticalAngles;
+    std::vector<float> m_horizontalAngles;
+    // One row of vertical angles per horizontal angle, already scaled by the file's multipliers.
+    std::vector<float> m_candela;
+
+    // Interpolates the candela in any direction. Horizontal angles the file leaves out come from its symmetry
+    // (one plane: the same all around, last plane 90: the same in every quadrant, 180: mirrored across 0-180).
+    // Past the last vertical angle there is no light.
+    float GetCandela(float verticalAngle, float horizontalAngle);
+    float GetMaxCandela();
+
+    // Reads the text of a file. Returns false (and prints why) if it isn't one.
+    static bool Parse(const std::string& text, IESProfile& profile);
+    static bool Load(const char* filePath, IESProfile& profile);
+};
+
+// The falloff of every spot light, as layers of one texture array (sampler2DArray lightProfiles in lightTypes.glsl).
+// The light shader reads a light's falloff with one fetch from the layer in its record, instead of working it out.
+// A layer can come from a spot exponent (what pow(spotEffect, exponent) gives), an IES file, or a cookie image.
+//
+// Layers are laid out around the light's axis: u = sin(angle from the axis / 2), so from the axis out to straight
+// behind the light, nearly evenly spread over the angle without needing acos. v goes once around the axis, starting
+// from the light's side axis (its local x). Values are relative to the brightest direction, from 0 to 1.
+class LightProfiles
+{
+public:
+    LightProfiles();
+    ~LightProfiles();
+
+    // Each returns the layer to give a light (SpotLight::m_profile), or -1 (and prints why) if it couldn't be added.
+    // Exponent layers are shared by every light with the same exponent.
+    int AddExponent(float exponent);
+    int AddIES(IESProfile& profile);
+    int AddIES(const char* filePath);
+    // The image is projected along the light's axis, its edges at fieldAngle (radians, less than 90 degrees) from it.
+    // Outside the circle that fits in the image there is no light.
+    int AddCookie(const char* filePath, float fieldAngle);
+    int AddCookie(const std::vector<float>& luminance, unsigned int width, unsigned int height, float fieldAngle);
+
+    unsigned int GetCount();
+    Texture* GetTexture();
+    std::vector<float>& GetLayer(int layer);
+
+    // The texels of a layer, LIGHT_PROFILE_WIDTH by LIGHT_PROFILE_HEIGHT, from a falloff.
+    // These don't touch OpenGL, so they can be checked on the CPU.
+    static void ResampleExponent(float exponent, std::vector<float>& texels);
+    static void ResampleIES(IESProfile& profile, std::vector<float>& texels);
+    // The luminance is width by height, bottom row first.
+    static bool ResampleCookie(const std::vector<float>& luminance, unsigned int width, unsigned int height, float fieldAngle,
+        std::vector<float>& texels);
+
+    // Reads a layer the way the light shader does (bilinear, clamped out from the axis, repeating around it).
+    // angle is from the light's axis, around is from its side axis, both in radians.
+    static float Sample(const std::vector<float>& texels, float angle, float around);
+
+    // Checks the IES reader and every resampler against the falloffs they come from.
+    static int RunTest();
+
+private:
+    // Copies texels into the next layer. Returns the layer.
+    int Add(std::vector<float>& texels);
+
+    Texture* m_texture;
+    std::vector<std::vector<float>> m_layers;
+
+    // The layer made for each exponent (-1 if the array was full).
+    std::map<float, int> m_exponentLayers;
+
+    // The angles the center of each column and row stand for.
+    static float GetColumnAngle(unsigned int column);
+    static float GetRowAngle(unsigned int row);
+};
@@ -0,0 +1,549 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightVolumeRenderer.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "lightVolumeRenderer.h"
+
+LightVolumeRenderer::LightVolumeRenderer()
+{
+    std::vector<glm::vec3> vertices;
+    std::vector<unsigned int> indices;
+
+    // Point lights are an icosphere.
+    LoadVolume("../assets/icosphere.obj", vertices, indices);
+    m_sphere = AddShape(vertices, indices);
+
+    // Spot lights get every tessellation of the rounded cone.
+    for (int level = 0; level < LIGHT_SECTOR_LEVELS; level++)
+    {
+        BuildSector(GetSectorSegments(level), vertices, indices);
+        m_sectors.push_back(AddShape(vertices, indices));
+    }
+    m_sectorLights.resize(LIGHT_SECTOR_LEVELS);
+
+    // The quad's corners, the vertex shader stretches them over the light on screen.
+    // Wound clockwise, so it's a back face like the inside of the other volumes.
+    vertices = { glm::vec3(0, 0, 0), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(1, 1, 0) };
+    indices = { 0, 2, 1, 1, 2, 3 };
+    m_quad = AddShape(vertices, indices);
+
+    // Set up vertex buffer
+    glGenBuffers(1, &m_vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(glm::vec3), m_vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Set up index buffer
+    glGenBuffers(1, &m_indexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_indexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_indices.size() * sizeof(unsigned int), m_indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // The instances, draw commands and stats are filled when rendering.
+    glGenBuffers(1, &m_instanceBuffer);
+    glGenBuffers(1, &m_indirectBuffer);
+    glGenBuffers(1, &m_statsBuffer);
+    glGenBuffers(1, &m_boundsBuffer);
+}
+
+LightVolumeRenderer::~LightVolumeRenderer()
+{
+    glDeleteBuffers(1, &m_vertexBuffer);
+    glDeleteBuffers(1, &m_indexBuffer);
+    glDeleteBuffers(1, &m_instanceBuffer);
+    glDeleteBuffers(1, &m_indirectBuffer);
+    glDeleteBuffers(1, &m_statsBuffer);
+    glDeleteBuffers(1, &m_boundsBuffer);
+}
+
+bool LightVolumeRenderer::LoadVolume(std::string filePath, std::vector<glm::vec3>& vertices, std::vector<unsigned int>& indices)
+{
+    vertices.clear();
+    indices.clear();
+
+    // This is a simpler version of the mesh loading code, light volumes only have positions.
+    std::ifstream file(filePath);
+    if (!file.good())
+    {
+        // If we encounter an error, print a message and return.
+        std::cout << "Can't read file: " << filePath << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        // Vertex positions
+        if (strncmp("v ", &line[0], 2) == 0)
+        {
+            strtok(&line[0], " ");
+            float x = std::stof(strtok(NULL, " "));
+            float y = std::stof(strtok(NULL, " "));
+            float z = std::stof(strtok(NULL, " "));
+            vertices.push_back(glm::vec3(x, y, z));
+        }
+        // Faces, with only positions there's nothing to sort, the indices go straight into the index buffer.
+        else if (strncmp("f", &line[0], 1) == 0)
+        {
+            char* token = strtok(&line[0], " ");
+            while ((token = strtok(0, " ")) != NULL)
+            {
+                indices.push_back(std::stoi(token) - 1);
+            }
+        }
+    }
+
+    file.close();
+    return true;
+}
+
+DrawElementsIndirectCommand LightVolumeRenderer::AddShape(std::vector<glm::vec3>& vertices, std::vector<unsigned int>& indices)
+{
+    // Indices stay relative to the shape's first vertex, the draw command's base vertex makes up the difference.
+    DrawElementsIndirectCommand command(indices.size(), 0, m_indices.size(), m_vertices.size(), 0);
+    m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
+    m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+    return command;
+}
+
+void LightVolumeRenderer::BuildSector(unsigned int segments, std::vector<glm::vec3>& vertices, std::vector<unsigned int>& indices)
+{
+    vertices.clear();
+    indices.clear();
+
+    // Rings of the cap, from the middle out to the rim. A quarter as many as the segments keeps the steps between
+    // rings no bigger than the steps around, for any angle up to 90 degrees.
+    unsigned int rings = glm::max(segments / 4, 2u);
+
+    // A flat facet between points on a circle cuts inside it, by cos(half the step) at its middle.
+    // The vertex shader pushes the cap and the sides out by that, so the facets never cut into the lit area.
+    // It's stored in every vertex except the tip, which is 0.
+    float step = glm::cos(glm::pi<float>() / segments);
+
+    // The tip, and the middle of the cap.
+    vertices.push_back(glm::vec3(0, 0, 0));
+    vertices.push_back(glm::vec3(0, 0, step));
+
+    // Then each ring, with vertex (ring - 1) * segments + segment + 2.
+    for (unsigned int ring = 1; ring <= rings; ring++)
+    {
+        for (unsigned int segment = 0; segment < segments; segment++)
+        {
+            vertices.push_back(glm::vec3((float)segment / segments, (float)ring / rings, step));
+        }
+    }
+
+    // Triangles are wound counter clockwise seen from outside, like the obj volumes.
+    for (unsigned int segment = 0; segment < segments; segment++)
+    {
+        unsigned int next = (segment + 1) % segments;
+
+        // Around the middle of the cap.
+        indices.push_back(1);
+        indices.push_back(2 + next);
+        indices.push_back(2 + segment);
+
+        // Between each ring and the next one out.
+        for (unsigned int ring = 1; ring < rings; ring++)
+        {
+            unsigned int inner = 2 + (ring - 1) * segments;
+            unsigned int outer = inner + segments;
+            indices.push_back(inner + segment);
+            indices.push_back(outer + next);
+            indices.push_back(outer + segment);
+            indices.push_back(inner + segment);
+            indices.push_back(inner + next);
+            indices.push_back(outer + next);
+        }
+
+        // The side of the cone, from the rim to the tip.
+        unsigned int rim = 2 + (rings - 1) * segments;
+        indices.push_back(0);
+        indices.push_back(rim + segment);
+        indices.push_back(rim + next);
+    }
+}
+
+unsigned int LightVolumeRenderer::GetSectorSegments(int level)
+{
+    return 8 << level;
+}
+
+int LightVolumeRenderer::ChooseSectorLevel(float pixelRadius)
+{
+    // With n segments, a facet's middle is r * (1 / cos(pi / n) - 1), about r * (pi / n)^2 / 2, pixels away from the
+    // circle. Keeping that under a pixel needs n > pi * sqrt(r / 2).
+    float needed = glm::pi<float>() * sqrt(glm::max(pixelRadius, 0.f) / 2);
+    for (int level = 0; level < LIGHT_SECTOR_LEVELS; level++)
+    {
+        if (GetSectorSegments(level) >= needed)
+        {
+            return level;
+        }
+    }
+    return LIGHT_SECTOR_LEVELS - 1;
+}
+
+float LightVolumeRenderer::GetPixelRadius(glm::vec4 sphere, glm::vec3 cameraPosition, float projectionScale, float viewportHeight)
+{
+    glm::vec3 toSphere = glm::vec3(sphere) - cameraPosition;
+    float distanceSquared = glm::dot(toSphere, toSphere);
+    if (distanceSquared <= sphere.w * sphere.w)
+    {
+        return viewportHeight;
+    }
+
+    // The sphere's silhouette is a cone from the camera, the tangent of its half angle is r / sqrt(d^2 - r^2).
+    // Projecting that scales it by projection[1][1], which covers half the viewport.
+    return sphere.w / sqrt(distanceSquared - sphere.w * sphere.w) * projectionScale * viewportHeight * .5f;
+}
+
+bool LightVolumeRenderer::GetScreenBounds(LightRecord& light, glm::mat4& view, glm::mat4& projection, LightScreenBounds& bounds)
+{
+    // Start with a box around the bounding sphere, in view space.
+    glm::vec4 sphere = light.GetBoundingSphere();
+    glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(sphere), 1));
+    glm::vec3 boxMin = center - sphere.w;
+    glm::vec3 boxMax = center + sphere.w;
+
+    // A spot light up to 90 degrees is inside its tip plus the slab its cap is in: two discs around the direction,
+    // one through the rim and one at full range. A disc of radius r facing n is r * sqrt(1 - n^2) wide along each axis.
+    // Where that box is smaller than the sphere's, use it.
+    float angle = light.m_coneShadow.x;
+    if (light.m_positionType.w == LIGHT_TYPE_SPOT && angle < glm::half_pi<float>())
+    {
+        float range = light.m_directionRange.w;
+        glm::vec3 tip = glm::vec3(view * glm::vec4(glm::vec3(light.m_positionType), 1));
+        glm::vec3 direction = glm::normalize(glm::mat3(view) * glm::vec3(light.m_directionRange));
+        glm::vec3 discSize = range * glm::sin(angle) * glm::sqrt(glm::max(1.f - direction * direction, 0.f));
+
+        glm::vec3 rim = tip + direction * range * glm::cos(angle);
+        glm::vec3 end = tip + direction * range;
+        glm::vec3 coneMin = glm::min(tip, glm::min(rim, end) - discSize);
+        glm::vec3 coneMax = glm::max(tip, glm::max(rim, end) + discSize);
+
+        boxMin = glm::max(boxMin, coneMin);
+        boxMax = glm::min(boxMax, coneMax);
+    }
+
+    // The camera looks down -z. Nothing to draw if all of the box is behind the near plane.
+    // The near plane is where the projection puts depth at -1: z = -projection[3][2] / (projection[2][2] - 1).
+    float nearZ = -projection[3][2] / (projection[2][2] - 1);
+    if (boxMin.z >= nearZ)
+    {
+        return false;
+    }
+
+    // Cut the box off at the near plane. Every corner is in front of the camera now, so the corners bound its projection.
+    bool cutByNear = boxMax.z > nearZ;
+    boxMax.z = glm::min(boxMax.z, nearZ);
+
+    glm::vec2 rectMin = glm::vec2(1);
+    glm::vec2 rectMax = glm::vec2(-1);
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec3 corner = glm::vec3(i & 1 ? boxMax.x : boxMin.x, i & 2 ? boxMax.y : boxMin.y, i & 4 ? boxMax.z : boxMin.z);
+        glm::vec4 clip = projection * glm::vec4(corner, 1);
+        rectMin = glm::min(rectMin, glm::vec2(clip) / clip.w);
+        rectMax = glm::max(rectMax, glm::vec2(clip) / clip.w);
+    }
+    rectMin = glm::max(rectMin, glm::vec2(-1));
+    rectMax = glm::min(rectMax, glm::vec2(1));
+    if (rectMin.x >= rectMax.x || rectMin.y >= rectMax.y)
+    {
+        return false;
+    }
+
+    // Depth only gets bigger with distance, so the front and back of the box bound the light's depth.
+    // Depth buffer values are 0 to 1, a light that's all past the far plane can't light anything that was drawn.
+    glm::vec4 nearClip = projection * glm::vec4(0, 0, boxMax.z, 1);
+    glm::vec4 farClip = projection * glm::vec4(0, 0, boxMin.z, 1);
+    float nearDepth = glm::max(nearClip.z / nearClip.w * .5f + .5f, 0.f);
+    float farDepth = glm::min(farClip.z / farClip.w * .5f + .5f, 1.f);
+    if (nearDepth >= 1)
+    {
+        return false;
+    }
+
+    bounds.m_rect = glm::vec4(rectMin, rectMax);
+    bounds.m_depth = glm::vec4(nearDepth, farDepth, cutByNear ? 1 : 0, 1);
+    return true;
+}
+
+void LightVolumeRenderer::RenderLights(LightBuffer* lights, Material* lightMaterial, glm::mat4 view, glm::mat4 projection, float viewportHeight,
+    LightBudget* budget)
+{
+    // Pick up the counts from the last frame that recorded them. It's finished by now, or close.
+    if (m_statsPending > 0)
+    {
+        m_shadedPixels.resize(m_statsPending);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_statsPending * sizeof(unsigned int), m_shadedPixels.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        m_statsPending = 0;
+    }
+
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(view)[3]);
+    std::vector<LightRecord>& records = lights->GetRecords();
+    unsigned int volumeCount = lights->GetPointCount() + lights->GetSpotCount();
+
+    // Only the lights the light buffer's tree finds in the view can be on screen. Bound each of those on screen.
+    m_bounds.assign(records.size(), LightScreenBounds());
+    m_onScreen.assign(volumeCount, false);
+    m_screenAreas.assign(volumeCount, 0);
+    m_candidates.clear();
+    Frustum frustum = Frustum(projection * view);
+    lights->GetBVH().QueryFrustum(frustum, m_candidates);
+    m_culledCount = volumeCount;
+    for (unsigned int c = 0; c < m_candidates.size(); c++)
+    {
+        unsigned int i = m_candidates[c];
+        m_onScreen[i] = GetScreenBounds(records[i], view, projection, m_bounds[i]);
+        if (m_onScreen[i])
+        {
+            glm::vec4& rect = m_bounds[i].m_rect;
+            m_screenAreas[i] = (rect.z - rect.x) * (rect.w - rect.y) * .25f;
+            m_culledCount--;
+        }
+    }
+
+    // The budget decides how much of each light to draw. Lights it leaves out entirely aren't drawn.
+    if (budget != nullptr)
+    {
+        budget->Update(records, volumeCount, m_onScreen, m_screenAreas, m_weights);
+        for (unsigned int i = 0; i < volumeCount; i++)
+        {
+            m_bounds[i].m_depth.w = m_weights[i];
+        }
+    }
+
+    // Group the lights being drawn by the shape they're drawn with.
+    std::vector<GLuint> pointLights;
+    for (int level = 0; level < LIGHT_SECTOR_LEVELS; level++)
+    {
+        m_sectorLights[level].clear();
+    }
+    m_quadLights.clear();
+    unsigned int drawnCount = 0;
+    for (unsigned int i = 0; i < volumeCount; i++)
+    {
+        if (!m_onScreen[i] || m_bounds[i].m_depth.w <= 0)
+        {
+            continue;
+        }
+        drawnCount++;
+
+        // The near plane cuts through the light, its back faces could cover the whole screen. A quad covers only its rectangle.
+        bool spot = records[i].m_positionType.w == LIGHT_TYPE_SPOT;
+        if (m_bounds[i].m_depth.z != 0 || (spot && records[i].m_coneShadow.x >= glm::half_pi<float>()))
+        {
+            m_quadLights.push_back(i);
+        }
+        else if (spot)
+        {
+            float pixelRadius = GetPixelRadius(records[i].GetBoundingSphere(), cameraPosition, projection[1][1], viewportHeight);
+            m_sectorLights[ChooseSectorLevel(pixelRadius)].push_back(i);
+        }
+        else
+        {
+            pointLights.push_back(i);
+        }
+    }
+
+    if (drawnCount == 0)
+    {
+        return;
+    }
+
+    // One command per shape, each drawing its lights as instances. An instance's only data is which light it is
+    // and what shape it's drawn with, and each command's instances start at its base instance.
+    std::vector<DrawElementsIndirectCommand> commands;
+    m_instances.clear();
+
+    commands.push_back(m_sphere);
+    commands.back().m_instanceCount = pointLights.size();
+    commands.back().m_baseInstance = 0;
+    for (unsigned int i = 0; i < pointLights.size(); i++)
+    {
+        m_instances.push_back(glm::uvec2(pointLights[i], LIGHT_VOLUME_SPHERE));
+    }
+    for (int level = 0; level < LIGHT_SECTOR_LEVELS; level++)
+    {
+        commands.push_back(m_sectors[level]);
+        commands.back().m_instanceCount = m_sectorLights[level].size();
+        commands.back().m_baseInstance = m_instances.size();
+        for (unsigned int i = 0; i < m_sectorLights[level].size(); i++)
+        {
+            m_instances.push_back(glm::uvec2(m_sectorLights[level][i], LIGHT_VOLUME_SECTOR));
+        }
+    }
+    commands.push_back(m_quad);
+    commands.back().m_instanceCount = m_quadLights.size();
+    commands.back().m_baseInstance = m_instances.size();
+    for (unsigned int i = 0; i < m_quadLights.size(); i++)
+    {
+        m_instances.push_back(glm::uvec2(m_quadLights[i], LIGHT_VOLUME_QUAD));
+    }
+
+    // The depth bounds test is set per draw, so with it each quad is its own draw, after the rest.
+    bool depthBounds = m_useDepthBounds && GLEW_EXT_depth_bounds_test && m_quadLights.size() > 0;
+    DrawElementsIndirectCommand quads = commands.back();
+    if (depthBounds)
+    {
+        commands.pop_back();
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+
+    // The vertex shader reads the quads' rectangles and every light's depth range from here.
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_boundsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, m_bounds.size() * sizeof(LightScreenBounds), m_bounds.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_BOUNDS_BINDING, m_boundsBuffer);
+
+    // Bind the vertex buffer and set the Vertex Attribute.
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+
+    // The instance data is integers, so it needs the I version of the pointer.
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(glm::uvec2), m_instances.data(), GL_STREAM_DRAW);
+    glVertexAttribIPointer(1, 2, GL_UNSIGNED_INT, sizeof(glm::uvec2), (void*)0);
+    glVertexAttribDivisor(1, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+
+    // Zero one counter per light to count into.
+    if (m_recordStats)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsBuffer);
+        if (volumeCount > m_statsCapacity)
+        {
+            glBufferData(GL_SHADER_STORAGE_BUFFER, volumeCount * sizeof(unsigned int), NULL, GL_DYNAMIC_READ);
+            m_statsCapacity = volumeCount;
+        }
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_STATS_BINDING, m_statsBuffer);
+    }
+    lightMaterial->SetInt((char*)"recordStats", m_recordStats ? 1 : 0);
+
+    // Bind material and draw
+    lights->Bind();
+    lightMaterial->Bind();
+
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, commands.size(), 0);
+
+    if (depthBounds)
+    {
+        // Pixels whose depth is outside the light's range are thrown out before the fragment shader runs.
+        // It tests the depth buffer, which isn't written since the depth test is off.
+        glEnable(GL_DEPTH_BOUNDS_TEST_EXT);
+        for (unsigned int i = 0; i < m_quadLights.size(); i++)
+        {
+            glm::vec4& depth = m_bounds[m_quadLights[i]].m_depth;
+            glDepthBoundsEXT(depth.x, depth.y);
+            glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, quads.m_count, GL_UNSIGNED_INT,
+                (void*)(quads.m_firstIndex * sizeof(unsigned int)), 1, quads.m_baseVertex, quads.m_baseInstance + i);
+        }
+        glDisable(GL_DEPTH_BOUNDS_TEST_EXT);
+    }
+
+    lightMaterial->Unbind();
+    lights->Unbind();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_BOUNDS_BINDING, 0);
+
+    if (m_recordStats)
+    {
+        // The counts are read back with glGetBufferSubData next frame.
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_STATS_BINDING, 0);
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        m_statsPending = volumeCount;
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    // Disable vertex attribute and set the divisor back to default.
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 0);
+}
+
+void LightVolumeRenderer::SetRecordStats(bool record)
+{
+    m_recordStats = record;
+    if (!record)
+    {
+        m_shadedPixels.clear();
+    }
+}
+
+bool LightVolumeRenderer::GetRecordStats()
+{
+    return m_recordStats;
+}
+
+std::vector<unsigned int>& LightVolumeRenderer::GetShadedPixels()
+{
+    return m_shadedPixels;
+}
+
+unsigned long long LightVolumeRenderer::GetTotalShadedPixels()
+{
+    unsigned long long total = 0;
+    for (unsigned int i = 0; i < m_shadedPixels.size(); i++)
+    {
+        total += m_shadedPixels[i];
+    }
+    return total;
+}
+
+unsigned int LightVolumeRenderer::GetSectorCount(int level)
+{
+    return m_sectorLights[level].size();
+}
+
+unsigned int LightVolumeRenderer::GetQuadCount()
+{
+    return m_quadLights.size();
+}
+
+unsigned int LightVolumeRenderer::GetCulledCount()
+{
+    return m_culledCount;
+}
+
+void LightVolumeRenderer::SetUseDepthBounds(bool useDepthBounds)
+{
+    m_useDepthBounds = useDepthBounds;
+}
+
+bool LightVolumeRenderer::GetUseDepthBounds()
+{
+    return m_useDepthBounds;
+}
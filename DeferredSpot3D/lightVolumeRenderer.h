@@ -0,0 +1,176 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightVolumeRenderer.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/constants.hpp"
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+
+#include "material.h"
+#include "meshPool.h"
+#include "lightBuffer.h"
+#include "lightBudget.h"
+#include "frustum.h"
+
+// Must match the binding of the LightStats block in lightFrag.glsl.
+#define LIGHT_STATS_BINDING 1
+// Must match the binding of the LightBounds block in lightVolumeVert.glsl.
+#define LIGHT_BOUNDS_BINDING 2
+
+// How many tessellations of the spot light volume there are to pick from, each with twice the segments of the last.
+#define LIGHT_SECTOR_LEVELS 4
+
+// The shape a light is drawn with, given to the vertex shader per instance. Must match lightVolumeVert.glsl.
+enum LightVolume
+{
+    LIGHT_VOLUME_SPHERE = 0, // Point lights
+    LIGHT_VOLUME_SECTOR = 1, // Spot lights up to 90 degrees: a cone with a rounded cap, built in the vertex shader
+    LIGHT_VOLUME_QUAD = 2 // Wider spot lights, and lights the near plane cuts through: the light's rectangle on screen
+};
+
+// Where a light can be on screen, worked out on the CPU (LightVolumeRenderer::GetScreenBounds).
+// One per light record, same layout as the LightBounds block in lightVolumeVert.glsl.
+struct LightScreenBounds
+{
+    glm::vec4 m_rect; // min xy, max xy, in normalized device coordinates
+    glm::vec4 m_depth; // x = nearest, y = farthest depth buffer value the light can reach, z = 1 if the near plane cuts through it,
+                       // w = how much of the light to draw (less than 1 while it fades out of the light budget)
+};
+
+// Draws the volume of every point and spot light in a light buffer in one pass.
+// Every shape shares one vertex and index buffer, so they're all drawn by one multi-draw, with one shader
+// (lightVolumeVert.glsl and lightFrag.glsl) that reads each light's record by index.
+//
+// Spot light volumes are generated rather than loaded. Scaling a cone mesh by tan(angle) blows up near 90 degrees,
+// and a coarse base either misses pixels or shades too many. Instead the volume is the part of the cone that is in
+// range (a cone with a rounded cap), its vertices are just angles that the vertex shader turns into positions for
+// each light, and there are a few tessellations to pick from by how big the light is on screen. Past 90 degrees the
+// shape isn't convex anymore (back faces would shade pixels twice), so those lights get a screen space quad instead.
+//
+// Each light's rectangle on screen and the range of depth it can reach are worked out on the CPU first.
+// Lights off screen are dropped there. A light the near plane cuts through (the camera is inside it, or close) would
+// cover the whole screen with its back faces, so it's drawn as a quad over just its rectangle instead. Pixels whose
+// depth is outside the light's range are thrown out before any lighting, by the depth bounds test
+// (GL_EXT_depth_bounds_test) for quads where it's supported, and by the fragment shader otherwise.
+class LightVolumeRenderer
+{
+public:
+    LightVolumeRenderer();
+    ~LightVolumeRenderer();
+
+    // The buffer must already be updated for this frame. Directional lights are skipped, the ambient light pass applies them.
+    // The camera (view and projection) and the viewport height bound each light on screen and pick its tessellation.
+    // The bound framebuffer needs the scene's depth attached for the depth bounds test (it's only read, not written).
+    // With a budget, only the lights it picks are drawn, and it puts the rest in its light grid for the ambient light pass.
+    void RenderLights(LightBuffer* lights, Material* lightMaterial, glm::mat4 view, glm::mat4 projection, float viewportHeight,
+        LightBudget* budget = nullptr);
+
+    // Counts the pixels each light shades. It's an atomic add per pixel, so it's only on while someone is looking.
+    void SetRecordStats(bool record);
+    bool GetRecordStats();
+
+    // From the last frame with stats: the pixels shaded by each light (by record index), and all of them together.
+    std::vector<unsigned int>& GetShadedPixels();
+    unsigned long long GetTotalShadedPixels();
+
+    // How many spot lights were drawn at each tessellation level, how many lights were drawn as quads,
+    // and how many were off screen, last frame.
+    unsigned int GetSectorCount(int level);
+    unsigned int GetQuadCount();
+    unsigned int GetCulledCount();
+
+    // Use GL_EXT_depth_bounds_test for quads, if the driver has it. On by default.
+    void SetUseDepthBounds(bool useDepthBounds);
+    bool GetUseDepthBounds();
+
+    // Segments around the rim of a tessellation level.
+    static unsigned int GetSectorSegments(int level);
+
+    // The level for a light whose bounding sphere covers pixelRadius pixels on screen: enough segments that the
+    // flat facets are never more than about a pixel outside the real shape.
+    static int ChooseSectorLevel(float pixelRadius);
+
+    // The radius of a sphere on screen, in pixels. Very big if the camera is inside it.
+    static float GetPixelRadius(glm::vec4 sphere, glm::vec3 cameraPosition, float projectionScale, float viewportHeight);
+
+    // Bounds a point or spot light on screen. Returns false if none of it is on screen.
+    // The lit area is boxed in view space (a spot light's box holds its tip and the slab its cap is in), the box is
+    // cut off at the near plane, and its corners are projected.
+    static bool GetScreenBounds(LightRecord& light, glm::mat4& view, glm::mat4& projection, LightScreenBounds& bounds);
+
+    // Makes the rounded cone. Vertices are (fraction of the way around, fraction of the cone angle, cos(pi / segments)),
+    // and the tip is (0, 0, 0). lightVolumeVert.glsl uses the last one to push the shape out enough that the flat
+    // facets always contain the real round shape.
+    static void BuildSector(unsigned int segments, std::vector<glm::vec3>& vertices, std::vector<unsigned int>& indices);
+
+private:
+    // Reads the positions and faces of an obj file.
+    bool LoadVolume(std::string filePath, std::vector<glm::vec3>& vertices, std::vector<unsigned int>& indices);
+
+    // Adds a shape to the end of the shared buffers, and returns the draw command for it (with no instances).
+    DrawElementsIndirectCommand AddShape(std::vector<glm::vec3>& vertices, std::vector<unsigned int>& indices);
+
+    GLuint m_vertexBuffer;
+    GLuint m_indexBuffer;
+    GLuint m_instanceBuffer;
+    GLuint m_indirectBuffer;
+    GLuint m_statsBuffer;
+    GLuint m_boundsBuffer;
+
+    std::vector<glm::vec3> m_vertices;
+    std::vector<unsigned int> m_indices;
+
+    // Where each shape is in the shared buffers.
+    DrawElementsIndirectCommand m_sphere = DrawElementsIndirectCommand(0, 0, 0, 0, 0);
+    DrawElementsIndirectCommand m_quad = DrawElementsIndirectCommand(0, 0, 0, 0, 0);
+    std::vector<DrawElementsIndirectCommand> m_sectors;
+
+    // Lights grouped by the command that draws them. Each is (record index, LightVolume).
+    std::vector<glm::uvec2> m_instances;
+    std::vector<std::vector<GLuint>> m_sectorLights;
+    std::vector<GLuint> m_quadLights;
+    unsigned int m_culledCount = 0;
+
+    // Every record's screen bounds, directional lights are left empty.
+    std::vector<LightScreenBounds> m_bounds;
+    // Lights in the view, from the light buffer's tree.
+    std::vector<unsigned int> m_candidates;
+    // For the light budget: which lights are on screen, how much of it they cover, and how much of each to draw.
+    std::vector<bool> m_onScreen;
+    std::vector<float> m_screenAreas;
+    std::vector<float> m_weights;
+    bool m_useDepthBounds = true;
+
+    bool m_recordStats = false;
+    // Lights counted into the stats buffer by the last frame, 0 if it didn't count.
+    unsigned int m_statsPending = 0;
+    unsigned int m_statsCapacity = 0;
+    std::vector<unsigned int> m_shadedPixels;
+};
@@ -0,0 +1,191 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lights.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+// Every kind of light the renderer knows about, and the one record they all become on the GPU (lightBuffer.h).
+
+// The smallest sphere (xyz = center, w = radius) around the part of a spot light that gets lit: the points inside
+// its cone that are within range of the tip. That's a cone with a rounded cap, so it never gets bigger than the range.
+// Must match spotBoundingSphere in lightVolumeVert.glsl.
+inline glm::vec4 GetSpotBoundingSphere(glm::vec3 position, glm::vec3 direction, float range, float angle)
+{
+    // Narrow cones: the tip and the rim of the cap are both on the sphere.
+    if (angle < glm::radians(45.f))
+    {
+        float distance = range / (2 * glm::cos(angle));
+        return glm::vec4(position + direction * distance, distance);
+    }
+    // Wider cones: the rim of the cap is the widest part, so center the sphere on it.
+    if (angle < glm::radians(90.f))
+    {
+        return glm::vec4(position + direction * range * glm::cos(angle), range * glm::sin(angle));
+    }
+    // Past 90 degrees, it's most of a sphere around the tip.
+    return glm::vec4(position, range);
+}
+
+//struct for point light
+struct PointLight
+{
+    glm::vec3 m_position;
+    float m_radius;
+    glm::vec4 m_attenuation;
+    glm::vec4 m_color;
+
+    // Defines a point light
+    PointLight(glm::vec3 position, float radius, glm::vec4 attenuation, glm::vec4 color) {
+        m_position = position;
+        m_radius = radius;
+        m_attenuation = attenuation;
+        m_color = color;
+    }
+
+    // Returns the world space sphere the light covers (xyz = center, w = radius).
+    glm::vec4 GetBoundingSphere() {
+        return glm::vec4(m_position, m_radius);
+    }
+};
+
+//struct for spotlight
+struct SpotLight
+{
+    glm::mat4 m_worldMatrix; // A matrix is required to rotate and position the cone volume for our spot light
+    // Note: You could include the scale based on angle and range, but we'd have to send them for the fragment shader anyway, so we wont.
+    glm::vec4 m_attenuation; // Defines light strength based on distance from light source
+    glm::vec4 m_color; // RBG Color of the light
+    float m_range; // Length light extends from transform position
+    float m_angle; // Angle of cone used for spot light
+    float m_exponent; // Exponent used to calculate light intensity based on angle
+    int m_profile = -1; // Layer in LightProfiles to use for the falloff instead (an IES file or a cookie), -1 to use the exponent
+
+    // Defines a spotlight
+    SpotLight(glm::mat4 worldMatrix, glm::vec4 attenuation, glm::vec4 color, float range, float angle, float exponent) {
+        m_worldMatrix = worldMatrix;
+        m_attenuation = attenuation;
+        m_color = color;
+        m_range = range;
+        m_angle = angle;
+        m_exponent = exponent;
+    }
+
+    // Returns the smallest world space sphere around the lit part of the cone (xyz = center, w = radius).
+    glm::vec4 GetBoundingSphere() {
+        glm::vec3 position = glm::vec3(m_worldMatrix[3]);
+        glm::vec3 direction = glm::normalize(glm::vec3(m_worldMatrix * glm::vec4(0, 0, -1, 0)));
+        return GetSpotBoundingSphere(position, direction, m_range, m_angle);
+    }
+
+    // Returns false only if the sphere is completely outside the cone.
+    bool IntersectsSphere(glm::vec4 sphere) {
+        glm::vec3 position = glm::vec3(m_worldMatrix[3]);
+        glm::vec3 direction = glm::normalize(glm::vec3(m_worldMatrix * glm::vec4(0, 0, -1, 0)));
+
+        // Split the vector to the sphere into the part along the cone's axis, and the part away from it.
+        glm::vec3 toSphere = glm::vec3(sphere) - position;
+        float along = glm::dot(toSphere, direction);
+        float away = sqrt(glm::max(glm::dot(toSphere, toSphere) - along * along, 0.f));
+
+        // Distance from the center to the side of the cone, and to the planes at the tip and base.
+        float toSide = cos(m_angle) * away - sin(m_angle) * along;
+        return toSide <= sphere.w && along >= -sphere.w && along <= m_range + sphere.w;
+    }
+
+    // The camera that sees exactly the cone, for rendering its shadow map.
+    glm::mat4 GetViewProjection() {
+        // Perspective projections fall apart near 180 degrees, very wide cones only get shadows near the middle.
+        float fov = glm::min(2 * m_angle, glm::radians(170.f));
+        return glm::perspective(fov, 1.f, m_range * .01f, m_range) * glm::inverse(m_worldMatrix);
+    }
+};
+
+// Where a spot light's shadow is in the shadow atlas. Shadowed spot lights' shadows are in their own storage
+// buffer (LightBuffer), read through the light record's shadow index.
+struct SpotShadow
+{
+    glm::mat4 m_matrix; // World space to atlas uv (xy) and depth (z)
+    glm::vec4 m_bounds; // The tile's uv rectangle (min xy, max xy), x < 0 if the light has no shadow
+
+    SpotShadow() {
+        m_bounds = glm::vec4(-1);
+    }
+};
+
+// Lights infinitely far away, like the sun. They light everything, so they're applied over the whole screen in one pass (ambientLightFrag.glsl).
+struct DirectionalLight
+{
+    glm::vec3 m_direction; // The direction the light travels in
+    glm::vec4 m_color; // RBG Color of the light
+
+    DirectionalLight(glm::vec3 direction, glm::vec4 color) {
+        m_direction = glm::normalize(direction);
+        m_color = color;
+    }
+};
+
+// The type tag in a LightRecord. Must match the LIGHT_TYPE_ defines in lightTypes.glsl.
+enum LightType
+{
+    LIGHT_TYPE_POINT = 0,
+    LIGHT_TYPE_SPOT = 1,
+    LIGHT_TYPE_DIRECTIONAL = 2
+};
+
+// One light of any type, laid out for a std430 storage buffer (lightRecord in lightTypes.glsl).
+// Fields a type doesn't use are left at their defaults. Kept to 96 bytes, everything a light needs for shading
+// and nothing else: a spot light's shadow (a matrix and a tile, as big as the rest together) is in its own buffer,
+// and the shadow index points to it (point lights: the cube map).
+struct LightRecord
+{
+    glm::vec4 m_positionType; // xyz = world position, w = LightType
+    glm::vec4 m_directionRange; // xyz = direction the light points (spot and directional), w = range (radius for point lights)
+    glm::vec4 m_attenuation; // Same as the light's
+    glm::vec4 m_color; // Same as the light's
+    glm::vec4 m_coneShadow; // x = cone angle, y = spot exponent, z = shadow index (-1 for none), w = cosine of the cone angle
+    glm::vec4 m_profile; // xyz = the light's side axis (where profiles start going around), w = layer in LightProfiles (-1 for none)
+
+    // The world space sphere the light can reach, a radius of -1 for directional lights (they reach everything).
+    glm::vec4 GetBoundingSphere() {
+        switch ((int)m_positionType.w)
+        {
+            case LIGHT_TYPE_POINT:
+                return glm::vec4(glm::vec3(m_positionType), m_directionRange.w);
+            case LIGHT_TYPE_SPOT:
+                return GetSpotBoundingSphere(glm::vec3(m_positionType), glm::vec3(m_directionRange), m_directionRange.w, m_coneShadow.x);
+            default:
+                return glm::vec4(0, 0, 0, -1);
+        }
+    }
+
+    LightRecord() {
+        m_positionType = glm::vec4(0);
+        m_directionRange = glm::vec4(0, 0, -1, 0);
+        m_attenuation = glm::vec4(0, 0, 1, 0);
+        m_color = glm::vec4(0);
+        m_coneShadow = glm::vec4(0, 0, -1, -2);
+        m_profile = glm::vec4(1, 0, 0, -1);
+    }
+};
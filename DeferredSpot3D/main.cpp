@@ -29,15 +29,34 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "glm/gtc/matrix_transform.hpp"
 #include "FreeImage.h"
 #include "mesh.h"
+#include "meshPool.h"
+#include "instanceCuller.h"
+#include "hiZPyramid.h"
+#include "passProfiler.h"
+#include "shaderCompileQueue.h"
+#include "shaderVariants.h"
+#include "shaderHotReloader.h"
 #include "fpsController.h"
 #include "transform3d.h"
 #include "material.h"
 #include "texture.h"
 #include "cubeMap.h"
-#include "pointLightRenderer.h"
-#include "spotLightRenderer.h"
+#include "textureCompressor.h"
+#include "textureStreamer.h"
+#include "textureManager.h"
+#include "mipResidency.h"
+#include "assetRegistry.h"
+#include "lights.h"
+#include "lightBuffer.h"
+#include "lightVolumeRenderer.h"
+#include "lightBudget.h"
+#include "lightProfiles.h"
+#include "pointShadowRenderer.h"
+#include "spotShadowRenderer.h"
+#include "shadowCasterCuller.h"
 #include <vector>
 #include <iostream>
+#include <climits>
 
 
 
@@ -52,6 +71,9 @@ Texture* screenNormal;
 Texture* screenDepth;
 Texture* screenLighting;
 
+// Hierarchical copy of the depth buffer, used to skip objects and lights that are hidden.
+HiZPyramid* hiZPyramid;
+
 // Window resize callback
 void resizeCallback(GLFWwindow* window, int width, int height)
 {
@@ -63,6 +85,7 @@ void resizeCallback(GLFWwindow* window, int width, int height)
     screenNormal->Resize(width, height, GL_RGBA, GL_UNSIGNED_BYTE);
     screenDepth->Resize(width, height, GL_DEPTH_COMPONENT, GL_FLOAT);
     screenLighting->Resize(width, height, GL_RGBA, GL_UNSIGNED_BYTE);
+    hiZPyramid->Resize(width, height);
 }
 
 // This will get called when the mouse moves.
@@ -71,9 +94,66 @@ void mouseMoveCallback(GLFWwindow *window, GLdouble mouseX, GLdouble mouseY)
     mousePosition = glm::vec2(mouseX, mouseY);
 }
 
+// Everything that can run instead of the demo, picked by the first argument.
+struct CommandLineMode
+{
+    const char* m_flag;
+    // Run once the window and its OpenGL context exist.
+    bool m_needsContext;
+    int (*m_run)(int argc, char** argv);
+};
+
+CommandLineMode commandLineModes[] =
+{
+    // Converting textures, with the arguments after --compress.
+    { "--compress", false, [](int argc, char** argv) { return TextureCompressor::Run(argc - 2, argv + 2); } },
+
+    // Timing the shadow caster culling. The default is 100 lights and 100000 instances.
+    { "--benchmark-casters", false, [](int argc, char** argv) {
+        return ShadowCasterCuller::RunBenchmark(argc > 2 ? atoi(argv[2]) : 100, argc > 3 ? atoi(argv[3]) : 100000); } },
+    // Timing the light tree's queries against checking every light, at 1000 to 100000 lights (or the count given).
+    { "--benchmark-lights", false, [](int argc, char** argv) { return LightBVH::RunBenchmark(argc > 2 ? atoi(argv[2]) : 0); } },
+    // Timing the SSE light evaluation against one light at a time, at 1024 lights (or the count given).
+    { "--benchmark-attenuation", false, [](int argc, char** argv) { return LightArrays::RunBenchmark(argc > 2 ? atoi(argv[2]) : 1024); } },
+
+    // Self-tests (selfTest.h).
+    { "--test-profiles", false, [](int, char**) { return LightProfiles::RunTest(); } },
+    { "--test-shadow-atlas", false, [](int, char**) { return ShadowAtlas::RunTest(); } },
+    { "--test-mip-residency", false, [](int, char**) { return MipResidency::RunTest(); } },
+    { "--test-mesh-pool", false, [](int, char**) { return MeshPool::RunTest(); } },
+    { "--test-hiz", false, [](int, char**) { return HiZReference::RunTest(); } },
+    { "--test-hiz-gpu", true, [](int, char**) { return HiZPyramid::RunTest(); } },
+    { "--test-culling", true, [](int, char**) { return InstanceCuller::RunTest(); } },
+};
+
+// Runs the mode the first argument names, if it's one that runs with (or without) a context.
+// Returns true and sets result to the program's exit code if one ran.
+bool RunCommandLineMode(int argc, char** argv, bool hasContext, int& result)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+
+    for (CommandLineMode& mode : commandLineModes)
+    {
+        if (std::string(argv[1]) == mode.m_flag && mode.m_needsContext == hasContext)
+        {
+            result = mode.m_run(argc, argv);
+            return true;
+        }
+    }
+    return false;
+}
 
 int main(int argc, char **argv)
 {
+    // Tools, benchmarks and self-tests that don't need a window run right away.
+    int result;
+    if (RunCommandLineMode(argc, argv, false, result))
+    {
+        return result;
+    }
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -92,6 +172,29 @@ int main(int argc, char **argv)
 	// Initialize glew
 	glewInit();
 
+    // Linked shader programs are saved here, so the next launch can skip compiling them.
+    ProgramBinaryCache::SetDirectory("../ShaderCache/");
+
+    // The ones checking compute shaders against their CPU versions need the context.
+    if (RunCommandLineMode(argc, argv, true, result))
+    {
+        glfwTerminate();
+        return result;
+    }
+
+    // Loaded textures use 16x anisotropic filtering (or as much as the driver allows).
+    Texture::SetDefaultAnisotropy(16);
+
+    // Loads textures on worker threads, through a ring of staging buffers.
+    TextureStreamer* textureStreamer = new TextureStreamer();
+
+    // Mipmapped textures loaded from here on only keep the levels that are visible on the GPU, within 64 MB.
+    TextureManager* textureManager = new TextureManager(64ull * 1024 * 1024);
+    TextureManager::SetActive(textureManager);
+
+    // Files are only loaded once, however many times they're asked for. Everything shares the same copy.
+    AssetRegistry* assetRegistry = new AssetRegistry();
+
 
     // Similarly to how this was done in 2 dimensions, we will need 3 textures for color, normals, and lighting:
     // The sample type doesn't really matter, because we'll be using texelfetch.
@@ -104,6 +207,10 @@ int main(int argc, char **argv)
     // It's used to calculate the 3D world position of our pixel in the lighting step
     screenDepth = new Texture(viewportDimensions.x, viewportDimensions.y, GL_DEPTH_COMPONENT, GL_FLOAT, GL_NEAREST);
 
+    // The Hi-Z pyramid is rebuilt from the depth texture every frame, right after the geometry is drawn.
+    // Lights are tested against it in the same frame, and instances are tested against it in the next frame.
+    hiZPyramid = new HiZPyramid(viewportDimensions.x, viewportDimensions.y);
+
 
     // Create and bind the framebuffer for our geometry data.
     // This is the first buffer we render to, and contains the textures and normals of all the sprites
@@ -125,6 +232,8 @@ int main(int argc, char **argv)
     glGenFramebuffers(1, &lightFrameBuffer);
     glBindFramebuffer(GL_FRAMEBUFFER, lightFrameBuffer);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, screenLighting->GetGLTexture(), 0);
+    // The scene's depth is attached too, but only for the depth bounds test to read. Lights never write it.
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, screenDepth->GetGLTexture(), 0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 
@@ -132,23 +241,61 @@ int main(int argc, char **argv)
 
     // The mesh loading code has changed slightly, we now have to do some extra math to take advantage of our normal maps.
     // Here we pass in true to calculate tangents.
-    Mesh* model = new Mesh("../assets/ironbuckler.obj", true);
-    Mesh* cube = new Mesh("../assets/cube.obj", true);
+    Mesh* model = assetRegistry->GetMesh("../assets/ironbuckler.obj", true);
+    Mesh* cube = assetRegistry->GetMesh("../assets/cube.obj", true);
+
+    // Every mesh drawn in the geometry pass is copied into one shared pool of buffers.
+    // That way the whole pass is a single glMultiDrawElementsIndirect, no matter how many different meshes there are.
+    MeshPool* meshPool = new MeshPool(1 << 18, 1 << 20);
+    int modelId = meshPool->AddMesh(model);
+
+    // Frustum culls the pool's instances with a compute shader before they're drawn.
+    InstanceCuller* instanceCuller = new InstanceCuller();
 
 
-	// Create Shaders
-    Shader* vertexShader = new Shader("../Assets/vertex.glsl", GL_VERTEX_SHADER);
-    Shader* fragmentShader = new Shader("../Assets/diffuseNormalFrag.glsl", GL_FRAGMENT_SHADER);
+    // Every shader program below is built in one batch, so the driver can compile them in parallel.
+    ShaderCompileQueue* shaderQueue = new ShaderCompileQueue();
 
-    // Create A Shader Program
-    ShaderProgram* shaderProgram = new ShaderProgram();
-    shaderProgram->AttachShader(vertexShader);
-    shaderProgram->AttachShader(fragmentShader);
+    // How normals are stored in the G-buffer. Every shader that reads or writes it is compiled with the same setting (gBuffer.glsl).
+    // Add SHADER_GBUFFER_OCTAHEDRAL to store them in two channels instead of three.
+    unsigned int gBufferFeatures = 0;
+
+    // Shaders that come in several variants, depending on which features they're compiled with (shaderVariants.h).
+    // The light shaders share one fragment shader, with only the code for their own light type compiled in.
+    ShaderVariants* geometryShaders = new ShaderVariants("../Assets/vertex.glsl", "../Assets/diffuseNormalFrag.glsl", shaderQueue);
+    ShaderVariants* placeholderShaders = new ShaderVariants("../Assets/vertex.glsl", "../Assets/placeholderFrag.glsl", shaderQueue);
+    ShaderVariants* lightShaders = new ShaderVariants("../Assets/lightVolumeVert.glsl", "../Assets/lightFrag.glsl", shaderQueue);
+    ShaderVariants* compositionShaders = new ShaderVariants("../Assets/fullScreenVert.glsl", "../Assets/compositionFrag.glsl", shaderQueue);
+    ShaderVariants* ambientLightShaders = new ShaderVariants("../Assets/fullScreenVert.glsl", "../Assets/ambientLightFrag.glsl", shaderQueue);
+    ShaderVariants* debugViewShaders = new ShaderVariants("../Assets/fullScreenVert.glsl", "../Assets/debugViewFrag.glsl", shaderQueue);
 
     // Create a material using a texture for our model
-    Material* diffuseNormalMat = new Material(shaderProgram);
-    diffuseNormalMat->SetTexture((char*)"diffuseMap", new Texture((char*)"../assets/iron_buckler_diffuse.png", GL_LINEAR));
-    diffuseNormalMat->SetTexture((char*)"normalMap", new Texture((char*)"../assets/iron_buckler_normal.png", GL_LINEAR));
+    // While the real shader compiles, the model is drawn in plain grey with the placeholder.
+    Material* diffuseNormalMat = new Material(geometryShaders->Get(gBufferFeatures), placeholderShaders->Get(gBufferFeatures));
+    // Both textures get a full mip chain, so the far away bucklers read from small levels.
+    // They are block compressed ahead of time (with --compress, see textureCompressor.h): BC1 for the color,
+    // and BC5 for the normals, a quarter and half the memory of the original pngs.
+    // Both files are read at the same time on worker threads.
+    std::vector<char*> textureFilePaths;
+    textureFilePaths.push_back((char*)"../assets/iron_buckler_diffuse.dds");
+    textureFilePaths.push_back((char*)"../assets/iron_buckler_normal.dds");
+    std::vector<Texture*> bucklerTextures = assetRegistry->GetTextures(textureFilePaths, GL_LINEAR);
+    Texture* diffuseMap = bucklerTextures[0];
+    Texture* normalMap = bucklerTextures[1];
+    diffuseNormalMat->SetTexture((char*)"diffuseMap", diffuseMap);
+    diffuseNormalMat->SetTexture((char*)"normalMap", normalMap);
+
+    // What every loaded file costs on the GPU, and how many things are sharing it.
+    std::cout << assetRegistry->GetReport() << std::endl;
+
+    // The depth pre-pass only needs a vertex shader, it doesn't write any color.
+    ShaderProgram* depthOnlyProgram = new ShaderProgram();
+    depthOnlyProgram->AttachShader(new Shader("../Assets/depthOnlyVert.glsl", GL_VERTEX_SHADER));
+    shaderQueue->Add(depthOnlyProgram);
+    Material* depthOnlyMat = new Material(depthOnlyProgram);
+
+    // Shadow maps are depth only too, with the light as the camera.
+    Material* shadowMat = new Material(depthOnlyProgram);
 
 
     Shader* skyboxVertexShader = new Shader("../Assets/skyboxvertex.glsl", GL_VERTEX_SHADER);
@@ -158,6 +305,7 @@ int main(int argc, char **argv)
     ShaderProgram* skyboxShaderProgram = new ShaderProgram();
     skyboxShaderProgram->AttachShader(skyboxVertexShader);
     skyboxShaderProgram->AttachShader(skyboxfragmentShader);
+    shaderQueue->Add(skyboxShaderProgram);
 
     // Create material for skybox
     Material* skyMat = new Material(skyboxShaderProgram);
@@ -169,44 +317,81 @@ int main(int argc, char **argv)
     faceFilePaths.push_back((char*)"../assets/skyboxBack.png");
     faceFilePaths.push_back((char*)"../assets/skyboxFront.png");
 
-    // The cube map class just saves time by holding all the previous cube map loading code
-    CubeMap* sky = new CubeMap(faceFilePaths);
+    // The skybox is the biggest set of images, so it streams in while the scene is already running.
+    // Until its faces arrive, the sky is a flat blue.
+    CubeMap* sky = textureStreamer->RequestCubeMap(faceFilePaths, glm::vec4(.45f, .6f, .8f, 1));
     skyMat->SetCubeMap((char*)"cubeMap", sky);
 
-    // Set up shader program and material for point lights
-    ShaderProgram* pointLightProgram = new ShaderProgram();
-    pointLightProgram->AttachShader(new Shader("../Assets/pointLightVert.glsl", GL_VERTEX_SHADER));
-    pointLightProgram->AttachShader(new Shader("../Assets/pointLightFrag.glsl", GL_FRAGMENT_SHADER));
-    Material* pointLightMat = new Material(pointLightProgram);
-    pointLightMat->SetTexture((char*)"texNormal", screenNormal);
-    pointLightMat->SetTexture((char*)"texDepth", screenDepth);
+    // Set up material for lights. Point and spot lights share it, the shader reads each light's type from its record.
+    Material* lightMat = new Material(lightShaders->Get(SHADER_SHADOWS | gBufferFeatures));
+    lightMat->SetTexture((char*)"texNormal", screenNormal);
+    lightMat->SetTexture((char*)"texDepth", screenDepth);
+    lightMat->SetTexture((char*)"hiZ", hiZPyramid->GetTexture());
 
+    // Every light goes in one buffer, and every light volume is drawn in one pass.
+    LightBuffer* lightBuffer = new LightBuffer();
 
-    PointLightRenderer* pointLightRenderer = new PointLightRenderer();
+    // Spot lights fall off by a profile texture instead of working out pow() on every pixel.
+    // Lights share a profile per exponent, and can have one from an IES file or a cookie image instead.
+    LightProfiles* lightProfiles = new LightProfiles();
+    lightBuffer->SetProfiles(lightProfiles);
+    lightMat->SetTexture((char*)"lightProfiles", lightProfiles->GetTexture());
+    LightVolumeRenderer* lightVolumeRenderer = new LightVolumeRenderer();
 
+    // At most this many lights are drawn as volumes, however many there are. The rest go in a grid of points,
+    // one unit apart, over the whole scene, and the ambient light pass applies them.
+    const unsigned int lightBudgetSize = 64;
+    LightBudget* lightBudget = new LightBudget(lightBudgetSize, glm::vec3(-12, -8, -12), glm::vec3(12, 10, 12), glm::uvec3(25, 19, 25));
+    lightBudget->SetProfiles(lightProfiles);
 
+    // Point light shadows are cube maps in one array, all six faces of a light are drawn in one pass.
+    PointShadowRenderer* pointShadowRenderer = new PointShadowRenderer();
+    lightMat->SetCubeMap((char*)"pointShadows", pointShadowRenderer->GetShadowMaps());
 
-    // Set up shader program and material for spot lights
-    ShaderProgram* spotLightProgram = new ShaderProgram();
-    spotLightProgram->AttachShader(new Shader("../Assets/spotLightVert.glsl", GL_VERTEX_SHADER));
-    spotLightProgram->AttachShader(new Shader("../Assets/spotLightFrag.glsl", GL_FRAGMENT_SHADER));
-    Material* spotLightMat = new Material(spotLightProgram);
-    spotLightMat->SetTexture((char*)"texNormal", screenNormal);
-    spotLightMat->SetTexture((char*)"texDepth", screenDepth);
+    // Every spot light's shadow map lives in one shared atlas. Tiles are only redrawn when something in them changes.
+    SpotShadowRenderer* shadowRenderer = new SpotShadowRenderer();
+    lightMat->SetTexture((char*)"shadowAtlas", shadowRenderer->GetAtlasTexture());
 
 
-    SpotLightRenderer* spotLightRenderer = new SpotLightRenderer();
+    // Create the material that will render the color and light to the screen
+    Material* compositionMat = new Material(compositionShaders->Get(gBufferFeatures));
 
+    // The light every pixel gets (ambient, directional lights and the light grid), added to the light buffer.
+    Material* ambientLightMat = new Material(ambientLightShaders->Get(gBufferFeatures));
 
-    // Create the material that will render the color and light to the screen
-    ShaderProgram* compositionProgram = new ShaderProgram();
-    compositionProgram->AttachShader(new Shader("../Assets/fullScreenVert.glsl", GL_VERTEX_SHADER));
-    compositionProgram->AttachShader(new Shader("../Assets/compositionFrag.glsl", GL_FRAGMENT_SHADER));
-    Material* compositionMat = new Material(compositionProgram);
+    // The G-buffer and light textures, drawn small up the left side of the screen when the debug views are on.
+    // Bottom to top: depth, normals, light, color.
+    Texture* debugViewTextures[] = { screenDepth, screenNormal, screenLighting, screenColor };
+    Material* debugViewMats[4];
+    for (int i = 0; i < 4; i++)
+    {
+        debugViewMats[i] = new Material(debugViewShaders->Get(0));
+        debugViewMats[i]->SetTexture((char*)"debugTexture", debugViewTextures[i]);
+    }
+
+    // Hand every program to the driver now. The rest of the setup runs while they compile.
+    // The placeholder is small, so it's ready almost immediately.
+    shaderQueue->SubmitAll();
+
+    // Edit a shader while the program is running, and it's rebuilt and swapped in without restarting.
+    ShaderHotReloader* hotReloader = new ShaderHotReloader("../Assets/");
+    hotReloader->Add(diffuseNormalMat->GetShaderProgram());
+    hotReloader->Add(depthOnlyMat->GetShaderProgram());
+    hotReloader->Add(skyMat->GetShaderProgram());
+    hotReloader->Add(lightMat->GetShaderProgram());
+    hotReloader->Add(compositionMat->GetShaderProgram());
+    hotReloader->Add(ambientLightMat->GetShaderProgram());
+    hotReloader->Add(debugViewMats[0]->GetShaderProgram());
+    hotReloader->Add(instanceCuller->GetShaderProgram());
+    hotReloader->Add(hiZPyramid->GetShaderProgram());
+    hotReloader->Add(pointShadowRenderer->GetShaderProgram());
     compositionMat->SetTexture((char*)"texColor", screenColor);
-    compositionMat->SetTexture((char*)"texNormal", screenNormal);
     compositionMat->SetTexture((char*)"texLight", screenLighting);
-    compositionMat->SetTexture((char*)"texDepth", screenDepth);
+    ambientLightMat->SetTexture((char*)"texNormal", screenNormal);
+    ambientLightMat->SetTexture((char*)"texDepth", screenDepth);
+    ambientLightMat->SetVec3((char*)"lightGridMin", lightBudget->GetGridMin());
+    ambientLightMat->SetVec3((char*)"lightGridSpacing", lightBudget->GetGridSpacing());
+    ambientLightMat->SetVec3((char*)"lightGridSize", glm::vec3(lightBudget->GetGridSize()));
 
 
     // The transform being used to draw our second shape.
@@ -220,15 +405,26 @@ int main(int argc, char **argv)
     }
 
     std::vector<PointLight> lights;
-    // Create spotlights, there aren't any in the demo, but you can uncomment this to add them
-    /*for (int i = 0; i < 10; i++)
+    // A few point lights inside the ring of bucklers, so they cast shadows outwards.
+    for (int i = 0; i < 4; i++)
+    {
+        PointLight l = PointLight(
+            glm::vec3(2.5f * sin(i * 1.57f), i * 2.5f - 4, 2.5f * cos(i * 1.57f)), 6,
+            glm::vec4(3, 1, 0, .25),
+            glm::vec4(1, .6f + i / 10.f, .3f, 1));
+        lights.push_back(l);
+    }
+    // A swarm of small lights around the outside of the ring, far more than the light budget draws.
+    // These ones don't get shadows (only the first few do, see PointShadowRenderer::Render).
+    for (int i = 0; i < 1000; i++)
     {
+        float height = (i % 100) / 10.f - 5;
         PointLight l = PointLight(
-            glm::vec3(5 * sin(i), i - 5, 5 * cos(i)), 6,
-            glm::vec4(1, 1, 0, .5f),
-            glm::vec4(i / 30.f, (i % 10) / 10.f, (i % 3) / 3.f, 1));
+            glm::vec3(7 * sin(i * 2.4f), height, 7 * cos(i * 2.4f)), 2.5f,
+            glm::vec4(3, 1, 0, .25),
+            glm::vec4(.2f + (i % 7) / 10.f, .2f + (i % 5) / 8.f, .2f + (i % 3) / 4.f, 1) * .5f);
         lights.push_back(l);
-    }*/
+    }
 
     // Create spotlights
     std::vector<Transform3D> spotLightTransforms;
@@ -240,7 +436,7 @@ int main(int argc, char **argv)
         t.SetPosition(glm::vec3(0, i - 5, 0));
         spotLightTransforms.push_back(t);
 
-        // Create a spotlight struct (definition in spotlightrenderer.h)
+        // Create a spotlight struct (definition in lights.h)
         SpotLight splt = SpotLight(
             t.GetMatrix(),
             glm::vec4(3, 1, 0, .25),
@@ -250,6 +446,22 @@ int main(int argc, char **argv)
         spotLights.push_back(splt);
     }
 
+    // One very wide light over the top, pointing down. Past 90 degrees it's drawn as a screen space quad.
+    {
+        Transform3D t;
+        t.SetPosition(glm::vec3(0, 7, 0));
+        t.RotateX(-1.5708f);
+        spotLightTransforms.push_back(t);
+        spotLights.push_back(SpotLight(t.GetMatrix(), glm::vec4(3, 1, 0, .25), glm::vec4(.3f, .3f, .4f, 1), 14, 1.75f, 1));
+
+        // Its light comes from a measured fixture, brighter along one side than the other.
+        spotLights.back().m_profile = lightProfiles->AddIES("../Assets/overheadFlood.ies");
+    }
+
+    // A dim sun, added with the ambient light instead of drawing a volume.
+    std::vector<DirectionalLight> directionalLights;
+    directionalLights.push_back(DirectionalLight(glm::vec3(-1, -2, -.5f), glm::vec4(.25f, .22f, .18f, 1)));
+
     // Make a first person controller for the camera.
     FPSController controller = FPSController();
 
@@ -257,12 +469,49 @@ int main(int argc, char **argv)
 
     // Print instructions to the console.
     std::cout << "Use WASD to move, and the mouse to look around." << std::endl;
+    std::cout << "Press P to toggle the depth pre-pass." << std::endl;
+    std::cout << "Press M to switch texture filtering (compare the geometry time in the title)." << std::endl;
+    std::cout << "Press K to pause the animation (shadow maps stop being redrawn while nothing moves)." << std::endl;
+    std::cout << "Press L to count the pixels each light shades (shown in the title)." << std::endl;
+    std::cout << "Press B to toggle the hardware depth bounds test for lights drawn as quads." << std::endl;
+    std::cout << "Press N to toggle the light budget (every light is drawn when it's off)." << std::endl;
+    std::cout << "Press V to toggle the debug views (depth, normals, light and color down the left side)." << std::endl;
     std::cout << "Press escape or alt-f4 to exit." << std::endl;
 
 
     float frames = 0;
     float secCounter = 0;
 
+    // The camera the Hi-Z pyramid was built with (last frame's camera, by the time it's used for instances)
+    glm::mat4 lastViewProjection;
+
+    // With the depth pre-pass on, the geometry is drawn twice:
+    // First with only positions to fill the depth buffer, then again with GL_EQUAL so the G-buffer shader
+    // runs exactly once per pixel, no matter how much overdraw there is.
+    bool useDepthPrePass = true;
+    bool prePassKeyWasDown = false;
+
+    // Texture filtering modes to compare: no mips, trilinear mips, and trilinear mips with 16x anisotropic filtering.
+    const char* filterNames[] = { "Bilinear", "Trilinear", "Anisotropic" };
+    int filterMode = 2;
+    bool filterKeyWasDown = false;
+
+    // Whether the bucklers and lights are spinning.
+    bool animate = true;
+    bool animateKeyWasDown = false;
+
+    // Counting the pixels shaded by each light costs an atomic add per pixel, so it's only on when asked for.
+    bool lightStatsKeyWasDown = false;
+    bool depthBoundsKeyWasDown = false;
+    bool budgetKeyWasDown = false;
+
+    // The G-buffer and light textures up the left side of the screen. Off, they cost nothing.
+    bool showDebugViews = false;
+    bool debugViewKeyWasDown = false;
+
+    // Times the geometry passes on the GPU, and counts how many fragments they wrote.
+    PassProfiler* profiler = new PassProfiler();
+
 	// Main Loop
 	while (!glfwWindowShouldClose(window))
 	{
@@ -275,14 +524,141 @@ int main(int argc, char **argv)
         secCounter += dt;
         if (secCounter > 1.f)
         {
-            std::string title = "Lights FPS: " + std::to_string(frames);
+            // Overdraw is how many times the G-buffer shader ran per pixel on average.
+            // With the pre-pass, this should be close to the fraction of the screen covered by geometry.
+            float overdraw = profiler->GetSamplesPassed("gbuffer") / (viewportDimensions.x * viewportDimensions.y);
+            float geometryMs = profiler->GetTimeMs("gbuffer") + (useDepthPrePass ? profiler->GetTimeMs("depth prepass") : 0);
+            float pointShadowMs = 0;
+            for (unsigned int i = 0; i < pointShadowRenderer->GetMaxLights(); i++)
+            {
+                pointShadowMs += profiler->GetTimeMs(PointShadowRenderer::GetPassName(i));
+            }
+
+            std::string title = "Lights FPS: " + std::to_string(frames)
+                + (useDepthPrePass ? " | Pre-pass on" : " | Pre-pass off")
+                + " | " + filterNames[filterMode]
+                + " | Geometry: " + std::to_string(geometryMs) + " ms"
+                + " | Overdraw: " + std::to_string(overdraw)
+                + " | Shadows: " + std::to_string(shadowRenderer->GetAtlas().GetLightsToRender().size()) + " drawn, "
+                + std::to_string(shadowRenderer->GetAtlas().GetCachedCount()) + " cached, "
+                + std::to_string(shadowRenderer->GetCasterCount()) + " casters culled in "
+                + std::to_string(shadowRenderer->GetCullTimeMs()) + " ms, drawn in "
+                + std::to_string(profiler->GetTimeMs("shadows")) + " ms"
+                + " | Point shadows: " + std::to_string(pointShadowRenderer->GetFaceCount()) + " faces, "
+                + std::to_string(pointShadowRenderer->GetCasterCount()) + " casters, drawn in "
+                + std::to_string(pointShadowMs) + " ms"
+                + " | Light volumes: ";
+            for (int level = 0; level < LIGHT_SECTOR_LEVELS; level++)
+            {
+                title += std::to_string(lightVolumeRenderer->GetSectorCount(level)) + " x" + std::to_string(LightVolumeRenderer::GetSectorSegments(level)) + ", ";
+            }
+            title += std::to_string(lightVolumeRenderer->GetQuadCount()) + " quads, "
+                + std::to_string(lightVolumeRenderer->GetCulledCount()) + " off screen"
+                + " | Budget: " + std::to_string(lightBudget->GetDrawnCount()) + " lights drawn, "
+                + std::to_string(lightBudget->GetGridCount()) + " in the grid";
+            if (lightVolumeRenderer->GetRecordStats())
+            {
+                // The most any one light shaded shows which light to look at.
+                std::vector<unsigned int>& shadedPixels = lightVolumeRenderer->GetShadedPixels();
+                unsigned int mostShaded = shadedPixels.size() > 0 ? *std::max_element(shadedPixels.begin(), shadedPixels.end()) : 0;
+                title += " (" + std::to_string(lightVolumeRenderer->GetTotalShadedPixels()) + " pixels shaded, at most "
+                    + std::to_string(mostShaded) + " by one light)";
+            }
+            title += " | " + textureManager->GetReport();
             glfwSetWindowTitle(window, title.c_str());
             secCounter = 0;
             frames = 0;
         }
         glfwSetTime(0);
+
+        // Check on the shaders that are still compiling, without waiting for them.
+        if (!shaderQueue->IsDone() && shaderQueue->Poll() == 0)
+        {
+            std::cout << "All shaders ready. " << ProgramBinaryCache::GetReport() << std::endl;
+        }
+
+        // Upload any textures the workers have finished loading.
+        if (textureStreamer->GetPendingCount() > 0)
+        {
+            textureStreamer->Update();
+            if (textureStreamer->GetPendingCount() == 0)
+            {
+                std::cout << "All textures streamed in." << std::endl;
+            }
+        }
+
+        // Pick up any shaders that were edited.
+        hotReloader->Update();
         
 
+        // Toggle the depth pre-pass when P is pressed.
+        bool prePassKeyDown = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+        if (prePassKeyDown && !prePassKeyWasDown)
+        {
+            useDepthPrePass = !useDepthPrePass;
+            std::cout << "Depth pre-pass " << (useDepthPrePass ? "on" : "off") << std::endl;
+        }
+        prePassKeyWasDown = prePassKeyDown;
+
+        // Cycle through the texture filtering modes when M is pressed.
+        bool filterKeyDown = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+        if (filterKeyDown && !filterKeyWasDown)
+        {
+            filterMode = (filterMode + 1) % 3;
+            diffuseMap->SetFiltering(GL_LINEAR, filterMode > 0, filterMode == 2 ? 16.f : 1.f);
+            normalMap->SetFiltering(GL_LINEAR, filterMode > 0, filterMode == 2 ? 16.f : 1.f);
+            std::cout << "Texture filtering: " << filterNames[filterMode] << std::endl;
+        }
+        filterKeyWasDown = filterKeyDown;
+
+        // Pause or resume the animation when K is pressed.
+        bool animateKeyDown = glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS;
+        if (animateKeyDown && !animateKeyWasDown)
+        {
+            animate = !animate;
+            std::cout << "Animation " << (animate ? "on" : "paused") << std::endl;
+        }
+        animateKeyWasDown = animateKeyDown;
+
+        // Toggle counting shaded pixels per light.
+        bool lightStatsKeyDown = glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS;
+        if (lightStatsKeyDown && !lightStatsKeyWasDown)
+        {
+            lightVolumeRenderer->SetRecordStats(!lightVolumeRenderer->GetRecordStats());
+            std::cout << "Light pixel counts " << (lightVolumeRenderer->GetRecordStats() ? "on" : "off") << std::endl;
+        }
+        lightStatsKeyWasDown = lightStatsKeyDown;
+
+        // Toggle the depth bounds test, with L on the pixel counts show the difference.
+        bool depthBoundsKeyDown = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+        if (depthBoundsKeyDown && !depthBoundsKeyWasDown)
+        {
+            lightVolumeRenderer->SetUseDepthBounds(!lightVolumeRenderer->GetUseDepthBounds());
+            std::cout << "Depth bounds test " << (lightVolumeRenderer->GetUseDepthBounds() ? "on" : "off")
+                << (GLEW_EXT_depth_bounds_test ? "" : " (not supported, the fragment shader tests depth instead)") << std::endl;
+        }
+        depthBoundsKeyWasDown = depthBoundsKeyDown;
+
+        // Toggle the light budget, turning it off is the same as an endless budget.
+        bool budgetKeyDown = glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS;
+        if (budgetKeyDown && !budgetKeyWasDown)
+        {
+            bool budgetOn = lightBudget->GetBudget() != lightBudgetSize;
+            lightBudget->SetBudget(budgetOn ? lightBudgetSize : UINT_MAX);
+            std::cout << "Light budget " << (budgetOn ? "on" : "off") << std::endl;
+        }
+        budgetKeyWasDown = budgetKeyDown;
+
+        // Toggle the debug views.
+        bool debugViewKeyDown = glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS;
+        if (debugViewKeyDown && !debugViewKeyWasDown)
+        {
+            showDebugViews = !showDebugViews;
+            std::cout << "Debug views " << (showDebugViews ? "on" : "off") << std::endl;
+        }
+        debugViewKeyWasDown = debugViewKeyDown;
+        float animationDt = animate ? dt : 0;
+
         // Update the player controller
         controller.Update(window, viewportDimensions, mousePosition, dt);
         
@@ -292,15 +668,22 @@ int main(int argc, char **argv)
         // rotate cube transform and get a matrix for it
         for (int i = 0; i < transforms.size(); i++)
         {
-            transforms[i].RotateY(dt);
+            transforms[i].RotateY(animationDt);
             matrices.push_back(transforms[i].GetMatrix());
+
+            // A moving buckler changes the shadow of every light it's in.
+            // They only spin in place, so where it was and where it is are the same sphere.
+            if (animate)
+            {
+                shadowRenderer->GetAtlas().MarkCasterMoved(TransformBoundingSphere(matrices[i], model->GetBoundingSphere()));
+            }
         }
 
         // Spin SpotLights
         for (int i = 0; i < spotLights.size(); i++)
         {
             // Rotate them all at different speeds around the y axis
-            spotLightTransforms[i].RotateY((i - 5.f) * dt);
+            spotLightTransforms[i].RotateY((i - 5.f) * animationDt);
             spotLights[i].m_worldMatrix = spotLightTransforms[i].GetMatrix();
         }
 
@@ -312,6 +695,9 @@ int main(int argc, char **argv)
         // Compose view and projection.
         glm::mat4 viewProjection = projection * view;
 
+        // Give each spot light a tile in the shadow atlas, sized by how much of the screen it covers.
+        shadowRenderer->Update(spotLights, controller.GetTransform().Position(), projection[1][1]);
+
         ///////////////////////////////
         // Start Rendering           /
         /////////////////////////////
@@ -329,15 +715,58 @@ int main(int argc, char **argv)
         // Set the camera and world matrices to the shader
         // The string names correspond directly to the uniform names within the shader.
         diffuseNormalMat->SetMatrix((char*)"cameraView", viewProjection);
+        depthOnlyMat->SetMatrix((char*)"cameraView", viewProjection);
 
+        // Queue the instances in the mesh pool, nearest first so hidden fragments fail the depth test early.
+        // The culler removes instances outside of the camera's view on the GPU.
+        meshPool->Submit(modelId, matrices);
+        meshPool->GetCommandList().SortFrontToBack(controller.GetTransform().Position());
+        instanceCuller->SetViewProjection(viewProjection);
+        instanceCuller->SetOcclusion(hiZPyramid, lastViewProjection);
+        meshPool->Prepare(instanceCuller);
 
-        // Bind the material and draw the model
-        diffuseNormalMat->Bind();
+        // Shaders that sample managed textures write how big they appear on screen during the geometry passes.
+        textureManager->BeginFeedback();
 
-        // Instead of just drawing one, we pass in a vector of matrices (this function is where the instancing really happens)
-        model->DrawInstanced(matrices);
+        if (useDepthPrePass)
+        {
+            // Fill the depth buffer only. Without color writes this is much cheaper than the G-buffer shader.
+            profiler->Begin("depth prepass");
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            depthOnlyMat->Bind();
+            meshPool->Render(true);
+            depthOnlyMat->Unbind();
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            profiler->End();
+
+            // Now only the nearest fragment of each pixel has a matching depth.
+            // The depth is already right, so there's no need to write it again.
+            glDepthFunc(GL_EQUAL);
+            glDepthMask(GL_FALSE);
+        }
 
+        // Bind the material and draw the model, with one indirect draw call for everything that was queued.
+        profiler->Begin("gbuffer");
+        diffuseNormalMat->Bind();
+        meshPool->Render(false);
         diffuseNormalMat->Unbind();
+        profiler->End();
+
+        // Back to normal depth testing (the depth mask also has to be on for glClear to clear depth next frame).
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+
+        // The same instances are the shadow casters. Draw them into the tiles of lights that changed.
+        profiler->Begin("shadows");
+        shadowRenderer->Render(meshPool, spotLights, shadowMat);
+        profiler->End();
+        // Point shadows are redrawn every frame, with a profiler pass per light.
+        pointShadowRenderer->Render(meshPool, lights, profiler);
+        meshPool->Clear();
+
+        // Load the mip levels that were needed a few frames ago, and evict the ones that weren't.
+        textureManager->EndFeedback();
+        textureManager->Update();
 
         /////////////////////////
         // Skybox              /
@@ -358,6 +787,10 @@ int main(int argc, char **argv)
         // Set the depth test back to the default setting.
         glDepthFunc(GL_LESS);
 
+        // The depth buffer is finished for this frame, build the Hi-Z pyramid from it.
+        hiZPyramid->Build(screenDepth);
+        lastViewProjection = viewProjection;
+
         ////////////////////////
         // Lighting           /
         //////////////////////
@@ -370,8 +803,8 @@ int main(int argc, char **argv)
         GLenum lightBuffers[] = { GL_COLOR_ATTACHMENT0 };
         glDrawBuffers(1, lightBuffers);
 
-        // Clear the color buffer
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // Clear the color buffer. Not the depth, that's the scene's.
+        glClear(GL_COLOR_BUFFER_BIT);
 
         // We don't care what order lights are rendered in
         glDisable(GL_DEPTH_TEST);
@@ -385,22 +818,14 @@ int main(int argc, char **argv)
         glCullFace(GL_FRONT);
         glEnable(GL_CULL_FACE);
 
-        // Render point lights.
-        // Let the light renderer take care of the rest
-        pointLightMat->SetMatrix((char*)"cameraView", viewProjection);
-        pointLightMat->SetMatrix((char*)"viewRotation", viewRotation);
-        // 100 and .1 are the near and far plane.
-        // These values are used to calculate the world position of a pixel from its depth value.
-        pointLightMat->SetFloat((char*)"projectionA", 100 / (100 - .1)); 
-        pointLightMat->SetFloat((char*)"projectionB", (-100 * .1) / (100 - .1));
-        pointLightRenderer->RenderLights(lights, pointLightMat);
+        // Gather every light, with its shadow, into the light buffer.
+        lightBuffer->Update(lights, spotLights, directionalLights, pointShadowRenderer->GetShadowIndices(), shadowRenderer->GetShadows());
 
-        // Render spot lights (we need all the same camera information as we would for point lights)
-        spotLightMat->SetMatrix((char*)"cameraView", viewProjection);
-        spotLightMat->SetMatrix((char*)"viewRotation", viewRotation);
-        spotLightMat->SetFloat((char*)"projectionA", 100 / (100 - .1));
-        spotLightMat->SetFloat((char*)"projectionB", (-100 * .1) / (100 - .1));
-        spotLightRenderer->RenderLights(spotLights, spotLightMat);
+        // Render point and spot lights, in one pass.
+        // Lighting is done in world space, the inverse camera turns a pixel's depth back into its world position.
+        lightMat->SetMatrix((char*)"cameraView", viewProjection);
+        lightMat->SetMatrix((char*)"inverseCameraView", glm::inverse(viewProjection));
+        lightVolumeRenderer->RenderLights(lightBuffer, lightMat, view, projection, viewportDimensions.y, lightBudget);
 
 
 
@@ -408,6 +833,22 @@ int main(int argc, char **argv)
         // Make sure to turn culling for faces off before continuing
         glDisable(GL_CULL_FACE);
 
+        // Then the light every pixel gets, added over the whole screen with the same blending.
+        // Directional lights come from the same light buffer.
+        ambientLightMat->SetInt((char*)"firstDirectionalLight", lightBuffer->GetFirstDirectional());
+        ambientLightMat->SetInt((char*)"directionalLightCount", lightBuffer->GetDirectionalCount());
+
+        // So do the lights that didn't fit in the light budget, which needs this frame's grid.
+        ambientLightMat->SetMatrix((char*)"inverseCameraView", glm::inverse(viewProjection));
+
+        lightBuffer->Bind();
+        lightBudget->Bind();
+        ambientLightMat->Bind();
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        ambientLightMat->Unbind();
+        lightBudget->Unbind();
+        lightBuffer->Unbind();
+
         // turn off blending as well
         glDisable(GL_BLEND);
 
@@ -432,9 +873,27 @@ int main(int argc, char **argv)
         // Unbind
         compositionMat->Unbind();
 
+        // The debug views go over the left quarter of the screen, each a quarter of its height.
+        if (showDebugViews)
+        {
+            glm::vec2 viewSize = viewportDimensions * .25f;
+            for (int i = 0; i < 4; i++)
+            {
+                glm::vec4 debugViewport = glm::vec4(0, viewSize.y * i, viewSize);
+                glViewport((GLint)debugViewport.x, (GLint)debugViewport.y, (GLsizei)debugViewport.z, (GLsizei)debugViewport.w);
+                debugViewMats[i]->SetVec4((char*)"debugViewport", debugViewport);
+                debugViewMats[i]->Bind();
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+                debugViewMats[i]->Unbind();
+            }
+            glViewport(0, 0, (GLsizei)viewportDimensions.x, (GLsizei)viewportDimensions.y);
+        }
+
+
 
 
 
+        profiler->NextFrame();
 
 		// Swap the backbuffer to the front.
 		glfwSwapBuffers(window);
@@ -443,18 +902,44 @@ int main(int argc, char **argv)
 		glfwPollEvents();
 	}
 
-    // Delete mesh objects
-    delete model;
-    delete cube;
-    delete pointLightRenderer;
-    delete spotLightRenderer;
+    // Delete mesh objects.
+    // The registry owns the loaded meshes and textures. Anything still using them keeps them alive until it's deleted.
+    delete assetRegistry;
+    delete meshPool;
+    delete instanceCuller;
+    delete hiZPyramid;
+    delete profiler;
+    delete shaderQueue;
+    delete hotReloader;
+    delete textureStreamer;
+    delete geometryShaders;
+    delete placeholderShaders;
+    delete lightShaders;
+    delete compositionShaders;
+    delete ambientLightShaders;
+    delete debugViewShaders;
+    delete lightBuffer;
+    delete lightVolumeRenderer;
+    delete lightBudget;
+    delete lightProfiles;
+    delete shadowRenderer;
+    delete pointShadowRenderer;
 
     // Free memory used by materials and all sub objects
     delete diffuseNormalMat;
+    delete depthOnlyMat;
+    delete shadowMat;
     delete skyMat;
-    delete pointLightMat;
-    delete spotLightMat;
+    delete lightMat;
     delete compositionMat;
+    delete ambientLightMat;
+    for (int i = 0; i < 4; i++)
+    {
+        delete debugViewMats[i];
+    }
+
+    // The manager holds on to the textures it manages, so this is where they are actually freed.
+    delete textureManager;
 
     glDeleteFramebuffers(1, &geometryFrameBuffer);
     glDeleteFramebuffers(1, &lightFrameBuffer);
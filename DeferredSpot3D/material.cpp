@@ -24,11 +24,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "material.h"
 
-Material::Material(ShaderProgram * shaderProgram)
+Material::Material(ShaderProgram * shaderProgram, ShaderProgram* placeholderProgram)
 {
     // Increment the reference counter on the shader program.
     shaderProgram->IncRefCount();
     m_shaderProgram = shaderProgram;
+
+    if (placeholderProgram != nullptr)
+    {
+        placeholderProgram->IncRefCount();
+        m_placeholderProgram = placeholderProgram;
+    }
 }
 
 Material::~Material()
@@ -37,6 +43,9 @@ Material::~Material()
     if (m_shaderProgram != nullptr)
         m_shaderProgram->DecRefCount();
 
+    if (m_placeholderProgram != nullptr)
+        m_placeholderProgram->DecRefCount();
+
     // Free textures
     for (int i = 0; i < m_textures.size(); i++)
     {
@@ -49,264 +58,196 @@ Material::~Material()
     }
 }
 
-void Material::SetTexture(char* name, Texture* texture)
+int Material::FindOrAdd(std::vector<std::string>& names, std::vector<GLint>& uniforms, char* name)
 {
-    // Bind shader program
-    m_shaderProgram->Bind();
-
-    // Request uniform from shader.
-    GLint uniform = glGetUniformLocation(m_shaderProgram->GetGLShaderProgram(), name);
-
-    // If there was no uniform location, print an error and return from the function.
-    if (uniform == -1)
-    {
-        std::cout << "Uniform: " << name << " not found in shader program." << std::endl;
-        return;
-    }
-
-    texture->IncRefCount();
-
-    // Search through current texture uniforms to find a match.
-    for (int i = 0; i < m_textureUniforms.size(); i++)
+    // Search through current uniforms to find a match.
+    for (int i = 0; i < names.size(); i++)
     {
-        // If there's a match replace the texture.
-        if (m_textureUniforms[i] == uniform)
+        if (names[i] == name)
         {
-            m_textures[i]->DecRefCount();
-            m_textures[i] = texture;
-            return;
+            return i;
         }
     }
 
-    // There is no match, add the new texture.
-    m_textureUniforms.push_back(uniform);
-    m_textures.push_back(texture);
+    // There is no match, add the new name.
+    // Its location is found the next time the material is bound.
+    names.push_back(name);
+    uniforms.push_back(-1);
+    m_resolvedProgram = nullptr;
+    return names.size() - 1;
 }
 
-void Material::SetCubeMap(char * name, CubeMap* cubeMap)
+void Material::SetTexture(char* name, Texture* texture)
 {
-    // Bind shader program
-    m_shaderProgram->Bind();
-
-    // Request uniform from shader.
-    GLint uniform = glGetUniformLocation(m_shaderProgram->GetGLShaderProgram(), name);
+    texture->IncRefCount();
 
-    // If there was no uniform location, print an error and return from the function.
-    if (uniform == -1)
+    int i = FindOrAdd(m_textureNames, m_textureUniforms, name);
+    if (i < m_textures.size())
     {
-        std::cout << "Uniform: " << name << " not found in shader program." << std::endl;
-        return;
+        // If there's a match replace the texture.
+        m_textures[i]->DecRefCount();
+        m_textures[i] = texture;
     }
+    else
+    {
+        // There is no match, add the new texture.
+        m_textures.push_back(texture);
+        m_textureFeedbackNames.push_back(std::string(name) + "Feedback");
+        m_textureFeedbackUniforms.push_back(-1);
+    }
+}
 
+void Material::SetCubeMap(char* name, CubeMap* cubeMap)
+{
     cubeMap->IncRefCount();
 
-    // Search through current uniforms to find a match.
-    for (int i = 0; i < m_cubeMapUniforms.size(); i++)
+    int i = FindOrAdd(m_cubeMapNames, m_cubeMapUniforms, name);
+    if (i < m_cubeMaps.size())
     {
         // If there's a match replace the cubeMap.
-        if (m_cubeMapUniforms[i] == uniform)
-        {
-            m_cubeMaps[i]->DecRefCount();
-            m_cubeMaps[i] = cubeMap;
-            return;
-        }
+        m_cubeMaps[i]->DecRefCount();
+        m_cubeMaps[i] = cubeMap;
+    }
+    else
+    {
+        // There is no match, add the new cubeMap.
+        m_cubeMaps.push_back(cubeMap);
     }
-
-    // There is no match, add the new cubeMap.
-    m_cubeMapUniforms.push_back(uniform);
-    m_cubeMaps.push_back(cubeMap);
 }
 
 void Material::SetMatrix(char* name, glm::mat4 matrix)
 {
-    // Bind shader program
-    m_shaderProgram->Bind();
-
-    // Request uniform
-    GLint uniform = glGetUniformLocation(m_shaderProgram->GetGLShaderProgram(), name);
-
-    // If there was no uniform location, print an error and return from the function.
-    if (uniform == -1)
+    int i = FindOrAdd(m_matrixNames, m_matrixUniforms, name);
+    if (i < m_matrices.size())
     {
-        std::cout << "Uniform: " << name << " not found in shader program." << std::endl;
-        return;
+        // If there's a match replace the matrix.
+        m_matrices[i] = matrix;
     }
-
-    // Search through current matrix uniforms to find a match.
-    for (int i = 0; i < m_matrixUniforms.size(); i++)
+    else
     {
-        // If there's a match replace the matrix.
-        if (m_matrixUniforms[i] == uniform)
-        {
-            m_matrices[i] = matrix;
-            return;
-        }
+        // There is no match, add the new matrix.
+        m_matrices.push_back(matrix);
     }
-
-    // There is no match, add the new matrix.
-    m_matrixUniforms.push_back(uniform);
-    m_matrices.push_back(matrix);
 }
 
 void Material::SetVec4(char * name, glm::vec4 vector)
 {
-    // Bind shader program
-    m_shaderProgram->Bind();
-
-    // Request uniform
-    GLint uniform = glGetUniformLocation(m_shaderProgram->GetGLShaderProgram(), name);
-
-    // If there was no uniform location, print an error and return from the function.
-    if (uniform == -1)
+    int i = FindOrAdd(m_vec4Names, m_vec4Uniforms, name);
+    if (i < m_vec4s.size())
     {
-        std::cout << "Uniform: " << name << " not found in shader program." << std::endl;
-        return;
+        m_vec4s[i] = vector;
     }
-
-    // Search through current vector uniforms to find a match.
-    for (int i = 0; i < m_vec4Uniforms.size(); i++)
+    else
     {
-        // If there's a match replace the vector.
-        if (m_vec4Uniforms[i] == uniform)
-        {
-            m_vec4s[i] = vector;
-            return;
-        }
+        m_vec4s.push_back(vector);
     }
-
-    // There is no match, add the new vector.
-    m_vec4Uniforms.push_back(uniform);
-    m_vec4s.push_back(vector);
 }
 
 void Material::SetVec3(char * name, glm::vec3 vector)
 {
-    // Bind shader program
-    m_shaderProgram->Bind();
-
-    // Request uniform
-    GLint uniform = glGetUniformLocation(m_shaderProgram->GetGLShaderProgram(), name);
-
-    // If there was no uniform location, print an error and return from the function.
-    if (uniform == -1)
+    int i = FindOrAdd(m_vec3Names, m_vec3Uniforms, name);
+    if (i < m_vec3s.size())
     {
-        std::cout << "Uniform: " << name << " not found in shader program." << std::endl;
-        return;
+        m_vec3s[i] = vector;
     }
-
-    // Search through current vector uniforms to find a match.
-    for (int i = 0; i < m_vec3Uniforms.size(); i++)
+    else
     {
-        // If there's a match replace the vector.
-        if (m_vec3Uniforms[i] == uniform)
-        {
-            m_vec3s[i] = vector;
-            return;
-        }
+        m_vec3s.push_back(vector);
     }
-
-    // There is no match, add the new vector.
-    m_vec3Uniforms.push_back(uniform);
-    m_vec3s.push_back(vector);
 }
 
 void Material::SetVec2(char * name, glm::vec2 vector)
 {
-    // Bind shader program
-    m_shaderProgram->Bind();
-
-    // Request uniform
-    GLint uniform = glGetUniformLocation(m_shaderProgram->GetGLShaderProgram(), name);
-
-    // If there was no uniform location, print an error and return from the function.
-    if (uniform == -1)
+    int i = FindOrAdd(m_vec2Names, m_vec2Uniforms, name);
+    if (i < m_vec2s.size())
     {
-        std::cout << "Uniform: " << name << " not found in shader program." << std::endl;
-        return;
+        m_vec2s[i] = vector;
     }
-
-    // Search through current vector uniforms to find a match.
-    for (int i = 0; i < m_vec2Uniforms.size(); i++)
+    else
     {
-        // If there's a match replace the vector.
-        if (m_vec2Uniforms[i] == uniform)
-        {
-            m_vec2s[i] = vector;
-            return;
-        }
+        m_vec2s.push_back(vector);
     }
-
-    // There is no match, add the new vector.
-    m_vec2Uniforms.push_back(uniform);
-    m_vec2s.push_back(vector);
 }
 
 void Material::SetFloat(char * name, float f)
 {
-    // Bind shader program
-    m_shaderProgram->Bind();
-
-    // Request uniform for matrix
-    GLint uniform = glGetUniformLocation(m_shaderProgram->GetGLShaderProgram(), name);
-
-    // If there was no uniform location, print an error and return from the function.
-    if (uniform == -1)
+    int i = FindOrAdd(m_floatNames, m_floatUniforms, name);
+    if (i < m_floats.size())
     {
-        std::cout << "Uniform: " << name << " not found in shader program." << std::endl;
-        return;
+        m_floats[i] = f;
     }
-
-    // Search through current vector uniforms to find a match.
-    for (int i = 0; i < m_floatUniforms.size(); i++)
+    else
     {
-        // If there's a match replace the vector.
-        if (m_floatUniforms[i] == uniform)
-        {
-            m_floats[i] = f;
-            return;
-        }
+        m_floats.push_back(f);
     }
-
-    // There is no match, add the new vector.
-    m_floatUniforms.push_back(uniform);
-    m_floats.push_back(f);
 }
 
 void Material::SetInt(char * name, int newint)
 {
-    // Bind shader program
-    m_shaderProgram->Bind();
-
-    // Request uniform for matrix
-    GLint uniform = glGetUniformLocation(m_shaderProgram->GetGLShaderProgram(), name);
-
-    // If there was no uniform location, print an error and return from the function.
-    if (uniform == -1)
+    int i = FindOrAdd(m_intNames, m_intUniforms, name);
+    if (i < m_ints.size())
     {
-        std::cout << "Uniform: " << name << " not found in shader program." << std::endl;
-        return;
+        m_ints[i] = newint;
     }
+    else
+    {
+        m_ints.push_back(newint);
+    }
+}
 
-    // Search through current vector uniforms to find a match.
-    for (int i = 0; i < m_intUniforms.size(); i++)
+ShaderProgram* Material::GetShaderProgram()
+{
+    return m_shaderProgram;
+}
+
+void Material::ResolveList(ShaderProgram* program, std::vector<std::string>& names, std::vector<GLint>& uniforms, bool reportMissing)
+{
+    for (int i = 0; i < names.size(); i++)
     {
-        // If there's a match replace the vector.
-        if (m_intUniforms[i] == uniform)
+        // Request uniform from shader.
+        uniforms[i] = glGetUniformLocation(program->GetGLShaderProgram(), names[i].c_str());
+
+        // A missing uniform stays at -1, which glUniform quietly ignores.
+        if (uniforms[i] == -1 && reportMissing)
         {
-            m_ints[i] = newint;
-            return;
+            std::cout << "Uniform: " << names[i] << " not found in shader program." << std::endl;
         }
     }
+}
 
-    // There is no match, add the new vector.
-    m_intUniforms.push_back(uniform);
-    m_ints.push_back(newint);
+void Material::ResolveUniforms(ShaderProgram* program, bool reportMissing)
+{
+    ResolveList(program, m_textureNames, m_textureUniforms, reportMissing);
+    ResolveList(program, m_textureFeedbackNames, m_textureFeedbackUniforms, false);
+    ResolveList(program, m_cubeMapNames, m_cubeMapUniforms, reportMissing);
+    ResolveList(program, m_matrixNames, m_matrixUniforms, reportMissing);
+    ResolveList(program, m_vec4Names, m_vec4Uniforms, reportMissing);
+    ResolveList(program, m_vec3Names, m_vec3Uniforms, reportMissing);
+    ResolveList(program, m_vec2Names, m_vec2Uniforms, reportMissing);
+    ResolveList(program, m_floatNames, m_floatUniforms, reportMissing);
+    ResolveList(program, m_intNames, m_intUniforms, reportMissing);
+
+    m_resolvedProgram = program;
+    m_resolvedGeneration = program->GetGeneration();
 }
 
 
 void Material::Bind()
 {
-    m_shaderProgram->Bind();
+    // Draw with the placeholder while the real program is still compiling.
+    // IsReady never waits on the driver, it just checks.
+    ShaderProgram* program = m_shaderProgram;
+    if (m_placeholderProgram != nullptr && !m_shaderProgram->IsReady())
+    {
+        program = m_placeholderProgram;
+    }
+    program->Bind();
+
+    // Look the uniforms up again if we switched programs, or the program was rebuilt.
+    if (program != m_resolvedProgram || program->GetGeneration() != m_resolvedGeneration)
+    {
+        ResolveUniforms(program, program == m_shaderProgram);
+    }
 
     // Bind all textures
     for (int i = 0; i < m_textureUniforms.size(); i++)
@@ -315,10 +256,13 @@ void Material::Bind()
         glActiveTexture(GL_TEXTURE0 + i);
 
         // Bind the texture
-        glBindTexture(GL_TEXTURE_2D, m_textures[i]->GetGLTexture());
+        glBindTexture(m_textures[i]->GetGLTarget(), m_textures[i]->GetGLTexture());
 
         // Use the the texture from GL_TEXTURE0 + i at the given texture uniform location.
         glUniform1i(m_textureUniforms[i], i);
+
+        // Tell the shader where to write mip feedback for this texture (-1 for none).
+        glUniform1i(m_textureFeedbackUniforms[i], m_textures[i]->GetFeedbackSlot());
     }
 
     // Bind all cubeMaps, continue from the previous location
@@ -328,7 +272,7 @@ void Material::Bind()
         glActiveTexture(GL_TEXTURE0 + m_textureUniforms.size() + i);
 
         // Bind the texture
-        glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubeMaps[i]->GetGLCubeMap());
+        glBindTexture(m_cubeMaps[i]->GetGLTarget(), m_cubeMaps[i]->GetGLCubeMap());
         
         // Use the the texture from GL_TEXTURE0 + i at the given texture uniform location.
         glUniform1i(m_cubeMapUniforms[i], m_textureUniforms.size() + i);
@@ -373,13 +317,13 @@ void Material::Unbind()
     for (int i = 0; i < m_textureUniforms.size(); i++)
     {
         glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindTexture(m_textures[i]->GetGLTarget(), 0);
     }
 
     for (int i = 0; i < m_cubeMapUniforms.size(); i++)
     {
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        glActiveTexture(GL_TEXTURE0 + m_textureUniforms.size() + i);
+        glBindTexture(m_cubeMaps[i]->GetGLTarget(), 0);
     }
 
     m_shaderProgram->Unbind();
@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "cubeMap.h"
 #include "glm/gtc/matrix_transform.hpp"
 #include <vector>
+#include <string>
 
 class Material
 {
@@ -35,27 +36,48 @@ private:
     // Shader program
     ShaderProgram* m_shaderProgram = nullptr;
 
+    // Used instead of the shader program until it's finished building (optional).
+    ShaderProgram* m_placeholderProgram = nullptr;
+
+    // Uniforms are stored by name, and their locations are looked up again whenever the program being bound changes.
+    // That lets a material be set up before its program has even finished compiling.
+    // The program and build the locations were last looked up for:
+    ShaderProgram* m_resolvedProgram = nullptr;
+    unsigned int m_resolvedGeneration = 0;
+
     // Texture uniforms in use.
-    std::vector<GLuint> m_textureUniforms;
+    std::vector<std::string> m_textureNames;
+    std::vector<GLint> m_textureUniforms;
     // Texture objects.
     std::vector<Texture*> m_textures;
+    // "<name>Feedback" for each texture, where shaders take the texture manager's feedback slot.
+    // Shaders that don't write feedback just don't have these, so they are never reported missing.
+    std::vector<std::string> m_textureFeedbackNames;
+    std::vector<GLint> m_textureFeedbackUniforms;
 
     // Cubemap uniforms in use.
-    std::vector<GLuint> m_cubeMapUniforms;
+    std::vector<std::string> m_cubeMapNames;
+    std::vector<GLint> m_cubeMapUniforms;
     // Cubemap objects.
     std::vector<CubeMap*> m_cubeMaps;
 
     // Uniform for matrix.
-    std::vector<GLuint> m_matrixUniforms;
+    std::vector<std::string> m_matrixNames;
+    std::vector<GLint> m_matrixUniforms;
     // Matrices to bind with material.
     std::vector<glm::mat4> m_matrices;
 
     // Uniform for vector.
-    std::vector<GLuint> m_vec4Uniforms;
-    std::vector<GLuint> m_vec3Uniforms;
-    std::vector<GLuint> m_vec2Uniforms;
-    std::vector<GLuint> m_floatUniforms;
-    std::vector<GLuint> m_intUniforms;
+    std::vector<std::string> m_vec4Names;
+    std::vector<std::string> m_vec3Names;
+    std::vector<std::string> m_vec2Names;
+    std::vector<std::string> m_floatNames;
+    std::vector<std::string> m_intNames;
+    std::vector<GLint> m_vec4Uniforms;
+    std::vector<GLint> m_vec3Uniforms;
+    std::vector<GLint> m_vec2Uniforms;
+    std::vector<GLint> m_floatUniforms;
+    std::vector<GLint> m_intUniforms;
     // vectors to bind with material.
     std::vector<glm::vec4> m_vec4s;
     std::vector<glm::vec3> m_vec3s;
@@ -63,10 +85,20 @@ private:
     std::vector<float> m_floats;
     std::vector<int> m_ints;
 
+    // Looks up the location of every uniform in a program.
+    // Missing uniforms are only reported for the real program, a placeholder is expected to be missing most of them.
+    void ResolveUniforms(ShaderProgram* program, bool reportMissing);
+    void ResolveList(ShaderProgram* program, std::vector<std::string>& names, std::vector<GLint>& uniforms, bool reportMissing);
+
+    // Finds a name in a list, or adds it. Returns the index.
+    int FindOrAdd(std::vector<std::string>& names, std::vector<GLint>& uniforms, char* name);
+
 public:
     // Create a material using a given shader program.
     // If you want to use a different shader program, create a new material.
-    Material(ShaderProgram* shaderProgram);
+    // The placeholder program (if there is one) is drawn with until the real program has finished building.
+    // Without one, Bind waits for the program to finish.
+    Material(ShaderProgram* shaderProgram, ShaderProgram* placeholderProgram = nullptr);
     ~Material();
     void SetTexture(char* name, Texture* texture);
     void SetCubeMap(char* name, CubeMap* cubeMap);
@@ -77,6 +109,8 @@ public:
     void SetFloat(char* name, float f);
     void SetInt(char* name, int i);
 
+    ShaderProgram* GetShaderProgram();
+
     void Bind();
     void Unbind();
-};
\ No newline at end of file
+};
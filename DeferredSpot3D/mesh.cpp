@@ -258,6 +258,30 @@ Mesh::~Mesh()
 
 
 
+void Mesh::IncRefCount()
+{
+    m_refCount++;
+}
+
+void Mesh::DecRefCount()
+{
+    m_refCount--;
+    if (m_refCount == 0)
+    {
+        delete this;
+    }
+}
+
+unsigned int Mesh::GetRefCount()
+{
+    return m_refCount;
+}
+
+unsigned long long Mesh::GetMemorySize()
+{
+    return m_vertices.size() * sizeof(Vertex3dUVNormal) + m_indices.size() * sizeof(unsigned int);
+}
+
 void Mesh::Draw()
 {
     
@@ -347,6 +371,41 @@ void Mesh::DrawInstanced(std::vector<glm::mat4> matrices)
 
 }
 
+std::vector<Vertex3dUVNormal>& Mesh::GetVertices()
+{
+    return m_vertices;
+}
+
+std::vector<unsigned int>& Mesh::GetIndices()
+{
+    return m_indices;
+}
+glm::vec4 Mesh::GetBoundingSphere()
+{
+    if (m_vertices.size() == 0)
+    {
+        return glm::vec4();
+    }
+
+    // Use the center of the bounding box as the center of the sphere.
+    glm::vec3 minimum = m_vertices[0].m_position;
+    glm::vec3 maximum = m_vertices[0].m_position;
+    for (unsigned int i = 1; i < m_vertices.size(); i++)
+    {
+        minimum = glm::min(minimum, m_vertices[i].m_position);
+        maximum = glm::max(maximum, m_vertices[i].m_position);
+    }
+    glm::vec3 center = (minimum + maximum) * .5f;
+
+    // The radius is the distance to the furthest vertex.
+    float radius = 0;
+    for (unsigned int i = 0; i < m_vertices.size(); i++)
+    {
+        radius = glm::max(radius, glm::length(m_vertices[i].m_position - center));
+    }
+
+    return glm::vec4(center, radius);
+}
 
 void Mesh::CalculateTangents()
 {
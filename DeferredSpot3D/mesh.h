@@ -31,6 +31,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <cstring>
 
 
 //struct for vertex with uv
@@ -64,19 +65,36 @@ public:
     // Shape destructor to clean up buffers
     ~Mesh();
 
+    // Meshes can be shared (see assetRegistry.h), and delete themselves when the last reference is released.
+    void IncRefCount();
+    void DecRefCount();
+    unsigned int GetRefCount();
+
+    // Size of the vertex and index buffers on the GPU.
+    unsigned long long GetMemorySize();
+
     // Draws the shape using a given world matrix
     void Draw();
     void DrawInstanced(std::vector<glm::mat4> matrices);
 
+    // Access to the cpu side mesh data (used to copy meshes into a MeshPool)
+    std::vector<Vertex3dUVNormal>& GetVertices();
+    std::vector<unsigned int>& GetIndices();
+
+    // Returns a sphere that contains every vertex (xyz = center, w = radius) in model space.
+    glm::vec4 GetBoundingSphere();
+
 private:
 	// Vectors of shape information
 	std::vector<Vertex3dUVNormal> m_vertices;
 	std::vector<unsigned int> m_indices;
 
+    unsigned int m_refCount = 0;
+
 	// Buffered shape info
-	GLuint m_vertexBuffer;
-	GLuint m_indexBuffer;
-    GLuint m_instanceBuffer;
+	GLuint m_vertexBuffer = 0;
+	GLuint m_indexBuffer = 0;
+    GLuint m_instanceBuffer = 0;
 
     void CalculateTangents();
 
@@ -0,0 +1,562 @@
+/*
+Title: Deferred Spot Lighting
+File Name: meshPool.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "meshPool.h"
+#include "selfTest.h"
+#include "instanceCuller.h"
+
+BufferSuballocator::BufferSuballocator(unsigned int capacity)
+{
+    // At the start, the whole buffer is one big free range.
+    m_capacity = capacity;
+    Range all = { 0, capacity };
+    m_freeRanges.push_back(all);
+}
+
+unsigned int BufferSuballocator::Allocate(unsigned int size)
+{
+    if (size == 0)
+    {
+        return INVALID_OFFSET;
+    }
+
+    // First fit: take the lowest free range that is big enough.
+    for (unsigned int i = 0; i < m_freeRanges.size(); i++)
+    {
+        if (m_freeRanges[i].m_size >= size)
+        {
+            unsigned int offset = m_freeRanges[i].m_offset;
+
+            // Shrink the free range from the front, and remove it if it's used up entirely.
+            m_freeRanges[i].m_offset += size;
+            m_freeRanges[i].m_size -= size;
+            if (m_freeRanges[i].m_size == 0)
+            {
+                m_freeRanges.erase(m_freeRanges.begin() + i);
+            }
+            return offset;
+        }
+    }
+
+    return INVALID_OFFSET;
+}
+
+void BufferSuballocator::Free(unsigned int offset, unsigned int size)
+{
+    if (size == 0 || offset == INVALID_OFFSET)
+    {
+        return;
+    }
+
+    // Find where the range goes to keep the list sorted by offset.
+    unsigned int i = 0;
+    while (i < m_freeRanges.size() && m_freeRanges[i].m_offset < offset)
+    {
+        i++;
+    }
+
+    Range range = { offset, size };
+    m_freeRanges.insert(m_freeRanges.begin() + i, range);
+
+    // Merge with the next range if they touch.
+    if (i + 1 < m_freeRanges.size() && m_freeRanges[i].m_offset + m_freeRanges[i].m_size == m_freeRanges[i + 1].m_offset)
+    {
+        m_freeRanges[i].m_size += m_freeRanges[i + 1].m_size;
+        m_freeRanges.erase(m_freeRanges.begin() + i + 1);
+    }
+
+    // Merge with the previous range if they touch.
+    if (i > 0 && m_freeRanges[i - 1].m_offset + m_freeRanges[i - 1].m_size == m_freeRanges[i].m_offset)
+    {
+        m_freeRanges[i - 1].m_size += m_freeRanges[i].m_size;
+        m_freeRanges.erase(m_freeRanges.begin() + i);
+    }
+}
+
+unsigned int BufferSuballocator::GetCapacity()
+{
+    return m_capacity;
+}
+
+unsigned int BufferSuballocator::GetFreeSpace()
+{
+    unsigned int total = 0;
+    for (unsigned int i = 0; i < m_freeRanges.size(); i++)
+    {
+        total += m_freeRanges[i].m_size;
+    }
+    return total;
+}
+
+unsigned int BufferSuballocator::GetFreeRangeCount()
+{
+    return m_freeRanges.size();
+}
+
+
+
+void DrawCommandList::Clear()
+{
+    m_commands.clear();
+    m_instanceMatrices.clear();
+    m_drawIds.clear();
+    m_boundingSpheres.clear();
+}
+
+void DrawCommandList::Add(const MeshPoolEntry& entry, const std::vector<glm::mat4>& matrices)
+{
+    if (matrices.size() == 0)
+    {
+        return;
+    }
+
+    // This draw's instances start wherever the previous draw's instances ended.
+    GLuint baseInstance = m_instanceMatrices.size();
+    m_instanceMatrices.insert(m_instanceMatrices.end(), matrices.begin(), matrices.end());
+    m_drawIds.insert(m_drawIds.end(), matrices.size(), (GLuint)m_commands.size());
+    m_boundingSpheres.push_back(entry.m_boundingSphere);
+
+    m_commands.push_back(DrawElementsIndirectCommand(entry.m_indexCount, matrices.size(), entry.m_firstIndex, entry.m_firstVertex, baseInstance));
+}
+
+void DrawCommandList::SortFrontToBack(glm::vec3 cameraPosition)
+{
+    // Squared distance from the camera to each instance's position.
+    std::vector<float> distances(m_instanceMatrices.size());
+    for (unsigned int i = 0; i < m_instanceMatrices.size(); i++)
+    {
+        glm::vec3 offset = glm::vec3(m_instanceMatrices[i][3]) - cameraPosition;
+        distances[i] = glm::dot(offset, offset);
+    }
+
+    // Sort the instances inside each command's range, nearest first.
+    std::vector<glm::mat4> sortedMatrices(m_instanceMatrices.size());
+    std::vector<float> nearest(m_commands.size());
+    for (unsigned int c = 0; c < m_commands.size(); c++)
+    {
+        unsigned int first = m_commands[c].m_baseInstance;
+        std::vector<unsigned int> order;
+        for (unsigned int i = 0; i < m_commands[c].m_instanceCount; i++)
+        {
+            order.push_back(first + i);
+        }
+        std::sort(order.begin(), order.end(), [&distances](unsigned int a, unsigned int b) { return distances[a] < distances[b]; });
+
+        for (unsigned int i = 0; i < order.size(); i++)
+        {
+            sortedMatrices[first + i] = m_instanceMatrices[order[i]];
+        }
+        nearest[c] = distances[order[0]];
+    }
+    m_instanceMatrices = sortedMatrices;
+
+    // Then put the commands with the nearest instances first.
+    // The instance ranges don't move, but draw ids and bounding spheres follow their commands.
+    std::vector<unsigned int> commandOrder;
+    for (unsigned int c = 0; c < m_commands.size(); c++)
+    {
+        commandOrder.push_back(c);
+    }
+    std::sort(commandOrder.begin(), commandOrder.end(), [&nearest](unsigned int a, unsigned int b) { return nearest[a] < nearest[b]; });
+
+    std::vector<DrawElementsIndirectCommand> sortedCommands;
+    std::vector<glm::vec4> sortedSpheres;
+    std::vector<GLuint> newDrawId(m_commands.size());
+    for (unsigned int i = 0; i < commandOrder.size(); i++)
+    {
+        sortedCommands.push_back(m_commands[commandOrder[i]]);
+        sortedSpheres.push_back(m_boundingSpheres[commandOrder[i]]);
+        newDrawId[commandOrder[i]] = i;
+    }
+    for (unsigned int i = 0; i < m_drawIds.size(); i++)
+    {
+        m_drawIds[i] = newDrawId[m_drawIds[i]];
+    }
+    m_commands = sortedCommands;
+    m_boundingSpheres = sortedSpheres;
+}
+
+std::vector<DrawElementsIndirectCommand>& DrawCommandList::GetCommands()
+{
+    return m_commands;
+}
+
+std::vector<glm::mat4>& DrawCommandList::GetInstanceMatrices()
+{
+    return m_instanceMatrices;
+}
+
+std::vector<GLuint>& DrawCommandList::GetDrawIds()
+{
+    return m_drawIds;
+}
+
+std::vector<glm::vec4>& DrawCommandList::GetBoundingSpheres()
+{
+    return m_boundingSpheres;
+}
+
+
+
+MeshPool::MeshPool(unsigned int vertexCapacity, unsigned int indexCapacity)
+    : m_vertexAllocator(vertexCapacity), m_indexAllocator(indexCapacity)
+{
+    // Allocate the shared buffers up front, meshes are copied into them later with glBufferSubData.
+    glGenBuffers(1, &m_vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexCapacity * sizeof(Vertex3dUVNormal), NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // A second copy of just the positions, at the same vertex offsets, for depth only passes.
+    glGenBuffers(1, &m_positionBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_positionBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexCapacity * sizeof(glm::vec3), NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenBuffers(1, &m_indexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_indexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, indexCapacity * sizeof(unsigned int), NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // The instance and indirect buffers are refilled every frame.
+    glGenBuffers(1, &m_instanceBuffer);
+    glGenBuffers(1, &m_indirectBuffer);
+}
+
+MeshPool::~MeshPool()
+{
+    glDeleteBuffers(1, &m_vertexBuffer);
+    glDeleteBuffers(1, &m_positionBuffer);
+    glDeleteBuffers(1, &m_indexBuffer);
+    glDeleteBuffers(1, &m_instanceBuffer);
+    glDeleteBuffers(1, &m_indirectBuffer);
+}
+
+int MeshPool::AddMesh(Mesh* mesh)
+{
+    std::vector<Vertex3dUVNormal>& vertices = mesh->GetVertices();
+    std::vector<unsigned int>& indices = mesh->GetIndices();
+
+    MeshPoolEntry entry;
+    entry.m_vertexCount = vertices.size();
+    entry.m_indexCount = indices.size();
+    entry.m_firstVertex = m_vertexAllocator.Allocate(entry.m_vertexCount);
+    entry.m_firstIndex = m_indexAllocator.Allocate(entry.m_indexCount);
+    entry.m_boundingSphere = mesh->GetBoundingSphere();
+    entry.m_inUse = true;
+
+    // If either buffer is out of room, give back whatever we did get and print an error.
+    if (entry.m_firstVertex == BufferSuballocator::INVALID_OFFSET || entry.m_firstIndex == BufferSuballocator::INVALID_OFFSET)
+    {
+        m_vertexAllocator.Free(entry.m_firstVertex, entry.m_vertexCount);
+        m_indexAllocator.Free(entry.m_firstIndex, entry.m_indexCount);
+        std::cout << "Mesh pool is full, could not add mesh." << std::endl;
+        return -1;
+    }
+
+    // Copy the mesh into its ranges.
+    // The indices stay relative to the mesh, baseVertex in the draw command offsets them for us.
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, entry.m_firstVertex * sizeof(Vertex3dUVNormal), vertices.size() * sizeof(Vertex3dUVNormal), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, m_indexBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, entry.m_firstIndex * sizeof(unsigned int), indices.size() * sizeof(unsigned int), indices.data());
+
+    // Fill the position only stream too.
+    std::vector<glm::vec3> positions;
+    for (unsigned int i = 0; i < vertices.size(); i++)
+    {
+        positions.push_back(vertices[i].m_position);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_positionBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, entry.m_firstVertex * sizeof(glm::vec3), positions.size() * sizeof(glm::vec3), positions.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Reuse a removed slot if there is one.
+    for (unsigned int i = 0; i < m_entries.size(); i++)
+    {
+        if (!m_entries[i].m_inUse)
+        {
+            m_entries[i] = entry;
+            return i;
+        }
+    }
+
+    m_entries.push_back(entry);
+    return m_entries.size() - 1;
+}
+
+void MeshPool::RemoveMesh(int meshId)
+{
+    if (meshId < 0 || meshId >= (int)m_entries.size() || !m_entries[meshId].m_inUse)
+    {
+        return;
+    }
+
+    MeshPoolEntry& entry = m_entries[meshId];
+    m_vertexAllocator.Free(entry.m_firstVertex, entry.m_vertexCount);
+    m_indexAllocator.Free(entry.m_firstIndex, entry.m_indexCount);
+    entry.m_inUse = false;
+}
+
+void MeshPool::Submit(int meshId, const std::vector<glm::mat4>& matrices)
+{
+    if (meshId < 0 || meshId >= (int)m_entries.size() || !m_entries[meshId].m_inUse)
+    {
+        std::cout << "Mesh pool: tried to draw a mesh that isn't in the pool." << std::endl;
+        return;
+    }
+
+    m_commandList.Add(m_entries[meshId], matrices);
+}
+
+void MeshPool::Draw(InstanceCuller* culler)
+{
+    Prepare(culler);
+    Render(false);
+    Clear();
+}
+
+void MeshPool::Prepare(InstanceCuller* culler)
+{
+    std::vector<DrawElementsIndirectCommand>& commands = m_commandList.GetCommands();
+    std::vector<glm::mat4>& matrices = m_commandList.GetInstanceMatrices();
+
+    if (commands.size() == 0)
+    {
+        return;
+    }
+
+    // Every draw's matrices live in one instance buffer.
+    // Each command's baseInstance tells OpenGL where its matrices begin.
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, matrices.size() * sizeof(glm::mat4), matrices.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (culler != nullptr)
+    {
+        // The culler fills the indirect buffer with the surviving instance counts,
+        // and writes the surviving matrices into its own buffer, which we draw from instead.
+        culler->Cull(m_commandList, m_instanceBuffer, m_indirectBuffer);
+        m_drawInstanceBuffer = culler->GetVisibleInstanceBuffer();
+    }
+    else
+    {
+        // Without culling, just upload the commands as they are.
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        m_drawInstanceBuffer = m_instanceBuffer;
+    }
+}
+
+void MeshPool::Render(bool positionsOnly)
+{
+    RenderRange(0, m_commandList.GetCommands().size(), positionsOnly);
+}
+
+void MeshPool::PrepareCommands(const std::vector<DrawElementsIndirectCommand>& commands, const std::vector<glm::mat4>& matrices)
+{
+    // The same buffers Prepare fills without a culler, the commands already point at the right matrices.
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, matrices.size() * sizeof(glm::mat4), matrices.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    m_drawInstanceBuffer = m_instanceBuffer;
+}
+
+void MeshPool::RenderRange(unsigned int firstCommand, unsigned int commandCount, bool positionsOnly)
+{
+    if (commandCount == 0)
+    {
+        return;
+    }
+
+    if (positionsOnly)
+    {
+        // The depth pre-pass only needs positions, so read them from the tightly packed position stream.
+        // That's a quarter of the memory per vertex compared to the full vertex.
+        glBindBuffer(GL_ARRAY_BUFFER, m_positionBuffer);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    }
+    else
+    {
+        // Bind the shared vertex buffer and set the Vertex Attributes exactly like Mesh::DrawInstanced does.
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex3dUVNormal), (void*)0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex3dUVNormal), (void*)sizeof(glm::vec3));
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_TRUE, sizeof(Vertex3dUVNormal), (void*)(sizeof(glm::vec3) + sizeof(glm::vec2)));
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_TRUE, sizeof(Vertex3dUVNormal), (void*)(2 * sizeof(glm::vec3) + sizeof(glm::vec2)));
+    }
+
+    // Instance matrices, from the culler's output if there was one.
+    glBindBuffer(GL_ARRAY_BUFFER, m_drawInstanceBuffer);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 16, (void*)(0));
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 16, (void*)(sizeof(float) * 4));
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 16, (void*)(sizeof(float) * 8));
+    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 16, (void*)(sizeof(float) * 12));
+    for (int i = 4; i < 8; i++)
+    {
+        glVertexAttribDivisor(i, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    for (int i = 0; i < 8; i++)
+    {
+        if (i == 0 || i >= 4 || !positionsOnly)
+        {
+            glEnableVertexAttribArray(i);
+        }
+    }
+
+    // Draw every mesh with one call.
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(firstCommand * sizeof(DrawElementsIndirectCommand)), commandCount, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    // Disable vertex attributes and set divisors back to default.
+    for (int i = 0; i < 8; i++)
+    {
+        glDisableVertexAttribArray(i);
+    }
+    for (int i = 4; i < 8; i++)
+    {
+        glVertexAttribDivisor(i, 0);
+    }
+}
+
+void MeshPool::Clear()
+{
+    m_commandList.Clear();
+}
+
+DrawCommandList& MeshPool::GetCommandList()
+{
+    return m_commandList;
+}
+
+int MeshPool::RunTest()
+{
+    SelfTest test("Mesh pool");
+
+    // First fit, running out of room, and merging freed ranges back together.
+    {
+        BufferSuballocator allocator(100);
+        unsigned int a = allocator.Allocate(30);
+        unsigned int b = allocator.Allocate(30);
+        unsigned int c = allocator.Allocate(30);
+        test.Check(a == 0 && b == 30 && c == 60, "Ranges weren't handed out back to back");
+        test.Check(allocator.Allocate(0) == BufferSuballocator::INVALID_OFFSET, "An empty range was allocated");
+        test.Check(allocator.Allocate(11) == BufferSuballocator::INVALID_OFFSET, "A range bigger than the space left was allocated");
+
+        // Two holes, 30 at 0 and 10 at 90. The first one that fits is taken, even when a later one fits better.
+        allocator.Free(a, 30);
+        test.Check(allocator.GetFreeSpace() == 40 && allocator.GetFreeRangeCount() == 2, "Freeing a range didn't leave two holes");
+        unsigned int d = allocator.Allocate(10);
+        test.Check(d == 0, "Allocation wasn't first fit");
+        test.Check(allocator.Allocate(25) == BufferSuballocator::INVALID_OFFSET, "A range bigger than any hole was allocated");
+
+        // Freeing the middle joins the holes on both sides into one.
+        allocator.Free(d, 10);
+        allocator.Free(b, 30);
+        test.Check(allocator.GetFreeRangeCount() == 2 && allocator.GetFreeSpace() == 70, "A freed range wasn't merged with the one before it");
+        allocator.Free(c, 30);
+        test.Check(allocator.GetFreeRangeCount() == 1 && allocator.GetFreeSpace() == 100, "Freed ranges weren't merged into one");
+        test.Check(allocator.Allocate(100) == 0, "The whole buffer couldn't be allocated after everything was freed");
+        test.Check(allocator.GetFreeSpace() == 0 && allocator.GetFreeRangeCount() == 0, "A full buffer still has free ranges");
+    }
+
+    // Each command's instances are its own range, in the order they were added, and stay that way after sorting.
+    {
+        MeshPoolEntry entries[3];
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            entries[i].m_firstVertex = i * 100;
+            entries[i].m_vertexCount = 100;
+            entries[i].m_firstIndex = i * 300;
+            entries[i].m_indexCount = 300;
+            entries[i].m_boundingSphere = glm::vec4(0, 0, 0, (float)i + 1);
+            entries[i].m_inUse = true;
+        }
+
+        // Instances at x = distance from the camera, mesh 0 far away, mesh 2 near.
+        auto at = [](float x) {
+            glm::mat4 world;
+            world[3] = glm::vec4(x, 0, 0, 1);
+            return world;
+        };
+        DrawCommandList list;
+        list.Add(entries[0], { at(50), at(40), at(60) });
+        list.Add(entries[1], std::vector<glm::mat4>());
+        list.Add(entries[1], { at(30), at(20) });
+        list.Add(entries[2], { at(5) });
+
+        std::vector<DrawElementsIndirectCommand>& commands = list.GetCommands();
+        test.Check(commands.size() == 3, "An empty draw added a command");
+        test.Check(commands.size() == 3 && commands[0].m_baseInstance == 0 && commands[0].m_instanceCount == 3 &&
+            commands[1].m_baseInstance == 3 && commands[1].m_instanceCount == 2 &&
+            commands[2].m_baseInstance == 5 && commands[2].m_instanceCount == 1, "Instance ranges are wrong after Add");
+        test.Check(commands.size() == 3 && commands[1].m_firstIndex == 300 && commands[1].m_baseVertex == 100 && commands[1].m_count == 300,
+            "A command doesn't point at its mesh");
+
+        std::vector<GLuint> expectedIds = { 0, 0, 0, 1, 1, 2 };
+        test.Check(list.GetDrawIds() == expectedIds && list.GetInstanceMatrices().size() == 6, "Draw ids are wrong after Add");
+
+        list.SortFrontToBack(glm::vec3(0));
+        if (commands.size() == 3)
+        {
+            // Mesh 2 is nearest, then mesh 1, then mesh 0. The ranges stay where they were.
+            test.Check(commands[0].m_baseInstance == 5 && commands[0].m_instanceCount == 1 &&
+                commands[1].m_baseInstance == 3 && commands[1].m_instanceCount == 2 &&
+                commands[2].m_baseInstance == 0 && commands[2].m_instanceCount == 3, "Commands aren't nearest first after sorting");
+            test.Check(list.GetBoundingSpheres()[0].w == 3 && list.GetBoundingSpheres()[2].w == 1, "Bounding spheres didn't follow their commands");
+
+            // Every instance still belongs to the command whose range it's in.
+            bool idsMatch = true;
+            for (unsigned int c = 0; c < commands.size(); c++)
+            {
+                for (unsigned int i = 0; i < commands[c].m_instanceCount; i++)
+                {
+                    idsMatch = idsMatch && list.GetDrawIds()[commands[c].m_baseInstance + i] == c;
+                }
+            }
+            test.Check(idsMatch, "Draw ids don't match the sorted commands");
+
+            std::vector<glm::mat4>& matrices = list.GetInstanceMatrices();
+            float expectedX[] = { 40, 50, 60, 20, 30, 5 };
+            bool sorted = true;
+            for (unsigned int i = 0; i < 6; i++)
+            {
+                sorted = sorted && matrices[i][3].x == expectedX[i];
+            }
+            test.Check(sorted, "Instances aren't nearest first within their command");
+        }
+    }
+
+    return test.Finish();
+}
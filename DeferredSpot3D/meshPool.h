@@ -0,0 +1,188 @@
+/*
+Title: Deferred Spot Lighting
+File Name: meshPool.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "glm/glm.hpp"
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+#include "mesh.h"
+
+class InstanceCuller;
+
+// This is the exact layout OpenGL expects for each draw in an indirect buffer.
+// (see glMultiDrawElementsIndirect in the OpenGL 4.3 spec)
+struct DrawElementsIndirectCommand
+{
+    GLuint m_count;         // Number of indices to draw
+    GLuint m_instanceCount; // Number of instances to draw
+    GLuint m_firstIndex;    // Offset into the shared index buffer (in indices, not bytes)
+    GLuint m_baseVertex;    // Added to every index, so each mesh can keep its own 0 based indices
+    GLuint m_baseInstance;  // Offset into the instance buffer for the first instance of this draw
+
+    DrawElementsIndirectCommand(GLuint count, GLuint instanceCount, GLuint firstIndex, GLuint baseVertex, GLuint baseInstance) {
+        m_count = count;
+        m_instanceCount = instanceCount;
+        m_firstIndex = firstIndex;
+        m_baseVertex = baseVertex;
+        m_baseInstance = baseInstance;
+    }
+};
+
+// Hands out ranges of a fixed size buffer (measured in elements, not bytes).
+// It doesn't touch OpenGL at all, so it can be used and tested without a context.
+class BufferSuballocator
+{
+public:
+    // Returned by Allocate when there isn't a large enough free range.
+    static const unsigned int INVALID_OFFSET = 0xFFFFFFFF;
+
+    BufferSuballocator(unsigned int capacity);
+
+    // Finds the first free range that fits and returns its offset.
+    unsigned int Allocate(unsigned int size);
+    // Gives a range back, merging it with any free neighbours.
+    void Free(unsigned int offset, unsigned int size);
+
+    unsigned int GetCapacity();
+    unsigned int GetFreeSpace();
+    unsigned int GetFreeRangeCount();
+
+private:
+    struct Range
+    {
+        unsigned int m_offset;
+        unsigned int m_size;
+    };
+
+    unsigned int m_capacity;
+
+    // Free ranges, always sorted by offset and never touching each other.
+    std::vector<Range> m_freeRanges;
+};
+
+// Where a single mesh lives inside the pool's shared buffers.
+struct MeshPoolEntry
+{
+    unsigned int m_firstVertex;
+    unsigned int m_vertexCount;
+    unsigned int m_firstIndex;
+    unsigned int m_indexCount;
+    glm::vec4 m_boundingSphere; // Model space bounding sphere, used for culling
+    bool m_inUse;
+};
+
+// Builds the per frame list of indirect draw commands and the instance matrices they point into.
+// Like the allocator, this is plain CPU data so it can be checked without a GPU.
+class DrawCommandList
+{
+public:
+    // Empties the list for a new frame.
+    void Clear();
+
+    // Adds one draw of a mesh entry with the given instance matrices.
+    // The matrices are appended to the shared instance array and the command's baseInstance points at them.
+    void Add(const MeshPoolEntry& entry, const std::vector<glm::mat4>& matrices);
+
+    // Reorders instances (and then whole commands) so the nearest ones are drawn first.
+    // Near objects fill the depth buffer early, so more of the hidden fragments behind them fail the depth test.
+    // Note: the GPU culler appends survivors with atomics, which only roughly keeps this order.
+    void SortFrontToBack(glm::vec3 cameraPosition);
+
+    std::vector<DrawElementsIndirectCommand>& GetCommands();
+    std::vector<glm::mat4>& GetInstanceMatrices();
+    std::vector<GLuint>& GetDrawIds();
+    std::vector<glm::vec4>& GetBoundingSpheres();
+
+private:
+    std::vector<DrawElementsIndirectCommand> m_commands;
+    std::vector<glm::mat4> m_instanceMatrices;
+
+    // For culling: which command each instance belongs to, and the bounding sphere of each command's mesh.
+    std::vector<GLuint> m_drawIds;
+    std::vector<glm::vec4> m_boundingSpheres;
+};
+
+// Stores many different meshes inside one large vertex buffer and one large index buffer.
+// Because they all share the same buffers, every mesh submitted in a frame can be drawn
+// with a single call to glMultiDrawElementsIndirect instead of one bind and draw per mesh.
+class MeshPool
+{
+public:
+    // Capacities are in vertices and indices.
+    MeshPool(unsigned int vertexCapacity, unsigned int indexCapacity);
+    ~MeshPool();
+
+    // Copies the mesh into the shared buffers and returns an id for it, or -1 if the pool is full.
+    int AddMesh(Mesh* mesh);
+    // Releases the space used by a mesh so another one can use it.
+    void RemoveMesh(int meshId);
+
+    // Queue up instances of a mesh for this frame.
+    void Submit(int meshId, const std::vector<glm::mat4>& matrices);
+
+    // Draws everything submitted since the last draw, then empties the queue.
+    // If a culler is given, instances are frustum culled on the GPU before drawing.
+    // This is the same as calling Prepare, Render and Clear.
+    void Draw(InstanceCuller* culler = nullptr);
+
+    // Uploads (and optionally culls) everything submitted, so it can be rendered more than once.
+    void Prepare(InstanceCuller* culler = nullptr);
+    // Draws what was prepared. positionsOnly only feeds attribute 0 and the instance matrices (for depth only passes).
+    void Render(bool positionsOnly);
+
+    // Uploads commands and instances that were built somewhere else (like each shadow map's casters, see
+    // shadowCasterCuller.h) in place of the prepared ones, so they can be drawn a range at a time.
+    // Whatever was prepared can't be rendered again after this, until the next Prepare.
+    void PrepareCommands(const std::vector<DrawElementsIndirectCommand>& commands, const std::vector<glm::mat4>& matrices);
+    // Draws some of the commands given to PrepareCommands, with one multi-draw call.
+    void RenderRange(unsigned int firstCommand, unsigned int commandCount, bool positionsOnly);
+    // Empties the queue for the next frame.
+    void Clear();
+
+    DrawCommandList& GetCommandList();
+
+    // Checks the suballocator (first fit, merging, running out of room) and the command list's instance ranges
+    // before and after sorting, without a GPU.
+    static int RunTest();
+
+private:
+    BufferSuballocator m_vertexAllocator;
+    BufferSuballocator m_indexAllocator;
+
+    std::vector<MeshPoolEntry> m_entries;
+    DrawCommandList m_commandList;
+
+    GLuint m_vertexBuffer;
+    GLuint m_positionBuffer;
+    GLuint m_indexBuffer;
+    GLuint m_instanceBuffer;
+    GLuint m_indirectBuffer;
+
+    // The instance buffer Render reads from (the culler's output when culling).
+    GLuint m_drawInstanceBuffer = 0;
+};
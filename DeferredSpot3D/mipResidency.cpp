@@ -0,0 +1,346 @@
+/*
+Title: Deferred Spot Lighting
+File Name: mipResidency.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mipResidency.h"
+#include "selfTest.h"
+#include <algorithm>
+#include <iostream>
+
+MipResidency::MipResidency(unsigned long long budget, unsigned int maxLoadsPerUpdate)
+{
+    m_budget = budget;
+    m_maxLoadsPerUpdate = maxLoadsPerUpdate;
+}
+
+unsigned int MipResidency::Add(const std::vector<unsigned int>& levelSizes, unsigned int coarseLevel)
+{
+    Entry entry;
+    entry.m_levelSizes = levelSizes;
+    entry.m_coarseLevel = std::min(coarseLevel, (unsigned int)levelSizes.size() - 1);
+    entry.m_residentLevel = entry.m_coarseLevel;
+    entry.m_requestedLevel = entry.m_coarseLevel;
+    entry.m_lastUsed.resize(levelSizes.size(), 0);
+
+    for (unsigned int i = entry.m_residentLevel; i < levelSizes.size(); i++)
+    {
+        m_residentBytes += levelSizes[i];
+    }
+
+    m_entries.push_back(entry);
+    return m_entries.size() - 1;
+}
+
+void MipResidency::Request(unsigned int id, unsigned int level, unsigned int frame)
+{
+    Entry& entry = m_entries[id];
+    level = std::min(level, (unsigned int)entry.m_levelSizes.size() - 1);
+
+    // Newer feedback replaces older feedback. Within a frame, the finest level wins.
+    if (!entry.m_requested || frame > entry.m_requestFrame)
+    {
+        entry.m_requested = true;
+        entry.m_requestFrame = frame;
+        entry.m_requestedLevel = level;
+    }
+    else if (frame == entry.m_requestFrame)
+    {
+        entry.m_requestedLevel = std::min(entry.m_requestedLevel, level);
+    }
+
+    // Sampling a level also needs every coarser level (trilinear filtering reads the next one too).
+    for (unsigned int i = level; i < entry.m_levelSizes.size(); i++)
+    {
+        entry.m_lastUsed[i] = std::max(entry.m_lastUsed[i], frame);
+    }
+    m_latestFrame = std::max(m_latestFrame, frame);
+}
+
+void MipResidency::Update(std::vector<unsigned int>& changed)
+{
+    // If the budget went down, drop levels until it fits again, least recently used first.
+    // Only the coarse levels stay no matter what.
+    while (m_residentBytes > m_budget && EvictOne((unsigned int)-1, (unsigned int)-1, changed))
+    {
+    }
+
+    // Textures that want finer levels than they have, the ones missing the most first.
+    std::vector<unsigned int> candidates;
+    for (unsigned int i = 0; i < m_entries.size(); i++)
+    {
+        if (m_entries[i].m_requested && m_entries[i].m_requestedLevel < m_entries[i].m_residentLevel)
+        {
+            candidates.push_back(i);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [this](unsigned int a, unsigned int b)
+    {
+        return m_entries[a].m_residentLevel - m_entries[a].m_requestedLevel > m_entries[b].m_residentLevel - m_entries[b].m_requestedLevel;
+    });
+
+    unsigned int loads = 0;
+    for (unsigned int i = 0; i < candidates.size() && loads < m_maxLoadsPerUpdate; i++)
+    {
+        unsigned int id = candidates[i];
+        Entry& entry = m_entries[id];
+        unsigned int level = entry.m_residentLevel - 1;
+        unsigned int size = entry.m_levelSizes[level];
+
+        // Make room by evicting levels that were needed less recently than this one.
+        bool fits = true;
+        while (m_residentBytes + size > m_budget)
+        {
+            if (!EvictOne(entry.m_lastUsed[level], id, changed))
+            {
+                fits = false;
+                break;
+            }
+        }
+        if (!fits)
+        {
+            continue;
+        }
+
+        entry.m_residentLevel = level;
+        m_residentBytes += size;
+        MarkChanged(id, changed);
+        loads++;
+    }
+}
+
+bool MipResidency::EvictOne(unsigned int frame, unsigned int skipId, std::vector<unsigned int>& changed)
+{
+    // Only the finest resident level of each texture can go, and never the coarse levels.
+    unsigned int victim = (unsigned int)-1;
+    unsigned int oldest = frame;
+    for (unsigned int i = 0; i < m_entries.size(); i++)
+    {
+        Entry& entry = m_entries[i];
+        if (i == skipId || entry.m_residentLevel >= entry.m_coarseLevel)
+        {
+            continue;
+        }
+        if (entry.m_lastUsed[entry.m_residentLevel] < oldest)
+        {
+            oldest = entry.m_lastUsed[entry.m_residentLevel];
+            victim = i;
+        }
+    }
+
+    if (victim == (unsigned int)-1)
+    {
+        return false;
+    }
+
+    Entry& entry = m_entries[victim];
+    m_residentBytes -= entry.m_levelSizes[entry.m_residentLevel];
+    entry.m_residentLevel++;
+    MarkChanged(victim, changed);
+    return true;
+}
+
+void MipResidency::MarkChanged(unsigned int id, std::vector<unsigned int>& changed)
+{
+    if (std::find(changed.begin(), changed.end(), id) == changed.end())
+    {
+        changed.push_back(id);
+    }
+}
+
+unsigned int MipResidency::GetResidentLevel(unsigned int id)
+{
+    return m_entries[id].m_residentLevel;
+}
+
+unsigned int MipResidency::GetRequestedLevel(unsigned int id)
+{
+    return m_entries[id].m_requestedLevel;
+}
+
+unsigned int MipResidency::GetLevelCount(unsigned int id)
+{
+    return m_entries[id].m_levelSizes.size();
+}
+
+unsigned long long MipResidency::GetResidentBytes()
+{
+    return m_residentBytes;
+}
+
+unsigned long long MipResidency::GetBudget()
+{
+    return m_budget;
+}
+
+void MipResidency::SetBudget(unsigned long long budget)
+{
+    m_budget = budget;
+}
+
+unsigned int MipResidency::GetTextureCount()
+{
+    return m_entries.size();
+}
+
+int MipResidency::RunTest()
+{
+    SelfTest test("Mip residency");
+
+    // Four levels, of which the last two (5 bytes) are coarse and stay resident.
+    std::vector<unsigned int> levels = { 64, 16, 4, 1 };
+    const unsigned int coarseLevel = 2;
+    const unsigned int coarseBytes = 5;
+
+    // Whether every texture still has its coarse levels, and the resident bytes add up.
+    auto consistent = [&](MipResidency& residency) {
+        unsigned long long bytes = 0;
+        for (unsigned int i = 0; i < residency.GetTextureCount(); i++)
+        {
+            if (residency.GetResidentLevel(i) > coarseLevel)
+            {
+                return false;
+            }
+            for (unsigned int j = residency.GetResidentLevel(i); j < levels.size(); j++)
+            {
+                bytes += levels[j];
+            }
+        }
+        return bytes == residency.GetResidentBytes();
+    };
+
+    // Every texture wants everything, more than fits. The budget holds, and no Update loads more than two levels.
+    {
+        MipResidency residency(3 * coarseBytes + 3 * 16, 2);
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            residency.Add(levels, coarseLevel);
+        }
+
+        bool underBudget = true;
+        bool limited = true;
+        bool coarse = true;
+        for (unsigned int frame = 1; frame < 20; frame++)
+        {
+            unsigned int before = 0;
+            for (unsigned int i = 0; i < 3; i++)
+            {
+                residency.Request(i, 0, frame);
+                before += residency.GetResidentLevel(i);
+            }
+
+            std::vector<unsigned int> changed;
+            residency.Update(changed);
+
+            unsigned int after = 0;
+            for (unsigned int i = 0; i < 3; i++)
+            {
+                after += residency.GetResidentLevel(i);
+            }
+            underBudget = underBudget && residency.GetResidentBytes() <= residency.GetBudget();
+            limited = limited && (before < after || before - after <= 2);
+            coarse = coarse && consistent(residency);
+        }
+        test.Check(underBudget, "The budget was exceeded");
+        test.Check(limited, "More than two levels were loaded in one Update");
+        test.Check(coarse, "A coarse level was evicted, or the resident bytes don't add up");
+    }
+
+    // With nothing in the way, loads are spread over Updates, two at a time.
+    {
+        MipResidency residency(1 << 20, 2);
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            residency.Add(levels, coarseLevel);
+            residency.Request(i, 0, 1);
+        }
+
+        std::vector<unsigned int> changed;
+        residency.Update(changed);
+        unsigned int loaded = 0;
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            loaded += coarseLevel - residency.GetResidentLevel(i);
+        }
+        test.Check(loaded == 2, "The first Update didn't load exactly two levels");
+
+        for (int update = 0; update < 2; update++)
+        {
+            changed.clear();
+            residency.Update(changed);
+        }
+        bool all = true;
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            all = all && residency.GetResidentLevel(i) == 0;
+        }
+        test.Check(all, "Three Updates didn't load all six levels");
+    }
+
+    // Room for two of level 1. The level needed least recently is the one that makes room for a third.
+    {
+        MipResidency residency(3 * coarseBytes + 2 * 16, 2);
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            residency.Add(levels, coarseLevel);
+        }
+
+        std::vector<unsigned int> changed;
+        residency.Request(0, 1, 1);
+        residency.Request(1, 1, 2);
+        residency.Update(changed);
+        test.Check(residency.GetResidentLevel(0) == 1 && residency.GetResidentLevel(1) == 1, "Two levels that fit weren't loaded");
+
+        // Texture 1 is used again, then texture 2 wants its level too. Texture 0 is the oldest.
+        changed.clear();
+        residency.Request(1, 1, 3);
+        residency.Request(2, 1, 4);
+        residency.Update(changed);
+        test.Check(residency.GetResidentLevel(0) == 2 && residency.GetResidentLevel(1) == 1 && residency.GetResidentLevel(2) == 1,
+            "The least recently used level wasn't the one evicted");
+        test.Check(changed.size() == 2, "The evicted and loaded textures weren't both reported as changed");
+
+        // Levels needed at the same time as the one being loaded are never evicted for it.
+        changed.clear();
+        residency.Request(1, 1, 5);
+        residency.Request(2, 1, 5);
+        residency.Request(0, 1, 5);
+        residency.Update(changed);
+        test.Check(residency.GetResidentLevel(0) == 2 && changed.empty(), "A level was evicted for one that isn't needed more recently");
+
+        // A smaller budget evicts down to it right away, the oldest first.
+        residency.Request(2, 1, 6);
+        residency.SetBudget(3 * coarseBytes + 16);
+        changed.clear();
+        residency.Update(changed);
+        test.Check(residency.GetResidentBytes() <= residency.GetBudget(), "Lowering the budget didn't evict down to it");
+        test.Check(residency.GetResidentLevel(1) == 2 && residency.GetResidentLevel(2) == 1, "Lowering the budget evicted the wrong level");
+
+        // Below the coarse levels, the coarse levels still stay.
+        residency.SetBudget(0);
+        changed.clear();
+        residency.Update(changed);
+        test.Check(residency.GetResidentBytes() == 3 * coarseBytes && consistent(residency), "A budget of 0 evicted coarse levels");
+    }
+
+    return test.Finish();
+}
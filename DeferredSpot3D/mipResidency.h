@@ -0,0 +1,95 @@
+/*
+Title: Deferred Spot Lighting
+File Name: mipResidency.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <vector>
+
+// Decides which mip levels of each texture should be in GPU memory, without touching OpenGL.
+//
+// Every texture keeps its coarse levels (coarseLevel and smaller) resident all the time. Finer levels are loaded
+// one at a time when feedback says the texture is drawn big enough on screen to need them. When loading one would
+// go over the memory budget, the least recently used fine levels of other textures are evicted to make room.
+//
+// Residency is always a full chain: a texture has every level from its resident level down to 1x1.
+// Levels are evicted finest first, and loaded coarsest first.
+class MipResidency
+{
+public:
+    // budget is in bytes. At most maxLoadsPerUpdate levels are loaded each Update, to spread out the upload cost.
+    MipResidency(unsigned long long budget, unsigned int maxLoadsPerUpdate = 2);
+
+    // Adds a texture and returns its id. levelSizes holds the bytes of each level, level 0 (full size) first.
+    // The texture starts out with only coarseLevel and smaller levels resident.
+    unsigned int Add(const std::vector<unsigned int>& levelSizes, unsigned int coarseLevel);
+
+    // Feedback: during frame, the texture was sampled as fine as level.
+    void Request(unsigned int id, unsigned int level, unsigned int frame);
+
+    // Loads and evicts levels. Every texture whose resident level changed is added to changed (once).
+    void Update(std::vector<unsigned int>& changed);
+
+    // The finest level currently resident.
+    unsigned int GetResidentLevel(unsigned int id);
+    // The finest level asked for by the latest feedback.
+    unsigned int GetRequestedLevel(unsigned int id);
+    unsigned int GetLevelCount(unsigned int id);
+
+    unsigned long long GetResidentBytes();
+    unsigned long long GetBudget();
+    void SetBudget(unsigned long long budget);
+    unsigned int GetTextureCount();
+
+    // Checks the budget, the coarse levels, the order levels are evicted in, lowering the budget, and the load
+    // limit, on made up textures.
+    static int RunTest();
+
+private:
+    struct Entry
+    {
+        std::vector<unsigned int> m_levelSizes;
+        unsigned int m_coarseLevel;
+        unsigned int m_residentLevel;
+
+        bool m_requested = false;
+        unsigned int m_requestedLevel = 0;
+        unsigned int m_requestFrame = 0;
+
+        // The last frame each level was needed in.
+        std::vector<unsigned int> m_lastUsed;
+    };
+
+    // Evicts the finest level of whichever texture used it least recently, as long as that was before frame.
+    // skipId is never touched. Returns false if nothing could be evicted.
+    bool EvictOne(unsigned int frame, unsigned int skipId, std::vector<unsigned int>& changed);
+
+    void MarkChanged(unsigned int id, std::vector<unsigned int>& changed);
+
+    std::vector<Entry> m_entries;
+    unsigned long long m_budget;
+    unsigned long long m_residentBytes = 0;
+    unsigned int m_maxLoadsPerUpdate;
+
+    // The newest frame any feedback has come from.
+    unsigned int m_latestFrame = 0;
+};
@@ -0,0 +1,143 @@
+/*
+Title: Deferred Spot Lighting
+File Name: passProfiler.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "passProfiler.h"
+
+PassProfiler::PassProfiler()
+{
+}
+
+PassProfiler::~PassProfiler()
+{
+    for (unsigned int i = 0; i < m_passes.size(); i++)
+    {
+        glDeleteQueries(PROFILER_FRAMES, m_passes[i].m_timeQueries);
+        glDeleteQueries(PROFILER_FRAMES, m_passes[i].m_sampleQueries);
+    }
+}
+
+void PassProfiler::Begin(std::string name)
+{
+    if (m_activePass != -1)
+    {
+        std::cout << "Pass " << m_passes[m_activePass].m_name << " was not ended before " << name << " began." << std::endl;
+        End();
+    }
+
+    Pass& pass = GetPass(name);
+    m_activePass = &pass - &m_passes[0];
+
+    // If the GPU still hasn't finished a pass from PROFILER_FRAMES ago, drop that result rather than waiting on it.
+    pass.m_pending[m_frame] = true;
+    glBeginQuery(GL_TIME_ELAPSED, pass.m_timeQueries[m_frame]);
+    glBeginQuery(GL_SAMPLES_PASSED, pass.m_sampleQueries[m_frame]);
+}
+
+void PassProfiler::End()
+{
+    if (m_activePass == -1)
+    {
+        return;
+    }
+    glEndQuery(GL_SAMPLES_PASSED);
+    glEndQuery(GL_TIME_ELAPSED);
+    m_activePass = -1;
+}
+
+void PassProfiler::NextFrame()
+{
+    m_frame = (m_frame + 1) % PROFILER_FRAMES;
+
+    // Read back whatever is ready from every frame slot, oldest results are simply overwritten by newer ones.
+    for (unsigned int p = 0; p < m_passes.size(); p++)
+    {
+        Pass& pass = m_passes[p];
+        for (unsigned int i = 0; i < PROFILER_FRAMES; i++)
+        {
+            // Look at the oldest slot first, so the newest result is the one that sticks.
+            unsigned int slot = (m_frame + i) % PROFILER_FRAMES;
+            if (!pass.m_pending[slot])
+            {
+                continue;
+            }
+
+            GLuint timeReady = 0;
+            GLuint samplesReady = 0;
+            glGetQueryObjectuiv(pass.m_timeQueries[slot], GL_QUERY_RESULT_AVAILABLE, &timeReady);
+            glGetQueryObjectuiv(pass.m_sampleQueries[slot], GL_QUERY_RESULT_AVAILABLE, &samplesReady);
+            if (timeReady && samplesReady)
+            {
+                GLuint64 nanoseconds = 0;
+                glGetQueryObjectui64v(pass.m_timeQueries[slot], GL_QUERY_RESULT, &nanoseconds);
+                glGetQueryObjectui64v(pass.m_sampleQueries[slot], GL_QUERY_RESULT, &pass.m_samplesPassed);
+                pass.m_timeMs = nanoseconds / 1000000.f;
+                pass.m_pending[slot] = false;
+            }
+        }
+    }
+}
+
+float PassProfiler::GetTimeMs(std::string name)
+{
+    return GetPass(name).m_timeMs;
+}
+
+GLuint64 PassProfiler::GetSamplesPassed(std::string name)
+{
+    return GetPass(name).m_samplesPassed;
+}
+
+std::string PassProfiler::GetReport()
+{
+    std::string report;
+    for (unsigned int i = 0; i < m_passes.size(); i++)
+    {
+        report += m_passes[i].m_name + ": " + std::to_string(m_passes[i].m_timeMs) + " ms, "
+            + std::to_string(m_passes[i].m_samplesPassed) + " samples\n";
+    }
+    return report;
+}
+
+PassProfiler::Pass& PassProfiler::GetPass(std::string name)
+{
+    for (unsigned int i = 0; i < m_passes.size(); i++)
+    {
+        if (m_passes[i].m_name == name)
+        {
+            return m_passes[i];
+        }
+    }
+
+    // First time we've seen this pass, make its queries.
+    Pass pass;
+    pass.m_name = name;
+    glGenQueries(PROFILER_FRAMES, pass.m_timeQueries);
+    glGenQueries(PROFILER_FRAMES, pass.m_sampleQueries);
+    for (unsigned int i = 0; i < PROFILER_FRAMES; i++)
+    {
+        pass.m_pending[i] = false;
+    }
+    m_passes.push_back(pass);
+    return m_passes.back();
+}
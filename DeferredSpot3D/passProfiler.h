@@ -0,0 +1,78 @@
+/*
+Title: Deferred Spot Lighting
+File Name: passProfiler.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include <vector>
+#include <string>
+#include <iostream>
+
+// How many frames of queries each pass keeps in flight.
+// Results are read a few frames late, so asking for them never stalls the CPU waiting on the GPU.
+#define PROFILER_FRAMES 3
+
+// Measures GPU time and the number of samples that passed the depth test for named render passes.
+// Wrap each pass in Begin and End, and call NextFrame once per frame.
+// Passes can't be nested or overlap, because only one query of each type can be active at a time.
+class PassProfiler
+{
+public:
+    PassProfiler();
+    ~PassProfiler();
+
+    // Start measuring a pass. The name identifies it from frame to frame.
+    void Begin(std::string name);
+    // Stop measuring the current pass.
+    void End();
+
+    // Move on to the next frame's set of queries, collecting any results that are ready.
+    void NextFrame();
+
+    // The latest results for a pass (0 if it has never finished).
+    float GetTimeMs(std::string name);
+    GLuint64 GetSamplesPassed(std::string name);
+
+    // One line per pass, for printing.
+    std::string GetReport();
+
+private:
+    struct Pass
+    {
+        std::string m_name;
+        GLuint m_timeQueries[PROFILER_FRAMES];
+        GLuint m_sampleQueries[PROFILER_FRAMES];
+        // Whether the queries for that frame were started and still need reading.
+        bool m_pending[PROFILER_FRAMES];
+        float m_timeMs = 0;
+        GLuint64 m_samplesPassed = 0;
+    };
+
+    // Finds a pass by name, or makes a new one.
+    Pass& GetPass(std::string name);
+
+    std::vector<Pass> m_passes;
+    unsigned int m_frame = 0;
+    int m_activePass = -1;
+};
@@ -0,0 +1,206 @@
+/*
+Title: Deferred Spot Lighting
+File Name: pointShadowRenderer.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pointShadowRenderer.h"
+#include <chrono>
+
+PointShadowRenderer::PointShadowRenderer(unsigned int faceSize, unsigned int maxLights)
+{
+    m_faceSize = faceSize;
+    m_maxLights = maxLights;
+
+    // Six layers per light. Linear filtering with comparisons on gives 2x2 PCF for free.
+    m_shadowMaps = new CubeMap(faceSize, maxLights, GL_DEPTH_COMPONENT24);
+    m_shadowMaps->IncRefCount();
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, m_shadowMaps->GetGLCubeMap());
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+
+    // glFramebufferTexture attaches every layer at once (a layered frame buffer), gl_Layer picks one per triangle.
+    glGenFramebuffers(1, &m_frameBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_shadowMaps->GetGLCubeMap(), 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "Point shadow frame buffer is incomplete." << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    m_program = new ShaderProgram();
+    m_program->AttachShader(new Shader("../Assets/pointShadowVert.glsl", GL_VERTEX_SHADER));
+    m_program->AttachShader(new Shader("../Assets/pointShadowGeom.glsl", GL_GEOMETRY_SHADER));
+    m_program->AttachShader(new Shader("../Assets/pointShadowFrag.glsl", GL_FRAGMENT_SHADER));
+    m_program->IncRefCount();
+
+    // Bind once to link the program so we can look up the uniforms.
+    m_program->Bind();
+    ResolveUniforms();
+    m_program->Unbind();
+}
+
+PointShadowRenderer::~PointShadowRenderer()
+{
+    glDeleteFramebuffers(1, &m_frameBuffer);
+    m_shadowMaps->DecRefCount();
+    m_program->DecRefCount();
+}
+
+void PointShadowRenderer::ResolveUniforms()
+{
+    m_faceViewProjectionUniform = glGetUniformLocation(m_program->GetGLShaderProgram(), "faceViewProjection");
+    m_faceMaskUniform = glGetUniformLocation(m_program->GetGLShaderProgram(), "faceMask");
+    m_firstLayerUniform = glGetUniformLocation(m_program->GetGLShaderProgram(), "firstLayer");
+    m_lightPositionUniform = glGetUniformLocation(m_program->GetGLShaderProgram(), "lightPosition");
+    m_lightRadiusUniform = glGetUniformLocation(m_program->GetGLShaderProgram(), "lightRadius");
+    m_resolvedGeneration = m_program->GetGeneration();
+}
+
+void PointShadowRenderer::Render(MeshPool* pool, std::vector<PointLight>& lights, PassProfiler* profiler)
+{
+    unsigned int shadowCount = glm::min((unsigned int)lights.size(), m_maxLights);
+    m_shadowIndices.assign(lights.size(), -1);
+    m_casterCount = 0;
+    m_faceCount = 0;
+    m_cullTimeMs = 0;
+    if (shadowCount == 0)
+    {
+        return;
+    }
+
+    // Find every light's casters (and which of its faces they're in) in one go, then upload them all together.
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    std::vector<PointLight> shadowedLights(lights.begin(), lights.begin() + shadowCount);
+    m_casterCuller.SetCasters(pool->GetCommandList());
+    m_casterCuller.CullPointLights(shadowedLights, m_casterCommands, m_casterMatrices, m_firstCasterCommands, m_faceMasks);
+    m_cullTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    m_casterCount = m_casterMatrices.size();
+
+    pool->PrepareCommands(m_casterCommands, m_casterMatrices);
+
+    // Remember where we were drawing, so it can be put back afterwards.
+    GLint previousFrameBuffer;
+    GLint previousViewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFrameBuffer);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    glViewport(0, 0, m_faceSize, m_faceSize);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+
+    // Clearing a layered frame buffer clears every layer, which also empties the faces nothing is drawn into.
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    m_program->Bind();
+
+    // The hot reloader may have swapped in a rebuilt program, with its uniforms somewhere else.
+    if (m_program->GetGeneration() != m_resolvedGeneration)
+    {
+        ResolveUniforms();
+    }
+    for (unsigned int i = 0; i < shadowCount; i++)
+    {
+        m_shadowIndices[i] = (float)i;
+
+        glm::mat4 faceViewProjections[6];
+        for (int face = 0; face < 6; face++)
+        {
+            faceViewProjections[face] = GetFaceViewProjection(lights[i], face);
+            if (m_faceMasks[i] & (1 << face))
+            {
+                m_faceCount++;
+            }
+        }
+
+        profiler->Begin(GetPassName(i));
+        glUniformMatrix4fv(m_faceViewProjectionUniform, 6, GL_FALSE, &(faceViewProjections[0][0][0]));
+        glUniform1i(m_faceMaskUniform, m_faceMasks[i]);
+        glUniform1i(m_firstLayerUniform, i * 6);
+        glUniform3fv(m_lightPositionUniform, 1, &(lights[i].m_position[0]));
+        glUniform1f(m_lightRadiusUniform, lights[i].m_radius);
+        pool->RenderRange(m_firstCasterCommands[i], m_firstCasterCommands[i + 1] - m_firstCasterCommands[i], true);
+        profiler->End();
+    }
+    m_program->Unbind();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFrameBuffer);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+}
+
+std::vector<float>& PointShadowRenderer::GetShadowIndices()
+{
+    return m_shadowIndices;
+}
+
+glm::mat4 PointShadowRenderer::GetFaceViewProjection(PointLight& light, int face)
+{
+    // The standard cube map orientation: each face looks down its axis, with these up vectors.
+    static const glm::vec3 directions[6] = {
+        glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) };
+    static const glm::vec3 ups[6] = {
+        glm::vec3(0, -1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1), glm::vec3(0, -1, 0), glm::vec3(0, -1, 0) };
+
+    // 90 degrees on each side makes the six faces meet exactly.
+    glm::mat4 projection = glm::perspective(glm::radians(90.f), 1.f, light.m_radius * .01f, light.m_radius);
+    return projection * glm::lookAt(light.m_position, light.m_position + directions[face], ups[face]);
+}
+
+unsigned int PointShadowRenderer::GetMaxLights()
+{
+    return m_maxLights;
+}
+
+std::string PointShadowRenderer::GetPassName(unsigned int light)
+{
+    return "point shadow " + std::to_string(light);
+}
+
+unsigned int PointShadowRenderer::GetCasterCount()
+{
+    return m_casterCount;
+}
+
+unsigned int PointShadowRenderer::GetFaceCount()
+{
+    return m_faceCount;
+}
+
+float PointShadowRenderer::GetCullTimeMs()
+{
+    return m_cullTimeMs;
+}
+
+CubeMap* PointShadowRenderer::GetShadowMaps()
+{
+    return m_shadowMaps;
+}
+
+ShaderProgram* PointShadowRenderer::GetShaderProgram()
+{
+    return m_program;
+}
@@ -0,0 +1,107 @@
+/*
+Title: Deferred Spot Lighting
+File Name: pointShadowRenderer.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "cubeMap.h"
+#include "shaderProgram.h"
+#include "meshPool.h"
+#include "passProfiler.h"
+#include "shadowCasterCuller.h"
+#include "lights.h"
+
+// Draws point light shadows into an array of depth cube maps, one cube map per shadowed light.
+// A light's six faces are drawn in a single pass: the geometry shader (pointShadowGeom.glsl) runs every triangle
+// once per face and routes it to that face's layer with gl_Layer, so each light costs one multi-draw instead of six.
+// Casters are culled per light on the CPU first (shadowCasterCuller.h), which also finds the faces that are empty.
+class PointShadowRenderer
+{
+public:
+    PointShadowRenderer(unsigned int faceSize = 512, unsigned int maxLights = 4);
+    ~PointShadowRenderer();
+
+    // Redraws the shadows of the first GetMaxLights() lights, and gives the rest none.
+    // The pool's instances must still be submitted (before Clear), and whatever it had prepared is replaced by the
+    // casters, so draw everything else first. Each light is its own profiler pass ("point shadow 0", ...).
+    void Render(MeshPool* pool, std::vector<PointLight>& lights, PassProfiler* profiler);
+
+    // One entry per light given to Render, for LightBuffer::Update.
+    std::vector<float>& GetShadowIndices();
+
+    // The camera for one face of a light's cube map, in the order of the cube map's faces (+x, -x, +y, -y, +z, -z).
+    static glm::mat4 GetFaceViewProjection(PointLight& light, int face);
+
+    unsigned int GetMaxLights();
+
+    // The name of a light's profiler pass.
+    static std::string GetPassName(unsigned int light);
+
+    // From the last Render: how many casters were drawn (over every light and face), and how long culling them took.
+    unsigned int GetCasterCount();
+    unsigned int GetFaceCount();
+    float GetCullTimeMs();
+
+    // The cube map array, set up for shadow comparisons (sample it with a samplerCubeArrayShadow).
+    CubeMap* GetShadowMaps();
+
+    // The program the shadows are drawn with, to hand to the ShaderHotReloader.
+    ShaderProgram* GetShaderProgram();
+
+private:
+    // Looks the uniforms up in the program as it is now. Done again whenever the program is rebuilt.
+    void ResolveUniforms();
+
+    unsigned int m_faceSize;
+    unsigned int m_maxLights;
+
+    CubeMap* m_shadowMaps;
+    GLuint m_frameBuffer;
+
+    ShaderProgram* m_program;
+    GLint m_faceViewProjectionUniform;
+    GLint m_faceMaskUniform;
+    GLint m_firstLayerUniform;
+    GLint m_lightPositionUniform;
+    GLint m_lightRadiusUniform;
+    unsigned int m_resolvedGeneration = 0;
+
+    std::vector<float> m_shadowIndices;
+
+    ShadowCasterCuller m_casterCuller;
+    std::vector<DrawElementsIndirectCommand> m_casterCommands;
+    std::vector<glm::mat4> m_casterMatrices;
+    std::vector<unsigned int> m_firstCasterCommands;
+    std::vector<unsigned int> m_faceMasks;
+
+    unsigned int m_casterCount = 0;
+    unsigned int m_faceCount = 0;
+    float m_cullTimeMs = 0;
+};
@@ -0,0 +1,191 @@
+/*
+Title: Deferred Spot Lighting
+File Name: programBinaryCache.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "programBinaryCache.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Written at the start of every cache file, so we don't try to load something else.
+// Change the version if the file layout changes.
+#define PROGRAM_CACHE_MAGIC 0x4E494250
+#define PROGRAM_CACHE_VERSION 1
+
+bool ProgramBinaryCache::s_enabled = false;
+std::string ProgramBinaryCache::s_directory;
+unsigned int ProgramBinaryCache::s_hits = 0;
+unsigned int ProgramBinaryCache::s_misses = 0;
+double ProgramBinaryCache::s_seconds = 0;
+
+void ProgramBinaryCache::SetDirectory(std::string directory)
+{
+    // Some drivers don't support any binary formats at all.
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount == 0)
+    {
+        std::cout << "Program binaries are not supported by this driver, shaders will always be compiled." << std::endl;
+        s_enabled = false;
+        return;
+    }
+
+    // Make sure the folder exists. It's fine if it already does.
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+
+    s_directory = directory;
+    if (s_directory.size() > 0 && s_directory.back() != '/' && s_directory.back() != '\\')
+    {
+        s_directory += '/';
+    }
+    s_enabled = true;
+}
+
+unsigned long long ProgramBinaryCache::Hash(const std::string& data, unsigned long long hash)
+{
+    for (unsigned int i = 0; i < data.size(); i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+unsigned long long ProgramBinaryCache::GetDriverHash()
+{
+    // A binary only works with the exact driver that made it.
+    unsigned long long hash = Hash(std::to_string(PROGRAM_CACHE_VERSION));
+    hash = Hash((const char*)glGetString(GL_VENDOR), hash);
+    hash = Hash((const char*)glGetString(GL_RENDERER), hash);
+    hash = Hash((const char*)glGetString(GL_VERSION), hash);
+    return hash;
+}
+
+bool ProgramBinaryCache::Load(GLuint program, unsigned long long key)
+{
+    if (!s_enabled)
+    {
+        return false;
+    }
+
+    std::ifstream file(GetFilePath(key), std::ios::binary);
+    if (!file.good())
+    {
+        return false;
+    }
+
+    // Read and check the header.
+    unsigned int magic = 0;
+    unsigned long long fileKey = 0;
+    GLenum format = 0;
+    GLint length = 0;
+    file.read((char*)&magic, sizeof(magic));
+    file.read((char*)&fileKey, sizeof(fileKey));
+    file.read((char*)&format, sizeof(format));
+    file.read((char*)&length, sizeof(length));
+    if (!file.good() || magic != PROGRAM_CACHE_MAGIC || fileKey != key || length <= 0)
+    {
+        return false;
+    }
+
+    std::vector<char> binary(length);
+    file.read(binary.data(), length);
+    if (!file.good())
+    {
+        return false;
+    }
+    file.close();
+
+    // The driver checks the binary itself. If it doesn't like it, the program is left unlinked.
+    glProgramBinary(program, format, binary.data(), length);
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    return linked == GL_TRUE;
+}
+
+void ProgramBinaryCache::Save(GLuint program, unsigned long long key)
+{
+    if (!s_enabled)
+    {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::ofstream file(GetFilePath(key), std::ios::binary);
+    if (!file.good())
+    {
+        std::cout << "Can't write program cache file: " << GetFilePath(key) << std::endl;
+        return;
+    }
+
+    unsigned int magic = PROGRAM_CACHE_MAGIC;
+    file.write((char*)&magic, sizeof(magic));
+    file.write((char*)&key, sizeof(key));
+    file.write((char*)&format, sizeof(format));
+    file.write((char*)&length, sizeof(length));
+    file.write(binary.data(), length);
+    file.close();
+}
+
+void ProgramBinaryCache::RecordBuild(bool fromCache, double seconds)
+{
+    if (fromCache)
+    {
+        s_hits++;
+    }
+    else
+    {
+        s_misses++;
+    }
+    s_seconds += seconds;
+}
+
+std::string ProgramBinaryCache::GetReport()
+{
+    return std::to_string(s_hits) + " shader programs loaded from cache, " + std::to_string(s_misses)
+        + " compiled, " + std::to_string(s_seconds * 1000) + " ms total";
+}
+
+std::string ProgramBinaryCache::GetFilePath(unsigned long long key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", key);
+    return s_directory + name;
+}
@@ -0,0 +1,72 @@
+/*
+Title: Deferred Spot Lighting
+File Name: programBinaryCache.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+
+// Saves linked shader programs to disk with glGetProgramBinary, and loads them back with glProgramBinary.
+// Compiling and linking GLSL is slow, loading a binary the driver made earlier is not.
+//
+// Programs are looked up by a key, which is a hash of every shader's source (including any defines in it)
+// and the driver's vendor, renderer, and version strings. A new driver or an edited shader changes the key,
+// so a stale binary is never used. Drivers may still reject a binary, in which case we just compile instead.
+class ProgramBinaryCache
+{
+public:
+    // Where cache files are written. The folder is created if it doesn't exist.
+    // Caching is off until this is called.
+    static void SetDirectory(std::string directory);
+
+    // Hashes a string (64 bit FNV-1a). Pass the previous hash to combine several strings.
+    static unsigned long long Hash(const std::string& data, unsigned long long hash = 14695981039346656037ull);
+
+    // Hash of the driver strings, to combine into every key.
+    static unsigned long long GetDriverHash();
+
+    // Loads the binary with this key into a program. Returns false if there isn't one, or the driver rejects it.
+    static bool Load(GLuint program, unsigned long long key);
+
+    // Saves a successfully linked program under a key.
+    static void Save(GLuint program, unsigned long long key);
+
+    // Keep count of how programs were built, and how long it took.
+    static void RecordBuild(bool fromCache, double seconds);
+    static std::string GetReport();
+
+private:
+    static std::string GetFilePath(unsigned long long key);
+
+    static bool s_enabled;
+    static std::string s_directory;
+
+    static unsigned int s_hits;
+    static unsigned int s_misses;
+    static double s_seconds;
+};
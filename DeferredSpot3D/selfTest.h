@@ -0,0 +1,52 @@
+/*
+Title: Deferred Spot Lighting
+File Name: selfTest.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <iostream>
+#include <string>
+
+// Counts and prints the results of a self-test: the RunTest functions that main runs instead of the demo,
+// when the first argument asks for one.
+//
+//     SelfTest test("Mesh pool");
+//     test.Check(offset == 0, "The first range wasn't at the start");
+//     return test.Finish();
+class SelfTest
+{
+public:
+    // Prints the test's name as a heading.
+    SelfTest(const char* name);
+
+    // Counts a failure if passed is false, and prints what went wrong.
+    void Check(bool passed, const std::string& what);
+
+    // Counts a failure, and returns where to print what went wrong (already indented, end it with std::endl).
+    std::ostream& Fail();
+
+    // Prints whether everything passed. Returns the program's exit code, 1 if anything failed.
+    int Finish();
+
+private:
+    unsigned int m_failures = 0;
+};
@@ -24,9 +24,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "shader.h"
 
-Shader::Shader(std::string filePath, GLenum shaderType)
+Shader::Shader(std::string filePath, GLenum shaderType, const std::vector<std::string>& defines)
 {
-    InitFromFile(filePath, shaderType);
+    InitFromFile(filePath, shaderType, defines);
 }
 
 Shader::~Shader()
@@ -40,6 +40,10 @@ Shader::~Shader()
 
 GLuint Shader::GetGLShader()
 {
+    if (!m_compileChecked)
+    {
+        Compile();
+    }
     return m_shader;
 }
 
@@ -48,53 +52,89 @@ GLenum Shader::GetGLShaderType()
     return m_type;
 }
 
-bool Shader::InitFromFile(std::string filePath, GLenum shaderType)
+std::string& Shader::GetSource()
+{
+    return m_source;
+}
+
+std::string& Shader::GetFilePath()
 {
+    return m_filePath;
+}
+
+std::vector<std::string>& Shader::GetDefines()
+{
+    return m_defines;
+}
 
-	std::ifstream file(filePath);
+bool Shader::InitFromFile(std::string filePath, GLenum shaderType, const std::vector<std::string>& defines)
+{
+	m_type = shaderType;
+	m_filePath = filePath;
+	m_defines = defines;
 
-	// Check if the file exists
-	if (!file.good())
+	// Read the file and everything it includes.
+	std::string shaderCode;
+	if (!ShaderPreprocessor::Load(filePath, shaderCode))
 	{
-		// If we encounter an error, print a message and return false.
-		std::cout << "Can't read file: " << filePath << std::endl;
 		return false;
 	}
 
-	// ifstream internally keeps track of where in the file.
-
-	// Here we find the end of the file.
-	file.seekg(0, std::ios::end);
-
-	// Make a string and set its size equal to the length of the file.
-	std::string shaderCode;
-	shaderCode.resize((size_t)file.tellg());
+	// Init using the string, with this shader's defines added.
+	return InitFromString(ShaderPreprocessor::AddDefines(shaderCode, defines), shaderType);
+}
 
-	// Go back to the beginning of the file.
-	file.seekg(0, std::ios::beg);
+bool Shader::InitFromString(std::string shaderCode, GLenum shaderType)
+{
+	m_type = shaderType;
+	m_source = shaderCode;
 
-	// Read the file into the string until we reach the end of the string.
-	file.read(&shaderCode[0], shaderCode.size());
+	// Throw away any shader compiled from old source.
+	if (m_shader != 0)
+	{
+		glDeleteShader(m_shader);
+		m_shader = 0;
+	}
 
-	// Close the file.
-	file.close();
+	// The actual compile happens in Compile, the first time the shader is needed.
+	m_compileStarted = false;
+	m_compileChecked = false;
+	return true;
+}
 
-	// Init using the string.
-	return InitFromString(shaderCode, shaderType);
+bool Shader::Compile()
+{
+	BeginCompile();
+	return FinishCompile();
 }
 
-bool Shader::InitFromString(std::string shaderCode, GLenum shaderType)
+GLuint Shader::BeginCompile()
 {
-	m_type = shaderType;
-	m_shader = glCreateShader(shaderType);
+	if (m_compileStarted)
+	{
+		return m_shader;
+	}
+	m_compileStarted = true;
+	m_shader = glCreateShader(m_type);
 
 	// Get the char* and length
-	const char* shaderCodePointer = shaderCode.data();
-	int shaderCodeLength = shaderCode.size();
+	const char* shaderCodePointer = m_source.data();
+	int shaderCodeLength = m_source.size();
 
 	// Set the source code and compile.
 	glShaderSource(m_shader, 1, &shaderCodePointer, &shaderCodeLength);
 	glCompileShader(m_shader);
+	return m_shader;
+}
+
+bool Shader::FinishCompile()
+{
+	if (m_compileChecked)
+	{
+		return m_shader != 0;
+	}
+	BeginCompile();
+	m_compileChecked = true;
 
 	GLint isCompiled;
 
@@ -25,29 +25,58 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "GL/glew.h"
 #include "GLFW/glfw3.h"
 #include <string>
+#include <vector>
 #include <iostream>
 #include <fstream>
 
+#include "shaderPreprocessor.h"
+
 class Shader
 {
 
 private:
-	GLuint m_shader;
+	GLuint m_shader = 0;
 	GLenum m_type;
 
+    // The source is kept so the shader can be compiled later, and so programs can hash it for the binary cache.
+    std::string m_source;
+
+    // Where the source came from, and the defines added to it (empty for shaders made from a string).
+    std::string m_filePath;
+    std::vector<std::string> m_defines;
+    // Compiling waits until something actually needs the GL shader.
+    // If the linked program is loaded from the binary cache, that never happens.
+    // Starting the compile and checking the result are separate, so the driver can compile in the background in between.
+    bool m_compileStarted = false;
+    bool m_compileChecked = false;
+
     // Reference Counter
     unsigned int m_refCount = 0;
 
 public:
-	Shader(std::string filePath, GLenum shaderType);
+	// Loads a shader file, resolving its includes and adding the defines ("NAME" or "NAME VALUE") after #version.
+	Shader(std::string filePath, GLenum shaderType, const std::vector<std::string>& defines = std::vector<std::string>());
 	~Shader();
 
+    // Compiles the shader first if it hasn't been yet. Returns 0 if it failed to compile.
     GLuint GetGLShader();
     GLenum GetGLShaderType();
+    std::string& GetSource();
+    std::string& GetFilePath();
+    std::vector<std::string>& GetDefines();
 
-	bool InitFromFile(std::string, GLenum shaderType);
+	bool InitFromFile(std::string filePath, GLenum shaderType, const std::vector<std::string>& defines = std::vector<std::string>());
 	bool InitFromString(std::string shaderCode, GLenum shaderType);
 
+    // Compile the source now. Returns false (and prints the error) if it doesn't compile.
+    bool Compile();
+
+    // Hands the source to the driver without waiting for the result, and returns the GL shader.
+    // With GL_KHR_parallel_shader_compile the driver compiles on its own threads.
+    GLuint BeginCompile();
+    // Checks the result of the compile, waiting for it if needed. Returns false (and prints the error) if it failed.
+    bool FinishCompile();
+
     void IncRefCount();
     void DecRefCount();
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+/*
+Title: Deferred Spot Lighting
+File Name: shaderCompileQueue.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "shaderCompileQueue.h"
+
+ShaderCompileQueue::ShaderCompileQueue()
+{
+    // Let the driver use as many compiler threads as it likes.
+    if (GLEW_KHR_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    }
+    else if (GLEW_ARB_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    }
+    else
+    {
+        std::cout << "Parallel shader compile is not supported, shaders will finish building one at a time." << std::endl;
+    }
+}
+
+ShaderCompileQueue::~ShaderCompileQueue()
+{
+    for (unsigned int i = 0; i < m_pending.size(); i++)
+    {
+        m_pending[i]->DecRefCount();
+    }
+}
+
+void ShaderCompileQueue::Add(ShaderProgram* program)
+{
+    program->IncRefCount();
+    m_pending.push_back(program);
+}
+
+void ShaderCompileQueue::SubmitAll()
+{
+    // Submit every compile and link before checking any of them,
+    // otherwise the first status check would wait for that program and nothing would overlap.
+    for (unsigned int i = 0; i < m_pending.size(); i++)
+    {
+        m_pending[i]->BeginBuild();
+    }
+}
+
+unsigned int ShaderCompileQueue::Poll()
+{
+    for (unsigned int i = 0; i < m_pending.size();)
+    {
+        // A program that failed to build is done too (its errors were printed), there's nothing left to wait for.
+        m_pending[i]->IsReady();
+        if (m_pending[i]->IsBuildFinished())
+        {
+            m_pending[i]->DecRefCount();
+            m_pending.erase(m_pending.begin() + i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+    return m_pending.size();
+}
+
+bool ShaderCompileQueue::IsDone()
+{
+    return m_pending.size() == 0;
+}
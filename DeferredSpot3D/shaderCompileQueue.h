@@ -1,6 +1,6 @@
 /*
 Title: Deferred Spot Lighting
-File Name: pointLightRenderer.h
+File Name: shaderCompileQueue.h
 Copyright ? 2016
 Author: David Erbelding
 Written under the supervision of David I. Schwartz, Ph.D., and
@@ -25,49 +25,32 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 #include "GL/glew.h"
 #include "GLFW/glfw3.h"
-#include "glm/glm.hpp"
-
-#include "glm/gtc/matrix_transform.hpp"
 #include <vector>
-#include <string>
 #include <iostream>
-#include <fstream>
 
-#include "material.h"
+#include "shaderProgram.h"
 
-//struct for vertex with uv
-struct PointLight
+// Builds a batch of shader programs at the same time.
+// Every program is handed to the driver up front, then Poll checks on them once a frame without waiting.
+// With GL_KHR_parallel_shader_compile the driver compiles them on several threads while we keep rendering.
+// Materials with a placeholder program draw with it until their own program shows up as ready.
+class ShaderCompileQueue
 {
-    glm::vec3 m_position;
-    float m_radius;
-    glm::vec4 m_attenuation;
-    glm::vec4 m_color;
+public:
+    ShaderCompileQueue();
+    ~ShaderCompileQueue();
 
-    // Makes a 2d vertex with uc and color data.
-    PointLight(glm::vec3 position, float radius, glm::vec4 attenuation, glm::vec4 color) {
-        m_position = position;
-        m_radius = radius;
-        m_attenuation = attenuation;
-        m_color = color;
-    }
-};
+    // Queue a program to build.
+    void Add(ShaderProgram* program);
 
+    // Start building everything in the queue.
+    void SubmitAll();
 
-class PointLightRenderer
-{
-public:
+    // Check which programs have finished. Returns how many are still building.
+    unsigned int Poll();
 
-    PointLightRenderer();
-    ~PointLightRenderer();
-    
-    void RenderLights(std::vector<PointLight> lights, Material* pointLightMaterial);
+    bool IsDone();
 
 private:
-
-    GLuint m_vertexBuffer;
-    GLuint m_indexBuffer;
-    GLuint m_instanceBuffer;
-
-    std::vector<glm::vec3> m_vertices;
-    std::vector<unsigned int> m_indices;
-};
\ No newline at end of file
+    std::vector<ShaderProgram*> m_pending;
+};
@@ -0,0 +1,188 @@
+/*
+Title: Deferred Spot Lighting
+File Name: shaderHotReloader.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "shaderHotReloader.h"
+
+ShaderHotReloader::ShaderHotReloader(std::string directory)
+{
+    m_watcher = new FileWatcher(directory);
+}
+
+ShaderHotReloader::~ShaderHotReloader()
+{
+    delete m_watcher;
+
+    for (unsigned int i = 0; i < m_pending.size(); i++)
+    {
+        m_pending[i].m_staging->DecRefCount();
+    }
+    for (unsigned int i = 0; i < m_programs.size(); i++)
+    {
+        m_programs[i]->DecRefCount();
+    }
+}
+
+void ShaderHotReloader::Add(ShaderProgram* program)
+{
+    program->IncRefCount();
+    m_programs.push_back(program);
+
+    // Without inotify, the watcher has to be told which files to look at.
+    // That's every file read so far, so includes are covered too.
+    std::vector<std::string> files = ShaderPreprocessor::GetLoadedFiles();
+    for (unsigned int i = 0; i < files.size(); i++)
+    {
+        m_watcher->AddFile(files[i]);
+    }
+}
+
+void ShaderHotReloader::Update()
+{
+    // Look for changed shader files.
+    std::vector<std::string> changed = m_watcher->TakeChangedFiles();
+    bool shaderChanged = false;
+    for (unsigned int i = 0; i < changed.size(); i++)
+    {
+        if (changed[i].size() > 5 && changed[i].compare(changed[i].size() - 5, 5, ".glsl") == 0)
+        {
+            shaderChanged = true;
+        }
+    }
+
+    if (shaderChanged)
+    {
+        // Any file could be included by any shader, so read everything again,
+        // and only rebuild the programs that came out different.
+        ShaderPreprocessor::ClearCache();
+        for (unsigned int i = 0; i < m_programs.size(); i++)
+        {
+            StartReload(m_programs[i]);
+        }
+    }
+
+    // Swap in any rebuilt programs that are ready.
+    for (unsigned int i = 0; i < m_pending.size();)
+    {
+        Reload& reload = m_pending[i];
+
+        if (reload.m_staging->IsReady())
+        {
+            reload.m_target->Swap(reload.m_staging);
+
+            // Name the program after its last stage, that's usually the one being worked on.
+            Shader* named = reload.m_target->GetShader(GL_FRAGMENT_SHADER);
+            if (named == nullptr)
+                named = reload.m_target->GetShader(GL_VERTEX_SHADER);
+            if (named == nullptr)
+                named = reload.m_target->GetShader(GL_COMPUTE_SHADER);
+            std::cout << "Reloaded shader: " << (named != nullptr ? named->GetFilePath() : "") << std::endl;
+        }
+        else if (reload.m_staging->IsBuildFinished())
+        {
+            // The errors were already printed.
+            std::cout << "Shader reload failed, keeping the old program." << std::endl;
+        }
+        else
+        {
+            // Still building.
+            i++;
+            continue;
+        }
+
+        // After a swap, the staging program holds the old GL program, so this deletes it.
+        reload.m_staging->DecRefCount();
+        m_pending.erase(m_pending.begin() + i);
+    }
+}
+
+void ShaderHotReloader::StartReload(ShaderProgram* program)
+{
+    GLenum stages[] = { GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER, GL_COMPUTE_SHADER };
+    Shader* shaders[4] = { nullptr, nullptr, nullptr, nullptr };
+    bool different = false;
+
+    // Read every stage again, with the same defines.
+    for (int i = 0; i < 4; i++)
+    {
+        Shader* current = program->GetShader(stages[i]);
+        if (current == nullptr || current->GetFilePath().size() == 0)
+        {
+            shaders[i] = current;
+            continue;
+        }
+
+        Shader* reloaded = new Shader(current->GetFilePath(), stages[i], current->GetDefines());
+        if (reloaded->GetSource().size() > 0 && reloaded->GetSource() != current->GetSource())
+        {
+            shaders[i] = reloaded;
+            different = true;
+        }
+        else
+        {
+            // Unchanged (or unreadable right now), keep using the old shader.
+            ReleaseShader(reloaded);
+            shaders[i] = current;
+        }
+    }
+
+    if (!different)
+    {
+        return;
+    }
+
+    // Replace any reload of this program that hasn't finished yet, it's already out of date.
+    for (unsigned int i = 0; i < m_pending.size(); i++)
+    {
+        if (m_pending[i].m_target == program)
+        {
+            m_pending[i].m_staging->DecRefCount();
+            m_pending.erase(m_pending.begin() + i);
+            break;
+        }
+    }
+
+    // Build the new program off to the side.
+    ShaderProgram* staging = new ShaderProgram();
+    for (int i = 0; i < 4; i++)
+    {
+        if (shaders[i] != nullptr)
+        {
+            staging->AttachShader(shaders[i]);
+        }
+    }
+    staging->IncRefCount();
+    staging->BeginBuild();
+
+    Reload reload;
+    reload.m_target = program;
+    reload.m_staging = staging;
+    m_pending.push_back(reload);
+}
+
+void ShaderHotReloader::ReleaseShader(Shader* shader)
+{
+    // Shaders delete themselves when their count goes back to zero.
+    shader->IncRefCount();
+    shader->DecRefCount();
+}
@@ -0,0 +1,70 @@
+/*
+Title: Deferred Spot Lighting
+File Name: shaderHotReloader.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "shaderProgram.h"
+#include "fileWatcher.h"
+
+// Rebuilds shader programs when their files change on disk, while the program keeps running.
+//
+// A FileWatcher thread notices the change. Then, for every program whose source actually changed,
+// a new program is built off to the side (in the background, if the driver supports parallel compiles).
+// When it's ready it's swapped into the existing ShaderProgram in one step, so nothing ever draws with a half built program,
+// and materials look up their uniforms again on their next bind. If it fails to build, the old program just stays.
+class ShaderHotReloader
+{
+public:
+    // The directory the shader files are in.
+    ShaderHotReloader(std::string directory);
+    ~ShaderHotReloader();
+
+    // Keep a program up to date with its files. Only programs made from files can be reloaded.
+    void Add(ShaderProgram* program);
+
+    // Call once a frame. Starts rebuilding changed programs, and swaps in any that are done. Never waits.
+    void Update();
+
+private:
+    // Starts building a new copy of a program from the files on disk, if they're different.
+    void StartReload(ShaderProgram* program);
+
+    // Frees a shader that may not have been attached to anything.
+    static void ReleaseShader(Shader* shader);
+
+    struct Reload
+    {
+        ShaderProgram* m_target;
+        ShaderProgram* m_staging;
+    };
+
+    FileWatcher* m_watcher;
+    std::vector<ShaderProgram*> m_programs;
+    std::vector<Reload> m_pending;
+};
@@ -0,0 +1,196 @@
+/*
+Title: Deferred Spot Lighting
+File Name: shaderPreprocessor.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "shaderPreprocessor.h"
+
+std::map<std::string, std::string> ShaderPreprocessor::s_cache;
+std::set<std::string> ShaderPreprocessor::s_loadedFiles;
+
+bool ShaderPreprocessor::Load(std::string filePath, std::string& source)
+{
+    // Use the cached copy if we've seen this file before.
+    std::map<std::string, std::string>::iterator cached = s_cache.find(filePath);
+    if (cached != s_cache.end())
+    {
+        source = cached->second;
+        return true;
+    }
+
+    std::set<std::string> included;
+    unsigned int fileCount = 0;
+    std::string output;
+    if (!Resolve(filePath, output, included, fileCount))
+    {
+        return false;
+    }
+
+    s_cache[filePath] = output;
+    source = output;
+    return true;
+}
+
+std::string ShaderPreprocessor::AddDefines(const std::string& source, const std::vector<std::string>& defines)
+{
+    if (defines.size() == 0)
+    {
+        return source;
+    }
+
+    // Find the end of the #version line, it has to stay first.
+    size_t version = source.find("#version");
+    size_t insertAt = 0;
+    unsigned int versionLine = 0;
+    if (version != std::string::npos)
+    {
+        insertAt = source.find('\n', version);
+        insertAt = (insertAt == std::string::npos) ? source.size() : insertAt + 1;
+        for (size_t i = 0; i < insertAt; i++)
+        {
+            if (source[i] == '\n')
+            {
+                versionLine++;
+            }
+        }
+    }
+
+    std::string defineLines;
+    for (unsigned int i = 0; i < defines.size(); i++)
+    {
+        defineLines += "#define " + defines[i] + "\n";
+    }
+
+    // Put the line numbers back to where they were.
+    defineLines += "#line " + std::to_string(versionLine + 1) + " 0\n";
+
+    return source.substr(0, insertAt) + defineLines + source.substr(insertAt);
+}
+
+void ShaderPreprocessor::ClearCache()
+{
+    s_cache.clear();
+}
+
+std::vector<std::string> ShaderPreprocessor::GetLoadedFiles()
+{
+    return std::vector<std::string>(s_loadedFiles.begin(), s_loadedFiles.end());
+}
+
+bool ShaderPreprocessor::ReadFile(std::string filePath, std::string& text)
+{
+    std::ifstream file(filePath);
+
+    // Check if the file exists
+    if (!file.good())
+    {
+        // If we encounter an error, print a message and return false.
+        std::cout << "Can't read file: " << filePath << std::endl;
+        return false;
+    }
+    s_loadedFiles.insert(filePath);
+
+    // ifstream internally keeps track of where in the file.
+
+    // Here we find the end of the file.
+    file.seekg(0, std::ios::end);
+
+    // Make a string and set its size equal to the length of the file.
+    text.resize((size_t)file.tellg());
+
+    // Go back to the beginning of the file.
+    file.seekg(0, std::ios::beg);
+
+    // Read the file into the string until we reach the end of the string.
+    file.read(&text[0], text.size());
+
+    // In text mode, line endings can shrink while reading, so only keep what was actually read.
+    text.resize((size_t)file.gcount());
+
+    // Close the file.
+    file.close();
+    return true;
+}
+
+bool ShaderPreprocessor::Resolve(std::string filePath, std::string& output, std::set<std::string>& included, unsigned int& fileCount)
+{
+    std::string text;
+    if (!ReadFile(filePath, text))
+    {
+        return false;
+    }
+
+    included.insert(filePath);
+    unsigned int fileIndex = fileCount++;
+    std::string directory = GetDirectory(filePath);
+
+    // Go through the file line by line, looking for includes.
+    std::istringstream lines(text);
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(lines, line))
+    {
+        lineNumber++;
+
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+        {
+            output += line + "\n";
+            continue;
+        }
+
+        // The file name is between the quotes.
+        size_t open = line.find('"', start);
+        size_t close = (open == std::string::npos) ? std::string::npos : line.find('"', open + 1);
+        if (close == std::string::npos)
+        {
+            std::cout << filePath << "(" << lineNumber << "): bad #include, expected #include \"file\"" << std::endl;
+            return false;
+        }
+        std::string includePath = directory + line.substr(open + 1, close - open - 1);
+
+        // Each file only goes in once.
+        if (included.count(includePath) == 0)
+        {
+            output += "#line 1 " + std::to_string(fileCount) + "\n";
+            if (!Resolve(includePath, output, included, fileCount))
+            {
+                return false;
+            }
+        }
+
+        // Carry on counting lines in this file after the include.
+        output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+    }
+
+    return true;
+}
+
+std::string ShaderPreprocessor::GetDirectory(std::string filePath)
+{
+    size_t slash = filePath.find_last_of("/\\");
+    if (slash == std::string::npos)
+    {
+        return "";
+    }
+    return filePath.substr(0, slash + 1);
+}
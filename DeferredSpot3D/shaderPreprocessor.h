@@ -0,0 +1,66 @@
+/*
+Title: Deferred Spot Lighting
+File Name: shaderPreprocessor.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+// GLSL has no #include, so shaders are put together on the CPU before they're compiled.
+//
+// #include "file.glsl" lines are replaced with the contents of that file (relative to the file including it).
+// Each file is only included once per shader, like #pragma once, so shared files can include each other freely.
+// #line directives are added around every include so compile errors still point at the right line,
+// the second number in an error is the file: 0 is the shader itself, then includes in the order they appear.
+//
+// Defines are added right after the #version line, so each permutation of a shader only contains the code it uses.
+class ShaderPreprocessor
+{
+public:
+    // Reads a shader and resolves its includes. Resolved sources are cached, so shared files are only read once.
+    // Returns false if the file or one of its includes can't be read.
+    static bool Load(std::string filePath, std::string& source);
+
+    // Adds a #define line for each define ("NAME" or "NAME VALUE") after the #version line.
+    static std::string AddDefines(const std::string& source, const std::vector<std::string>& defines);
+
+    // Forget everything that was cached, so files are read again (for when they change on disk).
+    static void ClearCache();
+
+    // Every file that has been read so far, including includes.
+    static std::vector<std::string> GetLoadedFiles();
+
+private:
+    static bool ReadFile(std::string filePath, std::string& text);
+    static bool Resolve(std::string filePath, std::string& output, std::set<std::string>& included, unsigned int& fileCount);
+    static std::string GetDirectory(std::string filePath);
+
+    // Resolved sources by file path.
+    static std::map<std::string, std::string> s_cache;
+    static std::set<std::string> s_loadedFiles;
+};
@@ -36,8 +36,14 @@ ShaderProgram::~ShaderProgram()
     if (m_vertexShader != nullptr)
         m_vertexShader->DecRefCount();
 
+    if (m_geometryShader != nullptr)
+        m_geometryShader->DecRefCount();
+
     if (m_fragmentShader != nullptr)
         m_fragmentShader->DecRefCount();
+
+    if (m_computeShader != nullptr)
+        m_computeShader->DecRefCount();
 }
 
 GLuint ShaderProgram::GetGLShaderProgram()
@@ -54,9 +60,15 @@ void ShaderProgram::AttachShader(Shader* shader)
         case GL_VERTEX_SHADER:
             currentShader = &m_vertexShader;
             break;
+        case GL_GEOMETRY_SHADER:
+            currentShader = &m_geometryShader;
+            break;
         case GL_FRAGMENT_SHADER:
             currentShader = &m_fragmentShader;
             break;
+        case GL_COMPUTE_SHADER:
+            currentShader = &m_computeShader;
+            break;
         default:
             return;
     }
@@ -70,30 +82,207 @@ void ShaderProgram::AttachShader(Shader* shader)
     // Replace it with the new shader
     *currentShader = shader;
 
-    // Attach the gl shader to the shader program.
-    if (shader->GetGLShader() != 0)
+    // ShaderProgram must be rebuilt.
+    // The gl shaders are only attached when it's built, and only if the program isn't in the binary cache.
+    m_buildState = BUILD_NONE;
+}
+
+void ShaderProgram::Bind()
+{
+    if (m_buildState != BUILD_DONE)
     {
-        glAttachShader(m_shaderProgram, shader->GetGLShader());
-        // ShaderProgram must be rebuilt
-        m_programBuilt = false;
+        // if the program hasn't been built, build it and get uniform data
+        FinishBuild();
     }
-    else
+
+    glUseProgram(m_shaderProgram);
+}
+
+void ShaderProgram::BeginBuild()
+{
+    if (m_buildState != BUILD_NONE)
+    {
+        return;
+    }
+    double startTime = glfwGetTime();
+
+    // Try the cache first, this skips compiling the shaders entirely.
+    m_cacheKey = GetCacheKey();
+    if (ProgramBinaryCache::Load(m_shaderProgram, m_cacheKey))
     {
-        // Print an error if trying to attach an uninitialized shader.
-        std::cout << "Failed to attach shader: Shader not initialized." << std::endl;
+        m_buildState = BUILD_DONE;
+        m_linked = true;
+        m_generation++;
+        ProgramBinaryCache::RecordBuild(true, glfwGetTime() - startTime);
+        return;
     }
+
+    // Detach anything attached by an earlier build.
+    GLint attachedCount = 0;
+    glGetProgramiv(m_shaderProgram, GL_ATTACHED_SHADERS, &attachedCount);
+    if (attachedCount > 0)
+    {
+        std::vector<GLuint> attached(attachedCount);
+        glGetAttachedShaders(m_shaderProgram, attachedCount, NULL, attached.data());
+        for (int i = 0; i < attachedCount; i++)
+        {
+            glDetachShader(m_shaderProgram, attached[i]);
+        }
+    }
+
+    // Start compiling the shaders and attach them.
+    // Nothing here waits for the compiler, the link will pick up the results when they're ready.
+    Shader* shaders[] = { m_vertexShader, m_geometryShader, m_fragmentShader, m_computeShader };
+    for (int i = 0; i < 4; i++)
+    {
+        if (shaders[i] == nullptr)
+        {
+            continue;
+        }
+
+        GLuint shader = shaders[i]->BeginCompile();
+        if (shader != 0)
+        {
+            glAttachShader(m_shaderProgram, shader);
+        }
+        else
+        {
+            // Print an error if trying to attach a shader that already failed to compile.
+            std::cout << "Failed to attach shader: Shader not initialized." << std::endl;
+        }
+    }
+
+    // Let the driver know we're going to ask for the binary, then link.
+    glProgramParameteri(m_shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(m_shaderProgram);
+
+    m_buildState = BUILD_LINKING;
+    m_buildSeconds = glfwGetTime() - startTime;
 }
 
-void ShaderProgram::Bind()
+bool ShaderProgram::FinishBuild()
 {
-    if (!m_programBuilt)
+    BeginBuild();
+    if (m_buildState == BUILD_DONE)
     {
-        // if the program hasn't been built, build it and get uniform data
-        glLinkProgram(m_shaderProgram);
-        m_programBuilt = true;
+        return m_linked;
     }
+    double startTime = glfwGetTime();
+    m_buildState = BUILD_DONE;
 
-    glUseProgram(m_shaderProgram);
+    // Check each shader, so their errors get printed.
+    Shader* shaders[] = { m_vertexShader, m_geometryShader, m_fragmentShader, m_computeShader };
+    for (int i = 0; i < 4; i++)
+    {
+        if (shaders[i] != nullptr)
+        {
+            shaders[i]->FinishCompile();
+        }
+    }
+
+    GLint isLinked;
+    glGetProgramiv(m_shaderProgram, GL_LINK_STATUS, &isLinked);
+    m_linked = isLinked == GL_TRUE;
+    m_generation++;
+    ProgramBinaryCache::RecordBuild(false, m_buildSeconds + glfwGetTime() - startTime);
+
+    if (!m_linked)
+    {
+        char infolog[1024];
+        glGetProgramInfoLog(m_shaderProgram, 1024, NULL, infolog);
+        std::cout << "Shader program link failed with error: " << std::endl << infolog << std::endl;
+        return false;
+    }
+
+    // Save it so next time it can be loaded instead.
+    ProgramBinaryCache::Save(m_shaderProgram, m_cacheKey);
+    return true;
+}
+
+bool ShaderProgram::IsReady()
+{
+    BeginBuild();
+
+    if (m_buildState == BUILD_LINKING)
+    {
+        // Ask the driver if it's done, this doesn't wait.
+        // Without the extension there's no way to ask, so we just wait for it: the whole compile and link stalls
+        // this thread. Building on a worker thread instead would need a second context sharing objects with this one,
+        // which the demo doesn't make.
+        if (GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile)
+        {
+            GLint complete = GL_FALSE;
+            glGetProgramiv(m_shaderProgram, GL_COMPLETION_STATUS_KHR, &complete);
+            if (!complete)
+            {
+                return false;
+            }
+        }
+        FinishBuild();
+    }
+
+    return m_linked;
+}
+
+bool ShaderProgram::IsBuildFinished()
+{
+    return m_buildState == BUILD_DONE;
+}
+
+unsigned int ShaderProgram::GetGeneration()
+{
+    return m_generation;
+}
+
+Shader* ShaderProgram::GetShader(GLenum type)
+{
+    switch (type)
+    {
+        case GL_VERTEX_SHADER:
+            return m_vertexShader;
+        case GL_GEOMETRY_SHADER:
+            return m_geometryShader;
+        case GL_FRAGMENT_SHADER:
+            return m_fragmentShader;
+        case GL_COMPUTE_SHADER:
+            return m_computeShader;
+        default:
+            return nullptr;
+    }
+}
+
+void ShaderProgram::Swap(ShaderProgram* other)
+{
+    std::swap(m_shaderProgram, other->m_shaderProgram);
+    std::swap(m_vertexShader, other->m_vertexShader);
+    std::swap(m_geometryShader, other->m_geometryShader);
+    std::swap(m_fragmentShader, other->m_fragmentShader);
+    std::swap(m_computeShader, other->m_computeShader);
+    std::swap(m_buildState, other->m_buildState);
+    std::swap(m_linked, other->m_linked);
+    std::swap(m_cacheKey, other->m_cacheKey);
+
+    // Both are different programs than they were, so both count as rebuilt.
+    unsigned int generation = std::max(m_generation, other->m_generation) + 1;
+    m_generation = generation;
+    other->m_generation = generation;
+}
+
+unsigned long long ShaderProgram::GetCacheKey()
+{
+    // Every shader's type and source, and the driver.
+    // Defines are written into the source, so they're part of the key too.
+    unsigned long long key = ProgramBinaryCache::GetDriverHash();
+    Shader* shaders[] = { m_vertexShader, m_geometryShader, m_fragmentShader, m_computeShader };
+    for (int i = 0; i < 4; i++)
+    {
+        if (shaders[i] != nullptr)
+        {
+            key = ProgramBinaryCache::Hash(std::to_string(shaders[i]->GetGLShaderType()), key);
+            key = ProgramBinaryCache::Hash(shaders[i]->GetSource(), key);
+        }
+    }
+    return key;
 }
 
 void ShaderProgram::Unbind()
@@ -23,6 +23,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #pragma once
 #include "shader.h"
+#include "programBinaryCache.h"
+#include <vector>
+#include <algorithm>
 #include <iostream>
 
 // Wraps opengl shader program functionality
@@ -32,13 +35,34 @@ class ShaderProgram
 private:
     // These shader objects wrap the functionality of loading and compiling shaders from files.
     Shader* m_vertexShader = nullptr;
+    Shader* m_geometryShader = nullptr;
     Shader* m_fragmentShader = nullptr;
+    Shader* m_computeShader = nullptr;
 
     // GL index for shader program
     GLuint m_shaderProgram;
 
-    // Keep track of if the program has been built and only build when needed
-    bool m_programBuilt = false;
+    // Keep track of if the program has been built and only build when needed.
+    // Building happens in two steps so the driver can work on it in the background:
+    // BeginBuild hands everything to the driver, FinishBuild checks the results.
+    enum BuildState
+    {
+        BUILD_NONE,
+        BUILD_LINKING,
+        BUILD_DONE
+    };
+    BuildState m_buildState = BUILD_NONE;
+    bool m_linked = false;
+
+    // Goes up every time the program is (re)built, so anything holding uniform locations knows to look them up again.
+    unsigned int m_generation = 0;
+
+    // Binary cache key and CPU time spent on the current build.
+    unsigned long long m_cacheKey = 0;
+    double m_buildSeconds = 0;
+
+    // The binary cache key for the current set of shaders.
+    unsigned long long GetCacheKey();
 
     // Reference Counter
     unsigned int m_refCount = 0;
@@ -48,6 +72,31 @@ public:
     ~ShaderProgram();
     GLuint GetGLShaderProgram();
     void AttachShader(Shader* shader);
+
+    // Starts building the program, either from the binary cache or by compiling and linking the shaders.
+    // Returns right away, without waiting on the driver.
+    void BeginBuild();
+    // Waits for the build to finish and checks it. Returns false if it failed.
+    bool FinishBuild();
+    // Returns true once the program is built and linked successfully. Starts the build if needed.
+    // When the driver supports GL_KHR_parallel_shader_compile this never waits, without it, it finishes the build
+    // right here (stalling the caller for the whole compile).
+    bool IsReady();
+
+    // True once the build has finished, whether it worked or not.
+    bool IsBuildFinished();
+
+    unsigned int GetGeneration();
+
+    // The shader attached for a stage (GL_VERTEX_SHADER, ...), or nullptr.
+    Shader* GetShader(GLenum type);
+
+    // Trades the GL program and shaders with another program, which is how a rebuilt program replaces this one.
+    // Anything using this program picks the new one up on its next bind (the generation goes up).
+    // The other program ends up holding the old GL program, and deletes it when it's deleted.
+    void Swap(ShaderProgram* other);
+
+    // Finishes building first if needed.
     void Bind();
     void Unbind();
     void IncRefCount();
@@ -0,0 +1,88 @@
+/*
+Title: Deferred Spot Lighting
+File Name: shaderVariants.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "shaderVariants.h"
+
+ShaderVariants::ShaderVariants(std::string vertexPath, std::string fragmentPath, ShaderCompileQueue* queue)
+{
+    m_vertexPath = vertexPath;
+    m_fragmentPath = fragmentPath;
+    m_queue = queue;
+}
+
+ShaderVariants::~ShaderVariants()
+{
+    for (std::map<unsigned int, ShaderProgram*>::iterator it = m_programs.begin(); it != m_programs.end(); it++)
+    {
+        it->second->DecRefCount();
+    }
+}
+
+ShaderProgram* ShaderVariants::Get(unsigned int features)
+{
+    std::map<unsigned int, ShaderProgram*>::iterator found = m_programs.find(features);
+    if (found != m_programs.end())
+    {
+        return found->second;
+    }
+
+    // Both stages get the same defines, so they always agree on what's turned on.
+    std::vector<std::string> defines = GetDefines(features);
+    ShaderProgram* program = new ShaderProgram();
+    program->AttachShader(new Shader(m_vertexPath, GL_VERTEX_SHADER, defines));
+    program->AttachShader(new Shader(m_fragmentPath, GL_FRAGMENT_SHADER, defines));
+    program->IncRefCount();
+    m_programs[features] = program;
+
+    if (m_queue != nullptr)
+    {
+        m_queue->Add(program);
+    }
+    return program;
+}
+
+unsigned int ShaderVariants::GetVariantCount()
+{
+    return m_programs.size();
+}
+
+std::vector<std::string> ShaderVariants::GetDefines(unsigned int features)
+{
+    // Must be in the same order as the bits in ShaderFeature.
+    static const char* names[] =
+    {
+        "GBUFFER_OCTAHEDRAL",
+        "SHADOWS",
+    };
+
+    std::vector<std::string> defines;
+    for (unsigned int i = 0; (1u << i) < SHADER_FEATURE_END; i++)
+    {
+        if (features & (1u << i))
+        {
+            defines.push_back(names[i]);
+        }
+    }
+    return defines;
+}
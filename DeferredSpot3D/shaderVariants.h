@@ -0,0 +1,73 @@
+/*
+Title: Deferred Spot Lighting
+File Name: shaderVariants.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include <string>
+#include <vector>
+#include <map>
+
+#include "shaderProgram.h"
+#include "shaderCompileQueue.h"
+
+// Features a shader can be compiled with. Each bit turns on the define with the same name (without SHADER_).
+// Shaders check them with #ifdef, so code for features that are off isn't in the program at all.
+enum ShaderFeature
+{
+    // G-buffer normals are stored in two channels with an octahedral mapping (gBuffer.glsl).
+    SHADER_GBUFFER_OCTAHEDRAL = 1 << 0,
+
+    // Spot lights are shadowed with their tile of the shadow atlas (spotShadowRenderer.h),
+    // point lights with their cube map in the point shadow array (pointShadowRenderer.h).
+    SHADER_SHADOWS = 1 << 1,
+
+    // One past the last feature bit.
+    SHADER_FEATURE_END = 1 << 2
+};
+
+// Every variant of one vertex and fragment shader pair, keyed by a mask of ShaderFeature bits.
+// Variants are only compiled the first time they are asked for.
+class ShaderVariants
+{
+public:
+    // If a queue is given, new variants are added to it instead of being built on first use.
+    ShaderVariants(std::string vertexPath, std::string fragmentPath, ShaderCompileQueue* queue = nullptr);
+    ~ShaderVariants();
+
+    // The program for a set of features, made now if it doesn't exist yet.
+    ShaderProgram* Get(unsigned int features);
+
+    unsigned int GetVariantCount();
+
+    // The define for every feature bit that is set.
+    static std::vector<std::string> GetDefines(unsigned int features);
+
+private:
+    std::string m_vertexPath;
+    std::string m_fragmentPath;
+    ShaderCompileQueue* m_queue;
+
+    std::map<unsigned int, ShaderProgram*> m_programs;
+};
@@ -0,0 +1,491 @@
+/*
+Title: Deferred Spot Lighting
+File Name: shadowAtlas.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "shadowAtlas.h"
+#include "selfTest.h"
+#include <iostream>
+
+ShadowAtlas::ShadowAtlas(unsigned int size, unsigned int minTileSize, unsigned int maxTileSize)
+{
+    m_size = size;
+    m_minTileSize = minTileSize;
+    m_maxTileSize = glm::min(maxTileSize, size);
+
+    // The root is the whole atlas.
+    Node root;
+    root.m_x = 0;
+    root.m_y = 0;
+    root.m_size = size;
+    root.m_parent = -1;
+    m_nodes.push_back(root);
+}
+
+bool ShadowAtlas::Allocate(unsigned int tileSize, ShadowTile& tile)
+{
+    int node = FindFreeLeaf(0, tileSize);
+    if (node < 0)
+    {
+        return false;
+    }
+
+    // Keep splitting off the first quarter until it's the right size.
+    while (m_nodes[node].m_size > tileSize && m_nodes[node].m_size / 2 >= tileSize)
+    {
+        Split(node);
+        node = m_nodes[node].m_firstChild;
+    }
+
+    m_nodes[node].m_used = true;
+    m_usedArea += (unsigned long long)m_nodes[node].m_size * m_nodes[node].m_size;
+
+    tile.m_x = m_nodes[node].m_x;
+    tile.m_y = m_nodes[node].m_y;
+    tile.m_size = m_nodes[node].m_size;
+    tile.m_node = node;
+    return true;
+}
+
+void ShadowAtlas::Free(ShadowTile& tile)
+{
+    if (!tile.IsValid())
+    {
+        return;
+    }
+
+    int node = tile.m_node;
+    m_nodes[node].m_used = false;
+    m_usedArea -= (unsigned long long)m_nodes[node].m_size * m_nodes[node].m_size;
+    tile = ShadowTile();
+
+    // Whenever all four quarters of a node are free leaves, merge them back into it.
+    int parent = m_nodes[node].m_parent;
+    while (parent >= 0)
+    {
+        int firstChild = m_nodes[parent].m_firstChild;
+        for (int i = 0; i < 4; i++)
+        {
+            if (m_nodes[firstChild + i].m_used || m_nodes[firstChild + i].m_firstChild >= 0)
+            {
+                return;
+            }
+        }
+        m_freeGroups.push_back(firstChild);
+        m_nodes[parent].m_firstChild = -1;
+        parent = m_nodes[parent].m_parent;
+    }
+}
+
+unsigned int ShadowAtlas::GetSize()
+{
+    return m_size;
+}
+
+unsigned long long ShadowAtlas::GetUsedArea()
+{
+    return m_usedArea;
+}
+
+void ShadowAtlas::MarkCasterMoved(glm::vec4 sphere)
+{
+    m_movedCasters.push_back(sphere);
+}
+
+void ShadowAtlas::Update(std::vector<SpotLight>& lights, glm::vec3 cameraPosition, float projectionScale)
+{
+    // Lights that went away give their tiles back.
+    for (unsigned int i = lights.size(); i < m_lights.size(); i++)
+    {
+        Free(m_lights[i].m_tile);
+    }
+    m_lights.resize(lights.size());
+
+    // The size each light wants. A tile grows as soon as the light needs it to, but only shrinks once
+    // the light needs a quarter of it, so lights near the boundary don't switch back and forth every frame.
+    // This compares with what the light asked for last time, not the tile it got, which may be smaller.
+    std::vector<unsigned int> sizes(lights.size());
+    for (unsigned int i = 0; i < lights.size(); i++)
+    {
+        glm::vec4 sphere = lights[i].GetBoundingSphere();
+        float distance = glm::length(glm::vec3(sphere) - cameraPosition);
+        float coverage = distance > sphere.w ? projectionScale * sphere.w / distance : 1.f;
+        sizes[i] = ChooseTileSize(coverage, m_minTileSize, m_maxTileSize);
+
+        unsigned int previous = m_lights[i].m_wantedSize;
+        if (previous > 0 && sizes[i] < previous && sizes[i] * 4 > previous)
+        {
+            sizes[i] = previous;
+        }
+    }
+
+    // Free every tile whose light wants a different size first, so the space is there for the new ones.
+    // A smaller tile the light fell back to is kept while it still wants the same size, so it isn't redrawn every frame.
+    for (unsigned int i = 0; i < lights.size(); i++)
+    {
+        if (m_lights[i].m_wantedSize != sizes[i])
+        {
+            Free(m_lights[i].m_tile);
+        }
+        m_lights[i].m_wantedSize = sizes[i];
+    }
+
+    // Place the biggest tiles first, they're the hardest to fit.
+    // If there isn't room, try smaller and smaller tiles, and if nothing fits the light goes without a shadow.
+    std::vector<unsigned int> order(lights.size());
+    for (unsigned int i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return sizes[a] > sizes[b]; });
+
+    for (unsigned int i = 0; i < order.size(); i++)
+    {
+        LightShadow& shadow = m_lights[order[i]];
+        if (shadow.m_tile.IsValid())
+        {
+            // Move a light that fell back to a smaller tile up, but only once a bigger one can actually be had
+            // (its own tile's space counts). Otherwise it gets the same space back, and isn't redrawn.
+            if (shadow.m_tile.m_size < sizes[order[i]])
+            {
+                ShadowTile old = shadow.m_tile;
+                Free(shadow.m_tile);
+                for (unsigned int size = sizes[order[i]]; size >= old.m_size; size /= 2)
+                {
+                    if (Allocate(size, shadow.m_tile))
+                    {
+                        break;
+                    }
+                }
+                if (shadow.m_tile.m_x != old.m_x || shadow.m_tile.m_y != old.m_y || shadow.m_tile.m_size != old.m_size)
+                {
+                    shadow.m_dirty = true;
+                }
+            }
+            continue;
+        }
+
+        for (unsigned int size = sizes[order[i]]; size >= m_minTileSize; size /= 2)
+        {
+            if (Allocate(size, shadow.m_tile))
+            {
+                break;
+            }
+        }
+        shadow.m_dirty = true;
+    }
+
+    // Anything that changed what a light sees means drawing it again.
+    m_lightsToRender.clear();
+    for (unsigned int i = 0; i < lights.size(); i++)
+    {
+        LightShadow& shadow = m_lights[i];
+        SpotLight& light = lights[i];
+
+        if (shadow.m_worldMatrix != light.m_worldMatrix || shadow.m_range != light.m_range || shadow.m_angle != light.m_angle)
+        {
+            shadow.m_dirty = true;
+        }
+
+        for (unsigned int j = 0; j < m_movedCasters.size() && !shadow.m_dirty; j++)
+        {
+            if (light.IntersectsSphere(m_movedCasters[j]))
+            {
+                shadow.m_dirty = true;
+            }
+        }
+
+        shadow.m_worldMatrix = light.m_worldMatrix;
+        shadow.m_range = light.m_range;
+        shadow.m_angle = light.m_angle;
+
+        // Lights are drawn this frame, so next frame they're cached unless something changes.
+        if (shadow.m_dirty && shadow.m_tile.IsValid())
+        {
+            m_lightsToRender.push_back(i);
+        }
+        shadow.m_dirty = false;
+    }
+    m_movedCasters.clear();
+}
+
+std::vector<unsigned int>& ShadowAtlas::GetLightsToRender()
+{
+    return m_lightsToRender;
+}
+
+ShadowTile ShadowAtlas::GetTile(unsigned int light)
+{
+    return m_lights[light].m_tile;
+}
+
+glm::mat4 ShadowAtlas::GetViewProjection(unsigned int light)
+{
+    SpotLight spotLight(m_lights[light].m_worldMatrix, glm::vec4(), glm::vec4(), m_lights[light].m_range, m_lights[light].m_angle, 1);
+    return spotLight.GetViewProjection();
+}
+
+SpotShadow ShadowAtlas::GetShadow(unsigned int light)
+{
+    SpotShadow shadow;
+    ShadowTile& tile = m_lights[light].m_tile;
+    if (!tile.IsValid())
+    {
+        return shadow;
+    }
+
+    // Clip space goes from -1 to 1, move it to 0 to 1, then into the tile's corner of the atlas.
+    float scale = (float)tile.m_size / m_size;
+    glm::vec2 offset = glm::vec2(tile.m_x, tile.m_y) / (float)m_size;
+    glm::mat4 toTile = glm::translate(glm::mat4(), glm::vec3(offset, 0)) * glm::scale(glm::mat4(), glm::vec3(scale, scale, 1));
+    glm::mat4 toTexture = glm::translate(glm::mat4(), glm::vec3(.5f)) * glm::scale(glm::mat4(), glm::vec3(.5f));
+    shadow.m_matrix = toTile * toTexture * GetViewProjection(light);
+
+    // Keep filtering half a texel inside the tile, so it never reads the neighbouring tiles.
+    float halfTexel = .5f / m_size;
+    shadow.m_bounds = glm::vec4(offset + halfTexel, offset + scale - halfTexel);
+    return shadow;
+}
+
+unsigned int ShadowAtlas::GetShadowCount()
+{
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < m_lights.size(); i++)
+    {
+        count += m_lights[i].m_tile.IsValid() ? 1 : 0;
+    }
+    return count;
+}
+
+unsigned int ShadowAtlas::GetCachedCount()
+{
+    return GetShadowCount() - m_lightsToRender.size();
+}
+
+unsigned int ShadowAtlas::ChooseTileSize(float coverage, unsigned int minTileSize, unsigned int maxTileSize)
+{
+    // A light filling the screen gets the biggest tile, and every halving of its size halves the tile.
+    unsigned int size = maxTileSize;
+    while (size > minTileSize && size / 2 >= coverage * maxTileSize)
+    {
+        size /= 2;
+    }
+    return size;
+}
+
+int ShadowAtlas::FindFreeLeaf(int node, unsigned int size)
+{
+    Node& current = m_nodes[node];
+    if (current.m_size < size || current.m_used)
+    {
+        return -1;
+    }
+    if (current.m_firstChild < 0)
+    {
+        return node;
+    }
+
+    // Prefer the smallest fit, so big free areas are left alone for big tiles.
+    int best = -1;
+    for (int i = 0; i < 4; i++)
+    {
+        int leaf = FindFreeLeaf(m_nodes[node].m_firstChild + i, size);
+        if (leaf >= 0 && (best < 0 || m_nodes[leaf].m_size < m_nodes[best].m_size))
+        {
+            best = leaf;
+        }
+    }
+    return best;
+}
+
+void ShadowAtlas::Split(int node)
+{
+    // Reuse a group of four from an earlier merge if there is one.
+    int firstChild;
+    if (m_freeGroups.size() > 0)
+    {
+        firstChild = m_freeGroups.back();
+        m_freeGroups.pop_back();
+    }
+    else
+    {
+        firstChild = m_nodes.size();
+        m_nodes.resize(m_nodes.size() + 4);
+    }
+
+    unsigned int half = m_nodes[node].m_size / 2;
+    for (int i = 0; i < 4; i++)
+    {
+        Node& child = m_nodes[firstChild + i];
+        child.m_x = m_nodes[node].m_x + (i % 2) * half;
+        child.m_y = m_nodes[node].m_y + (i / 2) * half;
+        child.m_size = half;
+        child.m_parent = node;
+        child.m_firstChild = -1;
+        child.m_used = false;
+    }
+    m_nodes[node].m_firstChild = firstChild;
+}
+
+int ShadowAtlas::RunTest()
+{
+    SelfTest test("Shadow atlas");
+
+    // Four quarters fill the atlas, and once they're all freed they merge back into one tile the size of the atlas.
+    {
+        ShadowAtlas atlas(1024, 64, 1024);
+        ShadowTile quarters[4];
+        bool placed = true;
+        for (int i = 0; i < 4; i++)
+        {
+            placed = atlas.Allocate(512, quarters[i]) && placed;
+            placed = placed && quarters[i].m_size == 512 && quarters[i].m_x % 512 == 0 && quarters[i].m_y % 512 == 0;
+        }
+        test.Check(placed, "Four quarters didn't fit in the atlas");
+        test.Check(atlas.GetUsedArea() == 1024 * 1024, "Used area is wrong with the atlas full");
+
+        ShadowTile extra;
+        test.Check(!atlas.Allocate(64, extra), "A tile fit in a full atlas");
+
+        for (int i = 0; i < 4; i++)
+        {
+            atlas.Free(quarters[i]);
+        }
+        test.Check(atlas.GetUsedArea() == 0, "Used area isn't 0 with every tile freed");
+
+        ShadowTile whole;
+        test.Check(atlas.Allocate(1024, whole) && whole.m_x == 0 && whole.m_y == 0, "Freed quarters weren't merged back together");
+        atlas.Free(whole);
+
+        // Small tiles go next to each other, leaving the other quarters whole.
+        ShadowTile small[2];
+        atlas.Allocate(64, small[0]);
+        atlas.Allocate(64, small[1]);
+        test.Check(small[0].m_x + small[0].m_y < 512 && small[1].m_x + small[1].m_y < 512, "Small tiles were spread over the atlas");
+        ShadowTile big;
+        test.Check(atlas.Allocate(512, big), "No room for a quarter next to two small tiles");
+    }
+
+    // Every light that changes tile is drawn once, and not again until something changes.
+    std::vector<SpotLight> lights;
+    for (int i = 0; i < 4; i++)
+    {
+        glm::mat4 world = glm::translate(glm::mat4(), glm::vec3(i * 30.f, 0, 0));
+        lights.push_back(SpotLight(world, glm::vec4(3, 1, 0, .25f), glm::vec4(1), 10, .5f, 1));
+    }
+    glm::vec3 camera = glm::vec3(0, 0, 1000);
+
+    // More lights than the atlas has room for. A tile already in the way leaves one light a smaller tile.
+    // That light has to keep it, not be given a new one (and redrawn) every frame.
+    {
+        ShadowAtlas atlas(2048, 64, 1024);
+        ShadowTile blocker;
+        atlas.Allocate(512, blocker);
+
+        // A huge projection scale makes every light want the biggest tile.
+        atlas.Update(lights, camera, 1e6f);
+        test.Check(atlas.GetLightsToRender().size() == 4, "Not every light was drawn the first time");
+        unsigned int fallbacks = 0;
+        for (unsigned int i = 0; i < lights.size(); i++)
+        {
+            fallbacks += atlas.GetTile(i).m_size == 512 ? 1 : 0;
+        }
+        test.Check(fallbacks == 1, "A light didn't fall back to a smaller tile");
+
+        atlas.Update(lights, camera, 1e6f);
+        test.Check(atlas.GetLightsToRender().empty(), "Lights were redrawn with nothing changed, with the atlas full");
+
+        // Six lights, the other two fit in what's left next to the blocker.
+        std::vector<SpotLight> more = lights;
+        more.push_back(lights[0]);
+        more.push_back(lights[1]);
+        atlas.Update(more, camera, 1e6f);
+        atlas.Update(more, camera, 1e6f);
+        test.Check(atlas.GetLightsToRender().empty(), "Lights were redrawn with nothing changed, with lights left over");
+        test.Check(atlas.GetShadowCount() == 6, "The two extra lights didn't fall back to the last two small tiles");
+
+        // Eight, two get nothing at all, which isn't drawn either.
+        more.push_back(lights[2]);
+        more.push_back(lights[3]);
+        atlas.Update(more, camera, 1e6f);
+        atlas.Update(more, camera, 1e6f);
+        test.Check(atlas.GetLightsToRender().empty(), "Lights were redrawn with nothing changed, with lights left out");
+        test.Check(atlas.GetShadowCount() == 6, "Lights left out of a full atlas got tiles");
+        atlas.Update(lights, camera, 1e6f);
+
+        // Once the space is there, the light moves up to the tile it wanted, and is drawn there once.
+        atlas.Free(blocker);
+        atlas.Update(lights, camera, 1e6f);
+        bool allFull = true;
+        for (unsigned int i = 0; i < lights.size(); i++)
+        {
+            allFull = allFull && atlas.GetTile(i).m_size == 1024;
+        }
+        test.Check(allFull && atlas.GetLightsToRender().size() == 1, "The light with a smaller tile didn't move up once there was room");
+        atlas.Update(lights, camera, 1e6f);
+        test.Check(atlas.GetLightsToRender().empty(), "Lights were redrawn after moving up");
+    }
+
+    // A tile shrinks only once the light needs a quarter of it.
+    {
+        ShadowAtlas atlas(2048, 64, 1024);
+        std::vector<SpotLight> one(1, lights[0]);
+        glm::vec4 sphere = one[0].GetBoundingSphere();
+        float distance = glm::length(glm::vec3(sphere) - camera);
+
+        // The projection scale that makes the light cover this much of the screen.
+        auto scaleFor = [&](float coverage) { return coverage * distance / sphere.w; };
+
+        atlas.Update(one, camera, scaleFor(.4f));
+        test.Check(atlas.GetTile(0).m_size == 512, "A light covering 40% of the screen didn't get a 512 tile");
+        atlas.Update(one, camera, scaleFor(.2f));
+        test.Check(atlas.GetTile(0).m_size == 512 && atlas.GetLightsToRender().empty(), "A tile shrank to half its size");
+        atlas.Update(one, camera, scaleFor(.05f));
+        test.Check(atlas.GetTile(0).m_size == 64 && atlas.GetLightsToRender().size() == 1, "A tile didn't shrink to a quarter");
+        atlas.Update(one, camera, scaleFor(.4f));
+        test.Check(atlas.GetTile(0).m_size == 512 && atlas.GetLightsToRender().size() == 1, "A tile didn't grow right away");
+    }
+
+    // Casters moving inside a cone redraw its light, anywhere else they don't.
+    {
+        ShadowAtlas atlas(2048, 64, 1024);
+        std::vector<SpotLight> one(1, lights[0]);
+        atlas.Update(one, camera, 1);
+        atlas.Update(one, camera, 1);
+        test.Check(atlas.GetLightsToRender().empty(), "A light was redrawn with nothing changed");
+
+        // The cone points down -z from the origin.
+        atlas.MarkCasterMoved(glm::vec4(0, 0, -5, 1));
+        atlas.Update(one, camera, 1);
+        test.Check(atlas.GetLightsToRender().size() == 1, "A caster moving in the cone didn't redraw the light");
+
+        atlas.MarkCasterMoved(glm::vec4(0, 0, 50, 1));
+        atlas.Update(one, camera, 1);
+        test.Check(atlas.GetLightsToRender().empty(), "A caster moving far away redrew the light");
+
+        one[0].m_worldMatrix = glm::translate(one[0].m_worldMatrix, glm::vec3(1, 0, 0));
+        atlas.Update(one, camera, 1);
+        test.Check(atlas.GetLightsToRender().size() == 1, "Moving the light didn't redraw it");
+    }
+
+    return test.Finish();
+}
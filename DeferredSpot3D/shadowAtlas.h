@@ -0,0 +1,141 @@
+/*
+Title: Deferred Spot Lighting
+File Name: shadowAtlas.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <vector>
+#include <algorithm>
+
+#include "lights.h"
+
+// A square area of the atlas, in texels.
+struct ShadowTile
+{
+    unsigned int m_x = 0;
+    unsigned int m_y = 0;
+    unsigned int m_size = 0;
+
+    // The quadtree node the tile is, -1 if this isn't a tile.
+    int m_node = -1;
+
+    bool IsValid() {
+        return m_node >= 0;
+    }
+};
+
+// Decides where every spot light's shadow map goes in one big shared depth texture, and when it has to be redrawn.
+// It doesn't touch OpenGL at all (spotShadowRenderer.h does the drawing), so it can be used and tested without a context.
+//
+// Tiles are handed out by a quadtree: the atlas is split into four, those into four again, and so on.
+// Every tile is a power of two and sits on a multiple of its size, so freeing tiles merges the quarters back together.
+//
+// Each light's tile size depends on how much of the screen its cone covers. A tile is kept from frame to frame,
+// and only redrawn when the light itself changed, it got a new tile, or a shadow caster moved inside its cone.
+class ShadowAtlas
+{
+public:
+    // Tile sizes are powers of two, between minTileSize and maxTileSize.
+    ShadowAtlas(unsigned int size, unsigned int minTileSize = 64, unsigned int maxTileSize = 1024);
+
+    // Finds room for a tile of a power of two size. Returns false if there isn't any.
+    bool Allocate(unsigned int tileSize, ShadowTile& tile);
+    // Gives a tile back, merging it with its neighbours where possible.
+    void Free(ShadowTile& tile);
+
+    unsigned int GetSize();
+    // Texels used by tiles.
+    unsigned long long GetUsedArea();
+
+    // Tell the atlas a shadow caster moved. Give the bounding sphere of where it was, and where it is now
+    // (a caster leaving a cone changes its shadow too). Lights whose cone touches the sphere are redrawn on the next Update.
+    void MarkCasterMoved(glm::vec4 sphere);
+
+    // Resizes and places every light's tile, and works out which ones need to be drawn this frame.
+    // Lights are matched up from frame to frame by their index. projectionScale is projection[1][1] of the camera.
+    void Update(std::vector<SpotLight>& lights, glm::vec3 cameraPosition, float projectionScale);
+
+    // The lights (indices) that have to be drawn into their tile this frame. Call after Update.
+    std::vector<unsigned int>& GetLightsToRender();
+
+    // Results for one light. Lights that didn't get a tile have an invalid one, and a SpotShadow with no shadow.
+    ShadowTile GetTile(unsigned int light);
+    glm::mat4 GetViewProjection(unsigned int light);
+    SpotShadow GetShadow(unsigned int light);
+
+    // How many lights have a tile, and how many of those are reused from the last frame.
+    unsigned int GetShadowCount();
+    unsigned int GetCachedCount();
+
+    // The tile size for a light covering this fraction of the screen's height (1 or more when the camera is inside it).
+    static unsigned int ChooseTileSize(float coverage, unsigned int minTileSize, unsigned int maxTileSize);
+
+    // Checks allocation, merging, smaller tiles when the atlas is full, resize hysteresis, and redraws after
+    // casters move, without a GPU.
+    static int RunTest();
+
+private:
+    struct Node
+    {
+        unsigned int m_x;
+        unsigned int m_y;
+        unsigned int m_size;
+        int m_parent;
+        // The four children are stored next to each other, -1 for a leaf.
+        int m_firstChild = -1;
+        // Leaves only, whether the leaf is a tile.
+        bool m_used = false;
+    };
+
+    struct LightShadow
+    {
+        ShadowTile m_tile;
+        // The tile size the light asked for. The tile can be smaller when the atlas was too full.
+        unsigned int m_wantedSize = 0;
+        // The light as it was drawn, to notice when it changes.
+        glm::mat4 m_worldMatrix;
+        float m_range = 0;
+        float m_angle = 0;
+        // Whether the tile has to be drawn (again).
+        bool m_dirty = true;
+    };
+
+    // Finds the smallest free leaf that is still at least size, under a node. Returns -1 if there isn't one.
+    int FindFreeLeaf(int node, unsigned int size);
+    // Turns a leaf into four children.
+    void Split(int node);
+
+    unsigned int m_size;
+    unsigned int m_minTileSize;
+    unsigned int m_maxTileSize;
+
+    std::vector<Node> m_nodes;
+    // Groups of four nodes that were merged away, to be reused by the next split.
+    std::vector<int> m_freeGroups;
+    unsigned long long m_usedArea = 0;
+
+    std::vector<LightShadow> m_lights;
+    std::vector<glm::vec4> m_movedCasters;
+    std::vector<unsigned int> m_lightsToRender;
+};
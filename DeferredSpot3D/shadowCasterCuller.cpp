@@ -0,0 +1,336 @@
+/*
+Title: Deferred Spot Lighting
+File Name: shadowCasterCuller.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "shadowCasterCuller.h"
+#include <chrono>
+#include <random>
+
+void ShadowCasterCuller::SetCasters(DrawCommandList& casters)
+{
+    m_casters = &casters;
+
+    std::vector<glm::mat4>& matrices = casters.GetInstanceMatrices();
+    std::vector<GLuint>& drawIds = casters.GetDrawIds();
+    std::vector<glm::vec4>& spheres = casters.GetBoundingSpheres();
+
+    // Round up to a multiple of four, so the SSE loop never reads past the end.
+    // The extra spheres are far away and have no size, and are never returned anyway.
+    unsigned int count = matrices.size();
+    unsigned int paddedCount = (count + 3) & ~3u;
+    m_x.assign(paddedCount, 1e30f);
+    m_y.assign(paddedCount, 1e30f);
+    m_z.assign(paddedCount, 1e30f);
+    m_radius.assign(paddedCount, 0);
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        glm::vec4 sphere = TransformBoundingSphere(matrices[i], spheres[drawIds[i]]);
+        m_x[i] = sphere.x;
+        m_y[i] = sphere.y;
+        m_z[i] = sphere.z;
+        m_radius[i] = sphere.w;
+    }
+}
+
+void ShadowCasterCuller::Cull(std::vector<SpotLight>& lights, std::vector<DrawElementsIndirectCommand>& commands,
+    std::vector<glm::mat4>& matrices, std::vector<unsigned int>& firstCommands)
+{
+#ifdef CASTER_CULL_SSE
+    // Everything about a light the test needs, with each value copied into all four lanes.
+    struct Cone
+    {
+        __m128 m_x, m_y, m_z;
+        __m128 m_directionX, m_directionY, m_directionZ;
+        __m128 m_cos, m_sin, m_range;
+    };
+    std::vector<Cone> cones(lights.size());
+    for (unsigned int l = 0; l < lights.size(); l++)
+    {
+        glm::vec3 position = glm::vec3(lights[l].m_worldMatrix[3]);
+        glm::vec3 direction = glm::normalize(glm::vec3(lights[l].m_worldMatrix * glm::vec4(0, 0, -1, 0)));
+        cones[l].m_x = _mm_set1_ps(position.x);
+        cones[l].m_y = _mm_set1_ps(position.y);
+        cones[l].m_z = _mm_set1_ps(position.z);
+        cones[l].m_directionX = _mm_set1_ps(direction.x);
+        cones[l].m_directionY = _mm_set1_ps(direction.y);
+        cones[l].m_directionZ = _mm_set1_ps(direction.z);
+        cones[l].m_cos = _mm_set1_ps(cos(lights[l].m_angle));
+        cones[l].m_sin = _mm_set1_ps(sin(lights[l].m_angle));
+        cones[l].m_range = _mm_set1_ps(lights[l].m_range);
+    }
+
+    m_visible.resize(lights.size());
+    for (unsigned int l = 0; l < lights.size(); l++)
+    {
+        m_visible[l].clear();
+    }
+
+    unsigned int count = GetCasterCount();
+    __m128 zero = _mm_setzero_ps();
+    for (unsigned int i = 0; i < count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&m_x[i]);
+        __m128 y = _mm_loadu_ps(&m_y[i]);
+        __m128 z = _mm_loadu_ps(&m_z[i]);
+        __m128 radius = _mm_loadu_ps(&m_radius[i]);
+        __m128 negativeRadius = _mm_sub_ps(zero, radius);
+
+        // The same math as SpotLight::IntersectsSphere, on four spheres at once.
+        for (unsigned int l = 0; l < cones.size(); l++)
+        {
+            Cone& cone = cones[l];
+            __m128 toX = _mm_sub_ps(x, cone.m_x);
+            __m128 toY = _mm_sub_ps(y, cone.m_y);
+            __m128 toZ = _mm_sub_ps(z, cone.m_z);
+
+            __m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toX, cone.m_directionX), _mm_mul_ps(toY, cone.m_directionY)), _mm_mul_ps(toZ, cone.m_directionZ));
+            __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toX, toX), _mm_mul_ps(toY, toY)), _mm_mul_ps(toZ, toZ));
+            __m128 away = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lengthSquared, _mm_mul_ps(along, along)), zero));
+            __m128 toSide = _mm_sub_ps(_mm_mul_ps(cone.m_cos, away), _mm_mul_ps(cone.m_sin, along));
+
+            __m128 inside = _mm_and_ps(_mm_cmple_ps(toSide, radius),
+                _mm_and_ps(_mm_cmpge_ps(along, negativeRadius), _mm_cmple_ps(along, _mm_add_ps(cone.m_range, radius))));
+
+            // One bit per sphere. Usually none of them are in the cone.
+            int mask = _mm_movemask_ps(inside);
+            if (mask == 0)
+            {
+                continue;
+            }
+            for (unsigned int bit = 0; bit < 4 && i + bit < count; bit++)
+            {
+                if (mask & (1 << bit))
+                {
+                    m_visible[l].push_back(i + bit);
+                }
+            }
+        }
+    }
+
+    BuildCommands(commands, matrices, firstCommands);
+#else
+    CullScalar(lights, commands, matrices, firstCommands);
+#endif
+}
+
+void ShadowCasterCuller::CullScalar(std::vector<SpotLight>& lights, std::vector<DrawElementsIndirectCommand>& commands,
+    std::vector<glm::mat4>& matrices, std::vector<unsigned int>& firstCommands)
+{
+    m_visible.resize(lights.size());
+    unsigned int count = GetCasterCount();
+    for (unsigned int l = 0; l < lights.size(); l++)
+    {
+        m_visible[l].clear();
+
+        // SpotLight::IntersectsSphere, with everything about the light worked out once instead of per sphere.
+        glm::vec3 position = glm::vec3(lights[l].m_worldMatrix[3]);
+        glm::vec3 direction = glm::normalize(glm::vec3(lights[l].m_worldMatrix * glm::vec4(0, 0, -1, 0)));
+        float cosAngle = cos(lights[l].m_angle);
+        float sinAngle = sin(lights[l].m_angle);
+        float range = lights[l].m_range;
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            glm::vec3 toSphere = glm::vec3(m_x[i], m_y[i], m_z[i]) - position;
+            float along = glm::dot(toSphere, direction);
+            float away = sqrt(glm::max(glm::dot(toSphere, toSphere) - along * along, 0.f));
+            float toSide = cosAngle * away - sinAngle * along;
+            if (toSide <= m_radius[i] && along >= -m_radius[i] && along <= range + m_radius[i])
+            {
+                m_visible[l].push_back(i);
+            }
+        }
+    }
+
+    BuildCommands(commands, matrices, firstCommands);
+}
+
+void ShadowCasterCuller::CullPointLights(std::vector<PointLight>& lights, std::vector<DrawElementsIndirectCommand>& commands,
+    std::vector<glm::mat4>& matrices, std::vector<unsigned int>& firstCommands, std::vector<unsigned int>& faceMasks)
+{
+    m_visible.resize(lights.size());
+    faceMasks.assign(lights.size(), 0);
+    unsigned int count = GetCasterCount();
+    for (unsigned int l = 0; l < lights.size(); l++)
+    {
+        m_visible[l].clear();
+        for (unsigned int i = 0; i < count; i++)
+        {
+            glm::vec3 toSphere = glm::vec3(m_x[i], m_y[i], m_z[i]) - lights[l].m_position;
+            float reach = lights[l].m_radius + m_radius[i];
+            if (glm::dot(toSphere, toSphere) > reach * reach)
+            {
+                continue;
+            }
+            m_visible[l].push_back(i);
+
+            // Each face sees a 90 degree pyramid around one axis. The sphere is in it if it's inside the four
+            // 45 degree planes around that axis, which comes down to comparing the other two axes against this one.
+            float slack = m_radius[i] * 1.41421356f;
+            for (int face = 0; face < 6; face++)
+            {
+                int axis = face / 2;
+                float forward = (face % 2 == 0) ? toSphere[axis] : -toSphere[axis];
+                if (forward + slack >= fabs(toSphere[(axis + 1) % 3]) && forward + slack >= fabs(toSphere[(axis + 2) % 3]))
+                {
+                    faceMasks[l] |= 1 << face;
+                }
+            }
+        }
+    }
+
+    BuildCommands(commands, matrices, firstCommands);
+}
+
+unsigned int ShadowCasterCuller::GetCasterCount()
+{
+    return m_casters != nullptr ? m_casters->GetInstanceMatrices().size() : 0;
+}
+
+void ShadowCasterCuller::BuildCommands(std::vector<DrawElementsIndirectCommand>& commands, std::vector<glm::mat4>& matrices,
+    std::vector<unsigned int>& firstCommands)
+{
+    commands.clear();
+    matrices.clear();
+    firstCommands.clear();
+
+    std::vector<DrawElementsIndirectCommand>& casterCommands = m_casters->GetCommands();
+    std::vector<glm::mat4>& casterMatrices = m_casters->GetInstanceMatrices();
+    std::vector<GLuint>& drawIds = m_casters->GetDrawIds();
+
+    for (unsigned int l = 0; l < m_visible.size(); l++)
+    {
+        firstCommands.push_back(commands.size());
+
+        // Each command's instances are next to each other, so instances in order come in runs of the same command.
+        // Every run becomes a copy of that command, pointing at just the visible matrices.
+        std::vector<unsigned int>& visible = m_visible[l];
+        GLuint lastDrawId = 0xFFFFFFFF;
+        for (unsigned int i = 0; i < visible.size(); i++)
+        {
+            GLuint drawId = drawIds[visible[i]];
+            if (drawId != lastDrawId)
+            {
+                DrawElementsIndirectCommand command = casterCommands[drawId];
+                command.m_instanceCount = 0;
+                command.m_baseInstance = matrices.size();
+                commands.push_back(command);
+                lastDrawId = drawId;
+            }
+            matrices.push_back(casterMatrices[visible[i]]);
+            commands.back().m_instanceCount++;
+        }
+    }
+    firstCommands.push_back(commands.size());
+}
+
+int ShadowCasterCuller::RunBenchmark(unsigned int lightCount, unsigned int instanceCount)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0, 1);
+
+    // A 200 unit wide field of unit sized instances, split between a few meshes.
+    const unsigned int meshCount = 4;
+    DrawCommandList casters;
+    for (unsigned int m = 0; m < meshCount; m++)
+    {
+        MeshPoolEntry entry;
+        entry.m_firstVertex = 0;
+        entry.m_vertexCount = 0;
+        entry.m_firstIndex = 0;
+        entry.m_indexCount = 36;
+        entry.m_boundingSphere = glm::vec4(0, 0, 0, 1);
+        entry.m_inUse = true;
+
+        std::vector<glm::mat4> matrices;
+        for (unsigned int i = m; i < instanceCount; i += meshCount)
+        {
+            glm::vec3 position = glm::vec3(unit(random), unit(random) * .1f, unit(random)) * 200.f - glm::vec3(100, 10, 100);
+            matrices.push_back(glm::translate(glm::mat4(), position));
+        }
+        casters.Add(entry, matrices);
+    }
+
+    // Lights hanging over the field, pointing down at random angles.
+    std::vector<SpotLight> lights;
+    for (unsigned int l = 0; l < lightCount; l++)
+    {
+        glm::vec3 position = glm::vec3(unit(random) * 200 - 100, 10, unit(random) * 200 - 100);
+        glm::mat4 world = glm::translate(glm::mat4(), position);
+        world = glm::rotate(world, -1.2f - unit(random) * .6f, glm::vec3(1, 0, 0));
+        world = glm::rotate(world, unit(random) * 6.28f, glm::vec3(0, 0, 1));
+        lights.push_back(SpotLight(world, glm::vec4(3, 1, 0, .25f), glm::vec4(1), 20, .2f + unit(random) * .4f, 16));
+    }
+
+    ShadowCasterCuller culler;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<glm::mat4> matrices;
+    std::vector<unsigned int> firstCommands;
+
+    // Run each part a few times and keep the fastest, so a single hiccup doesn't count.
+    const int runs = 5;
+    double setMs = 1e30, cullMs = 1e30, scalarMs = 1e30;
+    for (int run = 0; run < runs; run++)
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        culler.SetCasters(casters);
+        std::chrono::high_resolution_clock::time_point set = std::chrono::high_resolution_clock::now();
+        culler.Cull(lights, commands, matrices, firstCommands);
+        std::chrono::high_resolution_clock::time_point culled = std::chrono::high_resolution_clock::now();
+
+        setMs = glm::min(setMs, std::chrono::duration<double, std::milli>(set - start).count());
+        cullMs = glm::min(cullMs, std::chrono::duration<double, std::milli>(culled - set).count());
+    }
+    std::vector<DrawElementsIndirectCommand> scalarCommands;
+    std::vector<glm::mat4> scalarMatrices;
+    std::vector<unsigned int> scalarFirstCommands;
+    for (int run = 0; run < runs; run++)
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        culler.CullScalar(lights, scalarCommands, scalarMatrices, scalarFirstCommands);
+        std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+        scalarMs = glm::min(scalarMs, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    // Both versions have to find exactly the same casters.
+    bool same = matrices.size() == scalarMatrices.size() && firstCommands == scalarFirstCommands;
+    for (unsigned int i = 0; same && i < commands.size(); i++)
+    {
+        same = commands[i].m_instanceCount == scalarCommands[i].m_instanceCount && commands[i].m_baseInstance == scalarCommands[i].m_baseInstance;
+    }
+
+    double tests = (double)lightCount * instanceCount;
+    std::cout << "Shadow caster culling, " << lightCount << " lights x " << instanceCount << " instances:" << std::endl;
+    std::cout << "  Bounding spheres: " << setMs << " ms" << std::endl;
+#ifdef CASTER_CULL_SSE
+    std::cout << "  Cull (SSE):       " << cullMs << " ms, " << tests / (cullMs * 1e6) << " billion tests per second" << std::endl;
+#else
+    std::cout << "  Cull (no SSE):    " << cullMs << " ms" << std::endl;
+#endif
+    std::cout << "  Cull (scalar):    " << scalarMs << " ms, " << tests / (scalarMs * 1e6) << " billion tests per second" << std::endl;
+    std::cout << "  " << matrices.size() << " visible casters (" << matrices.size() / (float)lightCount << " per light), in "
+        << commands.size() << " draw commands" << std::endl;
+    std::cout << (same ? "  Results match." : "  Results don't match!") << std::endl;
+    return same ? 0 : 1;
+}
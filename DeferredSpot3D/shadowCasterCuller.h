@@ -0,0 +1,95 @@
+/*
+Title: Deferred Spot Lighting
+File Name: shadowCasterCuller.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "glm/glm.hpp"
+#include <vector>
+#include <iostream>
+
+#include "meshPool.h"
+#include "frustum.h"
+#include "lights.h"
+
+// SSE is always there on x64, and on 32 bit x86 when compiling for SSE2 or better.
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CASTER_CULL_SSE
+#include <xmmintrin.h>
+#endif
+
+// Finds which shadow casters are inside each spot light's cone, on the CPU.
+//
+// Every instance's bounding sphere is tested against every light's cone (SpotLight::IntersectsSphere).
+// The spheres are kept as separate arrays of x, y, z and radius, so four of them load straight into SSE registers
+// and are tested against a light at once. Each group of four is tested against every light before moving on,
+// so the spheres are only read from memory once, however many lights there are.
+//
+// The survivors become indirect draw commands, grouped by light, so each light's shadow map is one multi-draw.
+class ShadowCasterCuller
+{
+public:
+    // Moves every instance's bounding sphere into world space. Call once a frame, before Cull.
+    void SetCasters(DrawCommandList& casters);
+
+    // Culls the casters against every light. Each light's visible casters become one command per mesh
+    // (copied from the caster list, with only the visible instances), appended to commands, with their
+    // matrices appended to matrices. Light i's commands are firstCommands[i] up to firstCommands[i + 1].
+    void Cull(std::vector<SpotLight>& lights, std::vector<DrawElementsIndirectCommand>& commands,
+        std::vector<glm::mat4>& matrices, std::vector<unsigned int>& firstCommands);
+
+    // Exactly the same, one light and one sphere at a time without SSE. To check and time the SSE version against.
+    void CullScalar(std::vector<SpotLight>& lights, std::vector<DrawElementsIndirectCommand>& commands,
+        std::vector<glm::mat4>& matrices, std::vector<unsigned int>& firstCommands);
+
+    // The same for point lights, where a caster is visible if its sphere touches the light's.
+    // faceMasks gets a bit for every cube face with a caster in it (bit n is GL_TEXTURE_CUBE_MAP_POSITIVE_X + n),
+    // so faces that would only be cleared can be skipped. This one isn't SSE, there are far fewer point shadows.
+    void CullPointLights(std::vector<PointLight>& lights, std::vector<DrawElementsIndirectCommand>& commands,
+        std::vector<glm::mat4>& matrices, std::vector<unsigned int>& firstCommands, std::vector<unsigned int>& faceMasks);
+
+    unsigned int GetCasterCount();
+
+    // Times SetCasters and both versions of Cull on a made up scene, and prints the results.
+    // Runs instead of the demo when the first argument is --benchmark-casters:
+    //
+    //     DeferredSpot3D --benchmark-casters [lights] [instances]
+    //
+    // Returns the program's exit code (1 if the two versions disagree).
+    static int RunBenchmark(unsigned int lightCount, unsigned int instanceCount);
+
+private:
+    // Turns the visible instance indices of each light into commands and matrices.
+    void BuildCommands(std::vector<DrawElementsIndirectCommand>& commands, std::vector<glm::mat4>& matrices,
+        std::vector<unsigned int>& firstCommands);
+
+    DrawCommandList* m_casters = nullptr;
+
+    // World space bounding spheres, one entry per instance.
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+    std::vector<float> m_radius;
+
+    // The instances each light can see, in instance order.
+    std::vector<std::vector<unsigned int>> m_visible;
+};
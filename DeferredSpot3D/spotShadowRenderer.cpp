@@ -0,0 +1,160 @@
+/*
+Title: Deferred Spot Lighting
+File Name: spotShadowRenderer.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "spotShadowRenderer.h"
+#include <chrono>
+
+SpotShadowRenderer::SpotShadowRenderer(unsigned int atlasSize, unsigned int minTileSize, unsigned int maxTileSize)
+    : m_atlas(atlasSize, minTileSize, maxTileSize)
+{
+    // One depth texture for every light. Linear filtering with comparisons on gives 2x2 PCF for free.
+    m_atlasTexture = new Texture(atlasSize, atlasSize, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, GL_LINEAR, 1);
+    m_atlasTexture->IncRefCount();
+    glBindTexture(GL_TEXTURE_2D, m_atlasTexture->GetGLTexture());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Depth only, there's nothing to draw color into.
+    glGenFramebuffers(1, &m_frameBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_atlasTexture->GetGLTexture(), 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "Shadow atlas frame buffer is incomplete." << std::endl;
+    }
+
+    // Start out at the far plane everywhere.
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+SpotShadowRenderer::~SpotShadowRenderer()
+{
+    glDeleteFramebuffers(1, &m_frameBuffer);
+    m_atlasTexture->DecRefCount();
+}
+
+void SpotShadowRenderer::Update(std::vector<SpotLight>& lights, glm::vec3 cameraPosition, float projectionScale)
+{
+    m_atlas.Update(lights, cameraPosition, projectionScale);
+
+    m_shadows.resize(lights.size());
+    for (unsigned int i = 0; i < lights.size(); i++)
+    {
+        m_shadows[i] = m_atlas.GetShadow(i);
+    }
+}
+
+void SpotShadowRenderer::Render(MeshPool* pool, std::vector<SpotLight>& lights, Material* depthMaterial)
+{
+    std::vector<unsigned int>& lightsToRender = m_atlas.GetLightsToRender();
+    m_casterCount = 0;
+    m_cullTimeMs = 0;
+    if (lightsToRender.size() == 0)
+    {
+        return;
+    }
+
+    // Find every changed light's casters in one go, then upload them all together.
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    std::vector<SpotLight> changedLights;
+    for (unsigned int i = 0; i < lightsToRender.size(); i++)
+    {
+        changedLights.push_back(lights[lightsToRender[i]]);
+    }
+    m_casterCuller.SetCasters(pool->GetCommandList());
+    m_casterCuller.Cull(changedLights, m_casterCommands, m_casterMatrices, m_firstCasterCommands);
+    m_cullTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    m_casterCount = m_casterMatrices.size();
+
+    pool->PrepareCommands(m_casterCommands, m_casterMatrices);
+
+    // Remember where we were drawing, so it can be put back afterwards.
+    GLint previousFrameBuffer;
+    GLint previousViewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFrameBuffer);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+
+    // The scissor keeps the clear inside the tile.
+    glEnable(GL_SCISSOR_TEST);
+
+    // Push the depth back a little (more on slopes), so surfaces don't shadow themselves.
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(1.5f, 4.f);
+
+    for (unsigned int i = 0; i < lightsToRender.size(); i++)
+    {
+        ShadowTile tile = m_atlas.GetTile(lightsToRender[i]);
+        glm::mat4 viewProjection = m_atlas.GetViewProjection(lightsToRender[i]);
+
+        glViewport(tile.m_x, tile.m_y, tile.m_size, tile.m_size);
+        glScissor(tile.m_x, tile.m_y, tile.m_size, tile.m_size);
+        glClear(GL_DEPTH_BUFFER_BIT);
+
+        // Only the instances inside the light's cone are drawn.
+        depthMaterial->SetMatrix((char*)"cameraView", viewProjection);
+        depthMaterial->Bind();
+        pool->RenderRange(m_firstCasterCommands[i], m_firstCasterCommands[i + 1] - m_firstCasterCommands[i], true);
+        depthMaterial->Unbind();
+    }
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glDisable(GL_SCISSOR_TEST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFrameBuffer);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+}
+
+std::vector<SpotShadow>& SpotShadowRenderer::GetShadows()
+{
+    return m_shadows;
+}
+
+ShadowAtlas& SpotShadowRenderer::GetAtlas()
+{
+    return m_atlas;
+}
+
+unsigned int SpotShadowRenderer::GetCasterCount()
+{
+    return m_casterCount;
+}
+
+float SpotShadowRenderer::GetCullTimeMs()
+{
+    return m_cullTimeMs;
+}
+
+Texture* SpotShadowRenderer::GetAtlasTexture()
+{
+    return m_atlasTexture;
+}
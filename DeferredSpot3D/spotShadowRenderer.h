@@ -0,0 +1,83 @@
+/*
+Title: Deferred Spot Lighting
+File Name: spotShadowRenderer.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "glm/glm.hpp"
+#include <vector>
+#include <iostream>
+
+#include "texture.h"
+#include "material.h"
+#include "meshPool.h"
+#include "shadowAtlas.h"
+#include "shadowCasterCuller.h"
+#include "lights.h"
+
+// Draws spot light shadow maps into the tiles of one shared depth texture (ShadowAtlas decides where, and when).
+// Casters are the instances submitted to a mesh pool. They're culled against the cones of every light that needs
+// redrawing at once on the CPU (shadowCasterCuller.h), and then each light's casters are drawn depth only into its
+// tile with one multi-draw. The cost is one pass per changed light, over only the casters it can see.
+class SpotShadowRenderer
+{
+public:
+    SpotShadowRenderer(unsigned int atlasSize = 4096, unsigned int minTileSize = 64, unsigned int maxTileSize = 1024);
+    ~SpotShadowRenderer();
+
+    // Places every light in the atlas. Tell the atlas about moved casters (GetAtlas().MarkCasterMoved) before this.
+    void Update(std::vector<SpotLight>& lights, glm::vec3 cameraPosition, float projectionScale);
+
+    // Draws the tiles that need it, with the lights given to Update. The pool's instances must still be submitted
+    // (before Clear), and whatever it had prepared is replaced by the casters, so draw everything else first.
+    // depthMaterial only needs a "cameraView" matrix, like the depth pre-pass.
+    void Render(MeshPool* pool, std::vector<SpotLight>& lights, Material* depthMaterial);
+
+    // One entry per light for LightBuffer::Update.
+    std::vector<SpotShadow>& GetShadows();
+
+    ShadowAtlas& GetAtlas();
+
+    // From the last Render: how many casters were drawn (over every light), and how long culling them took.
+    unsigned int GetCasterCount();
+    float GetCullTimeMs();
+
+    // The depth texture, set up for shadow comparisons (sample it with a sampler2DShadow).
+    Texture* GetAtlasTexture();
+
+private:
+    ShadowAtlas m_atlas;
+    Texture* m_atlasTexture;
+    GLuint m_frameBuffer;
+
+    std::vector<SpotShadow> m_shadows;
+
+    ShadowCasterCuller m_casterCuller;
+    std::vector<DrawElementsIndirectCommand> m_casterCommands;
+    std::vector<glm::mat4> m_casterMatrices;
+    std::vector<unsigned int> m_firstCasterCommands;
+
+    unsigned int m_casterCount = 0;
+    float m_cullTimeMs = 0;
+};
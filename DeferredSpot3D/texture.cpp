@@ -22,39 +22,105 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "texture.h"
+#include "textureManager.h"
 
 
-Texture::Texture(char* filePath, GLint sampleMode)
+float Texture::s_defaultAnisotropy = 8;
+
+Texture::Texture(char* filePath, GLint sampleMode, bool mipmaps)
 {
-    // Load the file.
-    FIBITMAP* bitmap = FreeImage_Load(FreeImage_GetFileType(filePath), filePath);
-    // Convert the file to 32 bits so we can use it.
-    FIBITMAP* bitmap32 = FreeImage_ConvertTo32Bits(bitmap);
+    // Load the file into memory, then hand it to OpenGL.
+    DecodedImage image;
+    ImageDecoder::Decode(filePath, image);
+    Upload(image, sampleMode, mipmaps);
+}
+
+Texture::Texture(DecodedImage& image, GLint sampleMode, bool mipmaps)
+{
+    Upload(image, sampleMode, mipmaps);
+}
 
+std::vector<Texture*> Texture::Load(const std::vector<char*>& filePaths, GLint sampleMode, bool mipmaps)
+{
+    // Decode every file at once on worker threads, then create the textures here, where the GL context is.
+    std::vector<DecodedImage> images;
+    ImageDecoder::DecodeAll(filePaths, images);
+
+    std::vector<Texture*> textures;
+    for (unsigned int i = 0; i < images.size(); i++)
+    {
+        textures.push_back(new Texture(images[i], sampleMode, mipmaps));
+    }
+    return textures;
+}
 
+void Texture::Upload(DecodedImage& image, GLint sampleMode, bool mipmaps)
+{
     // Create an OpenGL texture.
     glGenTextures(1, &m_texture);
 
+    if (!image.m_loaded)
+    {
+        std::cout << "Texture " << image.m_filePath << " could not be loaded." << std::endl;
+        return;
+    }
+
+    // With a texture manager, only the coarse levels are uploaded now. The rest come in once they're needed.
+    if (mipmaps && TextureManager::GetActive() != nullptr && TextureManager::GetActive()->Register(this, image, sampleMode))
+    {
+        return;
+    }
+
+    m_width = image.m_width;
+    m_height = image.m_height;
+
     // Bind our texture.
     glBindTexture(GL_TEXTURE_2D, m_texture);
 
-    // Fill our openGL side texture object.
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, FreeImage_GetWidth(bitmap32), FreeImage_GetHeight(bitmap32),
-        0, GL_BGRA, GL_UNSIGNED_BYTE, static_cast<void*>(FreeImage_GetBits(bitmap32)));
+    if (image.IsCompressed())
+    {
+        // Block compressed files go straight to the GPU, which decodes the blocks while sampling.
+        // The mips come from the file. They can't be generated on the GPU, so a file without them only has level 0.
+        CompressedImage& compressed = image.m_compressed;
+        m_levels = mipmaps ? compressed.m_levels.size() : 1;
+        glTexStorage2D(GL_TEXTURE_2D, m_levels, compressed.m_internalFormat, m_width, m_height);
+
+        for (unsigned int i = 0; i < m_levels; i++)
+        {
+            unsigned int levelWidth = m_width >> i;
+            unsigned int levelHeight = m_height >> i;
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, levelWidth > 0 ? levelWidth : 1, levelHeight > 0 ? levelHeight : 1,
+                compressed.m_internalFormat, compressed.m_levels[i].size(), compressed.m_levels[i].data());
+        }
+    }
+    else
+    {
+        m_levels = mipmaps ? GetMipLevelCount(m_width, m_height) : 1;
+
+        // Allocate every level up front. The size can't change after this, which lets the driver skip some checks.
+        glTexStorage2D(GL_TEXTURE_2D, m_levels, GL_RGBA8, m_width, m_height);
+
+        // Fill our openGL side texture object.
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_BGRA, GL_UNSIGNED_BYTE, image.m_pixels.data());
+
+        // Each smaller level is filtered down from the one above it on the GPU.
+        // Minified surfaces then read a level close to their size on screen, instead of skipping over most of the full image,
+        // which aliases and misses the texture cache.
+        if (mipmaps)
+        {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+    }
 
 
     // Set texture sampling parameters
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, sampleMode);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, sampleMode);
 
     // Unbind the texture.
     glBindTexture(GL_TEXTURE_2D, 0);
 
-    // We can unload the images now that the texture data has been buffered with opengl
-    FreeImage_Unload(bitmap);
-    FreeImage_Unload(bitmap32);
+    SetFiltering(sampleMode, mipmaps, s_defaultAnisotropy);
 }
 
 Texture::Texture(unsigned int width, unsigned int height, GLenum format, GLenum type, GLint sampleMode)
@@ -67,6 +133,52 @@ Texture::Texture(unsigned int width, unsigned int height, GLenum format, GLenum
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+Texture::Texture(glm::vec4 color)
+{
+    unsigned char texel[4];
+    for (int i = 0; i < 4; i++)
+    {
+        texel[i] = (unsigned char)(glm::clamp(color[i], 0.0f, 1.0f) * 255 + .5f);
+    }
+
+    m_width = 1;
+    m_height = 1;
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+Texture::Texture(unsigned int width, unsigned int height, GLenum internalFormat, GLenum format, GLenum type, GLint sampleMode, unsigned int levels)
+{
+    glGenTextures(1, &m_texture);
+    Resize(width, height, internalFormat, format, type, levels);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, sampleMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, sampleMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+Texture::Texture(glm::uvec3 size, GLenum internalFormat, GLint sampleMode)
+{
+    m_width = size.x;
+    m_height = size.y;
+    m_target = GL_TEXTURE_2D_ARRAY;
+
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, internalFormat, size.x, size.y, size.z);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, sampleMode);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, sampleMode);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
 Texture::~Texture()
 {
     glDeleteTextures(1, &m_texture);
@@ -91,9 +203,209 @@ GLuint Texture::GetGLTexture()
     return m_texture;
 }
 
+GLenum Texture::GetGLTarget()
+{
+    return m_target;
+}
+
 void Texture::Resize(unsigned int width, unsigned int height, GLenum format, GLenum type)
 {
     glBindTexture(GL_TEXTURE_2D, m_texture);
     glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, type, NULL);
     glBindTexture(GL_TEXTURE_2D, 0);
 }
+
+void Texture::Resize(unsigned int width, unsigned int height, GLenum internalFormat, GLenum format, GLenum type, unsigned int levels)
+{
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+
+    // Each level is half the size of the one before it (but never smaller than 1).
+    for (unsigned int i = 0; i < levels; i++)
+    {
+        unsigned int levelWidth = width >> i;
+        unsigned int levelHeight = height >> i;
+        glTexImage2D(GL_TEXTURE_2D, i, internalFormat, levelWidth > 0 ? levelWidth : 1, levelHeight > 0 ? levelHeight : 1, 0, format, type, NULL);
+    }
+
+    // Tell OpenGL how many levels there are, so the texture is complete.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::Allocate(unsigned int width, unsigned int height, GLenum internalFormat, unsigned int levels)
+{
+    // Storage from glTexStorage2D can't change size or format, so start over with a new texture.
+    glDeleteTextures(1, &m_texture);
+    glGenTextures(1, &m_texture);
+
+    m_width = width;
+    m_height = height;
+    m_levels = levels;
+
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::Replace(GLuint texture, unsigned int width, unsigned int height, unsigned int levels)
+{
+    glDeleteTextures(1, &m_texture);
+    m_texture = texture;
+    m_width = width;
+    m_height = height;
+    m_levels = levels;
+}
+
+void Texture::SetFiltering(GLint sampleMode, bool mipmaps, float anisotropy)
+{
+    m_sampleMode = sampleMode;
+    m_mipmaps = mipmaps;
+    m_anisotropy = anisotropy;
+
+    // Pick the mipmapped version of the filter. Linear between levels too (trilinear) so there are no visible seams.
+    GLint minFilter = sampleMode;
+    if (mipmaps && m_levels > 1)
+    {
+        minFilter = (sampleMode == GL_NEAREST) ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, sampleMode);
+
+    // Anisotropic filtering takes extra samples along the direction the texture is squashed in,
+    // so surfaces seen at a steep angle stay sharp instead of dropping to a blurry level.
+    float maxAnisotropy = GetMaxAnisotropy();
+    if (maxAnisotropy > 1)
+    {
+        if (anisotropy < 1)
+            anisotropy = 1;
+        if (anisotropy > maxAnisotropy)
+            anisotropy = maxAnisotropy;
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::RestoreFiltering()
+{
+    SetFiltering(m_sampleMode, m_mipmaps, m_anisotropy);
+}
+
+unsigned int Texture::GetWidth()
+{
+    return m_width;
+}
+
+unsigned int Texture::GetHeight()
+{
+    return m_height;
+}
+
+unsigned int Texture::GetLevelCount()
+{
+    return m_levels;
+}
+
+unsigned int Texture::GetRefCount()
+{
+    return m_refCount;
+}
+
+unsigned long long Texture::GetMemorySize()
+{
+    glBindTexture(m_target, m_texture);
+    unsigned long long size = GetBoundMemorySize(m_target);
+    glBindTexture(m_target, 0);
+    return size;
+}
+
+int Texture::GetFeedbackSlot()
+{
+    return m_feedbackSlot;
+}
+
+void Texture::SetFeedbackSlot(int slot)
+{
+    m_feedbackSlot = slot;
+}
+
+unsigned int Texture::GetMipLevelCount(unsigned int width, unsigned int height)
+{
+    unsigned int size = width > height ? width : height;
+    unsigned int levels = 1;
+    while (size > 1)
+    {
+        size >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+unsigned long long Texture::GetBoundMemorySize(GLenum levelTarget)
+{
+    unsigned long long total = 0;
+
+    // Levels that don't exist have a width of 0, so keep going until there isn't one.
+    for (GLint level = 0; level < 32; level++)
+    {
+        GLint width = 0;
+        GLint height = 0;
+        glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_HEIGHT, &height);
+        if (width == 0 || height == 0)
+        {
+            break;
+        }
+
+        GLint compressed = GL_FALSE;
+        glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_COMPRESSED, &compressed);
+        if (compressed == GL_TRUE)
+        {
+            GLint size = 0;
+            glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+            total += size;
+            continue;
+        }
+
+        // Add up the bits of every channel the format has (unused channels are 0).
+        GLenum channels[] = { GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE, GL_TEXTURE_BLUE_SIZE,
+            GL_TEXTURE_ALPHA_SIZE, GL_TEXTURE_DEPTH_SIZE, GL_TEXTURE_STENCIL_SIZE };
+        GLint bits = 0;
+        for (int i = 0; i < 6; i++)
+        {
+            GLint channelBits = 0;
+            glGetTexLevelParameteriv(levelTarget, level, channels[i], &channelBits);
+            bits += channelBits;
+        }
+        // Arrays have a depth of one layer per image.
+        GLint depth = 1;
+        glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_DEPTH, &depth);
+        total += (unsigned long long)width * height * glm::max(depth, 1) * bits / 8;
+    }
+    return total;
+}
+
+float Texture::GetMaxAnisotropy()
+{
+    if (!GLEW_ARB_texture_filter_anisotropic && !GLEW_EXT_texture_filter_anisotropic)
+    {
+        return 1;
+    }
+    GLfloat maxAnisotropy = 1;
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+    return maxAnisotropy;
+}
+
+void Texture::SetDefaultAnisotropy(float anisotropy)
+{
+    s_defaultAnisotropy = anisotropy;
+}
+
+float Texture::GetDefaultAnisotropy()
+{
+    return s_defaultAnisotropy;
+}
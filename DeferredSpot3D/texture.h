@@ -25,7 +25,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "GL/glew.h"
 #include "GLFW/glfw3.h"
 #include "FreeImage.h"
+#include "glm/glm.hpp"
 #include <iostream>
+#include <vector>
+
+#include "imageDecoder.h"
 
 class Texture
 {
@@ -33,13 +37,93 @@ private:
     GLuint m_texture;
     unsigned int m_refCount = 0;
 
+    // Size of level 0 and how many mip levels there are.
+    unsigned int m_width = 0;
+    unsigned int m_height = 0;
+    unsigned int m_levels = 1;
+
+    // GL_TEXTURE_2D, or GL_TEXTURE_2D_ARRAY for an array of textures.
+    GLenum m_target = GL_TEXTURE_2D;
+
+    // The filtering last given to SetFiltering, so it can be put back when the GL texture is replaced.
+    GLint m_sampleMode = GL_LINEAR;
+    bool m_mipmaps = true;
+    float m_anisotropy = 1;
+
+    // Where the texture manager wants mip feedback for this texture written, -1 if it isn't managed.
+    int m_feedbackSlot = -1;
+
 public:
-    Texture(char* filePath, GLint sampleMode);
+    // Loads an image. With mipmaps, the whole mip chain is generated on the GPU, and the texture is sampled
+    // with trilinear filtering (and the default anisotropy) so far away surfaces read from small levels.
+    // .dds and .ktx2 files stay block compressed on the GPU, and use the mip levels stored in the file.
+    Texture(char* filePath, GLint sampleMode, bool mipmaps = true);
+    // Creates a texture from an image that was already loaded (see imageDecoder.h).
+    Texture(DecodedImage& image, GLint sampleMode, bool mipmaps = true);
     Texture(unsigned int width, unsigned int height, GLenum format, GLenum type, GLint sampleMode);
+    // Creates a 1x1 texture of a single color, to stand in for a texture that hasn't loaded yet.
+    Texture(glm::vec4 color);
+    // Creates an empty texture with a sized internal format and a full set of mip levels.
+    Texture(unsigned int width, unsigned int height, GLenum internalFormat, GLenum format, GLenum type, GLint sampleMode, unsigned int levels);
+    // Creates an empty array of textures (GL_TEXTURE_2D_ARRAY) with one mip level, size.z textures of size.x by size.y.
+    Texture(glm::uvec3 size, GLenum internalFormat, GLint sampleMode);
     ~Texture();
     void IncRefCount();
     void DecRefCount();
     GLuint GetGLTexture();
+    // What to bind the texture to.
+    GLenum GetGLTarget();
     void Resize(unsigned int width, unsigned int height, GLenum format, GLenum type);
+    void Resize(unsigned int width, unsigned int height, GLenum internalFormat, GLenum format, GLenum type, unsigned int levels);
+
+    // Replaces the texture with new, empty storage (glTexStorage2D) to upload into.
+    // The GL texture name changes, anything that needs it has to ask GetGLTexture again.
+    void Allocate(unsigned int width, unsigned int height, GLenum internalFormat, unsigned int levels);
+
+    // Takes ownership of a different GL texture (deleting the current one), which has the given size and levels.
+    void Replace(GLuint texture, unsigned int width, unsigned int height, unsigned int levels);
+
+    // Changes how the texture is sampled.
+    // sampleMode is GL_LINEAR or GL_NEAREST, and mipmaps picks the matching mipmapped filter (if the texture has mips).
+    // Anisotropy is clamped to what the driver supports, 1 turns it off.
+    void SetFiltering(GLint sampleMode, bool mipmaps, float anisotropy);
+    // Applies the last SetFiltering again, for a new GL texture taken over with Replace.
+    void RestoreFiltering();
+
+    unsigned int GetWidth();
+    unsigned int GetHeight();
+    unsigned int GetLevelCount();
+
+    // How many references are held, and how much GPU memory every level takes up (asked from the driver).
+    unsigned int GetRefCount();
+    unsigned long long GetMemorySize();
+
+    // Set by the texture manager (textureManager.h), materials pass it to the shader.
+    int GetFeedbackSlot();
+    void SetFeedbackSlot(int slot);
+
+    // The number of levels in a full mip chain, down to 1x1.
+    static unsigned int GetMipLevelCount(unsigned int width, unsigned int height);
+
+    // Adds up the size of every level of the texture that is bound, with levelTarget being GL_TEXTURE_2D,
+    // one of the cube map faces, or an array target. Compressed levels use their real size, others their bits per texel.
+    static unsigned long long GetBoundMemorySize(GLenum levelTarget);
+
+    // The highest anisotropy the driver supports (1 if it doesn't support anisotropic filtering).
+    static float GetMaxAnisotropy();
+
+    // The anisotropy loaded textures start with.
+    static void SetDefaultAnisotropy(float anisotropy);
+    static float GetDefaultAnisotropy();
+
+    // Loads a batch of images. The files are decoded in parallel on worker threads, and then uploaded together.
+    // Returns one texture per path, in the same order.
+    static std::vector<Texture*> Load(const std::vector<char*>& filePaths, GLint sampleMode, bool mipmaps = true);
+
+private:
+    static float s_defaultAnisotropy;
+
+    // Creates the GL texture and fills it with the image.
+    void Upload(DecodedImage& image, GLint sampleMode, bool mipmaps);
 
 };
\ No newline at end of file
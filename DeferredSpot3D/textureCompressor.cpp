@@ -0,0 +1,126 @@
+/*
+Title: Deferred Spot Lighting
+File Name: textureCompressor.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "textureCompressor.h"
+
+int TextureCompressor::Run(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cout << "Usage: --compress <input image> <output.dds> <bc1|bc3|bc5|bc7>" << std::endl;
+        return 1;
+    }
+
+    std::string format = argv[2];
+    GLenum internalFormat = 0;
+    if (format == "bc1")
+    {
+        internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    }
+    else if (format == "bc3")
+    {
+        internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+    else if (format == "bc5")
+    {
+        internalFormat = GL_COMPRESSED_RG_RGTC2;
+    }
+    else if (format == "bc7")
+    {
+        internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+    else
+    {
+        std::cout << "Unknown format " << format << ", use bc1, bc3, bc5 or bc7." << std::endl;
+        return 1;
+    }
+
+    return CompressFile(argv[0], argv[1], internalFormat, internalFormat == GL_COMPRESSED_RG_RGTC2) ? 0 : 1;
+}
+
+bool TextureCompressor::CompressFile(const char* inputPath, const char* outputPath, GLenum internalFormat, bool normalMap)
+{
+    DecodedImage decoded;
+    if (!ImageDecoder::Decode(inputPath, decoded) || decoded.IsCompressed())
+    {
+        std::cout << "Could not load " << inputPath << " as an uncompressed image." << std::endl;
+        return false;
+    }
+    unsigned int width = decoded.m_width;
+    unsigned int height = decoded.m_height;
+
+    // The decoder gives us bgra, the compressor wants rgba.
+    // Rows stay in FreeImage's order (bottom first), which is also the order glTexImage2D gets them in.
+    std::vector<unsigned char> level(width * height * 4);
+    for (unsigned int i = 0; i < width * height; i++)
+    {
+        level[i * 4 + 0] = decoded.m_pixels[i * 4 + FI_RGBA_RED];
+        level[i * 4 + 1] = decoded.m_pixels[i * 4 + FI_RGBA_GREEN];
+        level[i * 4 + 2] = decoded.m_pixels[i * 4 + FI_RGBA_BLUE];
+        level[i * 4 + 3] = decoded.m_pixels[i * 4 + FI_RGBA_ALPHA];
+    }
+
+    CompressedImage image;
+    image.m_internalFormat = internalFormat;
+    image.m_width = width;
+    image.m_height = height;
+
+    // Compress each level, then filter it down to make the next one, all the way to 1x1.
+    // Each level is made from the uncompressed level above it, so the compression errors don't pile up.
+    unsigned int levelWidth = width;
+    unsigned int levelHeight = height;
+    unsigned int uncompressedSize = 0;
+    while (true)
+    {
+        image.m_levels.push_back(std::vector<unsigned char>());
+        BlockCompressor::Compress(level.data(), levelWidth, levelHeight, internalFormat, image.m_levels.back());
+        uncompressedSize += levelWidth * levelHeight * 4;
+
+        if (levelWidth == 1 && levelHeight == 1)
+        {
+            break;
+        }
+
+        std::vector<unsigned char> next;
+        BlockCompressor::Downsample(level, levelWidth, levelHeight, next, normalMap);
+        level.swap(next);
+        levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+        levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+    }
+
+    if (!image.SaveDDS(outputPath))
+    {
+        return false;
+    }
+
+    unsigned int compressedSize = 0;
+    for (unsigned int i = 0; i < image.m_levels.size(); i++)
+    {
+        compressedSize += image.m_levels[i].size();
+    }
+    std::cout << inputPath << " -> " << outputPath << ": " << width << "x" << height << ", " << image.m_levels.size() << " levels, "
+        << uncompressedSize / 1024 << " KB as RGBA8, " << compressedSize / 1024 << " KB compressed ("
+        << (float)uncompressedSize / compressedSize << "x smaller)" << std::endl;
+    return true;
+}
@@ -0,0 +1,52 @@
+/*
+Title: Deferred Spot Lighting
+File Name: textureCompressor.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "FreeImage.h"
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "compressedImage.h"
+#include "imageDecoder.h"
+#include "blockCompressor.h"
+
+// Offline tool that converts images (png, jpg, anything FreeImage loads) into block compressed DDS files with a full mip chain.
+// It's built into the program, and runs instead of the demo when the first argument is --compress:
+//
+//     DeferredSpot3D --compress <input image> <output.dds> <bc1|bc3|bc5|bc7>
+//
+// bc1 suits opaque color maps, bc3 and bc7 keep alpha, and bc5 is for normal maps
+// (only x and y are stored, diffuseNormalFrag.glsl rebuilds z).
+class TextureCompressor
+{
+public:
+    // Runs the tool with the arguments that come after --compress. Returns the program's exit code.
+    static int Run(int argc, char** argv);
+
+    // Loads an image, builds its mip chain and compresses every level.
+    // Normal maps have their mip levels renormalized.
+    static bool CompressFile(const char* inputPath, const char* outputPath, GLenum internalFormat, bool normalMap);
+};
@@ -0,0 +1,289 @@
+/*
+Title: Deferred Spot Lighting
+File Name: textureManager.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "textureManager.h"
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+
+TextureManager* TextureManager::s_active = nullptr;
+
+TextureManager::TextureManager(unsigned long long budget)
+    : m_residency(budget)
+{
+    glGenBuffers(TEXTURE_FEEDBACK_FRAMES, m_feedbackBuffers);
+    for (int i = 0; i < TEXTURE_FEEDBACK_FRAMES; i++)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_feedbackBuffers[i]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, TEXTURE_FEEDBACK_CAPACITY * sizeof(GLuint), NULL, GL_DYNAMIC_READ);
+        m_feedbackFences[i] = 0;
+        m_feedbackFrames[i] = 0;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+TextureManager::~TextureManager()
+{
+    if (s_active == this)
+    {
+        s_active = nullptr;
+    }
+
+    for (int i = 0; i < TEXTURE_FEEDBACK_FRAMES; i++)
+    {
+        if (m_feedbackFences[i] != 0)
+        {
+            glDeleteSync(m_feedbackFences[i]);
+        }
+    }
+    glDeleteBuffers(TEXTURE_FEEDBACK_FRAMES, m_feedbackBuffers);
+
+    for (unsigned int i = 0; i < m_textures.size(); i++)
+    {
+        m_textures[i].m_texture->SetFeedbackSlot(-1);
+        m_textures[i].m_texture->DecRefCount();
+    }
+}
+
+void TextureManager::SetActive(TextureManager* manager)
+{
+    s_active = manager;
+}
+
+TextureManager* TextureManager::GetActive()
+{
+    return s_active;
+}
+
+bool TextureManager::Register(Texture* texture, DecodedImage& image, GLint sampleMode)
+{
+    if (!image.m_loaded || m_textures.size() >= TEXTURE_FEEDBACK_CAPACITY)
+    {
+        return false;
+    }
+
+    ManagedTexture managed;
+    managed.m_texture = texture;
+    managed.m_width = image.m_width;
+    managed.m_height = image.m_height;
+
+    unsigned int levelCount = Texture::GetMipLevelCount(image.m_width, image.m_height);
+    if (image.IsCompressed())
+    {
+        // Compressed levels can't be made here, the file has to have all of them.
+        if (image.m_compressed.m_levels.size() != levelCount)
+        {
+            return false;
+        }
+        managed.m_internalFormat = image.m_compressed.m_internalFormat;
+        managed.m_levels = image.m_compressed.m_levels;
+    }
+    else
+    {
+        // Build the mip chain on the CPU, the same box filter the texture compressor uses.
+        managed.m_internalFormat = GL_RGBA8;
+        managed.m_levels.resize(levelCount);
+        managed.m_levels[0] = image.m_pixels;
+        for (unsigned int i = 1; i < levelCount; i++)
+        {
+            BlockCompressor::Downsample(managed.m_levels[i - 1], glm::max(image.m_width >> (i - 1), 1u), glm::max(image.m_height >> (i - 1), 1u),
+                managed.m_levels[i], false);
+        }
+    }
+
+    // The first level small enough to always keep.
+    unsigned int coarseLevel = 0;
+    while (coarseLevel < levelCount - 1 && glm::max(image.m_width >> coarseLevel, image.m_height >> coarseLevel) > TEXTURE_COARSE_SIZE)
+    {
+        coarseLevel++;
+    }
+
+    std::vector<unsigned int> levelSizes;
+    for (unsigned int i = 0; i < levelCount; i++)
+    {
+        levelSizes.push_back(managed.m_levels[i].size());
+    }
+
+    // Nothing is on the GPU yet.
+    managed.m_residentLevel = levelCount;
+
+    unsigned int id = m_residency.Add(levelSizes, coarseLevel);
+    m_textures.push_back(managed);
+
+    texture->IncRefCount();
+
+    // The filtering every GPU copy of the texture gets, until something changes it (SetFiltering).
+    texture->SetFiltering(sampleMode, true, Texture::GetDefaultAnisotropy());
+    texture->SetFeedbackSlot(id);
+    Apply(id);
+    return true;
+}
+
+void TextureManager::BeginFeedback()
+{
+    unsigned int index = m_frame % TEXTURE_FEEDBACK_FRAMES;
+
+    // This buffer's feedback from a few frames ago wasn't picked up yet (Update only takes what's finished),
+    // it's certainly done by now.
+    if (m_feedbackFences[index] != 0)
+    {
+        ReadFeedback(index);
+    }
+
+    // Zero means the texture wasn't drawn.
+    GLuint zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_feedbackBuffers[index]);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TEXTURE_FEEDBACK_BINDING, m_feedbackBuffers[index]);
+    m_feedbackFrames[index] = m_frame;
+}
+
+void TextureManager::EndFeedback()
+{
+    unsigned int index = m_frame % TEXTURE_FEEDBACK_FRAMES;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TEXTURE_FEEDBACK_BINDING, 0);
+
+    // Make the shader's writes visible to glGetBufferSubData, and mark when they're done.
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    m_feedbackFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void TextureManager::Update()
+{
+    // Read whatever feedback the GPU has finished, without waiting for the rest.
+    for (unsigned int i = 0; i < TEXTURE_FEEDBACK_FRAMES; i++)
+    {
+        if (m_feedbackFences[i] == 0)
+        {
+            continue;
+        }
+        GLenum result = glClientWaitSync(m_feedbackFences[i], 0, 0);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+        {
+            ReadFeedback(i);
+        }
+    }
+
+    std::vector<unsigned int> changed;
+    m_residency.Update(changed);
+    for (unsigned int i = 0; i < changed.size(); i++)
+    {
+        Apply(changed[i]);
+    }
+
+    m_frame++;
+}
+
+void TextureManager::ReadFeedback(unsigned int index)
+{
+    glDeleteSync(m_feedbackFences[index]);
+    m_feedbackFences[index] = 0;
+
+    if (m_textures.size() == 0)
+    {
+        return;
+    }
+
+    std::vector<GLuint> feedback(m_textures.size());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_feedbackBuffers[index]);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, feedback.size() * sizeof(GLuint), feedback.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    for (unsigned int i = 0; i < feedback.size(); i++)
+    {
+        if (feedback[i] == 0)
+        {
+            continue;
+        }
+
+        // The shader wrote log2 of the largest size (in texels) the texture needed, in 16ths, plus one.
+        // A level that size has about one texel per pixel, and anything finer would be wasted.
+        float neededSize = (feedback[i] - 1) / 16.0f;
+        float fullSize = std::log2((float)glm::max(m_textures[i].m_width, m_textures[i].m_height));
+        int level = (int)std::floor(fullSize - neededSize);
+        m_residency.Request(i, glm::max(level, 0), m_feedbackFrames[index]);
+    }
+}
+
+void TextureManager::Apply(unsigned int id)
+{
+    ManagedTexture& managed = m_textures[id];
+    unsigned int resident = m_residency.GetResidentLevel(id);
+    unsigned int levelCount = managed.m_levels.size();
+    unsigned int width = glm::max(managed.m_width >> resident, 1u);
+    unsigned int height = glm::max(managed.m_height >> resident, 1u);
+    bool compressed = managed.m_internalFormat != GL_RGBA8;
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, levelCount - resident, managed.m_internalFormat, width, height);
+
+    GLuint oldTexture = managed.m_texture->GetGLTexture();
+    for (unsigned int level = resident; level < levelCount; level++)
+    {
+        unsigned int levelWidth = glm::max(managed.m_width >> level, 1u);
+        unsigned int levelHeight = glm::max(managed.m_height >> level, 1u);
+
+        if (level >= managed.m_residentLevel)
+        {
+            // Already on the GPU, copy it over without going through the CPU.
+            glCopyImageSubData(oldTexture, GL_TEXTURE_2D, level - managed.m_residentLevel, 0, 0, 0,
+                texture, GL_TEXTURE_2D, level - resident, 0, 0, 0, levelWidth, levelHeight, 1);
+        }
+        else if (compressed)
+        {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, level - resident, 0, 0, levelWidth, levelHeight,
+                managed.m_internalFormat, managed.m_levels[level].size(), managed.m_levels[level].data());
+        }
+        else
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, level - resident, 0, 0, levelWidth, levelHeight, GL_BGRA, GL_UNSIGNED_BYTE, managed.m_levels[level].data());
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    managed.m_texture->Replace(texture, width, height, levelCount - resident);
+    // Keep whatever filtering the texture had, the M key's comparison included.
+    managed.m_texture->RestoreFiltering();
+    managed.m_residentLevel = resident;
+}
+
+MipResidency& TextureManager::GetResidency()
+{
+    return m_residency;
+}
+
+std::string TextureManager::GetReport()
+{
+    std::stringstream report;
+    report << std::fixed << std::setprecision(1) << "Textures: " << m_residency.GetResidentBytes() / (1024.0 * 1024.0)
+        << "/" << m_residency.GetBudget() / (1024.0 * 1024.0) << " MB";
+    return report.str();
+}
@@ -0,0 +1,115 @@
+/*
+Title: Deferred Spot Lighting
+File Name: textureManager.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "texture.h"
+#include "imageDecoder.h"
+#include "blockCompressor.h"
+#include "mipResidency.h"
+
+// How many frames of feedback are in flight, so reading one back never waits on the GPU.
+#define TEXTURE_FEEDBACK_FRAMES 3
+// The most textures that can be managed at once (the size of the feedback buffer).
+#define TEXTURE_FEEDBACK_CAPACITY 4096
+// Must match the binding in textureFeedback.glsl
+#define TEXTURE_FEEDBACK_BINDING 5
+// Levels this big or smaller are always in memory, so there is always something to draw with.
+#define TEXTURE_COARSE_SIZE 64
+
+// Keeps texture memory under a budget by only keeping the mip levels that are actually needed.
+//
+// While a manager is active, mipmapped textures loaded from files are handed to it instead of being uploaded whole.
+// The manager keeps every level in system memory, but only puts the coarse ones on the GPU to start with.
+// During the geometry pass, shaders that include textureFeedback.glsl write how large each texture appears
+// on screen into a feedback buffer. A few frames later that is read back, and MipResidency decides which finer
+// levels to load and which least recently used levels to evict to stay under the budget.
+//
+// Changing which levels are resident makes a new texture with just those levels, copies the levels it already
+// had on the GPU (glCopyImageSubData), and uploads the new ones. Materials pick up the new texture on their next Bind.
+class TextureManager
+{
+public:
+    // budget is in bytes of GPU memory.
+    TextureManager(unsigned long long budget);
+    ~TextureManager();
+
+    // The manager new textures are given to. nullptr (the default) loads textures whole, like normal.
+    static void SetActive(TextureManager* manager);
+    static TextureManager* GetActive();
+
+    // Takes over a texture being loaded from an image, and uploads its coarse levels.
+    // Returns false if the texture can't be managed (it should then be uploaded normally).
+    bool Register(Texture* texture, DecodedImage& image, GLint sampleMode);
+
+    // Call around the passes that draw managed textures. Begin binds this frame's (cleared) feedback buffer.
+    void BeginFeedback();
+    void EndFeedback();
+
+    // Reads back finished feedback and loads or evicts levels. Call once a frame, after EndFeedback.
+    void Update();
+
+    MipResidency& GetResidency();
+
+    // Resident memory compared to the budget, for the window title.
+    std::string GetReport();
+
+private:
+    struct ManagedTexture
+    {
+        Texture* m_texture;
+        GLenum m_internalFormat;
+        unsigned int m_width;
+        unsigned int m_height;
+
+        // Every level, kept in system memory so any of them can be uploaded again later.
+        std::vector<std::vector<unsigned char>> m_levels;
+
+        // The finest level the GPU texture has right now.
+        unsigned int m_residentLevel;
+    };
+
+    // Rebuilds a texture's GPU copy to match its resident level.
+    void Apply(unsigned int id);
+
+    // Turns one frame's feedback into requests.
+    void ReadFeedback(unsigned int index);
+
+    static TextureManager* s_active;
+
+    std::vector<ManagedTexture> m_textures;
+    MipResidency m_residency;
+
+    GLuint m_feedbackBuffers[TEXTURE_FEEDBACK_FRAMES];
+    GLsync m_feedbackFences[TEXTURE_FEEDBACK_FRAMES];
+    unsigned int m_feedbackFrames[TEXTURE_FEEDBACK_FRAMES];
+
+    // Counts up by one every Update. Starts at 1, since 0 means "never used" to MipResidency.
+    unsigned int m_frame = 1;
+};
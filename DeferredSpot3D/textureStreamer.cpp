@@ -0,0 +1,457 @@
+/*
+Title: Deferred Spot Lighting
+File Name: textureStreamer.cpp
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "textureStreamer.h"
+
+TextureStreamer::TextureStreamer(unsigned int slotCount, unsigned int slotSize, unsigned int workerCount)
+{
+    m_slotSize = slotSize;
+    m_slots.resize(slotCount);
+
+    // Allocate the staging ring and map it once, for good. Persistent mapping lets the workers write into it
+    // while the buffer is in use, and coherent means we don't have to flush what they wrote.
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+    if (GLEW_ARB_buffer_storage)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr size = (GLsizeiptr)slotCount * slotSize;
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+        m_mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (m_mapped == nullptr)
+    {
+        std::cout << "Persistent buffer mapping is not supported, textures will be uploaded without staging buffers." << std::endl;
+    }
+
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        m_workers.push_back(std::thread(&TextureStreamer::Run, this));
+    }
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    // Stop the workers. Anyone waiting for a job or a slot wakes up and leaves.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_jobAdded.notify_all();
+    m_slotFreed.notify_all();
+    for (unsigned int i = 0; i < m_workers.size(); i++)
+    {
+        m_workers[i].join();
+    }
+
+    // Let go of everything that never made it.
+    std::vector<Job*> jobs(m_queued.begin(), m_queued.end());
+    jobs.insert(jobs.end(), m_finished.begin(), m_finished.end());
+    jobs.insert(jobs.end(), m_uploads.begin(), m_uploads.end());
+    for (unsigned int i = 0; i < jobs.size(); i++)
+    {
+        if (jobs[i]->m_texture != nullptr)
+        {
+            jobs[i]->m_texture->DecRefCount();
+        }
+        if (jobs[i]->m_cubeMap != nullptr)
+        {
+            jobs[i]->m_cubeMap->DecRefCount();
+        }
+        delete jobs[i];
+    }
+
+    for (unsigned int i = 0; i < m_slots.size(); i++)
+    {
+        if (m_slots[i].m_fence != 0)
+        {
+            glDeleteSync(m_slots[i].m_fence);
+        }
+    }
+
+    if (m_mapped != nullptr)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &m_buffer);
+}
+
+Texture* TextureStreamer::Request(char* filePath, GLint sampleMode, bool mipmaps, glm::vec4 placeholderColor)
+{
+    Texture* texture = new Texture(placeholderColor);
+
+    Job* job = new Job();
+    job->m_filePath = filePath;
+    job->m_texture = texture;
+    job->m_sampleMode = sampleMode;
+    job->m_mipmaps = mipmaps;
+
+    // Hold on to the texture until it's uploaded.
+    texture->IncRefCount();
+    Enqueue(job);
+    return texture;
+}
+
+CubeMap* TextureStreamer::RequestCubeMap(std::vector<char*> filePaths, glm::vec4 placeholderColor)
+{
+    CubeMap* cubeMap = new CubeMap(placeholderColor);
+
+    // Each face is its own job, so the faces decode in parallel.
+    for (unsigned int i = 0; i < filePaths.size(); i++)
+    {
+        Job* job = new Job();
+        job->m_filePath = filePaths[i];
+        job->m_cubeMap = cubeMap;
+        job->m_face = i;
+
+        cubeMap->IncRefCount();
+        Enqueue(job);
+    }
+    return cubeMap;
+}
+
+void TextureStreamer::Update(unsigned int uploadBudget)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_uploads.insert(m_uploads.end(), m_finished.begin(), m_finished.end());
+        m_finished.clear();
+    }
+
+    // Spread big batches over several frames, so no single frame has to wait on all of them.
+    unsigned int uploaded = 0;
+    while (m_uploads.size() > 0 && (uploaded == 0 || uploaded < uploadBudget))
+    {
+        Job* job = m_uploads.front();
+        m_uploads.pop_front();
+        uploaded += Upload(job);
+        m_pending--;
+        delete job;
+    }
+
+    // Slots whose copies the GPU has finished can take new images.
+    bool freed = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (unsigned int i = 0; i < m_slots.size(); i++)
+        {
+            Slot& slot = m_slots[i];
+            if (slot.m_fence == 0)
+            {
+                continue;
+            }
+
+            // A timeout of 0 just checks, it never waits.
+            GLenum result = glClientWaitSync(slot.m_fence, 0, 0);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+            {
+                glDeleteSync(slot.m_fence);
+                slot.m_fence = 0;
+                slot.m_free = true;
+                freed = true;
+            }
+        }
+    }
+    if (freed)
+    {
+        m_slotFreed.notify_all();
+    }
+}
+
+unsigned int TextureStreamer::GetPendingCount()
+{
+    return m_pending;
+}
+
+void TextureStreamer::Enqueue(Job* job)
+{
+    m_pending++;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued.push_back(job);
+    }
+    m_jobAdded.notify_one();
+}
+
+void TextureStreamer::Run()
+{
+    while (true)
+    {
+        Job* job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobAdded.wait(lock, [this]() { return !m_running || m_queued.size() > 0; });
+            if (!m_running)
+            {
+                return;
+            }
+            job = m_queued.front();
+            m_queued.pop_front();
+        }
+
+        Decode(job);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished.push_back(job);
+    }
+}
+
+void TextureStreamer::Decode(Job* job)
+{
+    const char* filePath = job->m_filePath.c_str();
+
+    // Block compressed files are read whole, then their levels are copied into a slot one after another.
+    if (CompressedImage::IsCompressedFile(filePath))
+    {
+        CompressedImage& compressed = job->m_image.m_compressed;
+        if (!compressed.Load(filePath))
+        {
+            return;
+        }
+        job->m_width = compressed.m_width;
+        job->m_height = compressed.m_height;
+        job->m_internalFormat = compressed.m_internalFormat;
+
+        unsigned int size = 0;
+        for (unsigned int i = 0; i < compressed.m_levels.size(); i++)
+        {
+            job->m_levelSizes.push_back(compressed.m_levels[i].size());
+            size += compressed.m_levels[i].size();
+        }
+
+        if (m_mapped != nullptr && size <= m_slotSize)
+        {
+            job->m_slot = AcquireSlot();
+        }
+        if (job->m_slot >= 0)
+        {
+            unsigned char* destination = m_mapped + (size_t)job->m_slot * m_slotSize;
+            for (unsigned int i = 0; i < compressed.m_levels.size(); i++)
+            {
+                memcpy(destination, compressed.m_levels[i].data(), compressed.m_levels[i].size());
+                destination += compressed.m_levels[i].size();
+            }
+            compressed.m_levels.clear();
+        }
+        job->m_loaded = true;
+        return;
+    }
+
+    FREE_IMAGE_FORMAT fileType = FreeImage_GetFileType(filePath);
+    FIBITMAP* bitmap = fileType == FIF_UNKNOWN ? nullptr : FreeImage_Load(fileType, filePath);
+    if (bitmap == nullptr)
+    {
+        std::cout << "Could not load " << filePath << std::endl;
+        return;
+    }
+
+    job->m_width = FreeImage_GetWidth(bitmap);
+    job->m_height = FreeImage_GetHeight(bitmap);
+    job->m_internalFormat = GL_RGBA8;
+    job->m_levelSizes.push_back(job->m_width * job->m_height * 4);
+
+    if (m_mapped != nullptr && job->m_levelSizes[0] <= m_slotSize)
+    {
+        job->m_slot = AcquireSlot();
+    }
+
+    if (job->m_slot >= 0)
+    {
+        // Convert to 32 bit bgra directly into the staging memory, skipping the copy FreeImage_ConvertTo32Bits would make.
+        unsigned char* destination = m_mapped + (size_t)job->m_slot * m_slotSize;
+        FreeImage_ConvertToRawBits(destination, bitmap, job->m_width * 4, 32, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, FALSE);
+    }
+    else
+    {
+        FIBITMAP* bitmap32 = FreeImage_ConvertTo32Bits(bitmap);
+        unsigned char* bits = FreeImage_GetBits(bitmap32);
+        job->m_image.m_pixels.assign(bits, bits + job->m_levelSizes[0]);
+        FreeImage_Unload(bitmap32);
+    }
+
+    FreeImage_Unload(bitmap);
+    job->m_loaded = true;
+}
+
+int TextureStreamer::AcquireSlot()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running)
+    {
+        for (unsigned int i = 0; i < m_slots.size(); i++)
+        {
+            if (m_slots[i].m_free)
+            {
+                m_slots[i].m_free = false;
+                return i;
+            }
+        }
+        m_slotFreed.wait(lock);
+    }
+    return -1;
+}
+
+unsigned int TextureStreamer::Upload(Job* job)
+{
+    if (!job->m_loaded)
+    {
+        std::cout << "Texture " << job->m_filePath << " could not be streamed." << std::endl;
+    }
+    else if (job->m_cubeMap != nullptr && !MatchCubeFace(job))
+    {
+        // Nothing was read from the slot, so it's free right away.
+        if (job->m_slot >= 0)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_slots[job->m_slot].m_free = true;
+        }
+    }
+    else
+    {
+        bool compressed = job->m_internalFormat != GL_RGBA8;
+
+        // Compressed files bring their mips. The others get level 0, and textures generate the rest on the GPU.
+        // Cube maps have whatever the first face set them up with.
+        unsigned int levels = 1;
+        if (job->m_cubeMap != nullptr)
+        {
+            levels = job->m_cubeMap->GetLevelCount();
+        }
+        else if (job->m_mipmaps)
+        {
+            levels = compressed ? job->m_levelSizes.size() : Texture::GetMipLevelCount(job->m_width, job->m_height);
+        }
+
+        GLenum target;
+        if (job->m_texture != nullptr)
+        {
+            job->m_texture->Allocate(job->m_width, job->m_height, job->m_internalFormat, levels);
+            glBindTexture(GL_TEXTURE_2D, job->m_texture->GetGLTexture());
+            target = GL_TEXTURE_2D;
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_CUBE_MAP, job->m_cubeMap->GetGLCubeMap());
+            target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + job->m_face;
+        }
+
+        // With the unpack buffer bound, the data "pointer" is an offset into it.
+        if (job->m_slot >= 0)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+        }
+
+        size_t offset = (size_t)(job->m_slot >= 0 ? job->m_slot : 0) * m_slotSize;
+        unsigned int uploadLevels = compressed ? levels : 1;
+        for (unsigned int i = 0; i < uploadLevels; i++)
+        {
+            const void* data;
+            if (job->m_slot >= 0)
+            {
+                data = reinterpret_cast<const void*>(offset);
+            }
+            else
+            {
+                data = compressed ? job->m_image.m_compressed.m_levels[i].data() : job->m_image.m_pixels.data();
+            }
+
+            unsigned int levelWidth = glm::max(job->m_width >> i, 1u);
+            unsigned int levelHeight = glm::max(job->m_height >> i, 1u);
+            if (compressed)
+            {
+                glCompressedTexSubImage2D(target, i, 0, 0, levelWidth, levelHeight, job->m_internalFormat, job->m_levelSizes[i], data);
+            }
+            else
+            {
+                glTexSubImage2D(target, i, 0, 0, levelWidth, levelHeight, GL_BGRA, GL_UNSIGNED_BYTE, data);
+            }
+            offset += job->m_levelSizes[i];
+        }
+
+        if (job->m_slot >= 0)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            // The slot can be written again once the GPU has read everything out of it.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_slots[job->m_slot].m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        if (job->m_texture != nullptr)
+        {
+            if (!compressed && levels > 1)
+            {
+                glGenerateMipmap(GL_TEXTURE_2D);
+            }
+            glBindTexture(GL_TEXTURE_2D, 0);
+            job->m_texture->SetFiltering(job->m_sampleMode, job->m_mipmaps, Texture::GetDefaultAnisotropy());
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        }
+    }
+
+    if (job->m_texture != nullptr)
+    {
+        job->m_texture->DecRefCount();
+    }
+    if (job->m_cubeMap != nullptr)
+    {
+        job->m_cubeMap->DecRefCount();
+    }
+
+    unsigned int size = 0;
+    for (unsigned int i = 0; i < job->m_levelSizes.size(); i++)
+    {
+        size += job->m_levelSizes[i];
+    }
+    return size;
+}
+
+bool TextureStreamer::MatchCubeFace(Job* job)
+{
+    CubeMap* cubeMap = job->m_cubeMap;
+    bool compressed = job->m_internalFormat != GL_RGBA8;
+
+    // The first square face to arrive sets up the whole cube. Uncompressed faces only get level 0, like CubeMap does.
+    if (cubeMap->GetSize() == 0 && job->m_width == job->m_height)
+    {
+        cubeMap->Allocate(job->m_width, job->m_internalFormat, compressed ? job->m_levelSizes.size() : 1);
+    }
+
+    // Every other face has to be the same size and format, with at least as many levels, or it would throw the
+    // faces already uploaded away.
+    if (job->m_width != job->m_height || job->m_width != cubeMap->GetSize() || job->m_internalFormat != cubeMap->GetInternalFormat() ||
+        (compressed && job->m_levelSizes.size() < cubeMap->GetLevelCount()))
+    {
+        std::cout << "Cube map face " << job->m_filePath << " doesn't match the other faces, it was skipped." << std::endl;
+        return false;
+    }
+    return true;
+}
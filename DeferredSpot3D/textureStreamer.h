@@ -0,0 +1,135 @@
+/*
+Title: Deferred Spot Lighting
+File Name: textureStreamer.h
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "FreeImage.h"
+#include "glm/glm.hpp"
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+
+#include "texture.h"
+#include "cubeMap.h"
+#include "imageDecoder.h"
+
+// Loads textures in the background while the program keeps rendering.
+//
+// A single pixel unpack buffer is split into a fixed ring of staging slots, and stays mapped the whole time.
+// Worker threads decode images straight into a free slot. Once a frame, Update has OpenGL copy finished slots
+// into their textures (glTexSubImage2D reading from the buffer, so the driver doesn't have to copy our memory
+// first or wait on it), then fences the slot so it's only reused once the GPU is done reading it.
+//
+// Requested textures start out as a single color placeholder, and switch to the real image when it arrives.
+// Images too big for a slot are decoded into normal memory and uploaded the old way.
+class TextureStreamer
+{
+public:
+    TextureStreamer(unsigned int slotCount = 4, unsigned int slotSize = 16 * 1024 * 1024, unsigned int workerCount = 2);
+    ~TextureStreamer();
+
+    // Queue a texture to load. The texture is usable right away, and shows placeholderColor until it's streamed in.
+    Texture* Request(char* filePath, GLint sampleMode, bool mipmaps = true, glm::vec4 placeholderColor = glm::vec4(.5f, .5f, .5f, 1));
+
+    // Queue the six faces of a cube map (in the order CubeMap takes them).
+    // Compressed faces keep their mip levels. Faces that don't match the first one to arrive are left out.
+    CubeMap* RequestCubeMap(std::vector<char*> filePaths, glm::vec4 placeholderColor = glm::vec4(.5f, .5f, .5f, 1));
+
+    // Uploads finished images, up to about uploadBudget bytes (at least one image), and frees slots the GPU is done with.
+    // Call once a frame.
+    void Update(unsigned int uploadBudget = 8 * 1024 * 1024);
+
+    // How many requested images haven't been uploaded yet.
+    unsigned int GetPendingCount();
+
+private:
+    // One image to load, and where it goes.
+    struct Job
+    {
+        std::string m_filePath;
+        Texture* m_texture = nullptr;
+        CubeMap* m_cubeMap = nullptr;
+        unsigned int m_face = 0;
+        GLint m_sampleMode = GL_LINEAR;
+        bool m_mipmaps = true;
+
+        // Filled in by the worker.
+        bool m_loaded = false;
+        unsigned int m_width = 0;
+        unsigned int m_height = 0;
+        // GL_RGBA8 (bgra texels, bottom row first) or one of the compressed formats.
+        GLenum m_internalFormat = 0;
+        // Bytes in each level, stored one after another. Uncompressed images only have level 0.
+        std::vector<unsigned int> m_levelSizes;
+        // The slot holding the data, or -1 if it didn't fit and m_image holds it instead.
+        int m_slot = -1;
+        DecodedImage m_image;
+    };
+
+    struct Slot
+    {
+        bool m_free = true;
+        // Set once the upload from this slot is issued, the slot is free again when it signals.
+        GLsync m_fence = 0;
+    };
+
+    // The worker threads.
+    void Run();
+    void Decode(Job* job);
+
+    // Waits for a free slot and claims it.
+    int AcquireSlot();
+
+    // Copies a finished job into its texture (main thread).
+    unsigned int Upload(Job* job);
+    // Sets up a cube map for the first face to arrive. Returns false (and prints why) if the face doesn't match it.
+    bool MatchCubeFace(Job* job);
+
+    void Enqueue(Job* job);
+
+    GLuint m_buffer;
+    unsigned char* m_mapped = nullptr;
+    unsigned int m_slotSize;
+
+    std::vector<std::thread> m_workers;
+    bool m_running = true;
+
+    // Jobs only the main thread looks at: finished and waiting to upload.
+    std::deque<Job*> m_uploads;
+    unsigned int m_pending = 0;
+
+    // Everything below is shared with the workers.
+    std::mutex m_mutex;
+    std::condition_variable m_jobAdded;
+    std::condition_variable m_slotFreed;
+    std::deque<Job*> m_queued;
+    std::vector<Job*> m_finished;
+    std::vector<Slot> m_slots;
+};
@@ -0,0 +1,74 @@
+/*
+Title: Deferred Spot Lighting
+File Name: ambientLightFrag.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#version 430 core
+
+// The light that reaches every pixel, added to the light buffer after the light volumes:
+// ambient light, directional lights, and the lights that didn't fit in the light budget (the light grid).
+// Composition is then only color times light.
+
+#include "gBuffer.glsl"
+#include "lightTypes.glsl"
+#include "lightGrid.glsl"
+
+uniform sampler2D texNormal;
+uniform sampler2D texDepth;
+
+// Directional lights light every pixel, so there's no volume to draw for them (the range of them in the light buffer).
+uniform int firstDirectionalLight;
+uniform int directionalLightCount;
+
+// The light grid needs the pixel's world position.
+uniform mat4 inverseCameraView;
+
+layout(location = 0) out vec4 lightColor;
+
+void main(void)
+{
+	float depth = texelFetch(texDepth, ivec2(gl_FragCoord), 0).x;
+
+	// Don't apply shading to the skybox. Full light leaves its color as it is.
+	if(depth >= .99999)
+	{
+		lightColor = vec4(1);
+		return;
+	}
+
+	vec4 light = vec4(.1, .1, .3, 1);
+	vec3 normal = normalize(decodeNormal(texelFetch(texNormal, ivec2(gl_FragCoord), 0)));
+
+	// Directional lights don't need a position.
+	for(int i = 0; i < directionalLightCount; i++)
+	{
+		light += shadeLight(lights[firstDirectionalLight + i], vec3(0), normal);
+	}
+
+	// And the lights that weren't drawn (or were only partly drawn) this frame.
+	vec3 position = worldPositionFromDepth(gl_FragCoord.xy / vec2(textureSize(texDepth, 0)), depth, inverseCameraView);
+	light += sampleLightGrid(position, normal);
+
+	lightColor = light;
+}
@@ -0,0 +1,118 @@
+/*
+Title: Deferred Spot Lighting
+File Name: cullInstancesComp.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#version 430 core
+
+// Each work group handles 64 instances (CULL_GROUP_SIZE in instanceCuller.cpp)
+layout(local_size_x = 64) in;
+
+// Same layout as DrawElementsIndirectCommand in meshPool.h
+struct drawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	uint baseVertex;
+	uint baseInstance;
+};
+
+// Every instance matrix submitted this frame
+layout(std430, binding = 0) readonly buffer InputInstances
+{
+	mat4 inputMatrices[];
+};
+
+// The draw command each instance belongs to
+layout(std430, binding = 1) readonly buffer DrawIds
+{
+	uint drawIds[];
+};
+
+// Model space bounding sphere of each draw command's mesh (xyz = center, w = radius)
+layout(std430, binding = 2) readonly buffer BoundingSpheres
+{
+	vec4 boundingSpheres[];
+};
+
+// The indirect draw commands, instance counts start at zero
+layout(std430, binding = 3) buffer DrawCommands
+{
+	drawCommand commands[];
+};
+
+// Visible instances, compacted to the front of each command's range
+layout(std430, binding = 4) writeonly buffer VisibleInstances
+{
+	mat4 visibleMatrices[];
+};
+
+uniform vec4 frustumPlanes[6];
+uniform uint instanceCount;
+
+// Occlusion culling against last frame's Hi-Z pyramid (hiZPyramid.h)
+// The pyramid itself (hiZ) is declared in hiZOcclusion.glsl
+uniform int useHiZ;
+uniform mat4 hiZViewProjection;
+
+#include "hiZOcclusion.glsl"
+
+void main(void)
+{
+	uint id = gl_GlobalInvocationID.x;
+
+	// The last work group may have extra invocations.
+	if(id >= instanceCount)
+	{
+		return;
+	}
+
+	mat4 world = inputMatrices[id];
+	uint drawId = drawIds[id];
+	vec4 sphere = boundingSpheres[drawId];
+
+	// Move the sphere into world space, scaling the radius by the largest axis of the matrix.
+	vec3 center = vec3(world * vec4(sphere.xyz, 1));
+	float scale = max(length(world[0].xyz), max(length(world[1].xyz), length(world[2].xyz)));
+	float radius = sphere.w * scale;
+
+	// If the sphere is completely behind any plane, it can't be seen.
+	for(int i = 0; i < 6; i++)
+	{
+		if(dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w < -radius)
+		{
+			return;
+		}
+	}
+
+	// Test against the depth from last frame, using last frame's camera.
+	if(useHiZ != 0 && isSphereOccluded(vec4(center, radius), hiZViewProjection))
+	{
+		return;
+	}
+
+	// atomicAdd returns the old count, which is the next free slot in this command's range.
+	uint slot = atomicAdd(commands[drawId].instanceCount, 1);
+	visibleMatrices[commands[drawId].baseInstance + slot] = world;
+}
@@ -0,0 +1,44 @@
+/*
+Title: Deferred Spot Lighting
+File Name: debugViewFrag.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#version 400 core
+
+// Draws one of the G-buffer or light textures as it is, into a small viewport.
+// Only drawn while the debug views are on, composition doesn't know about them.
+
+uniform sampler2D debugTexture;
+
+// The viewport being drawn into, in pixels (xy = corner, zw = size)
+uniform vec4 debugViewport;
+
+out vec4 fragColor;
+
+void main(void)
+{
+	// Squeeze the whole texture into the viewport.
+	vec2 uv = (gl_FragCoord.xy - debugViewport.xy) / debugViewport.zw;
+	fragColor = texelFetch(debugTexture, ivec2(uv * vec2(textureSize(debugTexture, 0))), 0);
+}
@@ -1,6 +1,6 @@
 /*
 Title: Deferred Spot Lighting
-File Name: pointLightVert.glsl
+File Name: depthOnlyVert.glsl
 Copyright ? 2016
 Author: David Erbelding
 Written under the supervision of David I. Schwartz, Ph.D., and
@@ -25,40 +25,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #version 400 core
 
-// Structs in glsl are used to pass collections of data more conveniently
-// You have to define the struct at the top of every shader that uses it.
-struct pointLight
-{
-	vec3 position;
-	float radius;
-	vec4 attenuation;
-	vec4 color;
-};
-
-// Vertex attribute for position
-layout(location = 0) in vec3 in_vertex;
-layout(location = 1) in vec4 in_positionRadius;
-layout(location = 2) in vec4 in_attenuation;
-layout(location = 3) in vec4 in_color;
+// The depth pre-pass only reads positions (MeshPool::Render with positionsOnly), and the instance matrix.
+layout(location = 0) in vec3 in_position;
+layout(location = 4) in mat4 in_worldMat;
 
 uniform mat4 cameraView;
 
-//uniform pointLight in_light;
-
-out pointLight light;
-out vec3 screenPosition;
+// vertex.glsl declares the same thing. Together with doing exactly the same math,
+// this guarantees both passes produce the same depth, so the GL_EQUAL test in the second pass passes.
+invariant gl_Position;
 
 void main(void)
 {
-	// Pass the light data forward to the fragment step
-	light.position = vec3(cameraView * vec4(in_positionRadius.xyz, 1));
-	light.radius = in_positionRadius.w;
-	light.attenuation = in_attenuation;
-	light.color = in_color;
-
-	// Send The world position in screen space
-	gl_Position = cameraView * vec4(in_positionRadius.xyz + (in_vertex * in_positionRadius.w), 1);
-
-	// Get the position of the vertex in screen space.
-	screenPosition = vec3(gl_Position);
-}
\ No newline at end of file
+	// There's no fragment shader. Color writes are off, so only depth is written.
+	vec4 worldPosition = (in_worldMat) * vec4(in_position, 1);
+	gl_Position = cameraView * worldPosition;
+}
@@ -23,7 +23,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 
-#version 400 core
+#version 430 core
+
+// Writing texture feedback is a side effect, which would otherwise turn off early depth testing
+// (and with it the depth pre-pass).
+layout(early_fragment_tests) in;
+
+#include "gBuffer.glsl"
+#include "textureFeedback.glsl"
 
 in vec3 position;
 in vec2 uv;
@@ -32,6 +39,10 @@ in mat3 tbn;
 uniform sampler2D diffuseMap;
 uniform sampler2D normalMap;
 
+// Feedback slots, set by Material for textures the texture manager streams.
+uniform int diffuseMapFeedback;
+uniform int normalMapFeedback;
+
 layout(location = 0) out vec4 color;
 layout(location = 1) out vec4 normal;
 
@@ -52,11 +63,18 @@ void main(void)
 
 	
 	// calculate normal from normal map
-	vec3 texnorm = normalize(vec3(texture(normalMap, uv)) * 2.0 - 1.0);
+	// Only x and y are read, z is rebuilt from them (it always points out of the surface).
+	// That way a BC5 normal map, which only has red and green, works the same as an RGB one.
+	vec2 texnormXY = texture(normalMap, uv).xy * 2.0 - 1.0;
+	vec3 texnorm = normalize(vec3(texnormXY, sqrt(max(1.0 - dot(texnormXY, texnormXY), 0.0))));
 	vec3 norm = tbn * texnorm;
 
 	
+	// Report how big the textures are on screen, so the right mip levels get loaded.
+	writeTextureFeedback(diffuseMapFeedback, uv);
+	writeTextureFeedback(normalMapFeedback, uv);
+
 	// finally, sample from the texuture and apply the light.
 	color = texture(diffuseMap, uv);
-	normal = vec4(norm * .5 + .5, 1);
+	normal = encodeNormal(norm);
 }
\ No newline at end of file
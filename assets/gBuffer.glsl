@@ -0,0 +1,72 @@
+/*
+Title: Deferred Spot Lighting
+File Name: gBuffer.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Writing and reading normals in the geometry buffer, included by every shader that touches it.
+// There's no #version here, the shader including this file has one.
+//
+// By default the normal is stored in the RGB channels, scaled from -1..1 to 0..1.
+// With GBUFFER_OCTAHEDRAL it's folded onto an octahedron and flattened into just the RG channels,
+// which leaves B free for something else.
+
+#ifdef GBUFFER_OCTAHEDRAL
+// Folds the lower half of the octahedron over the upper half.
+vec2 octahedronWrap(vec2 v)
+{
+	return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+#endif
+
+// Turns a world space normal into a G-buffer texel.
+vec4 encodeNormal(vec3 normal)
+{
+#ifdef GBUFFER_OCTAHEDRAL
+	vec3 n = normal / (abs(normal.x) + abs(normal.y) + abs(normal.z));
+	vec2 folded = (n.z >= 0.0) ? n.xy : octahedronWrap(n.xy);
+	return vec4(folded * .5 + .5, 0, 1);
+#else
+	return vec4(normal * .5 + .5, 1);
+#endif
+}
+
+// Turns a G-buffer texel back into a world space normal (not necessarily normalized).
+vec3 decodeNormal(vec4 texel)
+{
+#ifdef GBUFFER_OCTAHEDRAL
+	vec2 f = texel.xy * 2 - 1;
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0, 1);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return n;
+#else
+	return vec3(texel) * 2 - 1;
+#endif
+}
+
+// Undoes the camera's projection to find the world position of a pixel, from its depth buffer value.
+vec3 worldPositionFromDepth(vec2 screenUV, float depth, mat4 inverseViewProjection)
+{
+	vec4 worldPosition = inverseViewProjection * vec4(vec3(screenUV, depth) * 2 - 1, 1);
+	return worldPosition.xyz / worldPosition.w;
+}
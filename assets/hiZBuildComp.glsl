@@ -0,0 +1,75 @@
+/*
+Title: Deferred Spot Lighting
+File Name: hiZBuildComp.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#version 430 core
+
+// 8x8 texels per work group (HIZ_GROUP_SIZE in hiZPyramid.cpp)
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// Either the depth buffer (sourceLevel = -1), or the pyramid itself
+uniform sampler2D sourceDepth;
+uniform int sourceLevel;
+
+// The level being written
+layout(r32f, binding = 0) writeonly uniform image2D destination;
+
+void main(void)
+{
+	ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+	ivec2 size = imageSize(destination);
+
+	// The last work groups may hang off the edge.
+	if(texel.x >= size.x || texel.y >= size.y)
+	{
+		return;
+	}
+
+	// Level 0 is just a copy of the depth buffer.
+	if(sourceLevel < 0)
+	{
+		imageStore(destination, texel, vec4(texelFetch(sourceDepth, texel, 0).x));
+		return;
+	}
+
+	ivec2 sourceSize = textureSize(sourceDepth, sourceLevel);
+
+	// Normally a texel covers 2x2 texels of the level above.
+	// If the level above has an odd size, the last row and column also cover the texel left over at the edge.
+	int countX = (texel.x == size.x - 1 && sourceSize.x > 1 && (sourceSize.x & 1) == 1) ? 3 : 2;
+	int countY = (texel.y == size.y - 1 && sourceSize.y > 1 && (sourceSize.y & 1) == 1) ? 3 : 2;
+
+	// Keep the farthest depth, so that anything behind it is guaranteed to be hidden.
+	float farthest = 0;
+	for(int j = 0; j < countY; j++)
+	{
+		for(int i = 0; i < countX; i++)
+		{
+			ivec2 source = min(texel * 2 + ivec2(i, j), sourceSize - 1);
+			farthest = max(farthest, texelFetch(sourceDepth, source, sourceLevel).x);
+		}
+	}
+
+	imageStore(destination, texel, vec4(farthest));
+}
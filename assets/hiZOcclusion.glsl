@@ -0,0 +1,88 @@
+/*
+Title: Deferred Spot Lighting
+File Name: hiZOcclusion.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Included by any shader that tests spheres against the Hi-Z pyramid (hiZPyramid.h).
+// There's no #version here, the shader including this file has one.
+
+uniform sampler2D hiZ;
+
+// Returns true if a world space sphere (xyz = center, w = radius) is completely hidden behind the depth in the Hi-Z pyramid.
+// This follows HiZReference::IsSphereOccluded in hiZPyramid.cpp exactly.
+bool isSphereOccluded(vec4 sphere, mat4 viewProjection)
+{
+	// Project the corners of the sphere's bounding box to find the covered rectangle and its nearest depth.
+	vec2 uvMin = vec2(1);
+	vec2 uvMax = vec2(0);
+	float nearestDepth = 1;
+	for(int i = 0; i < 8; i++)
+	{
+		vec3 corner = sphere.xyz + sphere.w * vec3((i & 1) * 2 - 1, ((i >> 1) & 1) * 2 - 1, ((i >> 2) & 1) * 2 - 1);
+		vec4 p = viewProjection * vec4(corner, 1);
+
+		// A corner behind the camera would flip the rectangle inside out, so we can't say anything.
+		if(p.w <= 0.0001)
+		{
+			return false;
+		}
+
+		vec3 ndc = p.xyz / p.w;
+		uvMin = min(uvMin, ndc.xy * .5 + .5);
+		uvMax = max(uvMax, ndc.xy * .5 + .5);
+		nearestDepth = min(nearestDepth, ndc.z * .5 + .5);
+	}
+	uvMin = clamp(uvMin, 0, 1);
+	uvMax = clamp(uvMax, 0, 1);
+
+	// Find the covered pixels on level 0.
+	ivec2 size0 = textureSize(hiZ, 0);
+	ivec2 pixelMin = min(ivec2(uvMin * vec2(size0)), size0 - 1);
+	ivec2 pixelMax = min(ivec2(uvMax * vec2(size0)), size0 - 1);
+
+	// The pyramid has a level for every halving of the largest side.
+	int lastLevel = 0;
+	for(int s = max(size0.x, size0.y); s > 1; s >>= 1)
+	{
+		lastLevel++;
+	}
+
+	// Pick the first level where the rectangle is at most 2 texels wide and tall.
+	ivec2 extent = pixelMax - pixelMin;
+	int largest = max(extent.x, extent.y);
+	int level = 0;
+	while((1 << level) < largest && level < lastLevel)
+	{
+		level++;
+	}
+
+	// Read the (up to) four texels that cover the rectangle and keep the farthest.
+	ivec2 levelSize = textureSize(hiZ, level);
+	ivec2 a = min(pixelMin >> level, levelSize - 1);
+	ivec2 b = min(pixelMax >> level, levelSize - 1);
+	float farthest = max(max(texelFetch(hiZ, a, level).x, texelFetch(hiZ, ivec2(b.x, a.y), level).x),
+		max(texelFetch(hiZ, ivec2(a.x, b.y), level).x, texelFetch(hiZ, b, level).x));
+
+	// Hidden if even the nearest point is behind everything drawn there.
+	return nearestDepth > farthest;
+}
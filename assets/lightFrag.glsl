@@ -0,0 +1,149 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightFrag.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#version 430 core
+
+// One fragment shader for every light with a volume (point and spot lights). The light's type is in its record,
+// so every kind of light is drawn in the same pass, reading the G-buffer once per light per pixel.
+// Directional lights light every pixel, they are added over the whole screen afterwards (ambientLightFrag.glsl).
+
+// Spot lights' falloff comes from their profile texture (lightTypes.glsl).
+#define LIGHT_PROFILES
+
+#include "lightTypes.glsl"
+#include "gBuffer.glsl"
+
+flat in uint lightIndex;
+// The depth buffer values the light can reach (LightVolumeRenderer::GetScreenBounds)
+flat in vec2 lightDepthRange;
+// How much of the light to draw, lights fading out of the light budget are partly in the light grid instead
+flat in float lightWeight;
+
+uniform sampler2D texNormal;
+uniform sampler2D texDepth;
+// To get back to world space from the depth buffer
+uniform mat4 inverseCameraView;
+
+layout(location = 0) out vec4 lightColor;
+
+// Pixels shaded by each light, by its index, counted while recordStats is on (LightVolumeRenderer::SetRecordStats)
+layout(std430, binding = 1) buffer LightStats
+{
+	uint shadedPixels[];
+};
+uniform int recordStats;
+
+#if defined(SHADOWS)
+// Every spot light's shadow map, each in its own tile (spotShadowRenderer.h)
+uniform sampler2DShadow shadowAtlas;
+// Every shadowed point light's cube map, which store distance to the light over its radius (pointShadowFrag.glsl)
+uniform samplerCubeArrayShadow pointShadows;
+
+// Where each shadowed spot light's shadow is in the atlas, SpotShadow in lights.h (binding is LIGHT_SHADOW_BINDING)
+struct spotShadowTile
+{
+	mat4 matrix;	// World space to atlas uv and depth
+	vec4 bounds;	// The tile's uv rectangle
+};
+layout(std430, binding = 4) readonly buffer SpotShadows
+{
+	spotShadowTile spotShadows[];
+};
+
+// How much of a spot light reaches a point, from 0 (in shadow) to 1 (lit).
+float spotShadow(lightRecord light, vec3 position)
+{
+	// Lights that didn't fit in the atlas have no shadow.
+	if(light.coneShadow.z < 0)
+	{
+		return 1;
+	}
+	spotShadowTile shadow = spotShadows[int(light.coneShadow.z)];
+
+	// Project the pixel into the light's tile.
+	vec4 shadowPosition = shadow.matrix * vec4(position, 1);
+	shadowPosition.xyz /= shadowPosition.w;
+
+	// Four filtered comparisons half a texel apart (each is already 2x2 PCF), kept inside the tile.
+	vec2 texel = 1.0 / vec2(textureSize(shadowAtlas, 0));
+	float lit = 0;
+	for(int y = -1; y <= 1; y += 2)
+	{
+		for(int x = -1; x <= 1; x += 2)
+		{
+			vec2 uv = clamp(shadowPosition.xy + vec2(x, y) * texel * .5, shadow.bounds.xy, shadow.bounds.zw);
+			lit += texture(shadowAtlas, vec3(uv, shadowPosition.z));
+		}
+	}
+	return lit * .25;
+}
+
+// How much of a point light reaches a point, from 0 (in shadow) to 1 (lit).
+float pointShadow(lightRecord light, vec3 position)
+{
+	if(light.coneShadow.z < 0)
+	{
+		return 1;
+	}
+
+	// The direction picks the face, and the stored distance is compared with the pixel's (filtered, 2x2 PCF).
+	// A small bias keeps surfaces from shadowing themselves, polygon offset doesn't apply to written depth.
+	vec3 fromLight = position - light.positionType.xyz;
+	return texture(pointShadows, vec4(fromLight, light.coneShadow.z), length(fromLight) / light.directionRange.w - .01);
+}
+#endif
+
+void main(void)
+{
+	// First, we read the depth from the geometry buffer.
+	// Anything in front of or behind everything the light can reach isn't lit, so skip the rest.
+	// (Where the depth bounds test is used, these pixels never get here.)
+	float depth = texelFetch(texDepth, ivec2(gl_FragCoord), 0).x;
+	if(depth < lightDepthRange.x || depth > lightDepthRange.y)
+	{
+		discard;
+	}
+
+	if(recordStats != 0)
+	{
+		atomicAdd(shadedPixels[lightIndex], 1);
+	}
+
+	vec3 normal = normalize(decodeNormal(texelFetch(texNormal, ivec2(gl_FragCoord), 0)));
+
+	// Lighting is done in world space, with the position of the pixel rebuilt from the depth buffer.
+	vec3 position = worldPositionFromDepth(gl_FragCoord.xy / vec2(textureSize(texDepth, 0)), depth, inverseCameraView);
+
+	lightRecord light = lights[lightIndex];
+	lightColor = shadeLight(light, position, normal) * lightWeight;
+
+#if defined(SHADOWS)
+	// Only bother with shadows where there's light.
+	if(lightColor != vec4(0))
+	{
+		lightColor *= lightType(light) == LIGHT_TYPE_SPOT ? spotShadow(light, position) : pointShadow(light, position);
+	}
+#endif
+}
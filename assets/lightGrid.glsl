@@ -0,0 +1,81 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightGrid.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// The lights left over after the light budget (LightBudget in lightBudget.h), as a grid of points over the scene.
+// Each point holds the light reaching it as first order spherical harmonics, per color channel:
+// x = the part every direction gets, yzw = the part that depends on the direction (times the normal).
+// There's no #version here, the shader including this file has one (430 or later, for the storage buffer).
+
+// Same layout as LightGridPoint in lightBudget.h
+struct lightGridPoint
+{
+	vec4 red;
+	vec4 green;
+	vec4 blue;
+};
+
+// The grid, x first, then y, then z (binding is LIGHT_GRID_BINDING)
+layout(std430, binding = 3) readonly buffer LightGrid
+{
+	lightGridPoint gridPoints[];
+};
+
+uniform vec3 lightGridMin;
+uniform vec3 lightGridSpacing;
+// Points along each axis (whole numbers, kept as floats for Material::SetVec3)
+uniform vec3 lightGridSize;
+
+// The light the grid gives a surface, blending between the nearest points (same as LightBudget::Sample).
+vec4 sampleLightGrid(vec3 position, vec3 normal)
+{
+	// Where the position is in the grid, in steps. Outside the grid there's no light from it.
+	ivec3 size = ivec3(lightGridSize);
+	vec3 cell = (position - lightGridMin) / lightGridSpacing;
+	if(any(lessThan(cell, vec3(0))) || any(greaterThan(cell, vec3(size - 1))))
+	{
+		return vec4(0);
+	}
+
+	ivec3 low = min(ivec3(cell), size - 2);
+	vec3 t = cell - vec3(low);
+
+	// Blend the eight points around the position, then apply the normal.
+	vec4 red = vec4(0);
+	vec4 green = vec4(0);
+	vec4 blue = vec4(0);
+	for(int i = 0; i < 8; i++)
+	{
+		ivec3 corner = low + ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+		vec3 w3 = mix(1 - t, t, vec3(corner - low));
+		float w = w3.x * w3.y * w3.z;
+		lightGridPoint point = gridPoints[(corner.z * size.y + corner.y) * size.x + corner.x];
+		red += point.red * w;
+		green += point.green * w;
+		blue += point.blue * w;
+	}
+
+	vec4 n = vec4(1, normal);
+	return vec4(max(vec3(dot(red, n), dot(green, n), dot(blue, n)), vec3(0)), 0);
+}
@@ -0,0 +1,121 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightTypes.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Light data shared by the light volume pass (lightVolumeVert.glsl, lightFrag.glsl) and the ambient light pass (ambientLightFrag.glsl).
+// There's no #version here, the shader including this file has one (430 or later, for the storage buffer).
+
+// The type tag in a light record, must match LightType in lights.h.
+#define LIGHT_TYPE_POINT 0
+#define LIGHT_TYPE_SPOT 1
+#define LIGHT_TYPE_DIRECTIONAL 2
+
+// One light of any type, LightRecord in lights.h.
+struct lightRecord
+{
+	vec4 positionType;		// xyz = world position, w = type
+	vec4 directionRange;	// xyz = direction the light points, w = range (radius for point lights)
+	vec4 attenuation;
+	vec4 color;
+	vec4 coneShadow;		// x = cone angle, y = spot exponent, z = shadow index (-1 for none), w = cosine of the cone angle
+	vec4 profile;			// xyz = the light's side axis, w = layer in lightProfiles (-1 for none)
+};
+
+// Every light in the scene (LightBuffer in lightBuffer.h, binding is LIGHT_BUFFER_BINDING)
+layout(std430, binding = 0) readonly buffer Lights
+{
+	lightRecord lights[];
+};
+
+int lightType(lightRecord light)
+{
+	return int(light.positionType.w);
+}
+
+#if defined(LIGHT_PROFILES)
+// Every spot light's falloff, from its exponent, an IES file or a cookie (LightProfiles in lightProfiles.h)
+uniform sampler2DArray lightProfiles;
+
+// How much light a spot light's profile gives off in a direction (from the light, normalized).
+// u is sin(angle from the axis / 2), v goes around the axis starting from the side axis.
+float sampleLightProfile(lightRecord light, vec3 direction)
+{
+	vec3 axis = light.directionRange.xyz;
+	vec3 side = light.profile.xyz;
+	vec3 up = cross(axis, side);
+	float u = sqrt(clamp(.5 - .5 * dot(direction, axis), 0, 1));
+	float v = atan(dot(direction, up), dot(direction, side)) * (1 / 6.28318531);
+	return texture(lightProfiles, vec3(u, v, light.profile.w)).x;
+}
+#endif
+
+// How much of a light reaches a world space surface, before shadows.
+vec4 shadeLight(lightRecord light, vec3 position, vec3 normal)
+{
+	// Directional lights come from the same direction everywhere, and don't fade.
+	if(lightType(light) == LIGHT_TYPE_DIRECTIONAL)
+	{
+		return light.color * clamp(dot(-light.directionRange.xyz, normal), 0, 1);
+	}
+
+	// Calculate light angle.
+	vec3 surfaceToLight = light.positionType.xyz - position;
+
+	// Get diffuse value.
+	float ndotl = clamp(dot(normalize(surfaceToLight), normal), 0, 1);
+
+	// Calclate distance and attenuation.
+	float d = clamp(length(surfaceToLight) / light.directionRange.w, 0, 1);
+	float attenuation = (1 / (light.attenuation.x * d * d + light.attenuation.y * d + light.attenuation.z)) - light.attenuation.w;
+
+	if(lightType(light) == LIGHT_TYPE_SPOT)
+	{
+		// Spot effect calculation is the dot product of our light to surface vector with our light direction vector
+		// (Surface to light is negated because we want a light to surface vector here)
+		float spotEffect = clamp(dot(normalize(-surfaceToLight), light.directionRange.xyz), 0, 1);
+
+		// the dot product of two normalized vectors is equal to the cosine of the angle between them.
+		// If our cosine is less than the cosine of the light angle, we are outside the light volume.
+		// If we don't do this, the light will appear on surfaces outside of the volume when looking through the volume.
+		if(spotEffect <= light.coneShadow.w)
+		{
+			return vec4(0);
+		}
+
+		// Attenuation is multiplied by the spot effect (with the exponent) for spot lights.
+		// With a profile, that's already in its texture, along with anything an IES file or cookie adds.
+#if defined(LIGHT_PROFILES)
+		if(light.profile.w >= 0)
+		{
+			attenuation *= sampleLightProfile(light, normalize(-surfaceToLight));
+		}
+		else
+#endif
+		{
+			attenuation *= pow(spotEffect, light.coneShadow.y);
+		}
+	}
+
+	return light.color * ndotl * attenuation;
+}
@@ -0,0 +1,146 @@
+/*
+Title: Deferred Spot Lighting
+File Name: lightVolumeVert.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#version 430 core
+
+// Draws the volume of one light, of any type (lightVolumeRenderer.h).
+// Point lights are spheres. Spot lights are a cone with a rounded cap, or a screen space quad past 90 degrees.
+// Lights the near plane cuts through are quads too.
+#include "lightTypes.glsl"
+
+// Must match LightVolume in lightVolumeRenderer.h
+#define LIGHT_VOLUME_SPHERE 0
+#define LIGHT_VOLUME_SECTOR 1
+#define LIGHT_VOLUME_QUAD 2
+
+// Vertex attribute for position (for the rounded cone it's angles, see LightVolumeRenderer::BuildSector)
+layout(location = 0) in vec3 in_vertex;
+// Which light this instance is (an index into the light buffer), and the shape it's drawn with
+layout(location = 1) in uvec2 in_lightVolume;
+
+uniform mat4 cameraView;
+
+// Same layout as LightScreenBounds in lightVolumeRenderer.h
+struct screenBounds
+{
+	vec4 rect; // min xy, max xy, in normalized device coordinates
+	vec4 depth; // x = nearest, y = farthest depth buffer value the light reaches, w = how much of the light to draw
+};
+
+// Every light's bounds on screen, by its index, worked out on the CPU (LightVolumeRenderer::GetScreenBounds)
+layout(std430, binding = 2) readonly buffer LightBounds
+{
+	screenBounds bounds[];
+};
+
+flat out uint lightIndex;
+// The fragment shader skips pixels whose depth is outside this range
+flat out vec2 lightDepthRange;
+// Less than 1 for lights fading out of the light budget, the rest of them is in the light grid (lightGrid.glsl)
+flat out float lightWeight;
+
+#include "hiZOcclusion.glsl"
+
+// The smallest sphere around the lit part of a spot light, with its tip at the origin pointing down -z
+// (same as GetSpotBoundingSphere in lights.h)
+vec4 spotBoundingSphere(float range, float angle)
+{
+	// Narrow cones: the tip and the rim of the cap are both on the sphere.
+	if(angle < 0.785398)
+	{
+		float distance = range / (2 * cos(angle));
+		return vec4(0, 0, -distance, distance);
+	}
+	// Wider cones: the rim of the cap is the widest part, so center the sphere on it.
+	if(angle < 1.570796)
+	{
+		return vec4(0, 0, -range * cos(angle), range * sin(angle));
+	}
+	// Past 90 degrees, it's most of a sphere around the tip.
+	return vec4(0, 0, 0, range);
+}
+
+void main(void)
+{
+	// Pass the light forward to the fragment step, it reads the rest of the record itself.
+	lightIndex = in_lightVolume.x;
+	lightRecord light = lights[lightIndex];
+	lightDepthRange = bounds[lightIndex].depth.xy;
+	lightWeight = bounds[lightIndex].depth.w;
+
+	vec3 position = light.positionType.xyz;
+	float range = light.directionRange.w;
+	float angle = light.coneShadow.x;
+
+	// The cone points down -z. Build axes around the light's direction to put it in the world,
+	// the cone is round so it doesn't matter which way the sides face.
+	vec3 back = -light.directionRange.xyz;
+	vec3 right = normalize(cross(abs(back.y) < .99 ? vec3(0, 1, 0) : vec3(1, 0, 0), back));
+	vec3 up = cross(back, right);
+
+	vec4 sphere = vec4(position, range);
+	if(lightType(light) == LIGHT_TYPE_SPOT)
+	{
+		vec4 cone = spotBoundingSphere(range, angle);
+		sphere = vec4(position + back * cone.z, cone.w);
+	}
+
+	if(in_lightVolume.y == LIGHT_VOLUME_QUAD)
+	{
+		// Stretch the quad over the light's rectangle. Depth doesn't matter, lights are drawn without a depth test.
+		vec4 rect = bounds[lightIndex].rect;
+		gl_Position = vec4(mix(rect.xy, rect.zw, in_vertex.xy), 0, 1);
+	}
+	else
+	{
+		vec3 worldPosition = position + in_vertex * range;
+		if(in_lightVolume.y == LIGHT_VOLUME_SECTOR)
+		{
+			// The tip stays at the light. Everything else is on the cap, at an angle from the middle and around it.
+			// step is how much a flat facet cuts inside a circle. The sides are widened and the cap pushed out by it,
+			// so the facets always contain the round shape.
+			vec3 local = vec3(0);
+			float step = in_vertex.z;
+			if(step > 0)
+			{
+				float rimAngle = atan(tan(angle) / step);
+				float polar = in_vertex.y * rimAngle;
+				float around = in_vertex.x * 6.283185;
+				local = range / (step * step) * vec3(sin(polar) * cos(around), sin(polar) * sin(around), -cos(polar));
+			}
+			worldPosition = position + right * local.x + up * local.y + back * local.z;
+		}
+
+		// Transform that position into view space for our final vertex position.
+		gl_Position = cameraView * vec4(worldPosition, 1);
+	}
+
+	// If the whole light is hidden behind the scene it can't light anything.
+	// Move every vertex outside of the screen, so the light is clipped away and no pixels are shaded.
+	if(isSphereOccluded(sphere, cameraView))
+	{
+		gl_Position = vec4(2, 2, 2, 1);
+	}
+}
@@ -0,0 +1,44 @@
+/*
+Title: Deferred Spot Lighting
+File Name: placeholderFrag.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#version 400 core
+
+// A cheap stand in for diffuseNormalFrag.glsl, used while that program is still compiling.
+// It fills the G-buffer with plain grey and the surface normal, so lighting still works.
+
+#include "gBuffer.glsl"
+
+in vec3 position;
+in vec2 uv;
+in mat3 tbn;
+
+layout(location = 0) out vec4 color;
+layout(location = 1) out vec4 normal;
+
+void main(void)
+{
+	color = vec4(.5, .5, .5, 1);
+	normal = encodeNormal(normalize(tbn[2]));
+}
@@ -0,0 +1,79 @@
+/*
+Title: Deferred Spot Lighting
+File Name: pointShadowGeom.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#version 400 core
+
+// Every triangle is run six times, once per cube face (pointShadowRenderer.h).
+// Each invocation projects it with its face's camera and sends it to that face's layer of the cube map array,
+// so a light's whole cube map is drawn with one draw call instead of six.
+layout(triangles, invocations = 6) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+in vec3 vertexWorldPosition[];
+out vec3 worldPosition;
+
+// One camera per face, in the order of the layers: +x, -x, +y, -y, +z, -z.
+uniform mat4 faceViewProjection[6];
+// Bit n is set if the CPU found a caster in face n (ShadowCasterCuller::CullPointLights).
+uniform int faceMask;
+// This light's first layer, its cube map's index * 6.
+uniform int firstLayer;
+
+void main(void)
+{
+	int face = gl_InvocationID;
+
+	// Nothing in this face, it's only cleared.
+	if((faceMask & (1 << face)) == 0)
+	{
+		return;
+	}
+
+	vec4 positions[3];
+	for(int i = 0; i < 3; i++)
+	{
+		positions[i] = faceViewProjection[face] * vec4(vertexWorldPosition[i], 1);
+	}
+
+	// If every vertex is outside the same side of the face's frustum, the triangle can't touch it.
+	// The near and far planes are left to the clipper, it's the sides that throw away most triangles.
+	for(int axis = 0; axis < 2; axis++)
+	{
+		if((positions[0][axis] > positions[0].w && positions[1][axis] > positions[1].w && positions[2][axis] > positions[2].w)
+			|| (positions[0][axis] < -positions[0].w && positions[1][axis] < -positions[1].w && positions[2][axis] < -positions[2].w))
+		{
+			return;
+		}
+	}
+
+	for(int i = 0; i < 3; i++)
+	{
+		gl_Layer = firstLayer + face;
+		gl_Position = positions[i];
+		worldPosition = vertexWorldPosition[i];
+		EmitVertex();
+	}
+	EndPrimitive();
+}
@@ -0,0 +1,38 @@
+/*
+Title: Deferred Spot Lighting
+File Name: pointShadowVert.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#version 400 core
+
+// Point light shadows draw the casters with MeshPool::RenderRange (positionsOnly), like the depth pre-pass.
+layout(location = 0) in vec3 in_position;
+layout(location = 4) in mat4 in_worldMat;
+
+// The geometry shader does the projecting, once per cube face.
+out vec3 vertexWorldPosition;
+
+void main(void)
+{
+	vertexWorldPosition = vec3(in_worldMat * vec4(in_position, 1));
+}
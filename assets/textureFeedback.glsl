@@ -0,0 +1,54 @@
+/*
+Title: Deferred Spot Lighting
+File Name: textureFeedback.glsl
+Copyright ? 2016
+Author: David Erbelding
+Written under the supervision of David I. Schwartz, Ph.D., and
+supported by a professional development seed grant from the B. Thomas
+Golisano College of Computing & Information Sciences
+(https://www.rit.edu/gccis) at the Rochester Institute of Technology.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Mip streaming feedback for the texture manager (textureManager.h).
+// There's no #version here, the shader including this file needs 430 (or shader storage buffers).
+//
+// For each managed texture, the biggest size it was drawn at this frame:
+// log2 of the size in texels that would put one texel on each pixel, in 16ths, plus one (0 means not drawn).
+layout(std430, binding = 5) buffer TextureFeedback
+{
+	uint textureFeedback[];
+};
+
+// Records how big the texture in feedbackSlot is on screen here. Textures that aren't managed have slot -1.
+void writeTextureFeedback(int feedbackSlot, vec2 uv)
+{
+	// How far uv moves from one pixel to the next. Derivatives have to be taken before any branching.
+	float rho = max(length(dFdx(uv)), length(dFdy(uv)));
+
+	// Only one pixel in each 4x4 block reports, and only when it raises the value.
+	// Every pixel of a texture hits the same counter, so this keeps the atomics from piling up.
+	if(feedbackSlot < 0 || (int(gl_FragCoord.x) & 3) != 0 || (int(gl_FragCoord.y) & 3) != 0)
+	{
+		return;
+	}
+
+	uint value = uint(max(-log2(max(rho, 1e-8)), 0.0) * 16.0) + 1;
+	if(textureFeedback[feedbackSlot] < value)
+	{
+		atomicMax(textureFeedback[feedbackSlot], value);
+	}
+}
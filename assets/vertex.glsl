@@ -38,6 +38,9 @@ layout(location = 4) in mat4 in_worldMat;
 
 uniform mat4 cameraView;
 
+// The depth pre-pass (depthOnlyVert.glsl) has to produce exactly the same depth as this shader.
+invariant gl_Position;
+
 out vec3 position;
 out vec2 uv;
 out mat3 tbn;